@@ -18,6 +18,13 @@
 
 #include "EEG.h"
 #include "Sound_and_Spectrum.h"
+#include "NUM2.h"
+#include "MelderThread.h"
+#if ! defined (_WIN32)
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
 
 #include "oo_DESTROY.h"
 #include "EEG_def.h"
@@ -94,40 +101,237 @@ long EEG_getChannelNumber (EEG me, const char32 *channelName) {
 	return 0;
 }
 
+/*
+	The header of a BDF or EDF file consists of 256 bytes that describe the recording,
+	followed by 256 bytes per channel, in which each field is stored for all channels in turn.
+*/
+static const char *getBdfHeaderField (const char *header, long offset, int length, char *buffer) {
+	memcpy (buffer, header + offset, (size_t) length);
+	buffer [length] = '\0';
+	return buffer;
+}
+
+/*
+	The samples of one channel in one data record, little-endian and two's complement.
+	The loops have no branches, so that the compiler can vectorize them.
+*/
+static void decodeBdfSamples (const uint8 *p, long numberOfSamples, bool is24bit, double factor, double *to) {
+	if (is24bit) {
+		for (long i = 0; i < numberOfSamples; i ++, p += 3)
+			to [i] = ((int32) ((uint32) p [2] << 24 | (uint32) p [1] << 16 | (uint32) p [0] << 8) >> 8) * factor;   // extend the 24-bit sign
+	} else {
+		for (long i = 0; i < numberOfSamples; i ++, p += 2)
+			to [i] = (int16) (uint16) ((uint16) ((uint16) p [1] << 8) | (uint16) p [0]) * factor;
+	}
+}
+
+struct BdfReading {
+	bool is24bit;
+	long numberOfChannels, numberOfSamplesPerDataRecord, numberOfBytesPerChannelPerDataRecord, numberOfBytesPerDataRecord;
+	const double *factor;   // [1..numberOfChannels]
+	long numberOfSelectedChannels;   // the last one is the status channel
+	const long *selectedChannels;   // [1..numberOfSelectedChannels]
+	long firstSample, lastSample;   // in the file
+	double **z;   // [1..numberOfSelectedChannels - 1] [1..lastSample - firstSample + 1]
+	long firstRecord, lastRecord;
+	double *status;   // [1..(lastRecord - firstRecord + 1) * numberOfSamplesPerDataRecord]: the whole data records, for the annotations
+};
+
+/*
+	Decode data records firstRecord through lastRecord, which start at bytes.
+*/
+static void BdfReading_decodeRecords (BdfReading *me, const uint8 *bytes, long firstRecord, long lastRecord) {
+	for (long record = firstRecord; record <= lastRecord; record ++, bytes += my numberOfBytesPerDataRecord) {
+		const long numberOfSamplesBefore = (record - 1) * my numberOfSamplesPerDataRecord;
+		const long imin = std::max (1L, my firstSample - numberOfSamplesBefore);
+		const long imax = std::min (my numberOfSamplesPerDataRecord, my lastSample - numberOfSamplesBefore);
+		for (long ichan = 1; ichan < my numberOfSelectedChannels; ichan ++) {
+			const long channel = my selectedChannels [ichan];
+			decodeBdfSamples (bytes + (channel - 1) * my numberOfBytesPerChannelPerDataRecord + (imin - 1) * (my is24bit ? 3 : 2),
+				imax - imin + 1, my is24bit, my factor [channel], & my z [ichan] [numberOfSamplesBefore + imin - my firstSample + 1]);
+		}
+		decodeBdfSamples (bytes + (my numberOfChannels - 1) * my numberOfBytesPerChannelPerDataRecord,
+			my numberOfSamplesPerDataRecord, my is24bit, 1.0, & my status [(record - my firstRecord) * my numberOfSamplesPerDataRecord + 1]);
+	}
+}
+
+static bool BdfReading_readMapped (BdfReading *me, FILE *f, off_t startOfData) {
+	#if defined (_WIN32)
+		(void) me; (void) f; (void) startOfData;
+		return false;
+	#else
+		const double numberOfBytes_f = (double) (my lastRecord - my firstRecord + 1) * (double) my numberOfBytesPerDataRecord;
+		if (numberOfBytes_f > (double) SIZE_MAX / 2) return false;
+		const size_t numberOfBytes = (size_t) numberOfBytes_f;
+		const int fileDescriptor = fileno (f);
+		struct stat fileStatus;
+		if (fileDescriptor < 0 || fstat (fileDescriptor, & fileStatus) != 0 || ! S_ISREG (fileStatus. st_mode)) return false;
+		const off_t offset = startOfData + (off_t) (my firstRecord - 1) * (off_t) my numberOfBytesPerDataRecord;
+		if ((double) offset + numberOfBytes_f > (double) fileStatus. st_size)
+			return false;   // the file is too small: let the buffered version complain
+		const long pageSize = sysconf (_SC_PAGESIZE);
+		if (pageSize <= 0) return false;
+		const off_t mappingStart = offset - offset % pageSize;
+		const size_t mappingLength = numberOfBytes + (size_t) (offset - mappingStart);
+		void *mapping = mmap (nullptr, mappingLength, PROT_READ, MAP_PRIVATE, fileDescriptor, mappingStart);
+		if (mapping == MAP_FAILED) return false;
+		(void) madvise (mapping, mappingLength, MADV_SEQUENTIAL);
+		BdfReading_decodeRecords (me, (const uint8 *) mapping + (offset - mappingStart), my firstRecord, my lastRecord);
+		munmap (mapping, mappingLength);
+		return true;
+	#endif
+}
+
+#define BdfReading_BLOCK_SIZE  (16L * 1024 * 1024)   /* bytes */
+
+static void BdfReading_readBlocks (BdfReading *me, FILE *f, off_t startOfData) {
+	const long numberOfRecordsPerBlock = std::max (1L, BdfReading_BLOCK_SIZE / my numberOfBytesPerDataRecord);
+	autoNUMvector <uint8> bytes (0L, numberOfRecordsPerBlock * my numberOfBytesPerDataRecord - 1);
+	if (fseeko (f, startOfData + (off_t) (my firstRecord - 1) * (off_t) my numberOfBytesPerDataRecord, SEEK_SET))
+		Melder_throw (U"Cannot find data record ", my firstRecord, U".");
+	for (long firstRecordOfBlock = my firstRecord; firstRecordOfBlock <= my lastRecord; firstRecordOfBlock += numberOfRecordsPerBlock) {
+		const long lastRecordOfBlock = std::min (firstRecordOfBlock + numberOfRecordsPerBlock - 1, my lastRecord);
+		const size_t numberOfBytesToRead = (size_t) ((lastRecordOfBlock - firstRecordOfBlock + 1) * my numberOfBytesPerDataRecord);
+		if (fread (bytes.peek(), 1, numberOfBytesToRead, f) < numberOfBytesToRead)
+			Melder_throw (U"File too short: data record ", firstRecordOfBlock, U" or later is incomplete.");
+		BdfReading_decodeRecords (me, bytes.peek(), firstRecordOfBlock, lastRecordOfBlock);
+	}
+}
+
+/*
+	Interpret the status channel as marks (if the file has annotations) or as trigger bits.
+*/
+static autoTextGrid BdfStatus_to_TextGrid (const double *status, long numberOfSamples, double x1, double dx,
+	double xmin, double xmax, bool hasLetters)
+{
+	int numberOfStatusBits = 8;
+	for (long i = 1; i <= numberOfSamples; i ++) {
+		unsigned long value = (long) status [i];
+		if (value & 0x0000FF00) {
+			numberOfStatusBits = 16;
+		}
+	}
+	autoTextGrid thee;
+	if (hasLetters) {
+		thee = TextGrid_create (xmin, xmax, U"Mark Trigger", U"Mark Trigger");
+		autoMelderString letters;
+		double time = NUMundefined;
+		auto isInDomain = [xmin, xmax] (double t) { return t >= xmin && t <= xmax; };   // a part of a file may contain marks outside the part
+		for (long i = 1; i <= numberOfSamples; i ++) {
+			unsigned long value = (long) status [i];
+			for (int byte = 1; byte <= numberOfStatusBits / 8; byte ++) {
+				unsigned long mask = byte == 1 ? 0x000000ff : 0x0000ff00;
+				char32 kar = byte == 1 ? (value & mask) : (value & mask) >> 8;
+				if (kar != U'\0' && kar != 20) {
+					MelderString_appendCharacter (& letters, kar);
+				} else if (letters. string [0] != U'\0') {
+					if (letters. string [0] == U'+') {
+						if (NUMdefined (time) && isInDomain (time)) {
+							try {
+								TextGrid_insertPoint (thee.get(), 1, time, U"");
+							} catch (MelderError) {
+								Melder_throw (U"Did not insert empty mark (", letters. string, U") on Mark tier.");
+							}
+							time = NUMundefined;   // defensive
+						}
+						time = Melder_atof (& letters. string [1]);
+						MelderString_empty (& letters);
+					} else {
+						if (! NUMdefined (time)) {
+							Melder_throw (U"Undefined time for label at sample ", i, U".");
+						}
+						if (isInDomain (time)) {
+							try {
+								if (Melder_nequ (letters. string, U"Trigger-", 8)) {
+									try {
+										TextGrid_insertPoint (thee.get(), 2, time, & letters. string [8]);
+									} catch (MelderError) {
+										Melder_clearError ();
+										trace (U"Duplicate trigger at ", time, U" seconds: ", & letters. string [8]);
+									}
+								} else {
+									TextGrid_insertPoint (thee.get(), 1, time, & letters. string [0]);
+								}
+							} catch (MelderError) {
+								Melder_throw (U"Did not insert mark (", letters. string, U") on Trigger tier.");
+							}
+						}
+						time = NUMundefined;   // crucial
+						MelderString_empty (& letters);
+					}
+				}
+			}
+		}
+		if (NUMdefined (time) && isInDomain (time)) {
+			TextGrid_insertPoint (thee.get(), 1, time, U"");
+			time = NUMundefined;   // defensive
+		}
+	} else {
+		thee = TextGrid_create (xmin, xmax,
+			numberOfStatusBits == 8 ? U"S1 S2 S3 S4 S5 S6 S7 S8" : U"S1 S2 S3 S4 S5 S6 S7 S8 S9 S10 S11 S12 S13 S14 S15 S16", U"");
+		for (int bit = 1; bit <= numberOfStatusBits; bit ++) {
+			unsigned long bitValue = 1 << (bit - 1);
+			IntervalTier tier = (IntervalTier) thy tiers->at [bit];
+			for (long i = 1; i <= numberOfSamples; i ++) {
+				unsigned long previousValue = i == 1 ? 0 : (long) status [i - 1];
+				unsigned long thisValue = (long) status [i];
+				if ((thisValue & bitValue) != (previousValue & bitValue)) {
+					if (i > 1)
+						TextGrid_insertBoundary (thee.get(), bit, x1 + (i - 1.5) * dx);
+					if ((thisValue & bitValue) != 0)
+						TextGrid_setIntervalText (thee.get(), bit, tier -> intervals.size, U"1");
+				}
+			}
+		}
+	}
+	return thee;
+}
+
 autoEEG EEG_readFromBdfFile (MelderFile file) {
+	return EEG_readPartFromBdfFile (file, 0.0, 0.0, 1, 0);
+}
+
+autoEEG EEG_readPartFromBdfFile (MelderFile file, double tmin, double tmax, long fromChannel, long toChannel) {
 	try {
 		autofile f = Melder_fopen (file, "rb");
-		char buffer [81];
-		fread (buffer, 1, 8, f); buffer [8] = '\0';
-		bool is24bit = buffer [0] == (char) 255;
-		fread (buffer, 1, 80, f); buffer [80] = '\0';
-		trace (U"Local subject identification: \"", Melder_peek8to32 (buffer), U"\"");
-		fread (buffer, 1, 80, f); buffer [80] = '\0';
-		trace (U"Local recording identification: \"", Melder_peek8to32 (buffer), U"\"");
-		fread (buffer, 1, 8, f); buffer [8] = '\0';
-		trace (U"Start date of recording: \"", Melder_peek8to32 (buffer), U"\"");
-		fread (buffer, 1, 8, f); buffer [8] = '\0';
-		trace (U"Start time of recording: \"", Melder_peek8to32 (buffer), U"\"");
-		fread (buffer, 1, 8, f); buffer [8] = '\0';
-		long numberOfBytesInHeaderRecord = atol (buffer);
+		char fixedHeader [256], buffer [81];
+		if (fread (fixedHeader, 1, 256, f) < 256)
+			Melder_throw (U"File too short for a header.");
+		bool is24bit = fixedHeader [0] == (char) 255;
+		trace (U"Local subject identification: \"", Melder_peek8to32 (getBdfHeaderField (fixedHeader, 8, 80, buffer)), U"\"");
+		trace (U"Local recording identification: \"", Melder_peek8to32 (getBdfHeaderField (fixedHeader, 88, 80, buffer)), U"\"");
+		trace (U"Start date of recording: \"", Melder_peek8to32 (getBdfHeaderField (fixedHeader, 168, 8, buffer)), U"\"");
+		trace (U"Start time of recording: \"", Melder_peek8to32 (getBdfHeaderField (fixedHeader, 176, 8, buffer)), U"\"");
+		long numberOfBytesInHeaderRecord = atol (getBdfHeaderField (fixedHeader, 184, 8, buffer));
 		trace (U"Number of bytes in header record: ", numberOfBytesInHeaderRecord);
-		fread (buffer, 1, 44, f); buffer [44] = '\0';
-		trace (U"Version of data format: \"", Melder_peek8to32 (buffer), U"\"");
-		fread (buffer, 1, 8, f); buffer [8] = '\0';
-		long numberOfDataRecords = strtol (buffer, nullptr, 10);
+		trace (U"Version of data format: \"", Melder_peek8to32 (getBdfHeaderField (fixedHeader, 192, 44, buffer)), U"\"");
+		long numberOfDataRecords = strtol (getBdfHeaderField (fixedHeader, 236, 8, buffer), nullptr, 10);
 		trace (U"Number of data records: ", numberOfDataRecords);
-		fread (buffer, 1, 8, f); buffer [8] = '\0';
-		double durationOfDataRecord = atof (buffer);
+		double durationOfDataRecord = atof (getBdfHeaderField (fixedHeader, 244, 8, buffer));
 		trace (U"Duration of a data record: ", durationOfDataRecord);
-		fread (buffer, 1, 4, f); buffer [4] = '\0';
-		long numberOfChannels = atol (buffer);
+		long numberOfChannels = atol (getBdfHeaderField (fixedHeader, 252, 4, buffer));
 		trace (U"Number of channels in data record: ", numberOfChannels);
+		if (numberOfChannels < 1)
+			Melder_throw (U"Number of channels (", numberOfChannels, U") should be positive.");
 		if (numberOfBytesInHeaderRecord != (numberOfChannels + 1) * 256)
 			Melder_throw (U"Number of bytes in header record (", numberOfBytesInHeaderRecord,
 				U") doesn't match number of channels (", numberOfChannels, U").");
+		if (numberOfDataRecords < 1 || ! (durationOfDataRecord > 0.0))
+			Melder_throw (U"Number of data records (", numberOfDataRecords, U") and their duration (", durationOfDataRecord, U") should be positive.");
+		/*
+			Read the channel part of the header at once.
+		*/
+		autoNUMvector <char> header (0L, 256 * numberOfChannels - 1);
+		if (fread (header.peek(), 1, (size_t) (256 * numberOfChannels), f) < (size_t) (256 * numberOfChannels))
+			Melder_throw (U"File too short for a header of ", numberOfChannels, U" channels.");
+		const char *labels = header.peek(), *physicalMinima = labels + 104 * numberOfChannels,
+			*digitalMinima = physicalMinima + 16 * numberOfChannels, *numbersOfSamples = digitalMinima + 96 * numberOfChannels;
 		autostring32vector channelNames (1, numberOfChannels);
+		autoNUMvector <double> physicalMinimum (1, numberOfChannels), digitalMinimum (1, numberOfChannels);
+		double samplingFrequency = NUMundefined;
+		long numberOfSamplesPerDataRecord = 0;
 		for (long ichannel = 1; ichannel <= numberOfChannels; ichannel ++) {
-			fread (buffer, 1, 16, f); buffer [16] = '\0';   // labels of the channels
+			getBdfHeaderField (labels, (ichannel - 1) * 16, 16, buffer);   // label of the channel
 			/*
 			 * Strip all final spaces.
 			 */
@@ -140,169 +344,109 @@ autoEEG EEG_readFromBdfFile (MelderFile file) {
 			}
 			channelNames [ichannel] = Melder_8to32 (buffer);
 			trace (U"Channel <<", channelNames [ichannel], U">>");
-		}
-		bool hasLetters = str32equ (channelNames [numberOfChannels], U"EDF Annotations");
-		double samplingFrequency = NUMundefined;
-		for (long channel = 1; channel <= numberOfChannels; channel ++) {
-			fread (buffer, 1, 80, f); buffer [80] = '\0';   // transducer type
-		}
-		for (long channel = 1; channel <= numberOfChannels; channel ++) {
-			fread (buffer, 1, 8, f); buffer [8] = '\0';   // physical dimension of channels
-		}
-		autoNUMvector <double> physicalMinimum (1, numberOfChannels);
-		for (long ichannel = 1; ichannel <= numberOfChannels; ichannel ++) {
-			fread (buffer, 1, 8, f); buffer [8] = '\0';
-			physicalMinimum [ichannel] = atof (buffer);
-		}
-		autoNUMvector <double> physicalMaximum (1, numberOfChannels);
-		for (long ichannel = 1; ichannel <= numberOfChannels; ichannel ++) {
-			fread (buffer, 1, 8, f); buffer [8] = '\0';
-			physicalMaximum [ichannel] = atof (buffer);
-		}
-		autoNUMvector <double> digitalMinimum (1, numberOfChannels);
-		for (long ichannel = 1; ichannel <= numberOfChannels; ichannel ++) {
-			fread (buffer, 1, 8, f); buffer [8] = '\0';
-			digitalMinimum [ichannel] = atof (buffer);
-		}
-		autoNUMvector <double> digitalMaximum (1, numberOfChannels);
-		for (long ichannel = 1; ichannel <= numberOfChannels; ichannel ++) {
-			fread (buffer, 1, 8, f); buffer [8] = '\0';
-			digitalMaximum [ichannel] = atof (buffer);
-		}
-		for (long channel = 1; channel <= numberOfChannels; channel ++) {
-			fread (buffer, 1, 80, f); buffer [80] = '\0';   // prefiltering
-		}
-		long numberOfSamplesPerDataRecord = 0;
-		for (long channel = 1; channel <= numberOfChannels; channel ++) {
-			fread (buffer, 1, 8, f); buffer [8] = '\0';   // number of samples in each data record
-			long numberOfSamplesInThisDataRecord = atol (buffer);
+			physicalMinimum [ichannel] = atof (getBdfHeaderField (physicalMinima, (ichannel - 1) * 8, 8, buffer));
+			digitalMinimum [ichannel] = atof (getBdfHeaderField (digitalMinima, (ichannel - 1) * 8, 8, buffer));
+			long numberOfSamplesInThisDataRecord = atol (getBdfHeaderField (numbersOfSamples, (ichannel - 1) * 8, 8, buffer));
 			if (samplingFrequency == NUMundefined) {
 				numberOfSamplesPerDataRecord = numberOfSamplesInThisDataRecord;
 				samplingFrequency = numberOfSamplesInThisDataRecord / durationOfDataRecord;
 			}
 			if (numberOfSamplesInThisDataRecord / durationOfDataRecord != samplingFrequency)
-				Melder_throw (U"Number of samples per data record in channel ", channel,
+				Melder_throw (U"Number of samples per data record in channel ", ichannel,
 					U" (", numberOfSamplesInThisDataRecord,
 					U") doesn't match sampling frequency of channel 1 (", samplingFrequency, U").");
 		}
-		for (long channel = 1; channel <= numberOfChannels; channel ++) {
-			fread (buffer, 1, 32, f); buffer [32] = '\0';   // reserved
-		}
-		double duration = numberOfDataRecords * durationOfDataRecord;
-		autoEEG him = EEG_create (0, duration);
-		his numberOfChannels = numberOfChannels;
-		autoSound me = Sound_createSimple (numberOfChannels, duration, samplingFrequency);
-		Melder_assert (my nx == numberOfSamplesPerDataRecord * numberOfDataRecords);
-		autoNUMvector <unsigned char> dataBuffer (0L, 3 * numberOfSamplesPerDataRecord - 1);
-		for (long record = 1; record <= numberOfDataRecords; record ++) {
-			for (long channel = 1; channel <= numberOfChannels; channel ++) {
-				double factor = channel == numberOfChannels ? 1.0 : physicalMinimum [channel] / digitalMinimum [channel];
-				if (channel < numberOfChannels - EEG_getNumberOfExtraSensors (him.get())) factor /= 1000000.0;
-				if (is24bit) {
-					fread (& dataBuffer [0], 3, numberOfSamplesPerDataRecord, f);
-					unsigned char *p = & dataBuffer [0];
-					for (long i = 1; i <= numberOfSamplesPerDataRecord; i ++) {
-						long sample = i + (record - 1) * numberOfSamplesPerDataRecord;
-						Melder_assert (sample <= my nx);
-						uint8_t lowByte = *p ++, midByte = *p ++, highByte = *p ++;
-						uint32_t externalValue = ((uint32_t) highByte << 16) | ((uint32_t) midByte << 8) | (uint32_t) lowByte;
-						if ((highByte & 128) != 0)   // is the 24-bit sign bit on?
-							externalValue |= 0xFF000000;   // extend negative sign to 32 bits
-						my z [channel] [sample] = (int32_t) externalValue * factor;
-					}
-				} else {
-					fread (& dataBuffer [0], 2, numberOfSamplesPerDataRecord, f);
-					unsigned char *p = & dataBuffer [0];
-					for (long i = 1; i <= numberOfSamplesPerDataRecord; i ++) {
-						long sample = i + (record - 1) * numberOfSamplesPerDataRecord;
-						Melder_assert (sample <= my nx);
-						uint8 lowByte = *p ++, highByte = *p ++;
-						uint16 externalValue = (uint16) ((uint16) highByte << 8) | (uint16) lowByte;
-						my z [channel] [sample] = (int16) externalValue * factor;
-					}
-				}
-			}
+		if (numberOfSamplesPerDataRecord < 1)
+			Melder_throw (U"Number of samples per data record (", numberOfSamplesPerDataRecord, U") should be positive.");
+		bool hasLetters = str32equ (channelNames [numberOfChannels], U"EDF Annotations");
+
+		/*
+			The part to read.
+		*/
+		const double duration = numberOfDataRecords * durationOfDataRecord, dx = 1.0 / samplingFrequency, x1 = 0.5 * dx;
+		const long numberOfSamples = numberOfSamplesPerDataRecord * numberOfDataRecords;
+		long firstSample = 1, lastSample = numberOfSamples;
+		if (tmin < tmax) {
+			if (tmin < 0.0) tmin = 0.0;
+			if (tmax > duration) tmax = duration;
+			firstSample = std::max (1L, (long) ceil ((tmin - x1) / dx) + 1);
+			lastSample = std::min (numberOfSamples, (long) floor ((tmax - x1) / dx) + 1);
+			if (firstSample > lastSample)
+				Melder_throw (U"The time range ", tmin, U" to ", tmax, U" seconds contains no samples of this ", duration, U"-second recording.");
+		} else {
+			tmin = 0.0;
+			tmax = duration;
 		}
-		int numberOfStatusBits = 8;
-		for (long i = 1; i <= my nx; i ++) {
-			unsigned long value = (long) my z [numberOfChannels] [i];
-			if (value & 0x0000FF00) {
-				numberOfStatusBits = 16;
-			}
+		if (toChannel == 0) toChannel = numberOfChannels;
+		if (fromChannel < 1 || fromChannel > toChannel || toChannel > numberOfChannels)
+			Melder_throw (U"The channel range ", fromChannel, U" to ", toChannel, U" should lie within 1 to ", numberOfChannels, U".");
+		const long numberOfSelectedChannels = toChannel - fromChannel + 1 + (toChannel < numberOfChannels);   // always including the status channel
+		autoNUMvector <long> selectedChannels (1, numberOfSelectedChannels);
+		for (long ichan = 1; ichan < numberOfSelectedChannels; ichan ++)
+			selectedChannels [ichan] = fromChannel + ichan - 1;
+		selectedChannels [numberOfSelectedChannels] = numberOfChannels;
+
+		autoEEG him = EEG_create (tmin, tmax);
+		his numberOfChannels = numberOfChannels;   // for now, because the channel types depend on it
+		his channelNames = channelNames.transfer();
+		if (numberOfSelectedChannels < numberOfChannels) {
+			/*
+				An EEG object does not store the kind of each channel, but derives it from the number of channels
+				(see EEG_getNumberOfCapElectrodes and EEG_getNumberOfExtraSensors),
+				so a subset is acceptable only if that derivation assigns every selected channel its original kind;
+				otherwise Filter, Detrend and the re-referencing commands would skip electrodes or include sensors.
+			*/
+			auto channelKind = [&] (long channel) {   // 1 = cap electrode, 2 = external electrode, 3 = extra sensor or status
+				return channel <= EEG_getNumberOfCapElectrodes (him.get()) ? 1 :
+					channel <= his numberOfChannels - EEG_getNumberOfExtraSensors (him.get()) ? 2 : 3;
+			};
+			autoNUMvector <int> originalKind (1, numberOfSelectedChannels);
+			for (long ichan = 1; ichan <= numberOfSelectedChannels; ichan ++)
+				originalKind [ichan] = channelKind (selectedChannels [ichan]);
+			const long numberOfCapElectrodes = EEG_getNumberOfCapElectrodes (him.get());
+			const long numberOfElectrodes = numberOfChannels - EEG_getNumberOfExtraSensors (him.get());
+			his numberOfChannels = numberOfSelectedChannels;
+			for (long ichan = 1; ichan <= numberOfSelectedChannels; ichan ++)
+				if (channelKind (ichan) != originalKind [ichan])
+					Melder_throw (U"Channels ", fromChannel, U" to ", toChannel, U" with the status channel do not form a valid EEG: "
+						U"the kinds of channel would change. Choose a range such as ",
+						numberOfCapElectrodes > 0 ? Melder_cat (U"1 to ", numberOfCapElectrodes, U" (the cap electrodes) or ") : U"",
+						U"1 to ", numberOfElectrodes, U" (all electrodes).");
+			his numberOfChannels = numberOfChannels;
 		}
-		autoTextGrid thee;
-		if (hasLetters) {
-			thee = TextGrid_create (0, duration, U"Mark Trigger", U"Mark Trigger");
-			autoMelderString letters;
-			double time = NUMundefined;
-			for (long i = 1; i <= my nx; i ++) {
-				unsigned long value = (long) my z [numberOfChannels] [i];
-				for (int byte = 1; byte <= numberOfStatusBits / 8; byte ++) {
-					unsigned long mask = byte == 1 ? 0x000000ff : 0x0000ff00;
-					char32 kar = byte == 1 ? (value & mask) : (value & mask) >> 8;
-					if (kar != U'\0' && kar != 20) {
-						MelderString_appendCharacter (& letters, kar);
-					} else if (letters. string [0] != U'\0') {
-						if (letters. string [0] == U'+') {
-							if (NUMdefined (time)) {
-								try {
-									TextGrid_insertPoint (thee.get(), 1, time, U"");
-								} catch (MelderError) {
-									Melder_throw (U"Did not insert empty mark (", letters. string, U") on Mark tier.");
-								}
-								time = NUMundefined;   // defensive
-							}
-							time = Melder_atof (& letters. string [1]);
-							MelderString_empty (& letters);
-						} else {
-							if (! NUMdefined (time)) {
-								Melder_throw (U"Undefined time for label at sample ", i, U".");
-							}
-							try {
-								if (Melder_nequ (letters. string, U"Trigger-", 8)) {
-									try {
-										TextGrid_insertPoint (thee.get(), 2, time, & letters. string [8]);
-									} catch (MelderError) {
-										Melder_clearError ();
-										trace (U"Duplicate trigger at ", time, U" seconds: ", & letters. string [8]);
-									}
-								} else {
-									TextGrid_insertPoint (thee.get(), 1, time, & letters. string [0]);
-								}
-							} catch (MelderError) {
-								Melder_throw (U"Did not insert mark (", letters. string, U") on Trigger tier.");
-							}
-							time = NUMundefined;   // crucial
-							MelderString_empty (& letters);
-						}
-					}
-				}
-			}
-			if (NUMdefined (time)) {
-				TextGrid_insertPoint (thee.get(), 1, time, U"");
-				time = NUMundefined;   // defensive
-			}
-		} else {
-			thee = TextGrid_create (0, duration,
-				numberOfStatusBits == 8 ? U"S1 S2 S3 S4 S5 S6 S7 S8" : U"S1 S2 S3 S4 S5 S6 S7 S8 S9 S10 S11 S12 S13 S14 S15 S16", U"");
-			for (int bit = 1; bit <= numberOfStatusBits; bit ++) {
-				unsigned long bitValue = 1 << (bit - 1);
-				IntervalTier tier = (IntervalTier) thy tiers->at [bit];
-				for (long i = 1; i <= my nx; i ++) {
-					unsigned long previousValue = i == 1 ? 0 : (long) my z [numberOfChannels] [i - 1];
-					unsigned long thisValue = (long) my z [numberOfChannels] [i];
-					if ((thisValue & bitValue) != (previousValue & bitValue)) {
-						double time = i == 1 ? 0.0 : my x1 + (i - 1.5) * my dx;
-						if (time != 0.0)
-							TextGrid_insertBoundary (thee.get(), bit, time);
-						if ((thisValue & bitValue) != 0)
-							TextGrid_setIntervalText (thee.get(), bit, tier -> intervals.size, U"1");
-					}
-				}
-			}
+		autoNUMvector <double> factor (1, numberOfChannels);
+		for (long channel = 1; channel <= numberOfChannels; channel ++) {
+			factor [channel] = channel == numberOfChannels ? 1.0 : physicalMinimum [channel] / digitalMinimum [channel];
+			if (channel < numberOfChannels - EEG_getNumberOfExtraSensors (him.get())) factor [channel] /= 1000000.0;
 		}
+		autoSound me = Sound_create (numberOfSelectedChannels, tmin, tmax, lastSample - firstSample + 1, dx, x1 + (firstSample - 1) * dx);
+		const long firstRecord = (firstSample - 1) / numberOfSamplesPerDataRecord + 1;
+		const long lastRecord = (lastSample - 1) / numberOfSamplesPerDataRecord + 1;
+		const long numberOfStatusSamples = (lastRecord - firstRecord + 1) * numberOfSamplesPerDataRecord;
+		autoNUMvector <double> status (1, numberOfStatusSamples);
+		BdfReading reading;
+		reading. is24bit = is24bit;
+		reading. numberOfChannels = numberOfChannels;
+		reading. numberOfSamplesPerDataRecord = numberOfSamplesPerDataRecord;
+		reading. numberOfBytesPerChannelPerDataRecord = numberOfSamplesPerDataRecord * (is24bit ? 3 : 2);
+		reading. numberOfBytesPerDataRecord = numberOfChannels * reading. numberOfBytesPerChannelPerDataRecord;
+		reading. factor = factor.peek();
+		reading. numberOfSelectedChannels = numberOfSelectedChannels;
+		reading. selectedChannels = selectedChannels.peek();
+		reading. firstSample = firstSample;
+		reading. lastSample = lastSample;
+		reading. z = my z;
+		reading. firstRecord = firstRecord;
+		reading. lastRecord = lastRecord;
+		reading. status = status.peek();
+		if (! BdfReading_readMapped (& reading, f, (off_t) numberOfBytesInHeaderRecord))
+			BdfReading_readBlocks (& reading, f, (off_t) numberOfBytesInHeaderRecord);
 		f.close (file);
-		his channelNames = channelNames.transfer();
+		const long statusOffset = firstSample - (firstRecord - 1) * numberOfSamplesPerDataRecord - 1;
+		NUMvector_copyElements (& status [statusOffset], my z [numberOfSelectedChannels], 1, my nx);
+		autoTextGrid thee = hasLetters ?
+			BdfStatus_to_TextGrid (status.peek(), numberOfStatusSamples, x1 + (firstRecord - 1) * numberOfSamplesPerDataRecord * dx, dx, tmin, tmax, true) :
+			BdfStatus_to_TextGrid (& status [statusOffset], my nx, my x1, dx, tmin, tmax, false);
 		his sound = me.move();
 		his textgrid = thee.move();
 		if (EEG_getNumberOfCapElectrodes (him.get()) == 32) {
@@ -404,12 +548,70 @@ autoEEG EEG_readFromBdfFile (MelderFile file) {
 			EEG_setChannelName (him.get(), 63, U"PO4");
 			EEG_setChannelName (him.get(), 64, U"O2");
 		}
+		if (numberOfSelectedChannels < numberOfChannels) {
+			autostring32vector allNames (his channelNames, 1, numberOfChannels);
+			autostring32vector selectedNames (1, numberOfSelectedChannels);
+			for (long ichan = 1; ichan <= numberOfSelectedChannels; ichan ++)
+				selectedNames [ichan] = Melder_dup (allNames [selectedChannels [ichan]]);
+			his channelNames = selectedNames.transfer();
+			his numberOfChannels = numberOfSelectedChannels;
+		}
 		return him;
 	} catch (MelderError) {
 		Melder_throw (U"BDF file not read.");
 	}
 }
 
+/*
+	The channel operations below work in place on the channels of the sound,
+	with the electrode channels divided over threads.
+*/
+struct EEG_ChannelChunk {
+	double **z;
+	long firstChannel, lastChannel;
+	const std::function <void (double *channel, double *buffer, NUMfft_Table fftTable)> *process;
+	std::vector <double> buffer;   // room for the thread's own use, allocated on the calling thread
+	autoNUMfft_Table fftTable;   // likewise: NUMfft uses the table as scratch, so threads cannot share one
+};
+
+static MelderThread_RETURN_TYPE EEG_ChannelChunk_run (EEG_ChannelChunk *me) {
+	for (long ichan = my firstChannel; ichan <= my lastChannel; ichan ++)
+		(*my process) (my z [ichan], my buffer.data(), & my fftTable);
+	MelderThread_RETURN;
+}
+
+#define EEG_MAXIMUM_TOTAL_BUFFER_SIZE  (128L * 1024 * 1024)   /* numbers, summed over the threads */
+
+/*
+	Call process (channel, buffer, fftTable) for every electrode channel (not for the extra sensors),
+	where channel [1..nx] are the samples of the channel, buffer [1..bufferSize] is scratch space,
+	and fftTable has been initialized for transforms of fftSize points if fftSize > 0;
+	fewer threads are used if their buffers would be large.
+*/
+static void EEG_processElectrodeChannels (EEG me, long bufferSize, long fftSize,
+	std::function <void (double *channel, double *buffer, NUMfft_Table fftTable)> process)
+{
+	const long numberOfElectrodeChannels = my numberOfChannels - EEG_getNumberOfExtraSensors (me);
+	if (numberOfElectrodeChannels < 1) return;
+	long numberOfThreads = std::min ((long) MelderThread_getNumberOfProcessors (), numberOfElectrodeChannels);
+	if (bufferSize > 0)
+		numberOfThreads = std::max (1L, std::min (numberOfThreads, EEG_MAXIMUM_TOTAL_BUFFER_SIZE / bufferSize));
+	long numberOfChannelsPerThread = (numberOfElectrodeChannels - 1) / numberOfThreads + 1;
+	numberOfThreads = (numberOfElectrodeChannels - 1) / numberOfChannelsPerThread + 1;   // no empty chunks
+	std::vector <EEG_ChannelChunk> chunks ((size_t) numberOfThreads);
+	for (long ithread = 1; ithread <= numberOfThreads; ithread ++) {
+		EEG_ChannelChunk *chunk = & chunks [(size_t) ithread - 1];
+		chunk -> z = my sound -> z;
+		chunk -> firstChannel = (ithread - 1) * numberOfChannelsPerThread + 1;
+		chunk -> lastChannel = std::min (ithread * numberOfChannelsPerThread, numberOfElectrodeChannels);
+		chunk -> process = & process;
+		chunk -> buffer. resize ((size_t) bufferSize + 1);   // base 1
+		if (fftSize > 0)
+			NUMfft_Table_init (& chunk -> fftTable, fftSize);
+	}
+	MelderThread_run (EEG_ChannelChunk_run, chunks.data(), (int) numberOfThreads);
+}
+
 static void detrend (double *a, long numberOfSamples) {
 	double firstValue = a [1], lastValue = a [numberOfSamples];
 	a [1] = a [numberOfSamples] = 0.0;
@@ -419,31 +621,48 @@ static void detrend (double *a, long numberOfSamples) {
 }
 
 void EEG_detrend (EEG me) {
-	for (long ichan = 1; ichan <= my numberOfChannels - EEG_getNumberOfExtraSensors (me); ichan ++) {
-		detrend (my sound -> z [ichan], my sound -> nx);
-	}
+	const long numberOfSamples = my sound -> nx;
+	EEG_processElectrodeChannels (me, 0, 0, [numberOfSamples] (double *channel, double *, NUMfft_Table) {
+		detrend (channel, numberOfSamples);
+	});
 }
 
 void EEG_filter (EEG me, double lowFrequency, double lowWidth, double highFrequency, double highWidth, bool doNotch50Hz) {
 	try {
-/*
-	long nsampFFT = 1;
-	while (nsampFFT < my sound -> nx)
-		nsampFFT *= 2;
-	autoNUMfft_Table fftTable;
-	NUMfft_Table_init (& fftTable, nsampFFT);
-*/
-		for (long ichan = 1; ichan <= my numberOfChannels - EEG_getNumberOfExtraSensors (me); ichan ++) {
-			autoSound channel = Sound_extractChannel (my sound.get(), ichan);
-			autoSpectrum spec = Sound_to_Spectrum (channel.get(), true);
-			Spectrum_passHannBand (spec.get(), lowFrequency, 0.0, lowWidth);
-			Spectrum_passHannBand (spec.get(), 0.0, highFrequency, highWidth);
-			if (doNotch50Hz) {
-				Spectrum_stopHannBand (spec.get(), 48.0, 52.0, 1.0);
-			}
-			autoSound him = Spectrum_to_Sound (spec.get());
-			NUMvector_copyElements (his z [1], my sound -> z [ichan], 1, my sound -> nx);
+		/*
+			The filter is the one of Sound_to_Spectrum, Spectrum_passHannBand, Spectrum_stopHannBand and Spectrum_to_Sound
+			for each channel, but without creating those objects: the gains of the bands are computed once,
+			and every thread transforms its channels in a single buffer with its own Fourier table.
+		*/
+		const long numberOfSamples = my sound -> nx;
+		long nsampFFT = 2;
+		while (nsampFFT < numberOfSamples)
+			nsampFFT *= 2;
+		autoSpectrum gain = Spectrum_create (0.5 / my sound -> dx, nsampFFT / 2 + 1);
+		gain -> dx = 1.0 / (my sound -> dx * nsampFFT);   // as in Sound_to_Spectrum
+		for (long i = 1; i <= gain -> nx; i ++)
+			gain -> z [1] [i] = 1.0 / nsampFFT;   // including the scaling of the inverse transform
+		Spectrum_passHannBand (gain.get(), lowFrequency, 0.0, lowWidth);
+		Spectrum_passHannBand (gain.get(), 0.0, highFrequency, highWidth);
+		if (doNotch50Hz) {
+			Spectrum_stopHannBand (gain.get(), 48.0, 52.0, 1.0);
 		}
+		const double *g = gain -> z [1];
+		const long numberOfFrequencies = gain -> nx;
+		EEG_processElectrodeChannels (me, nsampFFT, nsampFFT, [&] (double *channel, double *data, NUMfft_Table fftTable) {
+			NUMvector_copyElements (channel, data, 1, numberOfSamples);
+			for (long i = numberOfSamples + 1; i <= nsampFFT; i ++)
+				data [i] = 0.0;
+			NUMfft_forward (fftTable, data);
+			data [1] *= g [1];
+			for (long i = 2; i < numberOfFrequencies; i ++) {
+				data [i + i - 2] *= g [i];
+				data [i + i - 1] *= g [i];
+			}
+			data [nsampFFT] *= g [numberOfFrequencies];
+			NUMfft_backward (fftTable, data);
+			NUMvector_copyElements (data, channel, 1, numberOfSamples);
+		});
 	} catch (MelderError) {
 		Melder_throw (me, U": not filtered.");
 	}
@@ -472,6 +691,17 @@ void EEG_setExternalElectrodeNames (EEG me,
 	EEG_setChannelName (me, firstExternalElectrode + 7, nameExg8);
 }
 
+/*
+	Subtract reference [1..nx] from every electrode channel.
+*/
+static void EEG_subtractFromElectrodeChannels (EEG me, const double *reference) {
+	const long numberOfSamples = my sound -> nx;
+	EEG_processElectrodeChannels (me, 0, 0, [reference, numberOfSamples] (double *channel, double *, NUMfft_Table) {
+		for (long isamp = 1; isamp <= numberOfSamples; isamp ++)
+			channel [isamp] -= reference [isamp];
+	});
+}
+
 void EEG_subtractReference (EEG me, const char32 *channelNumber1_text, const char32 *channelNumber2_text) {
 	long channelNumber1 = EEG_getChannelNumber (me, channelNumber1_text);
 	if (channelNumber1 == 0)
@@ -479,14 +709,12 @@ void EEG_subtractReference (EEG me, const char32 *channelNumber1_text, const cha
 	long channelNumber2 = EEG_getChannelNumber (me, channelNumber2_text);
 	if (channelNumber2 == 0 && channelNumber2_text [0] != '\0')
 		Melder_throw (me, U": no channel named \"", channelNumber2_text, U"\".");
-	const long numberOfElectrodeChannels = my numberOfChannels - EEG_getNumberOfExtraSensors (me);
+	autoNUMvector <double> reference (1, my sound -> nx);
 	for (long isamp = 1; isamp <= my sound -> nx; isamp ++) {
-		double referenceValue = channelNumber2 == 0 ? my sound -> z [channelNumber1] [isamp] :
+		reference [isamp] = channelNumber2 == 0 ? my sound -> z [channelNumber1] [isamp] :
 			0.5 * (my sound -> z [channelNumber1] [isamp] + my sound -> z [channelNumber2] [isamp]);
-		for (long ichan = 1; ichan <= numberOfElectrodeChannels; ichan ++) {
-			my sound -> z [ichan] [isamp] -= referenceValue;
-		}
 	}
+	EEG_subtractFromElectrodeChannels (me, reference.peek());
 }
 
 void EEG_subtractMeanChannel (EEG me, long fromChannel, long toChannel) {
@@ -496,17 +724,15 @@ void EEG_subtractMeanChannel (EEG me, long fromChannel, long toChannel) {
 		Melder_throw (U"No channel ", toChannel, U".");
 	if (fromChannel > toChannel)
 		Melder_throw (U"Channel range cannot run from ", fromChannel, U" to ", toChannel, U". Please reverse.");
-	const long numberOfElectrodeChannels = my numberOfChannels - EEG_getNumberOfExtraSensors (me);
+	autoNUMvector <double> reference (1, my sound -> nx);
 	for (long isamp = 1; isamp <= my sound -> nx; isamp ++) {
 		double referenceValue = 0.0;
 		for (long ichan = fromChannel; ichan <= toChannel; ichan ++) {
 			referenceValue += my sound -> z [ichan] [isamp];
 		}
-		referenceValue /= (toChannel - fromChannel + 1);
-		for (long ichan = 1; ichan <= numberOfElectrodeChannels; ichan ++) {
-			my sound -> z [ichan] [isamp] -= referenceValue;
-		}
+		reference [isamp] = referenceValue / (toChannel - fromChannel + 1);
 	}
+	EEG_subtractFromElectrodeChannels (me, reference.peek());
 }
 
 void EEG_setChannelToZero (EEG me, long channelNumber) {
@@ -27,6 +27,15 @@
 autoEEG EEG_create (double tmin, double tmax);
 
 autoEEG EEG_readFromBdfFile (MelderFile file);
+autoEEG EEG_readPartFromBdfFile (MelderFile file, double tmin, double tmax, long fromChannel, long toChannel);
+/*
+	Read only the samples between tmin and tmax (the whole recording if tmin >= tmax),
+	and only channels fromChannel through toChannel (through the last if toChannel is 0),
+	always followed by the status channel, from which the TextGrid is made.
+	The channel range must keep every channel's kind (cap electrode, external electrode, other sensor),
+	as derived from the number of channels; otherwise an error is thrown.
+	Times are preserved.
+*/
 
 autoEEG EEGs_concatenate (OrderedOf<structEEG>* me);
 
@@ -25,6 +25,25 @@
 
 // MARK: - EEG
 
+// MARK: Open
+
+FORM (NEW1_EEG_readPartFromBdfFile, U"Read EEG from part of BDF file", nullptr) {
+	LABEL (U"", U"BDF or EDF file:")
+	TEXTFIELD4 (bdfFile, U"BDF file", U"")
+	REALVAR (fromTime, U"left Time range (s)", U"0.0")
+	REALVAR (toTime, U"right Time range (s)", U"0.0 (= all)")
+	NATURALVAR (fromChannel, U"left Channel range", U"1")
+	INTEGERVAR (toChannel, U"right Channel range", U"0 (= all)")
+	LABEL (U"", U"The status channel is always read.")
+	OK
+DO
+	structMelderFile file = { 0 };
+	Melder_relativePathToFile (bdfFile, & file);
+	CREATE_ONE
+		autoEEG result = EEG_readPartFromBdfFile (& file, fromTime, toTime, fromChannel, toChannel);
+	CREATE_ONE_END (MelderFile_name (& file))
+}
+
 // MARK: Help
 
 DIRECT (HELP_EEG_help) {
@@ -719,6 +738,8 @@ void praat_EEG_init () {
 
 	Data_recognizeFileType (bdfFileRecognizer);
 
+	praat_addMenuCommand (U"Objects", U"Open", U"Read EEG from part of BDF file...", nullptr, 0, NEW1_EEG_readPartFromBdfFile);
+
 	praat_addAction1 (classEEG, 0, U"EEG help", nullptr, 0, HELP_EEG_help);
 	praat_addAction1 (classEEG, 1, U"View & Edit", nullptr, praat_ATTRACTIVE, WINDOW_EEG_viewAndEdit);
 	praat_addAction1 (classEEG, 0, U"Query -", nullptr, 0, nullptr);
@@ -39,6 +39,8 @@
 #include "PatternList.h"
 #include "Collection.h"
 #include "Categories.h"
+#include "MelderThread.h"
+#include <vector>
 
 static void bookkeeping (FFNet me);
 
@@ -439,25 +441,237 @@ void FFNet_computeDerivative (FFNet me) {
 	}
 }
 
+/*
+	Propagation of many patterns at once.
+	The patterns are divided into chunks that are handled on separate threads; the number of chunks depends only
+	on the number of patterns, and the costs and derivatives of the chunks are summed in chunk order,
+	so that the outcome does not depend on the number of processors.
+	Within a chunk, the patterns go through the network in blocks of FFNet_BLOCK_SIZE:
+	each row of weights is applied to all patterns of a block before the next row is needed.
+	For each pattern the sums are taken in the same order as in FFNet_propagate, FFNet_computeError and FFNet_computeDerivative.
+*/
+#define FFNet_BLOCK_SIZE  64
+#define FFNet_MINIMUM_CHUNK_SIZE  2048
+#define FFNet_MAXIMUM_NUMBER_OF_CHUNKS  64
+
+struct FFNet_PatternChunk {
+	FFNet net;
+	double **input, **target, **output;
+	long firstPattern, lastPattern, outputLayer;
+	bool computeDerivative;
+	double cost;
+	double *dw;   // [1..nWeights]
+};
+
+static MelderThread_RETURN_TYPE FFNet_PatternChunk_run (FFNet_PatternChunk *me) {
+	FFNet net = my net;
+	const long nLayers = net -> nLayers;
+	const long *nUnits = net -> nUnitsInLayer;
+	/*
+		Per layer, the activities of a block of patterns are stored unit after unit (the bias node last),
+		so that the innermost loops run over the patterns of the block.
+	*/
+	const long B = FFNet_BLOCK_SIZE;
+	std::vector <std::vector <double>> activity ((size_t) nLayers + 1), deriv ((size_t) nLayers + 1), error ((size_t) nLayers + 1);
+	std::vector <double *> weights ((size_t) nLayers + 1);
+	std::vector <double> patternActivity;   // the activities of one layer, pattern after pattern
+	for (long layer = 0; layer <= nLayers; layer ++) {
+		activity [layer]. assign ((size_t) ((nUnits [layer] + 1) * B), 1.0);
+		if (layer > 0) {
+			deriv [layer]. assign ((size_t) (nUnits [layer] * B), 0.0);
+			error [layer]. assign ((size_t) (nUnits [layer] * B), 0.0);
+			weights [layer] = & net -> w [net -> wFirst [FFNet_getNodeNumberFromUnitNumber (net, 1, layer)]];
+		}
+	}
+	if (my computeDerivative) {
+		long maximumWidth = 0;
+		for (long layer = 0; layer < nLayers; layer ++) {
+			if (nUnits [layer] + 1 > maximumWidth) maximumWidth = nUnits [layer] + 1;
+		}
+		patternActivity. resize ((size_t) (maximumWidth * B));
+	}
+	my cost = 0.0;
+	for (long firstPattern = my firstPattern; firstPattern <= my lastPattern; firstPattern += B) {
+		const long nb = std::min (B, my lastPattern - firstPattern + 1);
+		for (long ib = 0; ib < nb; ib ++) {
+			const double *input = my input [firstPattern + ib];
+			for (long i = 0; i < nUnits [0]; i ++)
+				activity [0] [(size_t) (i * B + ib)] = input [i + 1];
+		}
+		for (long layer = 1; layer <= nLayers; layer ++) {
+			const long nFrom = nUnits [layer - 1] + 1, nTo = nUnits [layer];
+			const bool isLinear = ( layer == nLayers && net -> outputsAreLinear );
+			for (long i = 0; i < nTo; i ++) {
+				const double *w = weights [layer] + i * nFrom;
+				double *act = & activity [layer] [(size_t) (i * B)];
+				double *d = & deriv [layer] [(size_t) (i * B)];
+				for (long ib = 0; ib < nb; ib ++)
+					act [ib] = 0.0;
+				for (long j = 0; j < nFrom; j ++) {
+					const double wj = w [j];
+					const double *a = & activity [layer - 1] [(size_t) (j * B)];
+					for (long ib = 0; ib < nb; ib ++)
+						act [ib] += wj * a [ib];
+				}
+				if (isLinear) {
+					for (long ib = 0; ib < nb; ib ++)
+						d [ib] = 1.0;
+				} else {
+					for (long ib = 0; ib < nb; ib ++)
+						act [ib] = net -> nonLinearity (net, act [ib], & d [ib]);
+				}
+			}
+		}
+		if (my output) {
+			const long n = nUnits [my outputLayer];
+			for (long ib = 0; ib < nb; ib ++) {
+				double *output = my output [firstPattern + ib];
+				for (long i = 0; i < n; i ++)
+					output [i + 1] = activity [my outputLayer] [(size_t) (i * B + ib)];
+			}
+		}
+		if (! my target)
+			continue;
+		/*
+			Costs and errors at the output layer, as in minimumSquaredError and minimumCrossEntropy.
+		*/
+		const long nOutputs = nUnits [nLayers];
+		for (long ib = 0; ib < nb; ib ++) {
+			const double *target = my target [firstPattern + ib];
+			double cost = 0.0;
+			for (long i = 0; i < nOutputs; i ++) {
+				const size_t cell = (size_t) (i * B + ib);
+				const double a = activity [nLayers] [cell];
+				if (net -> costFunctionType == 2) {
+					double t1 = 1.0 - target [i + 1];
+					double o1 = 1.0 - a;
+					cost -= target [i + 1] * log (a) + t1 * log (o1);
+					error [nLayers] [cell] = -t1 / o1 + target [i + 1] / a;
+				} else {
+					double e = error [nLayers] [cell] = target [i + 1] - a;
+					cost += e * e;
+				}
+				error [nLayers] [cell] *= deriv [nLayers] [cell];
+			}
+			my cost += net -> costFunctionType == 2 ? cost : 0.5 * cost;
+		}
+		if (! my computeDerivative)
+			continue;
+		/*
+			Backpropagation of the errors to the hidden layers.
+		*/
+		for (long layer = nLayers; layer > 1; layer --) {
+			const long nFrom = nUnits [layer - 1] + 1, nTo = nUnits [layer];
+			for (long j = 0; j < nFrom - 1; j ++) {
+				double *eFrom = & error [layer - 1] [(size_t) (j * B)];
+				for (long ib = 0; ib < nb; ib ++)
+					eFrom [ib] = 0.0;
+				for (long i = nTo - 1; i >= 0; i --) {
+					const double wij = weights [layer] [i * nFrom + j];
+					const double *eTo = & error [layer] [(size_t) (i * B)];
+					for (long ib = 0; ib < nb; ib ++)
+						eFrom [ib] += eTo [ib] * wij;
+				}
+				const double *d = & deriv [layer - 1] [(size_t) (j * B)];
+				for (long ib = 0; ib < nb; ib ++)
+					eFrom [ib] *= d [ib];
+			}
+		}
+		/*
+			Derivatives with respect to the weights, summed over the patterns in pattern order.
+		*/
+		for (long layer = 1; layer <= nLayers; layer ++) {
+			const long nFrom = nUnits [layer - 1] + 1, nTo = nUnits [layer];
+			for (long ib = 0; ib < nb; ib ++) {
+				for (long j = 0; j < nFrom; j ++)
+					patternActivity [(size_t) (ib * nFrom + j)] = activity [layer - 1] [(size_t) (j * B + ib)];
+			}
+			double *dwLayer = my dw + (weights [layer] - & net -> w [1]) + 1;
+			for (long i = 0; i < nTo; i ++) {
+				double *dw = dwLayer + i * nFrom;
+				const double *e = & error [layer] [(size_t) (i * B)];
+				for (long ib = 0; ib < nb; ib ++) {
+					const double minusError = - e [ib];
+					const double *a = & patternActivity [(size_t) (ib * nFrom)];
+					for (long j = 0; j < nFrom; j ++)
+						dw [j] += minusError * a [j];
+				}
+			}
+		}
+	}
+	MelderThread_RETURN;
+}
+
+double FFNet_propagatePatterns (FFNet me, double **input, long numberOfPatterns, double **target, bool computeDerivative, double **output, long outputLayer) {
+	if (numberOfPatterns < 1)
+		return 0.0;
+	long numberOfChunks = (numberOfPatterns - 1) / FFNet_MINIMUM_CHUNK_SIZE + 1;
+	if (numberOfChunks > FFNet_MAXIMUM_NUMBER_OF_CHUNKS) numberOfChunks = FFNet_MAXIMUM_NUMBER_OF_CHUNKS;
+	const long chunkSize = (numberOfPatterns - 1) / numberOfChunks + 1;
+	numberOfChunks = (numberOfPatterns - 1) / chunkSize + 1;
+	const long numberOfProcessors = std::min ((long) MelderThread_getNumberOfProcessors (), numberOfChunks);
+	const bool needsDerivative = target && computeDerivative;
+
+	std::vector <FFNet_PatternChunk> chunks ((size_t) numberOfChunks);
+	for (long ichunk = 0; ichunk < numberOfChunks; ichunk ++) {
+		FFNet_PatternChunk *chunk = & chunks [(size_t) ichunk];
+		chunk -> net = me;
+		chunk -> input = input;
+		chunk -> target = target;
+		chunk -> output = output;
+		chunk -> firstPattern = ichunk * chunkSize + 1;
+		chunk -> lastPattern = std::min ((ichunk + 1) * chunkSize, numberOfPatterns);
+		chunk -> outputLayer = outputLayer;
+		chunk -> computeDerivative = needsDerivative;
+		chunk -> cost = 0.0;
+		chunk -> dw = nullptr;
+	}
+	std::vector <std::vector <double>> dw ((size_t) (needsDerivative ? numberOfProcessors : 0));
+	double cost = 0.0;
+	for (long firstChunk = 0; firstChunk < numberOfChunks; firstChunk += numberOfProcessors) {
+		const long numberOfThreads = std::min (numberOfProcessors, numberOfChunks - firstChunk);
+		if (needsDerivative) {
+			for (long ithread = 0; ithread < numberOfThreads; ithread ++) {
+				dw [(size_t) ithread]. assign ((size_t) my nWeights + 1, 0.0);
+				chunks [(size_t) (firstChunk + ithread)]. dw = dw [(size_t) ithread]. data();
+			}
+		}
+		MelderThread_run (FFNet_PatternChunk_run, & chunks [(size_t) firstChunk], (int) numberOfThreads);
+		for (long ithread = 0; ithread < numberOfThreads; ithread ++) {
+			cost += chunks [(size_t) (firstChunk + ithread)]. cost;
+			if (needsDerivative) {
+				const double *chunkDw = dw [(size_t) ithread]. data();
+				for (long k = 1; k <= my nWeights; k ++)
+					my dw [k] += chunkDw [k];
+			}
+		}
+	}
+	return cost;
+}
+
 /******* end operation ******************************************************/
 
 long FFNet_getWinningUnit (FFNet me, int labeling) {
-	long pos = 1, k = my nNodes - my nOutputs;
+	return FFNet_getWinningUnitOfOutput (me, & my activity[my nNodes - my nOutputs], labeling);
+}
+
+long FFNet_getWinningUnitOfOutput (FFNet me, const double output[], int labeling) {
+	long pos = 1;
 	if (labeling == 2) { /* stochastic */
 		double sum = 0.0;
 		for (long i = 1; i <= my nOutputs; i++) {
-			sum += my activity[k + i];
+			sum += output[i];
 		}
 		double random = NUMrandomUniform (0.0, sum);
 		for (pos = my nOutputs; pos >= 2; pos--) {
-			if (random > (sum -= my activity[k + pos])) {
+			if (random > (sum -= output[pos])) {
 				break;
 			}
 		}
 	} else { /* winner-takes-all */
-		double max = my activity[k + 1];
-		for (long i = 2; i <= my nOutputs; i++) if (my activity[k + i] > max) {
-				max = my activity[k + i];
+		double max = output[1];
+		for (long i = 2; i <= my nOutputs; i++) if (output[i] > max) {
+				max = output[i];
 				pos = i;
 			}
 	}
@@ -174,10 +174,19 @@ void FFNet_computeDerivative (FFNet me);
 /* step (4) compute derivative in my dwi */
 /* Precondition: step (3) */
 
+double FFNet_propagatePatterns (FFNet me, double **input, long numberOfPatterns, double **target, bool computeDerivative, double **output, long outputLayer);
+/* steps (1) to (4) for input[1..numberOfPatterns][1..nInputs] at once, on several threads */
+/* if output != nullptr the activities in outputLayer are copied into output[1..numberOfPatterns] */
+/* if target != nullptr returns the summed cost, and if computeDerivative adds the summed derivatives to my dw */
+/* my activity, my error and my dwi are not used */
+
 long FFNet_getWinningUnit (FFNet me, int labeling);
 /* labeling = 1 : winner-takes-all */
 /* labeling = 2 : stochastic */
 
+long FFNet_getWinningUnitOfOutput (FFNet me, const double output[], int labeling);
+/* as FFNet_getWinningUnit, but for the activities output[1..nOutputs] */
+
 void FFNet_selectAllWeights (FFNet me);
 
 void FFNet_selectBiasesInLayer (FFNet me, long layer);
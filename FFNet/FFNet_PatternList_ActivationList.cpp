@@ -30,7 +30,6 @@
 static double func (Daata object, const double p[]) {
 	FFNet me = (FFNet) object;
 	Minimizer thee = my minimizer.get();
-	double fp = 0.0;
 
 	for (long j = 1, k = 1; k <= my nWeights; k++) {
 		my dw[k] = 0.0;
@@ -38,15 +37,7 @@ static double func (Daata object, const double p[]) {
 			my w[k] = p[j++];
 		}
 	}
-	for (long i = 1; i <= my nPatterns; i++) {
-		FFNet_propagate (me, my inputPattern[i], nullptr);
-		fp += FFNet_computeError (me, my targetActivation[i]);
-		FFNet_computeDerivative (me);
-		/* derivative (cumulative) */
-		for (long k = 1; k <= my nWeights; k++) {
-			my dw[k] += my dwi[k];
-		}
-	}
+	double fp = FFNet_propagatePatterns (me, my inputPattern, my nPatterns, my targetActivation, true, nullptr, 0);   // derivative (cumulative) in my dw
 	thy funcCalls++;
 	return fp;
 }
@@ -156,12 +147,7 @@ double FFNet_PatternList_ActivationList_getCosts_total (FFNet me, PatternList p,
 		_FFNet_PatternList_ActivationList_checkDimensions (me, p, a);
 		FFNet_setCostFunction (me, costFunctionType);
 
-		double cost = 0.0;
-		for (long i = 1; i <= p -> ny; i++) {
-			FFNet_propagate (me, p -> z[i], nullptr);
-			cost += FFNet_computeError (me, a -> z[i]);
-		}
-		return cost;
+		return FFNet_propagatePatterns (me, p -> z, p -> ny, a -> z, false, nullptr, 0);
 	} catch (MelderError) {
 		return NUMundefined;
 	}
@@ -186,9 +172,7 @@ autoActivationList FFNet_PatternList_to_ActivationList (FFNet me, PatternList p,
 		long nPatterns = p -> ny;
 		autoActivationList thee = ActivationList_create (nPatterns, my nUnitsInLayer[layer]);
 
-		for (long i = 1; i <= nPatterns; i++) {
-			FFNet_propagateToLayer (me, p -> z[i], thy z[i], layer);
-		}
+		FFNet_propagatePatterns (me, p -> z, nPatterns, nullptr, false, thy z, layer);
 		return thee;
 	} catch (MelderError) {
 		Melder_throw (me, U": no ActivationList created.");
@@ -84,11 +84,20 @@ autoCategories FFNet_PatternList_to_Categories (FFNet me, PatternList thee, int
 
 		autoCategories him = Categories_create ();
 
-		for (long k = 1; k <= thy ny; k ++) {
-			FFNet_propagate (me, thy z [k], nullptr);
-			long index = FFNet_getWinningUnit (me, labeling);
-			autoSimpleString item = Data_copy (my outputCategories->at [index]);
-			his addItem_move (item.move());
+		/*
+			The output activities are computed for many patterns at a time;
+			the winners are chosen in pattern order, because stochastic labeling draws random numbers.
+		*/
+		const long numberOfPatternsPerStep = 65536;
+		autoNUMmatrix <double> output (1, thy ny < numberOfPatternsPerStep ? thy ny : numberOfPatternsPerStep, 1, my nOutputs);
+		for (long first = 1; first <= thy ny; first += numberOfPatternsPerStep) {
+			const long numberOfPatterns = thy ny - first + 1 < numberOfPatternsPerStep ? thy ny - first + 1 : numberOfPatternsPerStep;
+			FFNet_propagatePatterns (me, thy z + (first - 1), numberOfPatterns, nullptr, false, output.peek(), my nLayers);
+			for (long k = 1; k <= numberOfPatterns; k ++) {
+				long index = FFNet_getWinningUnitOfOutput (me, output [k], labeling);
+				autoSimpleString item = Data_copy (my outputCategories->at [index]);
+				his addItem_move (item.move());
+			}
 		}
 		return him;
 	} catch (MelderError) {
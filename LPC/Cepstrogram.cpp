@@ -28,6 +28,7 @@
 #include "NUM2.h"
 #include "Sound_and_Spectrum.h"
 #include "Sound_extensions.h"
+#include "SampledAnalysis.h"
 
 #define TOLOG(x) ((1 / NUMln10) * log ((x) + 1e-30))
 #define TO10LOG(x) ((10 / NUMln10) * log ((x) + 1e-30))
@@ -293,21 +294,22 @@ autoPowerCepstrogram Sound_to_PowerCepstrogram (Sound me, double pitchFloor, dou
 
 		autoMelderProgress progress (U"Cepstrogram analysis");
 
-		for (long iframe = 1; iframe <= nFrames; iframe++) {
-			double t = Sampled_indexToX (thee.get(), iframe);
-			Sound_into_Sound (sound.get(), sframe.get(), t - windowDuration / 2);
-			Vector_subtractMean (sframe.get());
-			Sounds_multiply (sframe.get(), window.get());
-			autoSpectrum spec = Sound_to_Spectrum (sframe.get(), 1); // FFT yes
-			autoPowerCepstrum cepstrum = Spectrum_to_PowerCepstrum (spec.get());
-			for (long i = 1; i <= nq; i++) {
-				thy z[i][iframe] = cepstrum -> z[1][i];
-			}
-			if ((iframe % 10) == 1) {
-				Melder_progress ((double) iframe / nFrames, U"PowerCepstrogram analysis of frame ",
-					iframe, U" out of ", nFrames, U".");
-			}
-		}
+		Sampled_analyseFrames <autoSound> (thee.get(), 10,
+			[&] (autoSound& workspace) {
+				workspace = Sound_createSimple (1, windowDuration, samplingFrequency);
+			},
+			[&] (autoSound& workspace, long iframe) {
+				double t = Sampled_indexToX (thee.get(), iframe);
+				Sound_into_Sound (sound.get(), workspace.get(), t - windowDuration / 2);
+				Vector_subtractMean (workspace.get());
+				Sounds_multiply (workspace.get(), window.get());
+				autoSpectrum spec = Sound_to_Spectrum (workspace.get(), 1); // FFT yes
+				autoPowerCepstrum cepstrum = Spectrum_to_PowerCepstrum (spec.get());
+				for (long i = 1; i <= nq; i++) {
+					thy z[i][iframe] = cepstrum -> z[1][i];
+				}
+			},
+			U"PowerCepstrogram analysis");
 		return thee;
 	} catch (MelderError) {
 		Melder_throw (me, U": no PowerCepstrogram created.");
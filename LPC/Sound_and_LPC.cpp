@@ -30,6 +30,7 @@
 #include "Vector.h"
 #include "Spectrum.h"
 #include "NUM2.h"
+#include "SampledAnalysis.h"
 
 #define LPC_METHOD_AUTO 1
 #define LPC_METHOD_COVAR 2
@@ -371,7 +372,8 @@ end:
 static autoLPC _Sound_to_LPC (Sound me, int predictionOrder, double analysisWidth, double dt, double preEmphasisFrequency, int method, double tol1, double tol2) {
 	double t1, samplingFrequency = 1.0 / my dx;
 	double windowDuration = 2 * analysisWidth; /* gaussian window */
-	long nFrames, frameErrorCount = 0;
+	long nFrames;
+	std::atomic <long> frameErrorCount (0);   // counted on several threads
 
 	if (floor (windowDuration / my dx) < predictionOrder + 1) {
 		Melder_throw (U"Analysis window duration too short.\n For a prediction order of ", predictionOrder,
@@ -383,7 +385,6 @@ static autoLPC _Sound_to_LPC (Sound me, int predictionOrder, double analysisWidt
 	}
 	Sampled_shortTermAnalysis (me, windowDuration, dt, & nFrames, & t1);
 	autoSound sound = Data_copy (me);
-	autoSound sframe = Sound_createSimple (1, windowDuration, samplingFrequency);
 	autoSound window = Sound_createGaussian (windowDuration, samplingFrequency);
 	autoLPC thee = LPC_create (my xmin, my xmax, nFrames, dt, t1, predictionOrder, my dx);
 
@@ -393,34 +394,36 @@ static autoLPC _Sound_to_LPC (Sound me, int predictionOrder, double analysisWidt
 		Sound_preEmphasis (sound.get(), preEmphasisFrequency);
 	}
 
-	for (long i = 1; i <= nFrames; i++) {
-		LPC_Frame lpcframe = (LPC_Frame) & thy d_frames[i];
-		double t = Sampled_indexToX (thee.get(), i);
-		LPC_Frame_init (lpcframe, predictionOrder);
-		Sound_into_Sound (sound.get(), sframe.get(), t - windowDuration / 2);
-		Vector_subtractMean (sframe.get());
-		Sounds_multiply (sframe.get(), window.get());
-		if (method == LPC_METHOD_AUTO) {
-			if (! Sound_into_LPC_Frame_auto (sframe.get(), lpcframe)) {
-				frameErrorCount++;
+	Sampled_analyseFrames <autoSound> (thee.get(), 10,
+		[&] (autoSound& sframe) {
+			sframe = Sound_createSimple (1, windowDuration, samplingFrequency);
+		},
+		[&] (autoSound& sframe, long i) {
+			LPC_Frame lpcframe = (LPC_Frame) & thy d_frames[i];
+			double t = Sampled_indexToX (thee.get(), i);
+			LPC_Frame_init (lpcframe, predictionOrder);
+			Sound_into_Sound (sound.get(), sframe.get(), t - windowDuration / 2);
+			Vector_subtractMean (sframe.get());
+			Sounds_multiply (sframe.get(), window.get());
+			if (method == LPC_METHOD_AUTO) {
+				if (! Sound_into_LPC_Frame_auto (sframe.get(), lpcframe)) {
+					frameErrorCount++;
+				}
+			} else if (method == LPC_METHOD_COVAR) {
+				if (! Sound_into_LPC_Frame_covar (sframe.get(), lpcframe)) {
+					frameErrorCount++;
+				}
+			} else if (method == LPC_METHOD_BURG) {
+				if (! Sound_into_LPC_Frame_burg (sframe.get(), lpcframe)) {
+					frameErrorCount++;
+				}
+			} else if (method == LPC_METHOD_MARPLE) {
+				if (! Sound_into_LPC_Frame_marple (sframe.get(), lpcframe, tol1, tol2)) {
+					frameErrorCount++;
+				}
 			}
-		} else if (method == LPC_METHOD_COVAR) {
-			if (! Sound_into_LPC_Frame_covar (sframe.get(), lpcframe)) {
-				frameErrorCount++;
-			}
-		} else if (method == LPC_METHOD_BURG) {
-			if (! Sound_into_LPC_Frame_burg (sframe.get(), lpcframe)) {
-				frameErrorCount++;
-			}
-		} else if (method == LPC_METHOD_MARPLE) {
-			if (! Sound_into_LPC_Frame_marple (sframe.get(), lpcframe, tol1, tol2)) {
-				frameErrorCount++;
-			}
-		}
-		if ((i % 10) == 1) {
-			Melder_progress ( (double) i / nFrames, U"LPC analysis of frame ", i, U" out of ", nFrames, U".");
-		}
-	}
+		},
+		U"LPC analysis");
 	return thee;
 }
 
@@ -314,8 +314,6 @@ DIRECT (HELP_ArticulatorySynthesisTutorial) {
 	HELP (U"Articulatory synthesis")
 }
 
-void manual_Artsynth_init (ManPages me);
-
 // MARK: - buttons
 
 void praat_uvafon_Artsynth_init ();
@@ -373,7 +371,7 @@ void praat_uvafon_Artsynth_init () {
 	praat_addAction1 (classVocalTract, 0, U"Hack", nullptr, 0, nullptr);
 	praat_addAction1 (classVocalTract, 0, U"To Matrix", nullptr, 0, NEW_VocalTract_to_Matrix);
 
-	manual_Artsynth_init (theCurrentPraatApplication -> manPages);
+	INCLUDE_MANPAGES (manual_Artsynth_init)
 }
 
 /* End of file praat_Artsynth.cpp */
@@ -27,6 +27,8 @@
 #include "KNN.h"
 #include "KNN_threads.h"
 #include "OlaP.h"
+#include <algorithm>
+#include <vector>
 
 #include "oo_DESTROY.h"
 #include "KNN_def.h"
@@ -155,6 +157,56 @@ int KNN_learn
 
 }
 
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Classification - Division of the work over threads                                      //
+/////////////////////////////////////////////////////////////////////////////////////////////
+
+static int KNN_getNumberOfThreads
+(
+    long nrows,         // the number of instances to classify
+                        //
+    long ninstances,    // the size of the instance base
+                        //
+    long nfeatures      // the number of features per instance
+                        //
+)
+
+{
+    int nthreads = KNN_getNumberOfCPUs();
+
+    // Small jobs are not worth starting threads for; every
+    // classification costs about ninstances * nfeatures operations.
+    if ((double) nrows * ninstances * nfeatures < 1e6)
+        nthreads = 1;
+    if (nthreads > nrows)
+        nthreads = OlaMAX (nrows, 1);
+    return nthreads;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Classification - Search tree                                                            //
+/////////////////////////////////////////////////////////////////////////////////////////////
+
+typedef struct
+{
+        long begin, end;        // the instances of the node: order [begin .. end - 1]
+        long left, right;       // the child nodes, or -1 for a leaf
+} KNN_TreeNode_t;
+
+typedef struct
+{
+        PatternList p;
+        std::vector <long> order;               // instance indices, grouped by node
+        std::vector <KNN_TreeNode_t> nodes;
+        std::vector <double> lower, upper;      // the bounding box of every node, p->nx values per node
+        std::vector <long> blockEnds;           // one past the last instance index of every block
+        std::vector <long> roots;               // the root node of every block
+} KNN_Tree_t;
+
+static bool KNN_Tree_init (KNN_Tree_t * me, PatternList p, FeatureWeights fws, long nqueries);
+
+static long KNN_kNeighboursInTree (KNN_Tree_t * tree, PatternList j, FeatureWeights fws, long jy, long k, long * indices, double * distances);
+
 /////////////////////////////////////////////////////////////////////////////////////////////
 // Classification - To Categories                                                          //
 /////////////////////////////////////////////////////////////////////////////////////////////
@@ -169,6 +221,7 @@ typedef struct
         int dist;
         long istart;
         long istop;
+        KNN_Tree_t * tree;
 
 } KNN_input_ToCategories_t;
 
@@ -190,70 +243,34 @@ autoCategories KNN_classifyToCategories
 )
 
 {
-    int nthreads = KNN_getNumberOfCPUs();
-    long *outputindices = NUMvector <long> (0, ps->ny);
-    long chunksize =  ps->ny / nthreads;
-
-    Melder_assert(nthreads > 0); 
     Melder_assert(k > 0 && k <= my nInstances);
 
-    if(chunksize < 1)
-    {
-        chunksize = 1;
-        nthreads = ps->ny;
-    }
-
-    long istart = 1;
-    long istop = chunksize;
-
+    int nthreads = KNN_getNumberOfThreads (ps->ny, my nInstances, ps->nx);
+    autoNUMvector <long> outputindices (0L, ps->ny);
     autoCategories output = Categories_create ();
-    KNN_input_ToCategories_t ** input = (KNN_input_ToCategories_t **) malloc(nthreads * sizeof(KNN_input_ToCategories_t *));
 
-    if (!input)
-        return autoCategories();
+    KNN_Tree_t tree;
+    bool hasTree = KNN_Tree_init (& tree, my input.get(), fws, ps->ny);
 
+    // Every thread gets its own contiguous range of rows,
+    // so that the threads never write to the same output index.
+    std::vector <KNN_input_ToCategories_t> args (nthreads);
+    std::vector <void *> input (nthreads);
     for (int i = 0; i < nthreads; i ++)
     {
-        input [i] = (KNN_input_ToCategories_t *) malloc(sizeof(KNN_input_ToCategories_t));
-        if (! input [i])
-        {
-            while (input [i --])
-                free (input [i]);
-
-            free (input);
-            return autoCategories();
-        }
+        args[i].me = me;
+        args[i].ps = ps;
+        args[i].output = outputindices.peek();
+        args[i].fws = fws;
+        args[i].k = k;
+        args[i].dist = dist;
+        args[i].istart = 1 + (i * ps->ny) / nthreads;
+        args[i].istop = ((i + 1) * ps->ny) / nthreads;
+        args[i].tree = hasTree ? & tree : nullptr;
+        input[i] = & args[i];
     }
 
-    for (int i = 0; i < nthreads; i ++)
-    {  
-        input[i]->me = me;
-        input[i]->ps = ps;
-        input[i]->output = outputindices;
-        input[i]->fws = fws;
-        input[i]->k = k;
-        input[i]->dist = dist;
-        input[i]->istart = istart;
-
-        if (istop + chunksize > ps->ny)
-        {  
-            input[i]->istop = ps->ny; 
-            break;
-        }
-        else
-        {  
-            input[i]->istop = istop;
-            istart = istop + 1;
-            istop += chunksize;
-        }
-    }
- 
-    enum KNN_thread_status * error = (enum KNN_thread_status *) KNN_threadDistribution(KNN_classifyToCategoriesAux, (void **) input, nthreads);
-    //void *error = KNN_classifyToCategoriesAux (input [0]);
-    for (int i = 0; i < nthreads; i ++)
-        free (input [i]);
-  
-    free (input);
+    enum KNN_thread_status * error = (enum KNN_thread_status *) KNN_threadDistribution(KNN_classifyToCategoriesAux, input.data(), nthreads);
     if (error)           // Something went very wrong, you ought to inform the user!
     {
         free (error);
@@ -263,7 +280,6 @@ autoCategories KNN_classifyToCategories
 	for (long i = 1; i <= ps -> ny; i ++) {
 		output -> addItem_move (Data_copy (my output->at [outputindices [i]]));
 	}
-	NUMvector_free (outputindices, 0);
     return output;
 }
 
@@ -299,13 +315,22 @@ void * KNN_classifyToCategoriesAux
         // Localizing the k nearest neighbours //
         /////////////////////////////////////////
 
-        ncollected = KNN_kNeighbours
-        (
-            ((KNN_input_ToCategories_t *) input)->ps, 
-            ((KNN_input_ToCategories_t *) input)->me->input.get(),
-            ((KNN_input_ToCategories_t *) input)->fws, y, 
-            ((KNN_input_ToCategories_t *) input)->k, indices, distances
-        );
+        if (((KNN_input_ToCategories_t *) input)->tree)
+            ncollected = KNN_kNeighboursInTree
+            (
+                ((KNN_input_ToCategories_t *) input)->tree,
+                ((KNN_input_ToCategories_t *) input)->ps,
+                ((KNN_input_ToCategories_t *) input)->fws, y,
+                ((KNN_input_ToCategories_t *) input)->k, indices, distances
+            );
+        else
+            ncollected = KNN_kNeighbours
+            (
+                ((KNN_input_ToCategories_t *) input)->ps, 
+                ((KNN_input_ToCategories_t *) input)->me->input.get(),
+                ((KNN_input_ToCategories_t *) input)->fws, y, 
+                ((KNN_input_ToCategories_t *) input)->k, indices, distances
+            );
 
         /////////////////////////////////////////////////
         // Computing frequencies and average distances //
@@ -359,6 +384,7 @@ typedef struct {
 	int dist;
 	long istart;
 	long istop;
+	KNN_Tree_t * tree;
 } KNN_input_ToTableOfReal_t;
 
 autoTableOfReal KNN_classifyToTableOfReal
@@ -379,79 +405,43 @@ autoTableOfReal KNN_classifyToTableOfReal
 )
 
 {
-    int nthreads = KNN_getNumberOfCPUs();
-    long chunksize =  ps->ny / nthreads;
     autoCategories uniqueCategories = Categories_selectUniqueItems (my output.get());
     long ncategories = Categories_getSize (uniqueCategories.get());
    
-    Melder_assert (nthreads > 0);
     Melder_assert (ncategories > 0);
     Melder_assert (k > 0 && k <= my nInstances);
  
     if (! ncategories)
         return autoTableOfReal();
 
-    if (chunksize < 1)
-    {
-        chunksize = 1;
-        nthreads = ps->ny;
-    }
-
-    long istart = 1;
-    long istop = chunksize;
-
-    KNN_input_ToTableOfReal_t ** input = (KNN_input_ToTableOfReal_t **) malloc (nthreads * sizeof (KNN_input_ToTableOfReal_t *));
-    
-    if(! input)
-        return autoTableOfReal();
-
+    int nthreads = KNN_getNumberOfThreads (ps->ny, my nInstances, ps->nx);
     autoTableOfReal output = TableOfReal_create(ps->ny, ncategories);
 
+    KNN_Tree_t tree;
+    bool hasTree = KNN_Tree_init (& tree, my input.get(), fws, ps->ny);
+
     for (long i = 1; i <= ncategories; i ++)
         TableOfReal_setColumnLabel (output.get(), i, SimpleString_c (uniqueCategories->at [i]));
 
+    // Every thread gets its own contiguous range of rows of the output table.
+    std::vector <KNN_input_ToTableOfReal_t> args (nthreads);
+    std::vector <void *> input (nthreads);
     for (int i = 0; i < nthreads; i ++)
     {
-        input [i] = (KNN_input_ToTableOfReal_t *) malloc (sizeof (KNN_input_ToTableOfReal_t));
-        if (! input [i])
-        {
-            while (input [i --])   // ppgb FIXME: is always false
-                free (input [i]);   // ppgb FIXME: the stopping condition is incorrect
-
-            free (input);
-            return autoTableOfReal();
-        }
-    }
-
-    for (int i = 0; i < nthreads; i ++)
-    {  
-        input[i]->me = me;
-        input[i]->ps = ps;
-        input[i]->output = output.get();   // YUCK: reference copy
-        input[i]->uniqueCategories = uniqueCategories.releaseToAmbiguousOwner();
-        input[i]->fws = fws;
-        input[i]->k = k;
-        input[i]->dist = dist;
-        input[i]->istart = istart;
-
-        if(istop + chunksize > ps->ny)
-        {  
-            input[i]->istop = ps->ny; 
-            break;
-        }
-        else
-        {  
-            input[i]->istop = istop;
-            istart = istop + 1;
-            istop += chunksize;
-        }
+        args[i].me = me;
+        args[i].ps = ps;
+        args[i].output = output.get();
+        args[i].uniqueCategories = uniqueCategories.get();
+        args[i].fws = fws;
+        args[i].k = k;
+        args[i].dist = dist;
+        args[i].istart = 1 + (i * ps->ny) / nthreads;
+        args[i].istop = ((i + 1) * ps->ny) / nthreads;
+        args[i].tree = hasTree ? & tree : nullptr;
+        input[i] = & args[i];
     }
  
-    enum KNN_thread_status * error = (enum KNN_thread_status *) KNN_threadDistribution(KNN_classifyToTableOfRealAux, (void **) input, nthreads);
-    for (int i = 0; i < nthreads; i ++)
-        free (input [i]);
-  
-    free (input);
+    enum KNN_thread_status * error = (enum KNN_thread_status *) KNN_threadDistribution(KNN_classifyToTableOfRealAux, input.data(), nthreads);
     if (error)           // Something went very wrong, you ought to inform the user!
     {
         free (error);
@@ -472,73 +462,53 @@ void * KNN_classifyToTableOfRealAux
 )
 
 {
-    long ncategories = Categories_getSize (((KNN_input_ToTableOfReal_t *) input)->uniqueCategories);
-    autoNUMvector <long> indices (0L, ((KNN_input_ToTableOfReal_t *) input)->k);
-    autoNUMvector <double> distances (0L, ((KNN_input_ToTableOfReal_t *) input)->k);
+    KNN_input_ToTableOfReal_t * in = (KNN_input_ToTableOfReal_t *) input;
+    long ncategories = Categories_getSize (in->uniqueCategories);
+    autoNUMvector <long> indices (0L, in->k);
+    autoNUMvector <double> distances (0L, in->k);
 
-    for (long y = ((KNN_input_ToTableOfReal_t *) input)->istart; y <= ((KNN_input_ToTableOfReal_t *) input)->istop; ++y)
+    for (long y = in->istart; y <= in->istop; ++y)
     {
-        KNN_kNeighbours(((KNN_input_ToTableOfReal_t *) input)->ps, 
-                        ((KNN_input_ToTableOfReal_t *) input)->me->input.get(),
-                        ((KNN_input_ToTableOfReal_t *) input)->fws, y, 
-                        ((KNN_input_ToTableOfReal_t *) input)->k, indices.peek(), distances.peek());
+        if (in->tree)
+            KNN_kNeighboursInTree (in->tree, in->ps, in->fws, y, in->k, indices.peek(), distances.peek());
+        else
+            KNN_kNeighbours (in->ps, in->me->input.get(), in->fws, y, in->k, indices.peek(), distances.peek());
 
-        for(long i = 0; i < ((KNN_input_ToTableOfReal_t *) input)->k; ++i)
+        ////////////////////////
+        // Distance weighting //
+        ////////////////////////
+
+        // Each neighbour votes for its own category, with a weight
+        // that depends on its own distance to the unknown.
+        double sum = 0;
+        for (long i = 0; i < in->k; ++i)
         {
-            for(long j = 1; j <= ncategories; ++j) {
-                if (FeatureWeights_areFriends (((KNN_input_ToTableOfReal_t *) input) -> me -> output->at [indices [i]],
-											   ((KNN_input_ToTableOfReal_t *) input) -> uniqueCategories->at [j]))
-				{
-                    ++((KNN_input_ToTableOfReal_t *) input) -> output -> data [y] [j];
-				}
-			}
-        }
-    }
- 
-    switch (((KNN_input_ToTableOfReal_t *) input)->dist)
-    {
-        case kOla_DISTANCE_WEIGHTED_VOTING:
-            for (long y = ((KNN_input_ToTableOfReal_t *) input) -> istart; y <= ((KNN_input_ToTableOfReal_t *) input) -> istop; y ++)
+            double vote;
+            switch (in->dist)
             {
-                double sum = 0;
-                for(long c = 1; c <= ncategories; ++c)
-                {
-                    ((KNN_input_ToTableOfReal_t *) input)->output->data[y][c] *= 1 / OlaMAX(distances[c], kOla_MINFLOAT);
-                    sum += ((KNN_input_ToTableOfReal_t *) input)->output->data[y][c];
-                } 
-                
-                for(long c = 1; c <= ncategories; ++c)
-                    ((KNN_input_ToTableOfReal_t *) input)->output->data[y][c] /= sum;
+                case kOla_DISTANCE_WEIGHTED_VOTING:
+                    vote = 1 / OlaMAX(distances[i], kOla_MINFLOAT);
+                    break;
 
-            }
-            break;
+                case kOla_SQUARED_DISTANCE_WEIGHTED_VOTING:
+                    vote = 1 / OlaMAX(OlaSQUARE(distances[i]), kOla_MINFLOAT);
+                    break;
 
-        case kOla_SQUARED_DISTANCE_WEIGHTED_VOTING:
-            for (long y = ((KNN_input_ToTableOfReal_t *) input)->istart; y <= ((KNN_input_ToTableOfReal_t *) input)->istop; ++y)
-            {
-                double sum = 0;
-                for(long c = 1; c <= ncategories; ++c)
-                {
-                    ((KNN_input_ToTableOfReal_t *) input)->output->data[y][c] *= 1 / OlaMAX(OlaSQUARE(distances[c]), kOla_MINFLOAT);
-                    sum += ((KNN_input_ToTableOfReal_t *) input)->output->data[y][c];
-                } 
-
-                for(long c = 1; c <= ncategories; ++c)
-                    ((KNN_input_ToTableOfReal_t *) input)->output->data[y][c] /= sum;
+                default:
+                    vote = 1;
             }
-            break;
-
-        case kOla_FLAT_VOTING: 
-            for (long y = ((KNN_input_ToTableOfReal_t *) input)->istart; y <= ((KNN_input_ToTableOfReal_t *) input)->istop; ++y)
-            {
-                double sum = 0;
-                for(long c = 1; c <= ncategories; ++c)
-                    sum += ((KNN_input_ToTableOfReal_t *) input)->output->data[y][c];
 
-                for(long c = 1; c <= ncategories; ++c)
-                    ((KNN_input_ToTableOfReal_t *) input)->output->data[y][c] /= sum;
-            }
+            for (long j = 1; j <= ncategories; ++j) {
+                if (FeatureWeights_areFriends (in->me->output->at [indices [i]], in->uniqueCategories->at [j]))
+				{
+                    in->output->data [y] [j] += vote;
+                    sum += vote;
+				}
+			}
+        }
 
+        for (long c = 1; c <= ncategories; ++c)
+            in->output->data[y][c] /= sum;
     }
     return nullptr;
 }
@@ -547,7 +517,7 @@ void * KNN_classifyToTableOfRealAux
 // Classification - Folding                                                                //
 /////////////////////////////////////////////////////////////////////////////////////////////
 
-autoCategories KNN_classifyFold
+static long KNN_classifyFoldToIndices
 (
     ///////////////////////////////
     // Parameters                //
@@ -565,8 +535,10 @@ autoCategories KNN_classifyFold
                         //
     long begin,         // fold start, inclusive [...
                         //
-    long end            // fold end, inclusive ...]
+    long end,           // fold end, inclusive ...]
                         //
+    long * outputindices    // Out: for each instance in the fold, the index of
+                        // the winning category in the instance base
 )
 
 {
@@ -586,7 +558,6 @@ autoCategories KNN_classifyFold
     autoNUMvector <long> freqindices (0L, k);
     autoNUMvector <double> distances (0L, k);
     autoNUMvector <double> freqs (0L, k);
-    autoNUMvector <long> outputindices (0L, ps->ny);
     long noutputindices = 0;
 
     for (long y = begin; y <= end; ++y)
@@ -623,6 +594,35 @@ autoCategories KNN_classifyFold
         outputindices [noutputindices++] = freqindices [KNN_max (freqs.peek(), ncategories)];
     }
 
+    return noutputindices;
+}
+
+autoCategories KNN_classifyFold
+(
+    ///////////////////////////////
+    // Parameters                //
+    ///////////////////////////////
+
+    KNN me,             // the classifier being used
+                        //
+    PatternList ps,         // source PatternList
+                        //
+    FeatureWeights fws, // feature weights
+                        //
+    long k,             // the number of sought after neighbours
+                        //
+    int dist,           // distance weighting
+                        //
+    long begin,         // fold start, inclusive [...
+                        //
+    long end            // fold end, inclusive ...]
+                        //
+)
+
+{
+    autoNUMvector <long> outputindices (0L, ps->ny);
+    long noutputindices = KNN_classifyFoldToIndices (me, ps, fws, k, dist, begin, end, outputindices.peek());
+
 	autoCategories output = Categories_create ();
 	for (long o = 0; o < noutputindices; o ++) {
 		output -> addItem_move (Data_copy (my output->at [outputindices [o]]));
@@ -634,6 +634,39 @@ autoCategories KNN_classifyFold
 // Evaluation                                                                              //
 /////////////////////////////////////////////////////////////////////////////////////////////
 
+typedef struct {
+	KNN me;
+	FeatureWeights fws;
+	long k;
+	int dist;
+	long adder;
+	long ifoldstart;
+	long ifoldstop;
+	long ncorrect;
+} KNN_input_evaluate_t;
+
+static void * KNN_evaluateAux
+(
+    void * input
+)
+
+{
+    KNN_input_evaluate_t * in = (KNN_input_evaluate_t *) input;
+    KNN me = in->me;
+    autoNUMvector <long> outputindices (0L, my nInstances);
+
+    for (long ifold = in->ifoldstart; ifold <= in->ifoldstop; ++ifold)
+    {
+        long begin = 1 + (ifold - 1) * in->adder;
+        long noutputindices = KNN_classifyFoldToIndices (me, my input.get(), in->fws, in->k, in->dist,
+            begin, OlaMIN (begin + in->adder - 1, my nInstances), outputindices.peek());
+        for (long o = 0; o < noutputindices; o ++)
+            if (FeatureWeights_areFriends (my output->at [outputindices [o]], my output->at [begin + o]))
+                ++ in->ncorrect;
+    }
+    return nullptr;
+}
+
 double KNN_evaluate
 (
     ///////////////////////////////
@@ -653,7 +686,6 @@ double KNN_evaluate
 )
 
 {
-    double correct = 0.0;
     long adder;
 
     switch(mode)
@@ -676,16 +708,40 @@ double KNN_evaluate
     if (adder == 0)
         return -1;
 
-    for (long begin = 1; begin <= my nInstances; begin += adder)
+    // The folds are independent of each other and are divided over the threads;
+    // each thread counts the correct classifications in its own folds.
+    long nfolds = (my nInstances - 1) / adder + 1;
+    int nthreads = KNN_getNumberOfThreads (my nInstances, my nInstances, my input->nx);
+    if (nthreads > nfolds)
+        nthreads = nfolds;
+
+    std::vector <KNN_input_evaluate_t> args (nthreads);
+    std::vector <void *> input (nthreads);
+    for (int i = 0; i < nthreads; i ++)
+    {
+        args[i].me = me;
+        args[i].fws = fws;
+        args[i].k = k;
+        args[i].dist = dist;
+        args[i].adder = adder;
+        args[i].ifoldstart = 1 + (i * nfolds) / nthreads;
+        args[i].ifoldstop = ((i + 1) * nfolds) / nthreads;
+        args[i].ncorrect = 0;
+        input[i] = & args[i];
+    }
+
+    enum KNN_thread_status * error = (enum KNN_thread_status *) KNN_threadDistribution(KNN_evaluateAux, input.data(), nthreads);
+    if (error)
     {
-        autoCategories c = KNN_classifyFold (me, my input.get(), fws, k, dist, begin, OlaMIN (begin + adder - 1, my nInstances));
-        for (long y = 1; y <= c->size; y ++)
-            if (FeatureWeights_areFriends (c->at [y], my output->at [begin + y - 1]))
-                correct += 1.0;
+        free (error);
+        return -1;
     }
 
-    correct /= (double) my nInstances;
-    return correct;
+    long ncorrect = 0;
+    for (int i = 0; i < nthreads; i ++)
+        ncorrect += args[i].ncorrect;
+
+    return (double) ncorrect / (double) my nInstances;
 }
 
 /////////////////////////////////////////////////////////////////////////////////////////////
@@ -877,6 +933,50 @@ long KNN_max
 }
 
 
+////////////////////////////////////////////////////////////////////////////////////////////
+// Euclidean distance, if less than a bound                                                //
+/////////////////////////////////////////////////////////////////////////////////////////////
+
+// Computes the same distance as KNN_distanceEuclidean, but gives up as soon as the
+// partial sum shows that the distance cannot become less than bound; the sum only grows.
+
+static inline bool KNN_distanceEuclideanIsLess
+(
+    PatternList ps,         // PatternList 1
+                        //
+    PatternList pt,         // PatternList 2
+                        //
+    FeatureWeights fws, // Feature weights
+                        //
+    long rows,          // Vector index of pattern 1
+                        //
+    long rowt,          // Vector index of pattern 2
+                        //
+    double bound,       // the distance to beat
+                        //
+    double * distance   // Out: the distance, if less than bound
+                        //
+)
+
+{
+    double sum = 0.0, boundSquared = bound * bound;
+    double *zs = ps->z[rows], *zt = pt->z[rowt], *weights = fws->fweights->data[1];
+    long x = 1;
+
+    // Look at the partial sum only after every block of features.
+    for (long xblock = 8; xblock < ps->nx; xblock += 8)
+    {
+        for (; x <= xblock; ++x)
+            sum += OlaSQUARE ((zs[x] - zt[x]) * weights[x]);
+        if (sum > boundSquared && sqrt (sum) >= bound)
+            return false;
+    }
+    for (; x <= ps->nx; ++x)
+        sum += OlaSQUARE ((zs[x] - zt[x]) * weights[x]);
+    *distance = sqrt (sum);
+    return *distance < bound;
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////
 // Locate k neighbours, skip one + disposal of distance                                    //
 /////////////////////////////////////////////////////////////////////////////////////////////
@@ -931,8 +1031,8 @@ long KNN_kNeighboursSkip
     {
         if (py != jy && py != skipper)
         {
-            double d = KNN_distanceEuclidean (j, p, fws, jy, py);
-            if (d < distances [maxi])
+            double d;
+            if (KNN_distanceEuclideanIsLess (j, p, fws, jy, py, distances [maxi], & d))
             {
                 distances [maxi] = d;
                 indices [maxi] = py;
@@ -1017,8 +1117,8 @@ long KNN_kNeighboursSkipRange
     {
         if ((end + py) % p->ny + 1 != jy)
         {
-            double d = KNN_distanceEuclidean(j, p, fws, jy, (end + py) % p->ny + 1);
-            if (d < distances[maxi])
+            double d;
+            if (KNN_distanceEuclideanIsLess (j, p, fws, jy, (end + py) % p->ny + 1, distances [maxi], & d))
             {
                 distances [maxi] = d;
                 indices [maxi] = (end + py) % p->ny + 1;
@@ -1087,8 +1187,8 @@ long KNN_kNeighbours
     {
         if (py != jy)
         {
-            double d = KNN_distanceEuclidean (j, p, fws, jy, py);
-            if (d < distances [maxi])
+            double d;
+            if (KNN_distanceEuclideanIsLess (j, p, fws, jy, py, distances [maxi], & d))
             {
                 distances [maxi] = d;
                 indices [maxi] = py;
@@ -1108,6 +1208,263 @@ long KNN_kNeighbours
         return ret;
 }
 
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Search tree                                                                             //
+/////////////////////////////////////////////////////////////////////////////////////////////
+
+// The instances are divided into blocks of consecutive indices, and every block gets a k-d
+// tree of its own. KNN_kNeighboursInTree visits the blocks in index order. In every block it
+// collects the instances whose boxes could lie closer than the current k-th neighbour, and
+// offers them to the neighbour slots in index order, just as KNN_kNeighbours does. Every
+// instance that is left out would have been turned down by KNN_kNeighbours too, so the
+// neighbours, their slots, and hence the outcome of ties, are the same. The blocks double in
+// size, because the k-th neighbour only comes closer as the search proceeds.
+
+#define KNN_TREE_MINIMUM_INSTANCES  1024    // a smaller instance base is scanned faster
+#define KNN_TREE_MAXIMUM_FEATURES  16       // with more features, the boxes hardly prune
+#define KNN_TREE_MINIMUM_QUERIES  16        // building the tree costs about this many scans
+#define KNN_TREE_FIRST_BLOCK  256
+#define KNN_TREE_LEAF  16
+#define KNN_TREE_SCAN_FRACTION  8           // a block with more candidates than this part is scanned whole
+
+static long KNN_Tree_addNode
+(
+    KNN_Tree_t * me,    // the tree
+                        //
+    FeatureWeights fws, // feature weights
+                        //
+    long begin,         // the instances order [begin .. end - 1]
+                        //
+    long end            //
+)
+
+{
+    PatternList p = my p;
+    double *weights = fws->fweights->data[1];
+    long inode = my nodes.size();
+    KNN_TreeNode_t node = { begin, end, -1, -1 };
+    my nodes.push_back (node);
+    my lower.resize ((inode + 1) * p->nx);
+    my upper.resize ((inode + 1) * p->nx);
+    double *lower = & my lower [inode * p->nx], *upper = & my upper [inode * p->nx];
+
+    long xsplit = 0;
+    double widest = 0.0;
+    for (long x = 1; x <= p->nx; ++x)
+    {
+        lower[x - 1] = upper[x - 1] = p->z[my order[begin]][x];
+        for (long i = begin + 1; i < end; ++i)
+        {
+            double z = p->z[my order[i]][x];
+            if (z < lower[x - 1])
+                lower[x - 1] = z;
+            if (z > upper[x - 1])
+                upper[x - 1] = z;
+        }
+        double width = fabs ((upper[x - 1] - lower[x - 1]) * weights[x]);
+        if (width > widest)
+        {
+            widest = width;
+            xsplit = x;
+        }
+    }
+
+    // Split at the median of the feature with the widest weighted spread,
+    // unless the node is small or all its instances coincide.
+    if (end - begin <= KNN_TREE_LEAF || xsplit == 0)
+        return inode;
+    long middle = begin + (end - begin) / 2;
+    std::nth_element (my order.begin() + begin, my order.begin() + middle, my order.begin() + end,
+        [p, xsplit] (long a, long b) { return p->z[a][xsplit] < p->z[b][xsplit]; });
+    long left = KNN_Tree_addNode (me, fws, begin, middle);
+    long right = KNN_Tree_addNode (me, fws, middle, end);
+    my nodes[inode].left = left;
+    my nodes[inode].right = right;
+    return inode;
+}
+
+static bool KNN_Tree_init
+(
+    KNN_Tree_t * me,    // the tree to build
+                        //
+    PatternList p,      // the instance base
+                        //
+    FeatureWeights fws, // feature weights
+                        //
+    long nqueries       // the number of searches the tree will serve
+                        //
+)
+
+{
+    if (p->ny < KNN_TREE_MINIMUM_INSTANCES || p->nx > KNN_TREE_MAXIMUM_FEATURES || nqueries < KNN_TREE_MINIMUM_QUERIES)
+        return false;
+    for (long y = 1; y <= p->ny; ++y)
+        for (long x = 1; x <= p->nx; ++x)
+            if (isnan (p->z[y][x]) || isinf (p->z[y][x]))   // these cannot be ordered or boxed
+                return false;
+
+    my p = p;
+    my order.resize (p->ny);
+    for (long y = 1; y <= p->ny; ++y)
+        my order[y - 1] = y;
+    for (long begin = 0, size = KNN_TREE_FIRST_BLOCK; begin < p->ny; size *= 2)
+    {
+        long end = OlaMIN (begin + size, p->ny);
+        my roots.push_back (KNN_Tree_addNode (me, fws, begin, end));
+        my blockEnds.push_back (end + 1);
+        begin = end;
+    }
+    return true;
+}
+
+// Every term is at most the term that KNN_distanceEuclidean computes for any instance in the
+// box, and the terms are added in the same order, so that after rounding the sum is still at
+// most the distance to any of those instances.
+
+static inline bool KNN_Tree_boxIsCloser
+(
+    KNN_Tree_t * me,    // the tree
+                        //
+    long inode,         // the node whose box is tested
+                        //
+    double * zs,        // the unknown instance
+                        //
+    double * weights,   // feature weights
+                        //
+    double bound        // the distance to beat
+                        //
+)
+
+{
+    double *lower = & my lower [inode * my p->nx], *upper = & my upper [inode * my p->nx];
+    double sum = 0.0;
+    for (long x = 1; x <= my p->nx; ++x)
+    {
+        double gap = 0.0;
+        if (zs[x] < lower[x - 1])
+            gap = lower[x - 1] - zs[x];
+        else if (zs[x] > upper[x - 1])
+            gap = zs[x] - upper[x - 1];
+        sum += OlaSQUARE (gap * weights[x]);
+    }
+    return sqrt (sum) < bound;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Locate k neighbours with the search tree                                                //
+/////////////////////////////////////////////////////////////////////////////////////////////
+
+static long KNN_kNeighboursInTree
+(
+    ///////////////////////////////
+    // Parameters                //
+    ///////////////////////////////
+
+    KNN_Tree_t * me,    // the search tree over the target pattern
+                        //
+    PatternList j,      // source-pattern (where the unknown is located)
+                        //
+    FeatureWeights fws, // feature weights
+                        //
+    long jy,            // the index of the unknown instance in the source pattern
+                        //
+    long k,             // the number of sought after neighbours
+                        //
+    long * indices,     // Out: the indices of the k neighbours, as KNN_kNeighbours
+                        //
+    double * distances  // Out: their distances, as KNN_kNeighbours
+                        //
+)
+
+{
+    PatternList p = my p;
+    long dc = 0;
+    long py = 1;
+
+    Melder_assert (jy > 0 && jy <= j->ny);
+    Melder_assert (k > 0 && k <= p->ny);
+    Melder_assert (indices);
+    Melder_assert (distances);
+
+    while (dc < k && py <= p->ny)
+    {
+        if (py != jy)
+        {
+            distances[dc] = KNN_distanceEuclidean (j, p, fws, jy, py);
+            indices[dc] = py;
+            ++dc;
+        }
+        ++py;
+    }
+
+    double *zs = j->z[jy], *weights = fws->fweights->data[1];
+    long maxi = KNN_max(distances, k);
+    std::vector <long> stack, candidates;
+    for (size_t iblock = 0; iblock < my roots.size(); ++iblock)
+    {
+        if (my blockEnds[iblock] <= py)
+            continue;
+
+        // If the boxes hardly prune, as when the instances are sorted away from the unknown,
+        // sorting the candidates costs more than offering every instance of the block.
+        long blockBegin = iblock == 0 ? 1 : my blockEnds[iblock - 1];
+        size_t maximumCandidates = (size_t) (my blockEnds[iblock] - blockBegin) / KNN_TREE_SCAN_FRACTION;
+        bool scanned = false;
+        candidates.clear();
+        stack.push_back (my roots[iblock]);
+        while (! stack.empty())
+        {
+            long inode = stack.back();
+            stack.pop_back();
+            if (! KNN_Tree_boxIsCloser (me, inode, zs, weights, distances [maxi]))
+                continue;
+            const KNN_TreeNode_t & node = my nodes[inode];
+            if (node.left < 0)
+            {
+                for (long i = node.begin; i < node.end; ++i)
+                    if (my order[i] >= py && my order[i] != jy)
+                        candidates.push_back (my order[i]);
+            }
+            else
+            {
+                stack.push_back (node.left);
+                stack.push_back (node.right);
+            }
+            if (candidates.size() > maximumCandidates)
+            {
+                scanned = true;
+                stack.clear();
+                candidates.clear();
+                for (long i = OlaMAX (py, blockBegin); i < my blockEnds[iblock]; ++i)
+                    if (i != jy)
+                        candidates.push_back (i);
+            }
+        }
+
+        if (! scanned)
+            std::sort (candidates.begin(), candidates.end());
+        for (long candidate : candidates)
+        {
+            double d;
+            if (KNN_distanceEuclideanIsLess (j, p, fws, jy, candidate, distances [maxi], & d))
+            {
+                distances [maxi] = d;
+                indices [maxi] = candidate;
+                maxi = KNN_max (distances, k);
+            }
+        }
+    }
+
+    long ret = OlaMIN (k, dc);
+    if (ret < 1)
+    {
+        indices [0] = jy;
+        return 0;
+    }
+    else
+        return ret;
+}
+
 /////////////////////////////////////////////////////////////////////////////////////////////
 // Locating k (nearest) friends                                                            //
 /////////////////////////////////////////////////////////////////////////////////////////////
@@ -28,27 +28,7 @@
 #include "KNN.h"
 #include "KNN_threads.h"
 #include "OlaP.h"
-
-// Threading disabled
-/*
-// Linux... 
-#if defined (__linux__)
-    #define __USE_GNU
-    #include <sched.h>
-// BSD-style OSes
-#elif defined (__APPLE__)    
-    #include <sys/types.h>
-    #include <sys/sysctl.h>
-#endif
-// Non-pthreaders, Windows
-#ifdef _WIN32
-    #include <windows.h>
-// The rest of the pack
-#else
-    #include <pthread.h>
-#endif
-*/
-
+#include "MelderThread.h"
 
 /////////////////////////////////////////////////////
 // KNN_getNumberOfCPUs                             //
@@ -56,94 +36,26 @@
 
 int KNN_getNumberOfCPUs ()
 {
-    return(1);
-    
-    // Threading disabled
-    /*
-    int ncpus = 0;
-// Linux... 
-#if defined (__linux__)
-    cpu_set_t * cpuset = (cpu_set_t *) malloc(sizeof(cpu_set_t));
-    if(cpuset)
-    {
-        sched_getaffinity(0, sizeof(cpu_set_t), cpuset);
-        for(int cpu = 0; cpu <= CPU_SETSIZE; ++cpu) 
-            if(CPU_ISSET(cpu, cpuset))
-                ++ncpus;
-        free(cpuset);
-    }
-    Melder_assert(ncpus >= 1);
-// BSD-style OSes
-#elif defined (__APPLE__)
-    int mib[2];
-    size_t len = sizeof(ncpus);
-            
-    mib[0] = CTL_HW;
-    mib[1] = HW_NCPU;
-    sysctl(mib, 2, &ncpus, &len, 0, 0);
-// Non-pthreaders, Windows
-#elif defined (_WIN32)
-    typedef BOOL (WINAPI *LPFN_GLPI)
-        (PSYSTEM_LOGICAL_PROCESSOR_INFORMATION, PDWORD);
-  
-    BOOL done, rc;
-    DWORD returnLength, byteOffset;
-    PSYSTEM_LOGICAL_PROCESSOR_INFORMATION buffer, ptr;
-    LPFN_GLPI Glpi;
-
-    Glpi = (LPFN_GLPI) GetProcAddress(GetModuleHandle(TEXT("kernel32")), "GetLogicalProcessorInformation");
-
-    if(!Glpi) 
-        return(1);
-    
-    done = false;
-    buffer = nullptr;
-    returnLength = 0;
-
-    while(!done) 
-    {
-        rc = Glpi(buffer, &returnLength);
-        if(!rc) 
-        {
-            if(GetLastError() == ERROR_INSUFFICIENT_BUFFER) 
-            {
-                if(buffer) 
-                    free(buffer);
-                return (1);
-            } 
-            else done = true;
-        }
-        byteOffset = 0;
-        ptr=buffer;
-        while (byteOffset < returnLength) 
-        {
-            switch (ptr->Relationship) 
-            {
-                case RelationProcessorCore:
-                        ++ncpus;
-                default:
-            }
-            byteOffset += sizeof(SYSTEM_LOGICAL_PROCESSOR_INFORMATION);
-            ++ptr;
-        }
-    }
-    free(buffer);
-    ncpus = 1;
-// Unknown OS
-#else 
-    ncpus = 1;
-#endif
-    Melder_assert(ncpus >= 1);
-    return(ncpus);
-    */
+    return MelderThread_getNumberOfProcessors ();
 }
 
-
-
 /////////////////////////////////////////////////////
 // KNN_threadDistribution                          //
 /////////////////////////////////////////////////////
 
+typedef struct
+{
+    void * (* function) (void *);
+    void * input;
+    void * result;
+} KNN_thread_t;
+
+static MelderThread_RETURN_TYPE KNN_threadRun (KNN_thread_t * thread)
+{
+    thread->result = thread->function (thread->input);
+    MelderThread_RETURN
+}
+
 void * KNN_threadDistribution
 (   
     void * (* function) (void *), 
@@ -161,34 +73,26 @@ void * KNN_threadDistribution
         return((void *) error);
     }
 
-    if(nthreads > 1)
+    std::vector <KNN_thread_t> threads (nthreads);
+    for(int i = 0; i < nthreads; ++i)
     {
-#ifdef _WIN32
-        // Threading disabled
-        /*
-        HANDLE hHandle[nthreads];
-        for(int i = 0; i < nthreds; ++)
-            hHandle[i] = CreateThread(nullptr, 0, function, input[i], 0, nullptr);
-        while(nthreads--)
-            WaitForSingleObject(hHandle[nthreds], INFINITE);
-        */
-#else
-        // Threading disabled
-        /*
-        pthread_t thread_ids[nthreads];
-        for(int i = 0; i < nthreads; ++i)
-            pthread_create(&thread_ids[i], nullptr, function, input[i]);
-        while(nthreads--)
-            pthread_join(thread_ids[nthreads], nullptr);
-        return nullptr;
-        */
-#endif
-	}
-	void *result = function (input [0]);
-	return result;
-}
-
+        threads[i].function = function;
+        threads[i].input = input[i];
+        threads[i].result = nullptr;
+    }
+    MelderThread_run (KNN_threadRun, threads.data(), nthreads);
 
+    // Report the first failure and dispose of the others.
+    void * result = nullptr;
+    for(int i = 0; i < nthreads; ++i)
+    {
+        if(! result)
+            result = threads[i].result;
+        else if(threads[i].result)
+            free(threads[i].result);
+    }
+    return result;
+}
 
 /////////////////////////////////////////////////////
 // KNN_threadTest                                  //
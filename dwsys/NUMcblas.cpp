@@ -17,6 +17,7 @@
 
 /* #include "blaswrap.h" */
 #include "melder.h"
+#include "MelderThread.h"
 #include "NUMcblas.h"
 #include "NUMf2c.h"
 #include "NUM2.h"
@@ -225,8 +226,8 @@ L60:
 	return ret_val;
 }								/* NUMblas_ddot */
 
-int NUMblas_dgemm (const char *transa, const char *transb, long *m, long *n, long *k, double *alpha, double *a, long *lda,
-                   double *b, long *ldb, double *beta, double *c__, long *ldc) {
+static int NUMblas_dgemm_reference (const char *transa, const char *transb, long *m, long *n, long *k, double *alpha, double *a, long *lda,
+                                   double *b, long *ldb, double *beta, double *c__, long *ldc) {
 	/* System generated locals */
 	long a_dim1, a_offset, b_dim1, b_offset, c_dim1, c_offset, i__1, i__2, i__3;
 
@@ -1928,8 +1929,8 @@ int NUMblas_dsyr2 (const char *uplo, long *n, double *alpha, double *x, long *in
 
 #undef a_ref
 
-int NUMblas_dsyr2k (const char *uplo, const char *trans, long *n, long *k, double *alpha, double *a, long *lda, double *b,
-                    long *ldb, double *beta, double *c__, long *ldc) {
+static int NUMblas_dsyr2k_reference (const char *uplo, const char *trans, long *n, long *k, double *alpha, double *a, long *lda, double *b,
+                                     long *ldb, double *beta, double *c__, long *ldc) {
 	/* System generated locals */
 	long a_dim1, a_offset, b_dim1, b_offset, c_dim1, c_offset, i__1, i__2, i__3;
 
@@ -2646,8 +2647,8 @@ int NUMblas_dtrmv (const char *uplo, const char *trans, const char *diag, long *
 
 #undef a_ref
 
-int NUMblas_dtrsm (const char *side, const char *uplo, const char *transa, const char *diag, long *m, long *n,
-                   double *alpha, double *a, long *lda, double *b, long *ldb) {
+static int NUMblas_dtrsm_reference (const char *side, const char *uplo, const char *transa, const char *diag, long *m, long *n,
+                                   double *alpha, double *a, long *lda, double *b, long *ldb) {
 	/* System generated locals */
 	long a_dim1, a_offset, b_dim1, b_offset, i__1, i__2, i__3;
 
@@ -3011,6 +3012,282 @@ L30:
 	return ret_val;
 }								/* NUMblas_idamax */
 
+/********** Blocked level-3 routines **********/
+
+/*
+	The reference routines above run through whole columns of A, B and C for every column of C,
+	so that for large matrices every element is fetched from main memory many times.
+	NUMblas_dgemm therefore copies ("packs") op(B) in panels of KC x NC elements, scaled by alpha,
+	and op(A) in blocks of MC x KC elements, which stay in the caches while they are used;
+	a micro-kernel of fixed size MR x NR, whose inner loop the compiler turns into SIMD instructions,
+	then updates C from the packed data. Large products are divided over threads by blocks of rows of C.
+	NUMblas_dsyr2k and NUMblas_dtrsm hand small diagonal blocks to the reference routines
+	and perform the remaining updates with NUMblas_dgemm.
+	Small problems, and calls with invalid arguments (which are reported by the reference routines),
+	go to the reference routines directly, as do all calls if Melder_debug is 48.
+*/
+
+#define NUMblas_MR  8
+#define NUMblas_NR  4
+#define NUMblas_MC  128
+#define NUMblas_KC  256
+#define NUMblas_NC  2048
+#define NUMblas_BLOCK_SIZE  64   /* of the diagonal blocks in dsyr2k and dtrsm */
+#define NUMblas_MINIMUM_BLOCKED_WORK  30000.0   /* m * n * k below which packing does not pay */
+#define NUMblas_MINIMUM_WORK_PER_THREAD  1000000.0
+
+static inline bool NUMblas_useReference () {
+	return Melder_debug == 48;
+}
+
+/*
+	c [0..mr-1] [0..nr-1] (column-major with leading dimension ldc) += the product of
+	kc columns of MR packed elements of op(A) and kc rows of NR packed elements of op(B).
+*/
+static void NUMblas_dgemm_microKernel (long kc, const double *a, const double *b, double *c, long ldc, long mr, long nr) {
+	double ab [NUMblas_NR] [NUMblas_MR] = { { 0.0 } };
+	for (long p = 0; p < kc; p ++) {
+		for (int j = 0; j < NUMblas_NR; j ++)
+			for (int i = 0; i < NUMblas_MR; i ++)
+				ab [j] [i] += a [i] * b [j];
+		a += NUMblas_MR;
+		b += NUMblas_NR;
+	}
+	for (long j = 0; j < nr; j ++)
+		for (long i = 0; i < mr; i ++)
+			c [i + j * ldc] += ab [j] [i];
+}
+
+/*
+	Pack rows ic..ic+mc-1 and columns pc..pc+kc-1 of op(A) into panels of MR rows, padded with zeroes.
+*/
+static void NUMblas_dgemm_packA (bool transposed, const double *a, long lda, long ic, long pc, long mc, long kc, double *packed) {
+	for (long ir = 0; ir < mc; ir += NUMblas_MR) {
+		long mr = MIN (NUMblas_MR, mc - ir);
+		for (long p = 0; p < kc; p ++) {
+			for (long i = 0; i < mr; i ++)
+				packed [i] = transposed ? a [(pc + p) + (ic + ir + i) * lda] : a [(ic + ir + i) + (pc + p) * lda];
+			for (long i = mr; i < NUMblas_MR; i ++)
+				packed [i] = 0.0;
+			packed += NUMblas_MR;
+		}
+	}
+}
+
+/*
+	Pack rows pc..pc+kc-1 and columns jc..jc+nc-1 of alpha * op(B) into panels of NR columns, padded with zeroes.
+*/
+static void NUMblas_dgemm_packB (bool transposed, const double *b, long ldb, double alpha, long pc, long jc, long kc, long nc, double *packed) {
+	for (long jr = 0; jr < nc; jr += NUMblas_NR) {
+		long nr = MIN (NUMblas_NR, nc - jr);
+		for (long p = 0; p < kc; p ++) {
+			for (long j = 0; j < nr; j ++)
+				packed [j] = alpha * ( transposed ? b [(jc + jr + j) + (pc + p) * ldb] : b [(pc + p) + (jc + jr + j) * ldb] );
+			for (long j = nr; j < NUMblas_NR; j ++)
+				packed [j] = 0.0;
+			packed += NUMblas_NR;
+		}
+	}
+}
+
+struct NUMblas_GemmChunk {
+	bool transposedA;
+	const double *a;
+	long lda;
+	const double *packedB;
+	double *c;
+	long ldc;
+	long firstRow, lastRow, rowBlockSize;   // 0-based rows of C
+	long pc, jc, kc, nc;
+	double *packedA;   // room for rowBlockSize x kc elements, allocated on the calling thread
+};
+
+static MelderThread_RETURN_TYPE NUMblas_GemmChunk_run (NUMblas_GemmChunk *me) {
+	for (long ic = my firstRow; ic <= my lastRow; ic += my rowBlockSize) {
+		long mc = MIN (my rowBlockSize, my lastRow - ic + 1);
+		NUMblas_dgemm_packA (my transposedA, my a, my lda, ic, my pc, mc, my kc, my packedA);
+		for (long jr = 0; jr < my nc; jr += NUMblas_NR) {
+			long nr = MIN (NUMblas_NR, my nc - jr);
+			for (long ir = 0; ir < mc; ir += NUMblas_MR) {
+				long mr = MIN (NUMblas_MR, mc - ir);
+				NUMblas_dgemm_microKernel (my kc, & my packedA [ir * my kc], & my packedB [jr * my kc],
+					& my c [(ic + ir) + (my jc + jr) * my ldc], my ldc, mr, nr);
+			}
+		}
+	}
+	MelderThread_RETURN;
+}
+
+int NUMblas_dgemm (const char *transa, const char *transb, long *m, long *n, long *k, double *alpha, double *a, long *lda,
+	double *b, long *ldb, double *beta, double *c, long *ldc)
+{
+	const bool notA = lsame_ (transa, "N"), notB = lsame_ (transb, "N");
+	const bool valid =
+		(notA || lsame_ (transa, "T") || lsame_ (transa, "C")) && (notB || lsame_ (transb, "T") || lsame_ (transb, "C")) &&
+		*m >= 0 && *n >= 0 && *k >= 0 &&
+		*lda >= MAX (1, notA ? *m : *k) && *ldb >= MAX (1, notB ? *k : *n) && *ldc >= MAX (1, *m);
+	if (NUMblas_useReference () || ! valid || *alpha == 0.0 || (double) *m * *n * *k < NUMblas_MINIMUM_BLOCKED_WORK)
+		return NUMblas_dgemm_reference (transa, transb, m, n, k, alpha, a, lda, b, ldb, beta, c, ldc);
+	const long numberOfRows = *m, numberOfColumns = *n, depth = *k, ldc_ = *ldc;
+
+	/*
+		C := beta * C, without touching C if beta is 1, and without multiplying if beta is 0 (C may contain NaNs).
+	*/
+	if (*beta != 1.0) {
+		for (long j = 0; j < numberOfColumns; j ++) {
+			double *cj = & c [j * ldc_];
+			if (*beta == 0.0)
+				for (long i = 0; i < numberOfRows; i ++) cj [i] = 0.0;
+			else
+				for (long i = 0; i < numberOfRows; i ++) cj [i] *= *beta;
+		}
+	}
+
+	/*
+		Divide the rows of C over the threads; each thread works on blocks of at most MC rows.
+	*/
+	double workPerColumnBlock = (double) numberOfRows * MIN (numberOfColumns, NUMblas_NC) * MIN (depth, NUMblas_KC);
+	long numberOfThreads = MIN ((long) MelderThread_getNumberOfProcessors (),
+		MAX (1L, (long) (workPerColumnBlock / NUMblas_MINIMUM_WORK_PER_THREAD)));
+	long rowsPerThread = (numberOfRows - 1) / numberOfThreads + 1;
+	rowsPerThread = ((rowsPerThread - 1) / NUMblas_MR + 1) * NUMblas_MR;   // whole micro-panels
+	numberOfThreads = (numberOfRows - 1) / rowsPerThread + 1;   // no empty chunks
+	const long rowBlockSize = MIN (rowsPerThread, (long) (NUMblas_MC / NUMblas_MR * NUMblas_MR));   // whole micro-panels
+	const long maximumKc = MIN (depth, NUMblas_KC);
+	const long maximumNc = ((MIN (numberOfColumns, NUMblas_NC) - 1) / NUMblas_NR + 1) * NUMblas_NR;
+	autoNUMvector <double> packedB ((long) 0, maximumKc * maximumNc - 1);
+	autoNUMvector <double> packedA ((long) 0, numberOfThreads * rowBlockSize * maximumKc - 1);
+	std::vector <NUMblas_GemmChunk> chunks ((size_t) numberOfThreads);
+	for (long ithread = 0; ithread < numberOfThreads; ithread ++) {
+		NUMblas_GemmChunk *chunk = & chunks [(size_t) ithread];
+		chunk -> transposedA = ! notA;
+		chunk -> a = a;
+		chunk -> lda = *lda;
+		chunk -> packedB = packedB.peek();
+		chunk -> c = c;
+		chunk -> ldc = ldc_;
+		chunk -> firstRow = ithread * rowsPerThread;
+		chunk -> lastRow = MIN ((ithread + 1) * rowsPerThread, numberOfRows) - 1;
+		chunk -> rowBlockSize = rowBlockSize;
+		chunk -> packedA = & packedA [ithread * rowBlockSize * maximumKc];
+	}
+	for (long jc = 0; jc < numberOfColumns; jc += NUMblas_NC) {
+		long nc = MIN ((long) NUMblas_NC, numberOfColumns - jc);
+		for (long pc = 0; pc < depth; pc += NUMblas_KC) {
+			long kc = MIN ((long) NUMblas_KC, depth - pc);
+			NUMblas_dgemm_packB (! notB, b, *ldb, *alpha, pc, jc, kc, nc, packedB.peek());
+			for (long ithread = 0; ithread < numberOfThreads; ithread ++) {
+				NUMblas_GemmChunk *chunk = & chunks [(size_t) ithread];
+				chunk -> pc = pc;
+				chunk -> jc = jc;
+				chunk -> kc = kc;
+				chunk -> nc = nc;
+			}
+			MelderThread_run (NUMblas_GemmChunk_run, chunks.data(), (int) numberOfThreads);
+		}
+	}
+	return 0;
+}
+
+int NUMblas_dsyr2k (const char *uplo, const char *trans, long *n, long *k, double *alpha, double *a, long *lda, double *b,
+	long *ldb, double *beta, double *c, long *ldc)
+{
+	const bool upper = lsame_ (uplo, "U"), notrans = lsame_ (trans, "N");
+	const bool valid = (upper || lsame_ (uplo, "L")) && (notrans || lsame_ (trans, "T") || lsame_ (trans, "C")) &&
+		*n >= 0 && *k >= 0 && *lda >= MAX (1, notrans ? *n : *k) && *ldb >= MAX (1, notrans ? *n : *k) && *ldc >= MAX (1, *n);
+	if (NUMblas_useReference () || ! valid || *alpha == 0.0 || *n < 2 * NUMblas_BLOCK_SIZE ||
+		(double) *n * *n * *k < 2.0 * NUMblas_MINIMUM_BLOCKED_WORK)
+	{
+		return NUMblas_dsyr2k_reference (uplo, trans, n, k, alpha, a, lda, b, ldb, beta, c, ldc);
+	}
+	const long order = *n;
+	double one = 1.0;
+	/*
+		For every block column J of the triangle of C: the diagonal block C(J,J) with the reference routine,
+		and the rectangle C(R,J) above (upper) or below (lower) it as two general products:
+		alpha * op(A)(R) * op(B)(J)' + alpha * op(B)(R) * op(A)(J)' + beta * C(R,J).
+	*/
+	for (long j = 0; j < order; j += NUMblas_BLOCK_SIZE) {
+		long nb = MIN ((long) NUMblas_BLOCK_SIZE, order - j);
+		if (notrans) {
+			NUMblas_dsyr2k_reference (uplo, trans, & nb, k, alpha, & a [j], lda, & b [j], ldb, beta, & c [j + j * *ldc], ldc);
+		} else {
+			NUMblas_dsyr2k_reference (uplo, trans, & nb, k, alpha, & a [j * *lda], lda, & b [j * *ldb], ldb, beta, & c [j + j * *ldc], ldc);
+		}
+		long firstRow = upper ? 0 : j + nb;
+		long numberOfRows = upper ? j : order - j - nb;
+		if (numberOfRows == 0) continue;
+		double *cRJ = & c [firstRow + j * *ldc];
+		if (notrans) {
+			NUMblas_dgemm ("N", "T", & numberOfRows, & nb, k, alpha, & a [firstRow], lda, & b [j], ldb, beta, cRJ, ldc);
+			NUMblas_dgemm ("N", "T", & numberOfRows, & nb, k, alpha, & b [firstRow], ldb, & a [j], lda, & one, cRJ, ldc);
+		} else {
+			NUMblas_dgemm ("T", "N", & numberOfRows, & nb, k, alpha, & a [firstRow * *lda], lda, & b [j * *ldb], ldb, beta, cRJ, ldc);
+			NUMblas_dgemm ("T", "N", & numberOfRows, & nb, k, alpha, & b [firstRow * *ldb], ldb, & a [j * *lda], lda, & one, cRJ, ldc);
+		}
+	}
+	return 0;
+}
+
+int NUMblas_dtrsm (const char *side, const char *uplo, const char *transa, const char *diag, long *m, long *n,
+	double *alpha, double *a, long *lda, double *b, long *ldb)
+{
+	const bool left = lsame_ (side, "L"), upper = lsame_ (uplo, "U"), notrans = lsame_ (transa, "N");
+	const long order = left ? *m : *n;
+	const bool valid = (left || lsame_ (side, "R")) && (upper || lsame_ (uplo, "L")) &&
+		(notrans || lsame_ (transa, "T") || lsame_ (transa, "C")) && (lsame_ (diag, "U") || lsame_ (diag, "N")) &&
+		*m >= 0 && *n >= 0 && *lda >= MAX (1, order) && *ldb >= MAX (1, *m);
+	if (NUMblas_useReference () || ! valid || *alpha == 0.0 || order < 2 * NUMblas_BLOCK_SIZE ||
+		(double) order * order * (left ? *n : *m) < 2.0 * NUMblas_MINIMUM_BLOCKED_WORK)
+	{
+		return NUMblas_dtrsm_reference (side, uplo, transa, diag, m, n, alpha, a, lda, b, ldb);
+	}
+	const long numberOfRows = *m, numberOfColumns = *n, lda_ = *lda, ldb_ = *ldb;
+	double one = 1.0, minusOne = -1.0;
+	#define A_(i,j)  (& a [(i) + (j) * lda_])
+	#define B_(i,j)  (& b [(i) + (j) * ldb_])
+	if (*alpha != 1.0) {
+		for (long j = 0; j < numberOfColumns; j ++)
+			for (long i = 0; i < numberOfRows; i ++)
+				* B_(i, j) *= *alpha;
+	}
+	/*
+		Solve for one block of NUMblas_BLOCK_SIZE rows (left) or columns (right) of X at a time,
+		in the order in which op(A) allows it, and subtract its contribution from the rows or columns still to be solved.
+	*/
+	const bool lowerOp = ( upper != notrans );   // op(A) is lower triangular
+	const bool forward = ( left == lowerOp );
+	for (long iblock = 0; iblock < order; iblock += NUMblas_BLOCK_SIZE) {
+		long nb = MIN ((long) NUMblas_BLOCK_SIZE, order - iblock);
+		long first = forward ? iblock : order - iblock - nb;   // the block that is solved now
+		long firstOther = forward ? first + nb : 0, numberOfOthers = forward ? order - first - nb : first;   // the blocks still to be solved
+		if (left) {
+			NUMblas_dtrsm_reference (side, uplo, transa, diag, & nb, n, & one, A_(first, first), lda, B_(first, 0), ldb);
+			if (numberOfOthers == 0) continue;
+			/* B(others,:) -= op(A)(others,first) * X(first,:) */
+			if (notrans)
+				NUMblas_dgemm ("N", "N", & numberOfOthers, n, & nb, & minusOne, A_(firstOther, first), lda,
+					B_(first, 0), ldb, & one, B_(firstOther, 0), ldb);
+			else
+				NUMblas_dgemm ("T", "N", & numberOfOthers, n, & nb, & minusOne, A_(first, firstOther), lda,
+					B_(first, 0), ldb, & one, B_(firstOther, 0), ldb);
+		} else {
+			NUMblas_dtrsm_reference (side, uplo, transa, diag, m, & nb, & one, A_(first, first), lda, B_(0, first), ldb);
+			if (numberOfOthers == 0) continue;
+			/* B(:,others) -= X(:,first) * op(A)(first,others) */
+			if (notrans)
+				NUMblas_dgemm ("N", "N", m, & numberOfOthers, & nb, & minusOne, B_(0, first), ldb,
+					A_(first, firstOther), lda, & one, B_(0, firstOther), ldb);
+			else
+				NUMblas_dgemm ("N", "T", m, & numberOfOthers, & nb, & minusOne, B_(0, first), ldb,
+					A_(firstOther, first), lda, & one, B_(0, firstOther), ldb);
+		}
+	}
+	#undef A_
+	#undef B_
+	return 0;
+}
+
 #undef MAX
 #undef MIN
 
@@ -24,6 +24,7 @@
  djmw 20080122 float -> double
  */
 
+#include <vector>
 #include "CCs_to_DTW.h"
 
 static void regression (CC me, long frame, double r[], long nr) {
@@ -54,6 +55,92 @@ static void regression (CC me, long frame, double r[], long nr) {
 	}
 }
 
+/*
+	The distances between the frames of two CCs, computed cell by cell whenever the DTW needs them.
+	The coefficients are copied, so that the DTW does not depend on the CC objects.
+*/
+struct CCs_FrameDistance {
+	double wc, wle, wr, wer;
+	long stride;   // maximumNumberOfCoefficients + 1
+	std::vector <double> ci, cj;   // [(frame - 1) * stride + k] = coefficient k of the frame, with c [0] = c0
+	std::vector <long> numberOfCoefficientsj;   // [frame - 1]
+	std::vector <double> ri, rj;   // the regression coefficients, in the same arrangement
+
+	double operator() (long i, long j) const {
+		const double *fi = & ci [(size_t) ((i - 1) * stride)], *fj = & cj [(size_t) ((j - 1) * stride)];
+		const long numberOfCoefficients = numberOfCoefficientsj [(size_t) j - 1];
+		double dist = 0.0, distr = 0.0;
+
+		/* Cepstral distance. */
+
+		if (wc != 0.0) {
+			for (long k = 1; k <= numberOfCoefficients; k ++) {
+				double d = fi [k] - fj [k];
+				dist += d * d;
+			}
+			dist *= wc;
+		}
+
+		/* Log energy distance. */
+
+		if (wle != 0.0) {
+			double d = fi [0] - fj [0];
+			dist += wle * d * d;
+		}
+
+		/* Regression distance. */
+
+		const double *rfi = wr != 0.0 || wer != 0.0 ? & ri [(size_t) ((i - 1) * stride)] : nullptr;
+		const double *rfj = wr != 0.0 || wer != 0.0 ? & rj [(size_t) ((j - 1) * stride)] : nullptr;
+		if (wr != 0.0) {
+			for (long k = 1; k <= numberOfCoefficients; k ++) {
+				double d = rfi [k] - rfj [k];
+				distr += d * d;
+			}
+			dist += wr * distr;
+		}
+
+		/* Regression on c[0]: log(energy) */
+
+		if (wer != 0.0) {
+			double d = rfi [0] - rfj [0];
+			dist += wer * d * d;
+		}
+
+		dist /= wc + wle + wr + wer;
+		return sqrt (dist);   // prototype along y-direction
+	}
+};
+
+static void CC_getCoefficients (CC me, long stride, std::vector <double> *c, std::vector <long> *numberOfCoefficients) {
+	c -> assign ((size_t) (my nx * stride), 0.0);
+	if (numberOfCoefficients) {
+		numberOfCoefficients -> assign ((size_t) my nx, 0);
+	}
+	for (long iframe = 1; iframe <= my nx; iframe ++) {
+		CC_Frame cf = & my frame [iframe];
+		double *to = & (*c) [(size_t) ((iframe - 1) * stride)];
+		to [0] = cf -> c0;
+		for (long k = 1; k <= cf -> numberOfCoefficients; k ++) {
+			to [k] = cf -> c [k];
+		}
+		if (numberOfCoefficients) {
+			(*numberOfCoefficients) [(size_t) iframe - 1] = cf -> numberOfCoefficients;
+		}
+	}
+}
+
+/*
+	The regression coefficients of every frame are computed once, instead of once for every pair of frames.
+	Frames too close to the edges for a full regression window get zero coefficients.
+*/
+static void CC_getRegressionCoefficients (CC me, long stride, long nr, std::vector <double> *r) {
+	r -> assign ((size_t) (my nx * stride), 0.0);
+	for (long iframe = 1; iframe <= my nx; iframe ++) {
+		regression (me, iframe, & (*r) [(size_t) ((iframe - 1) * stride)], nr);
+	}
+}
+
 autoDTW CCs_to_DTW (CC me, CC thee, double wc, double wle, double wr, double wer, double dtr) {
 	try {
 		if (my maximumNumberOfCoefficients != thy maximumNumberOfCoefficients) {
@@ -71,68 +158,25 @@ autoDTW CCs_to_DTW (CC me, CC thee, double wc, double wle, double wr, double wer
 			Melder_casual (nr, U" frames used for regression coefficients.");
 		}
 
-		autoDTW him = DTW_create (my xmin, my xmax, my nx, my dx, my x1, thy xmin, thy xmax, thy nx, thy dx, thy x1);
-		autoNUMvector<double> ri (0L, my maximumNumberOfCoefficients);
-		autoNUMvector<double> rj (0L, my maximumNumberOfCoefficients);
-
-		/* Calculate distance matrix. */
-
-		autoMelderProgress progess (U"CCs_to_DTW");
-		for (long i = 1; i <= my nx; i ++) {
-			CC_Frame fi = & my frame [i];
-
-			regression (me, i, ri.peek(), nr);
-
-			for (long j = 1; j <= thy nx; j ++) {
-				CC_Frame fj = & thy frame [j];
-				double dist = 0.0, distr = 0.0;
-
-				/* Cepstral distance. */
-
-				if (wc != 0.0) {
-					for (long k = 1; k <= fj -> numberOfCoefficients; k ++) {
-						double d = fi -> c [k] - fj -> c [k];
-						dist += d * d;
-					}
-					dist *= wc;
-				}
-
-				/* Log energy distance. */
-
-				if (wle != 0.0) {
-					double d = fi -> c0 - fj -> c0;
-					dist += wle * d * d;
-				}
-
-				/* Regression distance. */
-
-				if (wr != 0.0) {
-					regression (thee, j, rj.peek(), nr);
-					for (long k = 1; k <= fj -> numberOfCoefficients; k ++) {
-						double d = ri [k] - rj [k];
-						distr += d * d;
-					}
-					dist += wr * distr;
-				}
-
-				/* Regression on c[0]: log(energy) */
-
-				if (wer != 0.0) {
-					if (wr == 0.0) {
-						regression (thee, j, rj.peek(), nr);
-					}
-					double d = ri [0] - rj [0];
-					dist += wer * d * d;
-				}
-
-				dist /= wc + wle + wr + wer;
-				his z [i] [j] = sqrt (dist);   // prototype along y-direction
-			}
-
-			if (i % 10 == 1) {
-				Melder_progress (0.999 * i / my nx, U"Calculate distances: frame ", i, U" from ", my nx, U".");
-			}
+		CCs_FrameDistance distance;
+		distance. wc = wc;
+		distance. wle = wle;
+		distance. wr = wr;
+		distance. wer = wer;
+		distance. stride = my maximumNumberOfCoefficients + 1;
+		CC_getCoefficients (me, distance. stride, & distance. ci, nullptr);
+		CC_getCoefficients (thee, distance. stride, & distance. cj, & distance. numberOfCoefficientsj);
+		if (wr != 0.0 || wer != 0.0) {
+			CC_getRegressionCoefficients (me, distance. stride, nr, & distance. ri);
+			CC_getRegressionCoefficients (thee, distance. stride, nr, & distance. rj);
 		}
+
+		/*
+			The distance matrix is not calculated here: a path search computes only the distances inside its band,
+			and the whole matrix is computed only if it is drawn, queried or saved.
+		*/
+		autoDTW him = DTW_createWithDistanceFunction (my xmin, my xmax, my nx, my dx, my x1, thy xmin, thy xmax, thy nx, thy dx, thy x1,
+			distance);
 		return him;
 	} catch (MelderError) {
 		Melder_throw (U"DTW not created from CCs.");
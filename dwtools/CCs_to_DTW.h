@@ -42,6 +42,7 @@ autoDTW CCs_to_DTW (CC me, CC thee, double wc, double wle, double wr, double wer
 				from the frames within a time span of 'dtr' seconds.
 				c[i,j] is jth cepstral coefficient in frame i.
 			d4 = regression on energy (c[0])
+		The distances are computed only when they are needed (see DTW_createWithDistanceFunction).
 	2. Find optimum path through the distance matrix (see DTW).
 
 	PRECONDITIONS:
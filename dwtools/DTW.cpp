@@ -61,6 +61,57 @@
 #include "oo_DESCRIPTION.h"
 #include "DTW_def.h"
 
+Thing_implement (DeferredMatrix, Matrix, 0);
+
+void DeferredMatrix_materialize (DeferredMatrix me) {
+	if (my z) return;
+	autoNUMmatrix <double> z (1, my ny, 1, my nx);
+	for (long irow = 1; irow <= my ny; irow ++) {
+		for (long icol = 1; icol <= my nx; icol ++) {
+			z [irow] [icol] = my computeCell (irow, icol);
+		}
+	}
+	my z = z.transfer();
+	my computeCell = nullptr;   // releases whatever the function held on to
+}
+
+void structDeferredMatrix :: v_copy (Daata thee) {
+	DeferredMatrix_materialize (this);
+	DeferredMatrix_Parent :: v_copy (thee);
+}
+
+bool structDeferredMatrix :: v_equal (Daata otherData) {
+	DeferredMatrix_materialize (this);
+	DeferredMatrix_materialize (static_cast <DeferredMatrix> (otherData));
+	return DeferredMatrix_Parent :: v_equal (otherData);
+}
+
+void structDeferredMatrix :: v_writeText (MelderFile openFile) {
+	DeferredMatrix_materialize (this);
+	DeferredMatrix_Parent :: v_writeText (openFile);
+}
+
+void structDeferredMatrix :: v_writeBinary (FILE *f) {
+	DeferredMatrix_materialize (this);
+	DeferredMatrix_Parent :: v_writeBinary (f);
+}
+
+double structDeferredMatrix :: v_getMatrix (long irow, long icol) {
+	if (irow < 1 || irow > our ny) return 0.0;
+	if (icol < 1 || icol > our nx) return 0.0;
+	return DeferredMatrix_getValue (this, irow, icol);
+}
+
+double structDeferredMatrix :: v_getFunction2 (double x, double y) {
+	DeferredMatrix_materialize (this);
+	return DeferredMatrix_Parent :: v_getFunction2 (x, y);
+}
+
+double structDeferredMatrix :: v_getValueAtSample (long isamp, long ilevel, int unit) {
+	DeferredMatrix_materialize (this);
+	return DeferredMatrix_Parent :: v_getValueAtSample (isamp, ilevel, unit);
+}
+
 Thing_implement (DTW, Matrix, 2);
 
 #define DTW_BIG 1e308
@@ -76,7 +127,7 @@ void structDTW :: v_info () {
 	if (nx == ny) {
 		double dd = 0;
 		for (long i = 1; i <= nx; i++) {
-			dd += z[i][i];
+			dd += DeferredMatrix_getValue (this, i, i);
 		}
 		MelderInfo_writeLine (U"Distance along diagonal: ", dd / nx);
 	}
@@ -430,18 +481,40 @@ autoDTW DTW_create (double tminp, double tmaxp, long ntp, double dtp, double t1p
 	}
 }
 
+autoDTW DTW_createWithDistanceFunction (double tminp, double tmaxp, long ntp, double dtp, double t1p,
+	double tminc, double tmaxc, long ntc, double dtc, double t1c, std::function <double (long iy, long ix)> distance)
+{
+	try {
+		autoDTW me = Thing_new (DTW);
+		SampledXY_init (me.get(), tminc, tmaxc, ntc, dtc, t1c, tminp, tmaxp, ntp, dtp, t1p);   // no z
+		my computeCell = distance;
+		my path = NUMvector<structDTW_Path> (1, ntc + ntp - 1);
+		DTW_Path_Query_init (& my pathQuery, ntp, ntc);
+		my wx = 1; my wy = 1; my wd = 2;
+		return me;
+	} catch (MelderError) {
+		Melder_throw (U"DTW not created.");
+	}
+}
+
 void DTW_setWeights (DTW me, double wx, double wy, double wd) {
 	my wx = wx; my wy = wy; my wd = wd;
 }
 
 autoDTW DTW_swapAxes (DTW me) {
 	try {
-		autoDTW thee = DTW_create (my xmin, my xmax, my nx, my dx, my x1, my ymin, my ymax, my ny, my dy, my y1);
-
-		for (long x = 1; x <= my nx; x++) {
-			for (long y = 1; y <= my ny; y++) {
-				thy z[x][y] = my z[y][x];
+		autoDTW thee;
+		if (my z) {
+			thee = DTW_create (my xmin, my xmax, my nx, my dx, my x1, my ymin, my ymax, my ny, my dy, my y1);
+			for (long x = 1; x <= my nx; x++) {
+				for (long y = 1; y <= my ny; y++) {
+					thy z[x][y] = my z[y][x];
+				}
 			}
+		} else {
+			std::function <double (long iy, long ix)> distance = my computeCell;
+			thee = DTW_createWithDistanceFunction (my xmin, my xmax, my nx, my dx, my x1, my ymin, my ymax, my ny, my dy, my y1,
+				[distance] (long iy, long ix) { return distance (ix, iy); });
 		}
 		thy pathLength = my pathLength;
 		for (long i = 1; i <= my pathLength; i++) {
@@ -608,6 +681,7 @@ static void DTW_paintDistances_raw (DTW me, Graphics g, double xmin, double xmax
 	                                 & ixmin, & ixmax);
 	(void) Matrix_getWindowSamplesY (me, ymin - 0.49999 * my dy, ymax + 0.49999 * my dy,
 	                                 & iymin, & iymax);
+	DeferredMatrix_materialize (me);
 	if (maximum <= minimum) {
 		(void) Matrix_getWindowExtrema (me, ixmin, ixmax, iymin, iymax, & minimum, & maximum);
 	}
@@ -868,6 +942,7 @@ void DTW_and_Sounds_drawWarpX (DTW me, Sound yy, Sound xx, Graphics g, double xm
 
 autoMatrix DTW_to_Matrix_distances (DTW me) {
 	try {
+		DeferredMatrix_materialize (me);
 		autoMatrix thee = Matrix_create (my xmin, my xmax, my nx, my dx, my x1, my ymin, my ymax, my ny, my dy, my y1);
 		NUMmatrix_copyElements (my z, thy z, 1, my ny, 1, my nx);
 		return thee;
@@ -900,7 +975,7 @@ void DTW_drawDistancesAlongPath (DTW me, Graphics g, double xmin, double xmax, d
 	autoNUMvector<double> d (ixmin, ixmax);
 
 	for (long i = ixmin; i <= ixmax; i++) {
-		d[i] = my z[my path[i].y][i];
+		d[i] = DeferredMatrix_getValue (me, my path[i].y, i);
 	}
 
 	if (dmin >= dmax) {
@@ -1126,6 +1201,7 @@ void DTW_and_Matrix_replace (DTW me, Matrix thee) {
 		if (my nx != thy nx || my dx != thy dx || my ny != thy ny || my dy != thy dy) {
 			Melder_throw (U"The sampling of the matrix and the DTW must be equal.");
 		}
+		DeferredMatrix_materialize (me);
 		double minimum, maximum;
 		Matrix_getWindowExtrema (me, 0, 0, 0, 0, & minimum, & maximum);
 		if (minimum < 0) {
@@ -1176,7 +1252,10 @@ static void DTW_checkSlopeConstraints (DTW me, double band, int slope) {
     }
 }
 
-static void DTW_and_Polygon_setUnreachableParts (DTW me, Polygon thee, long **psi) {
+/*
+	Narrows the band of rows ylow[ix]..yhigh[ix] of each column to the part inside the Polygon.
+*/
+static void DTW_and_Polygon_narrowReachableRows (DTW me, Polygon thee, long *ylow, long *yhigh) {
     try {
         double eps = my dx / 100; // safely enough
         double dtw_slope = (my ymax - my ymin) / (my xmax - my xmin);
@@ -1194,9 +1273,7 @@ static void DTW_and_Polygon_setUnreachableParts (DTW me, Polygon thee, long **ps
             for (long iy = iystart + 1; iy <= my ny; iy++) {
                 double y = my y1 + (iy - 1) * my dy;
                 if (Polygon_getLocationOfPoint (thee, x, y, eps) == Polygon_OUTSIDE) {
-                    for (long k = iy; k <= my ny; k++) {
-                        psi[k][ix] =  DTW_UNREACHABLE;
-                    }
+                    if (yhigh[ix] >= iy) yhigh[ix] = iy - 1;
                     break;
                 }
             }
@@ -1209,9 +1286,7 @@ static void DTW_and_Polygon_setUnreachableParts (DTW me, Polygon thee, long **ps
             for (long iy = iystart - 1; iy >= 1; iy--) {
                 double y = my y1 + (iy - 1) * my dy;
                 if (Polygon_getLocationOfPoint (thee, x, y, eps) == Polygon_OUTSIDE) {
-                    for (long k = iy; k >= 1; k--) {
-                        psi[k][ix] = DTW_UNREACHABLE;
-                    }
+                    if (ylow[ix] <= iy) ylow[ix] = iy + 1;
                     break;
                 }
             }
@@ -1222,7 +1297,6 @@ static void DTW_and_Polygon_setUnreachableParts (DTW me, Polygon thee, long **ps
 
 }
 
-#define DTW_ISREACHABLE(y,x) ((psi[y][x] != DTW_UNREACHABLE) && (psi[y][x] != DTW_FORBIDDEN))
 static void DTW_findPath_special (DTW me, int matchStart, int matchEnd, int slope, autoMatrix *cummulativeDists) {
     (void) matchStart;
     (void) matchEnd;
@@ -1344,71 +1418,94 @@ void DTW_and_Polygon_findPathInside (DTW me, Polygon thee, int localSlope, autoM
             Melder_throw (U"Local slope parameter is illegal.");
         }
 
-        autoNUMmatrix<double> delta (-2, my ny, -2, my nx);
-        autoNUMmatrix<long> psi (-2, my ny, -2, my nx);
-        for (long i = 1; i <= my ny; i++) {
-            for (long j = 1; j <= my nx; j++) {
-                delta[i][j] = my z[i][j];
-            }
+        /*
+            Only the cells inside the band of column ix, i.e. rows ylow[ix] to yhigh[ix], can be reached;
+            only for these cells the distance, the cumulative distance and the direction are stored,
+            column after column, so that the memory needed is proportional to the area of the band.
+            If the DTW has no distance matrix yet, only these distances (and those of the begin parts
+            of the first row and column) are computed.
+        */
+        long rowto = delta_xy;
+        if (localSlope != 1) {
+			rowto = (long) floor (slopes[localSlope]) + 1;
+		}
+        if (rowto > my ny) rowto = my ny;
+        long colto = delta_xy;
+        if (localSlope != 1) {
+			colto = (long) floor (slopes[localSlope]) + 1;
+		}
+        if (colto > my nx) colto = my nx;
+        autoNUMvector<long> ylow (1, my nx), yhigh (1, my nx), offset (1, my nx);
+        ylow[1] = 2; // the begin part of the first column is reachable
+        yhigh[1] = rowto;
+        for (long ix = 2; ix <= my nx; ix++) {
+            ylow[ix] = ix <= colto ? 1 : 2; // as is the begin part of the first row
+            yhigh[ix] = my ny;
         }
-        // start by making the outside unreachable
-        for (long k = -2; k <= 1; k++) {
-           for (long j = -2; j <= my nx; j++) {
-               // delta[k][j] = DTW_BIG;
-                psi[k][j] = DTW_UNREACHABLE;
+        DTW_and_Polygon_narrowReachableRows (me, thee, ylow.peek(), yhigh.peek());
+        long numberOfCells = 0;
+        for (long ix = 1; ix <= my nx; ix++) {
+            offset[ix] = numberOfCells;
+            if (yhigh[ix] >= ylow[ix]) {
+                numberOfCells += yhigh[ix] - ylow[ix] + 1;
             }
-            for (long i = 1; i <= my ny; i++) {
-             //   delta[i][k] = DTW_BIG;
-                psi[i][k] = DTW_UNREACHABLE;
+        }
+        autoNUMvector<double> delta ((long) 0, numberOfCells);
+        autoNUMvector<signed char> psi ((long) 0, numberOfCells);
+        autoNUMvector<double> distance ((long) 0, numberOfCells);
+        #define DTW_INBAND(y,x) ((x) >= 1 && (x) <= my nx && (y) >= ylow[x] && (y) <= yhigh[x])
+        #define DTW_CELL(y,x) (offset[x] + (y) - ylow[x])
+        #define DTW_PSI(y,x) (DTW_INBAND (y, x) ? psi[DTW_CELL (y, x)] : DTW_UNREACHABLE)
+        #define DTW_ISREACHABLE(y,x) ((DTW_PSI (y, x) != DTW_UNREACHABLE) && (DTW_PSI (y, x) != DTW_FORBIDDEN))
+        #define DTW_DISTANCE(y,x) distance[DTW_CELL (y, x)]
+        for (long ix = 1; ix <= my nx; ix++) {
+            for (long iy = ylow[ix]; iy <= yhigh[ix]; iy++) {
+                delta[DTW_CELL (iy, ix)] = DTW_DISTANCE (iy, ix) = DeferredMatrix_getValue (me, iy, ix);
             }
         }
 
         // Make begin part of first column reachable
-        long rowto = delta_xy;
-        if (localSlope != 1) {
-			rowto = (long) floor (slopes[localSlope]) + 1;
-		}
+        const double distance11 = DeferredMatrix_getValue (me, 1, 1);
+        double sum = distance11;
         for (long iy = 2; iy <= rowto; iy++) {
+            sum += DeferredMatrix_getValue (me, iy, 1);
+            if (! DTW_INBAND (iy, 1)) continue;
             if (localSlope != 1) {
-                delta[iy][1] = delta[iy - 1][1] + my z[iy][1];
-                psi[iy][1] = DTW_Y;
+                delta[DTW_CELL (iy, 1)] = sum;
+                psi[DTW_CELL (iy, 1)] = DTW_Y;
             } else {
-                psi[iy][1] = DTW_START; // will be adapted by DTW_and_Polygon_setUnreachableParts
+                psi[DTW_CELL (iy, 1)] = DTW_START;
             }
         }
         // Make begin part of first row reachable
-        long colto = delta_xy;
-        if (localSlope != 1) {
-			colto = (long) floor (slopes[localSlope]) + 1;
-		}
+        sum = distance11;
         for (long ix = 2; ix <= colto; ix++) {
+            sum += DeferredMatrix_getValue (me, 1, ix);
+            if (! DTW_INBAND (1, ix)) continue;
             if (localSlope != 1) {
-                delta[1][ix] = delta[1][ix -1] + my z[1][ix];
-                psi[1][ix] = DTW_X;
+                delta[DTW_CELL (1, ix)] = sum;
+                psi[DTW_CELL (1, ix)] = DTW_X;
             } else {
-                psi[1][ix] = DTW_START; // will be adapted by DTW_and_Polygon_setUnreachableParts
+                psi[DTW_CELL (1, ix)] = DTW_START;
            }
         }
 
-        // Now we can set the unreachable parts from the Polygon
-        DTW_and_Polygon_setUnreachableParts (me, thee, psi.peek());
-
         // Forward pass.
         long numberOfIsolatedPoints = 0;
         autoMelderProgress progress (U"Find path");
         for (long j = 2; j <= my nx; j++) {
-            for (long i = 2; i <= my ny; i++) {
+            for (long i = ylow[j] > 2 ? ylow[j] : 2; i <= yhigh[j]; i++) {
                 if (! DTW_ISREACHABLE (i, j)) continue;
                 double g, gmin = DTW_BIG;
                 long direction = 0;
                 if (DTW_ISREACHABLE (i - 1, j - 1)) {
-                    gmin = delta[i - 1][j - 1] + 2 * my z[i][j];
+                    gmin = delta[DTW_CELL (i - 1, j - 1)] + 2 * DTW_DISTANCE (i, j);
                     direction = DTW_XANDY;
                 } else if (DTW_ISREACHABLE (i, j - 1)) {
-                    gmin = delta[i][j - 1] + my z[i][j];
+                    gmin = delta[DTW_CELL (i, j - 1)] + DTW_DISTANCE (i, j);
                     direction = DTW_X;
                 } else if (DTW_ISREACHABLE (i - 1, j)) {
-                    gmin = delta[i - 1][j] + my z[i][j];
+                    gmin = delta[DTW_CELL (i - 1, j)] + DTW_DISTANCE (i, j);
                     direction = DTW_Y;
                 } else {
                     numberOfIsolatedPoints++;
@@ -1417,11 +1514,11 @@ void DTW_and_Polygon_findPathInside (DTW me, Polygon thee, int localSlope, autoM
 
                 switch (localSlope) {
                 case 1:  { // no restriction
-                    if (DTW_ISREACHABLE (i, j - 1) && ((g = delta[i][j - 1] + my z[i][j]) < gmin)) {
+                    if (DTW_ISREACHABLE (i, j - 1) && ((g = delta[DTW_CELL (i, j - 1)] + DTW_DISTANCE (i, j)) < gmin)) {
                         gmin = g;
                         direction = DTW_X;
                     }
-                    if (DTW_ISREACHABLE (i - 1, j) && ((g = delta[i - 1][j] + my z[i][j]) < gmin)) {
+                    if (DTW_ISREACHABLE (i - 1, j) && ((g = delta[DTW_CELL (i - 1, j)] + DTW_DISTANCE (i, j)) < gmin)) {
                         gmin = g;
                         direction = DTW_Y;
                     }
@@ -1431,23 +1528,23 @@ void DTW_and_Polygon_findPathInside (DTW me, Polygon thee, int localSlope, autoM
                 // P = 1/2
 
                 case 2: { // P = 1/2
-                    if (DTW_ISREACHABLE (i - 1, j - 3) && psi[i][j - 1] == DTW_X && psi[i][j - 2] == DTW_XANDY &&
-                        (g = delta[i-1][j-3] + 2 * my z[i][j-2] + my z[i][j-1] + my z[i][j]) < gmin) {
+                    if (DTW_ISREACHABLE (i - 1, j - 3) && DTW_PSI (i, j - 1) == DTW_X && DTW_PSI (i, j - 2) == DTW_XANDY &&
+                        (g = delta[DTW_CELL (i-1, j-3)] + 2 * DTW_DISTANCE (i, j-2) + DTW_DISTANCE (i, j-1) + DTW_DISTANCE (i, j)) < gmin) {
                         gmin = g;
                         direction = DTW_X;
                     }
-                    if (DTW_ISREACHABLE (i - 1, j - 2) && psi[i][j - 1] == DTW_XANDY &&
-                        (g = delta[i - 1][j - 2] + 2 * my z[i][j - 1] + my z[i][j]) < gmin) {
+                    if (DTW_ISREACHABLE (i - 1, j - 2) && DTW_PSI (i, j - 1) == DTW_XANDY &&
+                        (g = delta[DTW_CELL (i - 1, j - 2)] + 2 * DTW_DISTANCE (i, j - 1) + DTW_DISTANCE (i, j)) < gmin) {
                         gmin = g;
                         direction = DTW_X;
                     }
-                    if (DTW_ISREACHABLE (i - 2, j - 1) && psi[i - 1][j] == DTW_XANDY &&
-                        (g = delta[i - 2][j - 1] + 2 * my z[i - 1][j] + my z[i][j]) < gmin) {
+                    if (DTW_ISREACHABLE (i - 2, j - 1) && DTW_PSI (i - 1, j) == DTW_XANDY &&
+                        (g = delta[DTW_CELL (i - 2, j - 1)] + 2 * DTW_DISTANCE (i - 1, j) + DTW_DISTANCE (i, j)) < gmin) {
                         gmin = g;
                         direction = DTW_Y;
                     }
-                    if (DTW_ISREACHABLE (i - 3, j - 1) && psi[i - 1][j] == DTW_Y && psi[i - 2][j] == DTW_XANDY &&
-                        (g = delta[i-3][j-1] + 2 * my z[i-2][j] + my z[i-1][j] + my z[i][j]) < gmin) {
+                    if (DTW_ISREACHABLE (i - 3, j - 1) && DTW_PSI (i - 1, j) == DTW_Y && DTW_PSI (i - 2, j) == DTW_XANDY &&
+                        (g = delta[DTW_CELL (i-3, j-1)] + 2 * DTW_DISTANCE (i-2, j) + DTW_DISTANCE (i-1, j) + DTW_DISTANCE (i, j)) < gmin) {
                         gmin = g;
                         direction = DTW_Y;
                     }
@@ -1457,13 +1554,13 @@ void DTW_and_Polygon_findPathInside (DTW me, Polygon thee, int localSlope, autoM
                 // P = 1
 
                 case 3: {
-                    if (DTW_ISREACHABLE (i - 1, j - 2) && psi[i][j - 1] == DTW_XANDY &&
-                        (g = delta[i - 1][j - 2] + 2 * my z[i][j - 1] + my z[i][j]) < gmin) {
+                    if (DTW_ISREACHABLE (i - 1, j - 2) && DTW_PSI (i, j - 1) == DTW_XANDY &&
+                        (g = delta[DTW_CELL (i - 1, j - 2)] + 2 * DTW_DISTANCE (i, j - 1) + DTW_DISTANCE (i, j)) < gmin) {
                         gmin = g;
                         direction = DTW_X;
                     }
-                    if (DTW_ISREACHABLE (i - 2, j - 1) && psi[i - 1][j] == DTW_XANDY &&
-                        (g = delta[i - 2][j - 1] + 2 * my z[i - 1][j] + my z[i][j]) < gmin) {
+                    if (DTW_ISREACHABLE (i - 2, j - 1) && DTW_PSI (i - 1, j) == DTW_XANDY &&
+                        (g = delta[DTW_CELL (i - 2, j - 1)] + 2 * DTW_DISTANCE (i - 1, j) + DTW_DISTANCE (i, j)) < gmin) {
                         gmin = g;
                         direction = DTW_Y;
                     }
@@ -1473,13 +1570,13 @@ void DTW_and_Polygon_findPathInside (DTW me, Polygon thee, int localSlope, autoM
                 // P = 2
 
                 case 4: {
-                    if (DTW_ISREACHABLE (i - 2, j - 3) && psi[i][j - 1] == DTW_XANDY && psi[i - 1][j - 2] == DTW_XANDY &&
-                        (g = delta[i-2][j-3] + 2 * my z[i-1][j-2] + 2 * my z[i][j-1] + my z[i][j]) < gmin) {
+                    if (DTW_ISREACHABLE (i - 2, j - 3) && DTW_PSI (i, j - 1) == DTW_XANDY && DTW_PSI (i - 1, j - 2) == DTW_XANDY &&
+                        (g = delta[DTW_CELL (i-2, j-3)] + 2 * DTW_DISTANCE (i-1, j-2) + 2 * DTW_DISTANCE (i, j-1) + DTW_DISTANCE (i, j)) < gmin) {
                             gmin = g;
                             direction = DTW_X;
                     }
-                    if (DTW_ISREACHABLE (i - 3, j - 2) && psi[i - 1][j] == DTW_XANDY && psi[i - 2][j - 1] == DTW_XANDY &&
-                        (g = delta[i-3][j-2] + 2 * my z[i-2][j-1] + 2 * my z[i-1][j] + my z[i][j]) < gmin) {
+                    if (DTW_ISREACHABLE (i - 3, j - 2) && DTW_PSI (i - 1, j) == DTW_XANDY && DTW_PSI (i - 2, j - 1) == DTW_XANDY &&
+                        (g = delta[DTW_CELL (i-3, j-2)] + 2 * DTW_DISTANCE (i-2, j-1) + 2 * DTW_DISTANCE (i-1, j) + DTW_DISTANCE (i, j)) < gmin) {
                             gmin = g;
                             direction = DTW_Y;
                     }
@@ -1489,8 +1586,8 @@ void DTW_and_Polygon_findPathInside (DTW me, Polygon thee, int localSlope, autoM
                 break;
                 }
                 Melder_assert (direction != 0);
-                psi[i][j] = direction;
-                delta[i][j] = gmin;
+                psi[DTW_CELL (i, j)] = (signed char) direction;
+                delta[DTW_CELL (i, j)] = gmin;
             }
             if ((j % 10) == 2) {
                 Melder_progress (0.999 * j / my nx, U"Calculate time warp: frame ", j, U" from ", my nx, U".");
@@ -1500,12 +1597,13 @@ void DTW_and_Polygon_findPathInside (DTW me, Polygon thee, int localSlope, autoM
         // Find minimum at end of path and trace back.
 
         long iy = my ny;
-        double minimum = delta[iy][my nx];
+        double minimum = DTW_INBAND (iy, my nx) ? delta[DTW_CELL (iy, my nx)] : DeferredMatrix_getValue (me, iy, my nx);
         for (long i = my ny - 1; i > 0; i--) {
             if (! DTW_ISREACHABLE (i, my nx)) {
                 break; // we're in unreachable places
-            } else if (delta[i][my nx] < minimum) {
-                minimum = delta[iy = i][my nx];
+            } else if (delta[DTW_CELL (i, my nx)] < minimum) {
+                iy = i;
+                minimum = delta[DTW_CELL (iy, my nx)];
             }
         }
         
@@ -1517,14 +1615,14 @@ void DTW_and_Polygon_findPathInside (DTW me, Polygon thee, int localSlope, autoM
         // Fill path backwards.
 
         while (ix > 1) {
-            if (psi[iy][ix] == DTW_XANDY) {
+            if (DTW_PSI (iy, ix) == DTW_XANDY) {
                 ix--;
                 iy--;
-            } else if (psi[iy][ix] == DTW_X) {
+            } else if (DTW_PSI (iy, ix) == DTW_X) {
                 ix--;
-            } else if (psi[iy][ix] == DTW_Y) {
+            } else if (DTW_PSI (iy, ix) == DTW_Y) {
                 iy--;
-            } else if (psi[iy][ix] == DTW_START) {
+            } else if (DTW_PSI (iy, ix) == DTW_START) {
                 break;
             }
             if (pathIndex < 2 || iy < 1) break;
@@ -1546,11 +1644,29 @@ void DTW_and_Polygon_findPathInside (DTW me, Polygon thee, int localSlope, autoM
                 my ymin, my ymax, my ny, my dy, my y1);
             for (long i = 1; i <= my ny; i++) {
                 for (long j = 1; j <= my nx; j++) {
-                    his z[i][j] = delta[i][j];
+                    his z[i][j] = DeferredMatrix_getValue (me, i, j);
+                }
+            }
+            if (localSlope != 1) {
+                for (long i = 2; i <= rowto; i++) {
+                    his z[i][1] += his z[i - 1][1];
+                }
+                for (long j = 2; j <= colto; j++) {
+                    his z[1][j] += his z[1][j - 1];
+                }
+            }
+            for (long j = 1; j <= my nx; j++) {
+                for (long i = ylow[j]; i <= yhigh[j]; i++) {
+                    his z[i][j] = delta[DTW_CELL (i, j)];
                 }
             }
             *cummulativeDists = him.move();
         }
+        #undef DTW_INBAND
+        #undef DTW_CELL
+        #undef DTW_PSI
+        #undef DTW_ISREACHABLE
+        #undef DTW_DISTANCE
     } catch (MelderError) {
         Melder_throw (me, U": cannot find path.");
     }
@@ -29,6 +29,36 @@
 #include "DurationTier.h"
 #include "Sound.h"
 
+/*
+	The syntactic parent of DTW: a Matrix whose cells can be left uncomputed.
+	As long as z is null, computeCell (irow, icol) gives the value that z [irow] [icol] would have;
+	DeferredMatrix_materialize fills in the whole of z, as copying, comparing and saving do first.
+*/
+Thing_define (DeferredMatrix, Matrix) {
+	std::function <double (long irow, long icol)> computeCell;
+
+	void v_copy (Daata data_to)
+		override;
+	bool v_equal (Daata otherData)
+		override;
+	void v_writeText (MelderFile openFile)
+		override;
+	void v_writeBinary (FILE *f)
+		override;
+	double v_getMatrix (long irow, long icol)
+		override;
+	double v_getFunction2 (double x, double y)
+		override;
+	double v_getValueAtSample (long isamp, long ilevel, int unit)
+		override;
+};
+
+void DeferredMatrix_materialize (DeferredMatrix me);
+
+static inline double DeferredMatrix_getValue (DeferredMatrix me, long irow, long icol) {
+	return my z ? my z [irow] [icol] : my computeCell (irow, icol);
+}
+
 #include "DTW_def.h"
 
 #define DTW_SAKOECHIBA 1
@@ -47,6 +77,14 @@ void DTW_Path_Query_init (DTW_Path_Query me, long ny, long nx);
 autoDTW DTW_create (double tminp, double tmaxp, long ntp, double dtp, double t1p,
 	double tminc, double tmaxc, long ntc, double dtc, double t1c);
 
+autoDTW DTW_createWithDistanceFunction (double tminp, double tmaxp, long ntp, double dtp, double t1p,
+	double tminc, double tmaxc, long ntc, double dtc, double t1c, std::function <double (long iy, long ix)> distance);
+/*
+	As DTW_create, but the distances are not stored: distance (iy, ix) is called for the cells that are needed,
+	e.g. those inside the band of a path search, and the whole matrix is computed only
+	when it is drawn, queried, changed, copied or saved.
+*/
+
 void DTW_setWeights (DTW me, double wx, double wy, double wd);
 
 autoDTW DTW_swapAxes (DTW me);
@@ -143,7 +143,7 @@ autoTable DTW_and_IntervalTier_to_Table (DTW me, IntervalTier thee, double preci
 				long numberOfFrames = Matrix_getWindowSamplesX (me, xmin, xmax, &ixmin, &ixmax);
 				double sumOfDistances = 0;
 				while (pathIndex < my pathLength && my path[pathIndex].x < ixmax) {
-					sumOfDistances += my z[my path[pathIndex].y][my path[pathIndex].x];
+					sumOfDistances += DeferredMatrix_getValue (me, my path[pathIndex].y, my path[pathIndex].x);
 					pathIndex++;
 				}
 				Table_setNumericValue (him.get(), i, 1, textinterval -> xmin);
@@ -161,7 +161,7 @@ autoTable DTW_and_IntervalTier_to_Table (DTW me, IntervalTier thee, double preci
 				long numberOfFrames = Matrix_getWindowSamplesY (me, ymin, ymax, &iymin, &iymax);
 				double sumOfDistances = 0;
 				while (pathIndex < my pathLength && my path[pathIndex].y < iymax) {
-					sumOfDistances += my z[my path[pathIndex].y][my path[pathIndex].x];
+					sumOfDistances += DeferredMatrix_getValue (me, my path[pathIndex].y, my path[pathIndex].x);
 					pathIndex++;
 				}
 				Table_setNumericValue (him.get(), i, 1, textinterval -> xmin);
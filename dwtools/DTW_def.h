@@ -40,7 +40,7 @@ oo_END_STRUCT (DTW_Path_Query)
 #undef ooSTRUCT
 
 #define ooSTRUCT DTW
-oo_DEFINE_CLASS (DTW, Matrix)
+oo_DEFINE_CLASS (DTW, DeferredMatrix)
 	oo_DOUBLE (weightedDistance)
 	oo_LONG (pathLength)
 	oo_STRUCT_VECTOR (DTW_Path, path, pathLength)
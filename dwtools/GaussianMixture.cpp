@@ -21,6 +21,7 @@
 */
 #include "Distributions_and_Strings.h"
 #include "GaussianMixture.h"
+#include "MelderThread.h"
 #include "NUMlapack.h"
 #include "NUMmachar.h"
 #include "NUM2.h"
@@ -82,10 +83,14 @@ static void GaussianMixture_updateCovariance (GaussianMixture me, long component
 
 	for (long j = 1; j <= thy numberOfColumns; j ++) {
 		thy centroid [j] = 0;
-		for (long i = 1; i <= numberOfRows; i ++) {
-			double gamma = mixprob * p [i] [component] / p [i] [my numberOfComponents + 1];
+	}
+	for (long i = 1; i <= numberOfRows; i ++) {   // row by row, because the data are stored row-wise
+		double gamma = mixprob * p [i] [component] / p [i] [my numberOfComponents + 1];
+		for (long j = 1; j <= thy numberOfColumns; j ++) {
 			thy centroid [j] += gamma * data [i] [j] ; // eq. Bishop 9.17
 		}
+	}
+	for (long j = 1; j <= thy numberOfColumns; j ++) {
 		thy centroid [j] /= gsum;
 	}
 
@@ -113,11 +118,15 @@ static void GaussianMixture_updateCovariance (GaussianMixture me, long component
 			double gdn = gamma / gsum; // we cannot divide by nk - 1, this could cause instability
 			for (long j = 1; j <= thy numberOfColumns; j ++) {
 				double xj = thy centroid [j] - data [i] [j];
-				for (long k = j; k <= thy numberOfColumns; k ++) {
-					thy data [j] [k] = thy data [k] [j] += gdn * xj * (thy centroid [k] - data [i] [k]);
+				for (long k = j; k <= thy numberOfColumns; k ++) {   // only the upper triangle
+					thy data [j] [k] += gdn * xj * (thy centroid [k] - data [i] [k]);
 				}
 			}
 		}
+		for (long j = 1; j <= thy numberOfRows; j ++)
+			for (long k = j + 1; k <= thy numberOfColumns; k ++) {
+				thy data [k] [j] = thy data [j] [k];
+			}
 	}
 	thy numberOfObservations = my mixingProbabilities[component] * numberOfRows;
 }
@@ -144,6 +153,55 @@ static void GaussianMixture_addCovarianceFraction (GaussianMixture me, long im,
 	}
 }
 
+#define GaussianMixture_MINIMUM_WORK_PER_THREAD  1000000.0   /* rows x components x (co)variance elements */
+
+static double GaussianMixture_getWorkPerRowAndComponent (GaussianMixture me) {
+	Covariance thee = my covariances->at [1];
+	return thy numberOfRows == 1 ? my dimension : 0.5 * my dimension * (my dimension + 1.0);
+}
+
+static long GaussianMixture_getNumberOfThreads (GaussianMixture me, long numberOfRows, long numberOfComponents, long maximumNumberOfThreads) {
+	double work = GaussianMixture_getWorkPerRowAndComponent (me) * numberOfRows * numberOfComponents;
+	long numberOfThreads = std::min ((long) MelderThread_getNumberOfProcessors (), maximumNumberOfThreads);
+	numberOfThreads = std::min (numberOfThreads, (long) floor (work / GaussianMixture_MINIMUM_WORK_PER_THREAD));
+	return std::max (1L, numberOfThreads);
+}
+
+struct GaussianMixture_ComponentChunk {
+	GaussianMixture gm;
+	double **data, **p;
+	long numberOfRows, fromComponent, toComponent;
+};
+
+static MelderThread_RETURN_TYPE GaussianMixture_ComponentChunk_updateCovariances (GaussianMixture_ComponentChunk *me) {
+	for (long im = my fromComponent; im <= my toComponent; im ++) {
+		GaussianMixture_updateCovariance (my gm, im, my data, my numberOfRows, my p);
+	}
+	MelderThread_RETURN;
+}
+
+/*
+	The M-step for the means and covariances of all components.
+	Every component only reads the data and the probabilities and only writes into its own Covariance,
+	so the components can be updated on separate threads with exactly the same results as on one thread.
+*/
+static void GaussianMixture_updateCovariances (GaussianMixture me, double **data, long numberOfRows, double **p) {
+	long numberOfThreads = GaussianMixture_getNumberOfThreads (me, numberOfRows, my numberOfComponents, my numberOfComponents);
+	long numberOfComponentsPerThread = (my numberOfComponents - 1) / numberOfThreads + 1;
+	numberOfThreads = (my numberOfComponents - 1) / numberOfComponentsPerThread + 1;   // no empty chunks
+	std::vector <GaussianMixture_ComponentChunk> chunks ((size_t) numberOfThreads);
+	for (long ithread = 1; ithread <= numberOfThreads; ithread ++) {
+		GaussianMixture_ComponentChunk *chunk = & chunks [(size_t) ithread - 1];
+		chunk -> gm = me;
+		chunk -> data = data;
+		chunk -> p = p;
+		chunk -> numberOfRows = numberOfRows;
+		chunk -> fromComponent = (ithread - 1) * numberOfComponentsPerThread + 1;
+		chunk -> toComponent = std::min (ithread * numberOfComponentsPerThread, my numberOfComponents);
+	}
+	MelderThread_run (GaussianMixture_ComponentChunk_updateCovariances, chunks.data(), (int) numberOfThreads);
+}
+
 void structGaussianMixture :: v_info () {
 	our structDaata :: v_info ();
 	MelderInfo_writeLine (U"Number of components: ", our numberOfComponents);
@@ -861,6 +919,31 @@ void GaussianMixture_splitComponent (GaussianMixture me, long component) {
 	}
 }
 
+struct GaussianMixture_RowChunk {
+	GaussianMixture gm;
+	double **data, **p;
+	long fromRow, toRow, fromComponent, toComponent;
+	double ln2pid;
+};
+
+static MelderThread_RETURN_TYPE GaussianMixture_RowChunk_getProbabilities (GaussianMixture_RowChunk *me) {
+	GaussianMixture gm = my gm;
+	for (long i = my fromRow; i <= my toRow; i ++) {   // each data row is used for all components while it is in the cache
+		for (long ic = my fromComponent; ic <= my toComponent; ic ++) {
+			Covariance him = gm -> covariances->at [ic];
+			/*
+				With diagonal storage (1 x n) the inverse of the Cholesky factor holds the reciprocal standard deviations,
+				and the distance is a plain weighted sum of squares without a triangular solve.
+			*/
+			double dsq = NUMmahalanobisDistance_chi (his lowerCholesky, my data [i], his centroid, his numberOfRows, gm -> dimension);
+			double prob = exp (- 0.5 * (my ln2pid + his lnd + dsq));
+			prob = prob < 1e-300 ? 1e-300 : prob; // prevent p from being zero
+			my p [i] [ic] = prob;
+		}
+	}
+	MelderThread_RETURN;
+}
+
 int GaussianMixture_and_TableOfReal_getProbabilities (GaussianMixture me, TableOfReal thee, long component, double **p) {
 	try {
 		double ln2pid = my dimension * log (NUM2pi);
@@ -874,15 +957,27 @@ int GaussianMixture_and_TableOfReal_getProbabilities (GaussianMixture me, TableO
 
 		for (long ic = icb; ic <= ice; ic ++) {
 			Covariance him = my covariances->at [ic];
-			SSCP_expandLowerCholesky (him);
+			SSCP_expandLowerCholesky (him);   // may allocate or throw, so not on the threads
+		}
 
-			for (long i = 1; i <= thy numberOfRows; i++) {
-				double dsq = NUMmahalanobisDistance_chi (his lowerCholesky, thy data [i], his centroid, his numberOfRows, my dimension);
-				double prob = exp (- 0.5 * (ln2pid + his lnd + dsq));
-				prob = prob < 1e-300 ? 1e-300 : prob; // prevent p from being zero
-				p[i][ic] = prob;
-			}
+		// The rows are independent, so blocks of rows can be done on separate threads.
+
+		long numberOfThreads = GaussianMixture_getNumberOfThreads (me, thy numberOfRows, ice - icb + 1, thy numberOfRows);
+		long numberOfRowsPerThread = (thy numberOfRows - 1) / numberOfThreads + 1;
+		numberOfThreads = (thy numberOfRows - 1) / numberOfRowsPerThread + 1;   // no empty chunks
+		std::vector <GaussianMixture_RowChunk> chunks ((size_t) numberOfThreads);
+		for (long ithread = 1; ithread <= numberOfThreads; ithread ++) {
+			GaussianMixture_RowChunk *chunk = & chunks [(size_t) ithread - 1];
+			chunk -> gm = me;
+			chunk -> data = thy data;
+			chunk -> p = p;
+			chunk -> fromRow = (ithread - 1) * numberOfRowsPerThread + 1;
+			chunk -> toRow = std::min (ithread * numberOfRowsPerThread, thy numberOfRows);
+			chunk -> fromComponent = icb;
+			chunk -> toComponent = ice;
+			chunk -> ln2pid = ln2pid;
 		}
+		MelderThread_run (GaussianMixture_RowChunk_getProbabilities, chunks.data(), (int) numberOfThreads);
 
 		GaussianMixture_updateProbabilityMarginals (me, p, thy numberOfRows);
 		return 1;
@@ -934,8 +1029,8 @@ void GaussianMixture_and_TableOfReal_improveLikelihood (GaussianMixture me, Tabl
 				iter ++;
 				// M-step: 1. new means & covariances
 
+				GaussianMixture_updateCovariances (me, thy data, thy numberOfRows, pp.peek());
 				for (long im = 1; im <= my numberOfComponents; im ++) {
-					GaussianMixture_updateCovariance (me, im, thy data, thy numberOfRows, pp.peek());
 					GaussianMixture_addCovarianceFraction (me, im, covg.get(), lambda);
 				}
 
@@ -24,6 +24,7 @@
 #include "Index.h"
 #include "NUM2.h"
 #include "Strings_extensions.h"
+#include "MelderThread.h"
 
 #include "oo_DESTROY.h"
 #include "HMM_def.h"
@@ -227,10 +228,11 @@ void HMMState_setLabel (HMMState me, char32 *label) {
 /**************** HMMBaumWelch ******************************/
 
 void structHMMBaumWelch :: v_destroy () noexcept {
-	for (long it = 1; it <= capacity; it ++) {
-		NUMmatrix_free (xi[it], 1, 1);
-	}
-	NUMvector_free (xi, 1);
+	NUMmatrix_free (xi, 1, 1);
+	NUMmatrix_free (xisum, 1, 1);
+	NUMvector_free (gammasum, 1);
+	NUMmatrix_free (gammasum_k, 1, 1);
+	NUMvector_free (emission, 1);
 	NUMvector_free (scale, 1);
 	NUMmatrix_free (beta, 1, 1);
 	NUMmatrix_free (alpha, 1, 1);
@@ -247,18 +249,19 @@ autoHMMBaumWelch HMMBaumWelch_create (long nstates, long nsymbols, long capacity
 		my numberOfTimes = my capacity = capacity;
 		my numberOfStates = nstates;
 		my numberOfSymbols = nsymbols;
-		my alpha = NUMmatrix<double> (1, nstates, 1, capacity);
-		my beta = NUMmatrix<double> (1, nstates, 1, capacity);
+		my alpha = NUMmatrix<double> (1, capacity, 1, nstates);
+		my beta = NUMmatrix<double> (1, capacity, 1, nstates);
 		my scale = NUMvector<double> (1, capacity);
-		my xi = NUMvector<double **> (1, capacity);
+		my xi = NUMmatrix<double> (1, nstates, 1, nstates);
+		my xisum = NUMmatrix<double> (1, nstates, 1, nstates);
+		my gammasum = NUMvector<double> (1, nstates);
+		my gammasum_k = NUMmatrix<double> (1, nstates, 1, nsymbols);
+		my emission = NUMvector<double> (1, nstates);
 		my aij_num = NUMmatrix<double> (0, nstates, 1, nstates + 1);
 		my aij_denom = NUMmatrix<double> (0, nstates, 1, nstates + 1);
 		my bik_num = NUMmatrix<double> (1, nstates, 1, nsymbols);
 		my bik_denom = NUMmatrix<double> (1, nstates, 1, nsymbols);
-		my gamma = NUMmatrix<double> (1, nstates, 1, capacity);
-		for (long it = 1; it <= capacity; it++) {
-			my xi[it] = NUMmatrix<double> (1, nstates, 1, nstates);
-		}
+		my gamma = NUMmatrix<double> (1, capacity, 1, nstates);
 		return me;
 	} catch (MelderError) {
 		Melder_throw (U"HMMBaumWelch not created.");
@@ -269,12 +272,12 @@ void HMMBaumWelch_getGamma (HMMBaumWelch me) {
 	for (long it = 1; it <= my numberOfTimes; it ++) {
 		double sum = 0.0;
 		for (long is = 1; is <= my numberOfStates; is ++) {
-			my gamma [is] [it] = my alpha [is] [it] * my beta [is] [it];
-			sum += my gamma [is] [it];
+			my gamma [it] [is] = my alpha [it] [is] * my beta [it] [is];
+			sum += my gamma [it] [is];
 		}
 
 		for (long is = 1; is <= my numberOfStates; is ++) {
-			my gamma [is] [it] /= sum;
+			my gamma [it] [is] /= sum;
 		}
 	}
 }
@@ -286,8 +289,8 @@ autoHMMViterbi HMMViterbi_create (long nstates, long ntimes) {
 		autoHMMViterbi me = Thing_new (HMMViterbi);
 		my numberOfTimes = ntimes;
 		my numberOfStates = nstates;
-		my viterbi = NUMmatrix<double> (1, nstates, 1, ntimes);
-		my bp = NUMmatrix<long> (1, nstates, 1 , ntimes);
+		my viterbi = NUMmatrix<double> (1, ntimes, 1, nstates);
+		my bp = NUMmatrix<long> (1, ntimes, 1, nstates);
 		my path = NUMvector<long> (1, ntimes);
 		return me;
 	} catch (MelderError) {
@@ -872,12 +875,138 @@ void HMMBaumWelch_reInit (HMMBaumWelch me) {
 	}
 }
 
+/*
+	Add the statistics that thee gathered to mine.
+*/
+static void HMMBaumWelch_addStatistics (HMMBaumWelch me, HMMBaumWelch thee) {
+	for (long is = 0; is <= my numberOfStates; is ++) {
+		for (long js = 1; js <= my numberOfStates + 1; js ++) {
+			my aij_num [is] [js] += thy aij_num [is] [js];
+			my aij_denom [is] [js] += thy aij_denom [is] [js];
+		}
+	}
+	for (long is = 1; is <= my numberOfStates; is ++) {
+		for (long k = 1; k <= my numberOfSymbols; k ++) {
+			my bik_num [is] [k] += thy bik_num [is] [k];
+			my bik_denom [is] [k] += thy bik_denom [is] [k];
+		}
+	}
+	my lnProb += thy lnProb;
+	my totalNumberOfSequences += thy totalNumberOfSequences;
+}
+
+/*
+	A stretch of known symbols in an observation sequence;
+	every stretch is trained on as a separate sequence.
+*/
+struct HMMStretch {
+	long *obs;   // obs [1..numberOfTimes]
+	long numberOfTimes;
+};
+
+/*
+	The stretches are divided into blocks, whose statistics are gathered separately and then added in a fixed order,
+	so that the learned model does not depend on the number of threads.
+*/
+#define HMM_MAXIMUM_NUMBER_OF_BLOCKS  16
+#define HMM_MINIMUM_WORK_PER_BLOCK  100000.0   /* times x states x states */
+
+struct HMMLearningChunk {
+	HMM hmm;
+	const HMMStretch *stretches;
+	const long *firstStretchOfBlock;   // [0..numberOfBlocks]: block iblock has stretches firstStretchOfBlock [iblock] .. firstStretchOfBlock [iblock + 1] - 1
+	long firstBlock, lastBlock;
+	HMMBaumWelch workspace;   // with the capacity of the longest stretch
+	autoHMMBaumWelch *blockStatistics;   // [0..numberOfBlocks - 1]
+};
+
+static MelderThread_RETURN_TYPE HMMLearningChunk_run (HMMLearningChunk *me) {
+	HMMBaumWelch bw = my workspace;
+	for (long iblock = my firstBlock; iblock <= my lastBlock; iblock ++) {
+		HMMBaumWelch_reInit (bw);
+		for (long istretch = my firstStretchOfBlock [iblock]; istretch < my firstStretchOfBlock [iblock + 1]; istretch ++) {
+			long *obs = my stretches [istretch]. obs;
+			bw -> numberOfTimes = my stretches [istretch]. numberOfTimes;
+			(bw -> totalNumberOfSequences) ++;
+			HMM_and_HMMBaumWelch_forward (my hmm, bw, obs); // get new alphas
+			HMM_and_HMMBaumWelch_backward (my hmm, bw, obs); // get new betas
+			HMMBaumWelch_getGamma (bw);
+			HMM_and_HMMBaumWelch_getXi (my hmm, bw, obs);
+			HMM_and_HMMBaumWelch_addEstimate (my hmm, bw, obs);
+		}
+		HMMBaumWelch blockStatistics = my blockStatistics [iblock].get();
+		HMMBaumWelch_reInit (blockStatistics);
+		HMMBaumWelch_addStatistics (blockStatistics, bw);
+	}
+	MelderThread_RETURN;
+}
+
 void HMM_and_HMMObservationSequenceBag_learn (HMM me, HMMObservationSequenceBag thee, double delta_lnp, double minProb, int info) {
 	try {
 		// act as if all observation sequences are in memory
 		long capacity = HMMObservationSequenceBag_getLongestSequence (thee);
-		autoHMMBaumWelch bw = HMMBaumWelch_create (my numberOfStates, my numberOfObservationSymbols, capacity);
+
+		/*
+			Collect the stretches of known symbols once.
+			Interpretation of unknowns: end of sequence
+		*/
+		std::vector <autoStringsIndex> indexes;
+		std::vector <HMMStretch> stretches;
+		double work = 0.0;
+		for (long ios = 1; ios <= thy size; ios ++) {
+			HMMObservationSequence hmm_os = thy at [ios];
+			autoStringsIndex si = HMM_and_HMMObservationSequence_to_StringsIndex (me, hmm_os);
+			long *obs = si -> classIndex, nobs = si -> numberOfItems; // convenience
+			long istart = 1, iend = nobs;
+			while (istart <= nobs) {
+				while (istart <= nobs && obs[istart] == 0) {
+					istart++;
+				};
+				if (istart > nobs) {
+					break;
+				}
+				iend = istart + 1;
+				while (iend <= nobs && obs[iend] != 0) {
+					iend++;
+				}
+				iend --;
+				stretches.push_back ({ obs + istart - 1, iend - istart + 1 });
+				work += (double) (iend - istart + 1) * my numberOfStates * my numberOfStates;
+				istart = iend + 1;
+			}
+			indexes.push_back (si.move());
+		}
+		const long numberOfStretches = (long) stretches.size();
+
+		long numberOfBlocks = std::min ((long) HMM_MAXIMUM_NUMBER_OF_BLOCKS, std::max (1L, (long) floor (work / HMM_MINIMUM_WORK_PER_BLOCK)));
+		if (numberOfBlocks > numberOfStretches) numberOfBlocks = std::max (1L, numberOfStretches);
+		std::vector <long> firstStretchOfBlock ((size_t) numberOfBlocks + 1);
+		for (long iblock = 0; iblock <= numberOfBlocks; iblock ++) {
+			firstStretchOfBlock [(size_t) iblock] = iblock * numberOfStretches / numberOfBlocks;
+		}
+		std::vector <autoHMMBaumWelch> blockStatistics ((size_t) numberOfBlocks);
+		for (long iblock = 0; iblock < numberOfBlocks; iblock ++) {
+			blockStatistics [(size_t) iblock] = HMMBaumWelch_create (my numberOfStates, my numberOfObservationSymbols, 1);
+		}
+		long numberOfThreads = std::min ((long) MelderThread_getNumberOfProcessors (), numberOfBlocks);
+		long numberOfBlocksPerThread = (numberOfBlocks - 1) / numberOfThreads + 1;
+		numberOfThreads = (numberOfBlocks - 1) / numberOfBlocksPerThread + 1;   // no empty chunks
+		std::vector <autoHMMBaumWelch> workspaces ((size_t) numberOfThreads);
+		std::vector <HMMLearningChunk> chunks ((size_t) numberOfThreads);
+		for (long ithread = 1; ithread <= numberOfThreads; ithread ++) {
+			workspaces [(size_t) ithread - 1] = HMMBaumWelch_create (my numberOfStates, my numberOfObservationSymbols, capacity);
+			HMMLearningChunk *chunk = & chunks [(size_t) ithread - 1];
+			chunk -> hmm = me;
+			chunk -> stretches = stretches.data();
+			chunk -> firstStretchOfBlock = firstStretchOfBlock.data();
+			chunk -> firstBlock = (ithread - 1) * numberOfBlocksPerThread;
+			chunk -> lastBlock = std::min (ithread * numberOfBlocksPerThread, numberOfBlocks) - 1;
+			chunk -> workspace = workspaces [(size_t) ithread - 1].get();
+			chunk -> blockStatistics = blockStatistics.data();
+		}
+		autoHMMBaumWelch bw = HMMBaumWelch_create (my numberOfStates, my numberOfObservationSymbols, 1);   // only for the total statistics
 		bw -> minProb = minProb;
+
 		if (info) {
 			MelderInfo_open (); 
 		}
@@ -885,35 +1014,9 @@ void HMM_and_HMMObservationSequenceBag_learn (HMM me, HMMObservationSequenceBag
 		do {
 			lnp = bw -> lnProb;
 			HMMBaumWelch_reInit (bw.get());
-			for (long ios = 1; ios <= thy size; ios ++) {
-				HMMObservationSequence hmm_os = thy at [ios];
-				autoStringsIndex si = HMM_and_HMMObservationSequence_to_StringsIndex (me, hmm_os); // TODO outside the loop or more efficiently
-				long *obs = si -> classIndex, nobs = si -> numberOfItems; // convenience
-
-				// Interpretation of unknowns: end of sequence
-
-				long istart = 1, iend = nobs;
-				while (istart <= nobs) {
-					while (istart <= nobs && obs[istart] == 0) {
-						istart++;
-					};
-					if (istart > nobs) {
-						break;
-					}
-					iend = istart + 1;
-					while (iend <= nobs && obs[iend] != 0) {
-						iend++;
-					}
-					iend --;
-					bw -> numberOfTimes = iend - istart + 1;
-					(bw -> totalNumberOfSequences) ++;
-					HMM_and_HMMBaumWelch_forward (me, bw.get(), obs + istart - 1); // get new alphas
-					HMM_and_HMMBaumWelch_backward (me, bw.get(), obs + istart - 1); // get new betas
-					HMMBaumWelch_getGamma (bw.get());
-					HMM_and_HMMBaumWelch_getXi (me, bw.get(), obs + istart - 1);
-					HMM_and_HMMBaumWelch_addEstimate (me, bw.get(), obs + istart - 1);
-					istart = iend + 1;
-				}
+			MelderThread_run (HMMLearningChunk_run, chunks.data(), (int) numberOfThreads);
+			for (long iblock = 0; iblock < numberOfBlocks; iblock ++) {
+				HMMBaumWelch_addStatistics (bw.get(), blockStatistics [(size_t) iblock].get());
 			}
 			// we have processed all observation sequences, now it is time to estimate new probabilities.
 			iter++;
@@ -1137,19 +1240,29 @@ void HMM_drawForwardAndBackwardProbabilitiesIllustration (Graphics g, bool garni
 }
 
 void HMM_and_HMMBaumWelch_getXi (HMM me, HMMBaumWelch thee, long *obs) {
-
-	for (long it = 1; it <= thy numberOfTimes - 1; it++) {
+	/*
+		Only the sums of xi over time are needed, so xi is computed one time step at a time.
+	*/
+	for (long is = 1; is <= thy numberOfStates; is ++) {
+		for (long js = 1; js <= thy numberOfStates; js ++) {
+			thy xisum [is] [js] = 0.0;
+		}
+	}
+	for (long it = 1; it <= thy numberOfTimes - 1; it ++) {
+		const double *alpha_t = thy alpha [it], *beta_tp1 = thy beta [it + 1];
+		const long symbol = obs [it + 1];
 		double sum = 0.0;
-		for (long is = 1; is <= thy numberOfStates; is++) {
-			for (long js = 1; js <= thy numberOfStates; js++) {
-				thy xi[it][is][js] = thy alpha[is][it] * thy beta[js][it + 1] *
-					my transitionProbs[is][js] * my emissionProbs[js][ obs[it + 1] ];
-				sum += thy xi[it][is][js];
+		for (long is = 1; is <= thy numberOfStates; is ++) {
+			const double *a_is = my transitionProbs [is];
+			double *xi_is = thy xi [is];
+			for (long js = 1; js <= thy numberOfStates; js ++) {
+				xi_is [js] = alpha_t [is] * beta_tp1 [js] * a_is [js] * my emissionProbs [js] [symbol];
+				sum += xi_is [js];
 			}
 		}
-		for (long is = 1; is <= my numberOfStates; is++) {
-			for (long js = 1; js <= my numberOfStates; js++) {
-				thy xi[it][is][js] /= sum;
+		for (long is = 1; is <= my numberOfStates; is ++) {
+			for (long js = 1; js <= my numberOfStates; js ++) {
+				thy xisum [is] [js] += thy xi [is] [js] / sum;
 			}
 		}
 	}
@@ -1159,26 +1272,40 @@ void HMM_and_HMMBaumWelch_addEstimate (HMM me, HMMBaumWelch thee, long *obs) {
 	for (long is = 1; is <= my numberOfStates; is ++) {
 		// only for valid start states with p > 0
 		if (my transitionProbs [0] [is] > 0.0) {
-			thy aij_num [0] [is] += thy gamma [is] [1];
+			thy aij_num [0] [is] += thy gamma [1] [is];
 			thy aij_denom [0] [is] += 1.0;
 		}
 	}
 
+	/*
+		Sum gamma over time, per state and per observed symbol, running through time in the outer loop.
+	*/
+	double *gammasum = thy gammasum, **gammasum_k = thy gammasum_k;
 	for (long is = 1; is <= my numberOfStates; is ++) {
-		double gammasum = 0.0;
-		for (long it = 1; it <= thy numberOfTimes - 1; it ++) {
-			gammasum += thy gamma [is] [it];
+		gammasum [is] = 0.0;
+		for (long k = 1; k <= my numberOfObservationSymbols; k ++) {
+			gammasum_k [is] [k] = 0.0;
+		}
+	}
+	for (long it = 1; it <= thy numberOfTimes - 1; it ++) {
+		for (long is = 1; is <= my numberOfStates; is ++) {
+			gammasum [is] += thy gamma [it] [is];
+		}
+	}
+	if (! my notHidden) {
+		for (long it = 1; it <= thy numberOfTimes; it ++) {
+			for (long is = 1; is <= my numberOfStates; is ++) {
+				gammasum_k [is] [obs [it]] += thy gamma [it] [is];
+			}
 		}
+	}
 
+	for (long is = 1; is <= my numberOfStates; is ++) {
 		for (long js = 1; js <= my numberOfStates; js ++) {
-			double xisum = 0.0;
-			for (long it = 1; it <= thy numberOfTimes - 1; it ++) {
-				xisum += thy xi [it] [is] [js];
-			}
 			// zero probs signal invalid connections, don't reestimate
 			if (my transitionProbs [is] [js] > 0.0) {
-				thy aij_num [is] [js] += xisum;
-				thy aij_denom [is] [js] += gammasum;
+				thy aij_num [is] [js] += thy xisum [is] [js];
+				thy aij_denom [is] [js] += gammasum [is];
 			}
 		}
 
@@ -1187,24 +1314,18 @@ void HMM_and_HMMBaumWelch_addEstimate (HMM me, HMMBaumWelch thee, long *obs) {
 			A not hidden model is emulated with fixed emissionProbs.
 		*/
 		if (! my notHidden) {
-			gammasum += thy gamma [is] [thy numberOfTimes];   // now sum all, add last term
+			double gammasum_all = gammasum [is] + thy gamma [thy numberOfTimes] [is];   // now sum all, add last term
 			for (long k = 1; k <= my numberOfObservationSymbols; k ++) {
-				double gammasum_k = 0.0;
-				for (long it = 1; it <= thy numberOfTimes; it ++) {
-					if (obs [it] == k) {
-						gammasum_k += thy gamma [is] [it];
-					}
-				}
 				// only reestimate probs > 0 !
 				if (my emissionProbs [is] [k] > 0.0) {
-					thy bik_num [is] [k] += gammasum_k;
-					thy bik_denom [is] [k] += gammasum;
+					thy bik_num [is] [k] += gammasum_k [is] [k];
+					thy bik_denom [is] [k] += gammasum_all;
 				}
 			}
 		}
 		// For a left-to-right model the final state determines the transition prob to go to the END state
 		if (my leftToRight) {
-			thy aij_num [is] [my numberOfStates + 1] += thy gamma [is] [thy numberOfTimes];
+			thy aij_num [is] [my numberOfStates + 1] += thy gamma [thy numberOfTimes] [is];
 			thy aij_denom [is] [my numberOfStates + 1] += 1.0;
 		}
 	}
@@ -1255,27 +1376,36 @@ void HMM_and_HMMBaumWelch_forward (HMM me, HMMBaumWelch thee, long *obs) {
 	// initialise at t = 1 & scale
 	thy scale [1] = 0.0;
 	for (long js = 1; js <= my numberOfStates; js ++) {
-		thy alpha [js] [1] = my transitionProbs [0] [js] * my emissionProbs [js] [obs [1]];
-		thy scale [1] += thy alpha [js] [1];
+		thy alpha [1] [js] = my transitionProbs [0] [js] * my emissionProbs [js] [obs [1]];
+		thy scale [1] += thy alpha [1] [js];
 	}
 	for (long js = 1; js <= my numberOfStates; js ++) {
-		thy alpha [js] [1] /= thy scale [1];
+		thy alpha [1] [js] /= thy scale [1];
 	}
-	// recursion
+	/*
+		Recursion. The product of alpha at the previous time and the transition matrix
+		is accumulated row by row of the matrix, so that the inner loop runs along contiguous memory.
+	*/
 	for (long it = 2; it <= thy numberOfTimes; it ++) {
-		thy scale [it] = 0.0;
+		const double *alpha_tm1 = thy alpha [it - 1];
+		double *alpha_t = thy alpha [it];
 		for (long js = 1; js <= my numberOfStates; js ++) {
-			double sum = 0.0;
-			for (long is = 1; is <= my numberOfStates; is ++) {
-				sum += thy alpha [is] [it - 1] * my transitionProbs [is] [js];
+			alpha_t [js] = 0.0;
+		}
+		for (long is = 1; is <= my numberOfStates; is ++) {
+			const double alpha_is = alpha_tm1 [is], *a_is = my transitionProbs [is];
+			for (long js = 1; js <= my numberOfStates; js ++) {
+				alpha_t [js] += alpha_is * a_is [js];
 			}
-
-			thy alpha [js] [it] = sum * my emissionProbs [js] [obs [it]];
-			thy scale [it] += thy alpha [js] [it];
+		}
+		thy scale [it] = 0.0;
+		for (long js = 1; js <= my numberOfStates; js ++) {
+			alpha_t [js] *= my emissionProbs [js] [obs [it]];
+			thy scale [it] += alpha_t [js];
 		}
 
 		for (long js = 1; js <= my numberOfStates; js ++) {
-			thy alpha [js] [it] /= thy scale [it];
+			alpha_t [js] /= thy scale [it];
 		}
 	}
 
@@ -1286,55 +1416,74 @@ void HMM_and_HMMBaumWelch_forward (HMM me, HMMBaumWelch thee, long *obs) {
 
 void HMM_and_HMMBaumWelch_backward (HMM me, HMMBaumWelch thee, long *obs) {
 	for (long is = 1; is <= my numberOfStates; is ++) {
-		thy beta [is] [thy numberOfTimes] = 1.0 / thy scale [thy numberOfTimes];
+		thy beta [thy numberOfTimes] [is] = 1.0 / thy scale [thy numberOfTimes];
 	}
+	double *emission = thy emission;
 	for (long it = thy numberOfTimes - 1; it >= 1; it --) {
+		const double *beta_tp1 = thy beta [it + 1];
+		for (long js = 1; js <= my numberOfStates; js ++) {
+			emission [js] = my emissionProbs [js] [obs [it + 1]];
+		}
 		for (long is = 1; is <= my numberOfStates; is ++) {
+			const double *a_is = my transitionProbs [is];
 			double sum = 0.0;
 			for (long js = 1; js <= my numberOfStates; js ++) {
-				sum += thy beta [js] [it + 1] * my transitionProbs [is] [js] * my emissionProbs [js] [obs [it + 1]];
+				sum += beta_tp1 [js] * a_is [js] * emission [js];
 			}
-			thy beta [is] [it] = sum / thy scale [it];
+			thy beta [it] [is] = sum / thy scale [it];
 		}
 	}
 }
 
 /*************************** HMM decoding ***********************************/
 
+/*
+	The Viterbi scores are logarithms of probabilities, so that they do not underflow for long sequences;
+	an impossible path has a score of -INFINITY.
+*/
 // precondition: valid symbols, i.e. 1 <= o[i] <= my numberOfSymbols for i=1..nt
 void HMM_and_HMMViterbi_decode (HMM me, HMMViterbi thee, long *obs) {
 	long ntimes = thy numberOfTimes;
+	autoNUMmatrix <double> lnTransitionProbs (0, my numberOfStates, 1, my numberOfStates);
+	for (long is = 0; is <= my numberOfStates; is++) {
+		for (long js = 1; js <= my numberOfStates; js++) {
+			lnTransitionProbs [is] [js] = log (my transitionProbs [is] [js]);   // log (0.0) = -INFINITY
+		}
+	}
 	// initialisation
 	for (long is = 1; is <= my numberOfStates; is++) {
-		thy viterbi[is][1] = my transitionProbs[0][is] * my emissionProbs[is][ obs[1] ];
-		thy bp[is][1] = 0;
+		thy viterbi [1] [is] = lnTransitionProbs [0] [is] + log (my emissionProbs [is] [obs [1]]);
+		thy bp [1] [is] = 0;
 	}
 	// recursion
 	for (long it = 2; it <= ntimes; it++) {
+		const double *viterbi_tm1 = thy viterbi [it - 1];
 		for (long is = 1; is <= my numberOfStates; is++) {
 			// all transitions isp -> is from previous time to current
-			double max_score = -1; // any negative number is ok
+			double max_score = -INFINITY;
+			long best = 1;   // if no path is possible
 			for (long isp = 1; isp <= my numberOfStates; isp++) {
-				double score = thy viterbi[isp][it - 1] * my transitionProbs[isp][is]; // * my emissionProbs[is][ obs[it] ]
+				double score = viterbi_tm1 [isp] + lnTransitionProbs [isp] [is]; // + ln (emissionProbs[is][ obs[it] ])
 				if (score > max_score) {
 					max_score = score;
-					thy bp[is][it] = isp;
+					best = isp;
 				}
 			}
-			thy viterbi[is][it] = max_score * my emissionProbs[is][ obs[it] ];
+			thy bp [it] [is] = best;
+			thy viterbi [it] [is] = max_score + log (my emissionProbs [is] [obs [it]]);
 		}
 	}
 	// path starts at state with best end probability
 	thy path[ntimes] = 1;
-	thy prob = thy viterbi[1][ntimes];
+	thy lnProb = thy viterbi [ntimes] [1];
 	for (long is = 2; is <= my numberOfStates; is++) {
-		if (thy viterbi[is][ntimes] > thy prob) {
-			thy prob = thy viterbi[ thy path[ntimes] = is ][ntimes];
+		if (thy viterbi [ntimes] [is] > thy lnProb) {
+			thy lnProb = thy viterbi [ntimes] [thy path [ntimes] = is];
 		}
 	}
 	// trace back and get path
 	for (long it = ntimes; it > 1; it--) {
-		thy path[it - 1] = thy bp[ thy path[it] ][it];
+		thy path [it - 1] = thy bp [it] [thy path [it]];
 	}
 }
 
@@ -50,11 +50,13 @@ Thing_define (HMMBaumWelch, Daata) {
 	long numberOfSymbols;
 	double lnProb;
 	double minProb;
-	double **alpha;
+	double **alpha;   // [1..capacity] [1..numberOfStates], time-major like beta and gamma
 	double **beta;
 	double *scale;
 	double **gamma;
-	double ***xi;
+	double **xi;   // [1..numberOfStates] [1..numberOfStates], for one time step
+	double **xisum;   // [1..numberOfStates] [1..numberOfStates], summed over the time steps of the current sequence
+	double *gammasum, **gammasum_k, *emission;   // room for addEstimate and backward, which may run on a separate thread
 	double **aij_num, **aij_denom;
 	double **bik_num, **bik_denom;
 
@@ -65,9 +65,9 @@ oo_DEFINE_CLASS (HMMViterbi, Daata)
 
 	oo_LONG (numberOfTimes)
 	oo_LONG (numberOfStates)
-	oo_DOUBLE (prob)
-	oo_DOUBLE_MATRIX (viterbi, numberOfStates, numberOfTimes)
-	oo_LONG_MATRIX (bp, numberOfStates, numberOfTimes)
+	oo_DOUBLE (lnProb)
+	oo_DOUBLE_MATRIX (viterbi, numberOfTimes, numberOfStates)   // ln (p)
+	oo_LONG_MATRIX (bp, numberOfTimes, numberOfStates)
 	oo_LONG_VECTOR (path, numberOfTimes)
 
 oo_END_CLASS(HMMViterbi)
@@ -31,6 +31,7 @@
 #include "Sound_to_Pitch.h"
 #include "Vector.h"
 #include "NUM2.h"
+#include "SampledAnalysis.h"
 
 #define MIN(m,n) ((m) < (n) ? (m) : (n))
 // prototypes
@@ -218,22 +219,22 @@ autoMelSpectrogram Sound_to_MelSpectrogram (Sound me, double analysisWidth, doub
 		fmax_mel = f1_mel + numberOfFilters * df_mel;
 
 		Sampled_shortTermAnalysis (me, windowDuration, dt, &numberOfFrames, &t1);
-		autoSound sframe = Sound_createSimple (1, windowDuration, samplingFrequency);
 		autoSound window = Sound_createGaussian (windowDuration, samplingFrequency);
 		autoMelSpectrogram thee = MelSpectrogram_create (my xmin, my xmax, numberOfFrames, dt, t1, fmin_mel, fmax_mel, numberOfFilters, df_mel, f1_mel);
 
 		autoMelderProgress progress (U"MelSpectrograms analysis");
 
-		for (long iframe = 1; iframe <= numberOfFrames; iframe++) {
-			double t = Sampled_indexToX (thee.get(), iframe);
-			Sound_into_Sound (me, sframe.get(), t - windowDuration / 2.0);
-			Sounds_multiply (sframe.get(), window.get());
-			Sound_into_MelSpectrogram_frame (sframe.get(), thee.get(), iframe);
-			
-			if (iframe % 10 == 1) {
-				Melder_progress ((double) iframe / numberOfFrames, U"Frame ", iframe, U" out of ", numberOfFrames, U".");
-			}
-		}
+		Sampled_analyseFrames <autoSound> (thee.get(), 10,
+			[&] (autoSound& sframe) {
+				sframe = Sound_createSimple (1, windowDuration, samplingFrequency);
+			},
+			[&] (autoSound& sframe, long iframe) {
+				double t = Sampled_indexToX (thee.get(), iframe);
+				Sound_into_Sound (me, sframe.get(), t - windowDuration / 2.0);
+				Sounds_multiply (sframe.get(), window.get());
+				Sound_into_MelSpectrogram_frame (sframe.get(), thee.get(), iframe);
+			},
+			U"MelSpectrogram analysis");
 		
 		_Spectrogram_windowCorrection ((Spectrogram) thee.get(), window -> nx);
 
@@ -222,6 +222,7 @@ static int synthCallback (short *wav, int numsamples, espeak_EVENT *events)
 
 const char32 *SpeechSynthesizer_getVoiceLanguageCodeFromName (SpeechSynthesizer /* me */, const char32 *voiceLanguageName) {
 	try {
+		espeakdata_praat_init ();
 		long voiceLanguageNameIndex = Strings_findString (espeakdata_voices_names.get(), voiceLanguageName);
 		if (voiceLanguageNameIndex == 0) {
 			Melder_throw (U"Cannot find language \"", voiceLanguageName, U"\".");
@@ -236,6 +237,7 @@ const char32 *SpeechSynthesizer_getVoiceLanguageCodeFromName (SpeechSynthesizer
 const char32 *SpeechSynthesizer_getVoiceVariantCodeFromName (SpeechSynthesizer /* me */, const char32 *voiceVariantName) {
 	try {
 		static const char32 * defaultVariantCode = U"default";
+		espeakdata_praat_init ();
 		// Strings espeakdata_variants_names is one longer than the actual list of variants
 		long voiceVariantIndex = Strings_findString (espeakdata_variants_names.get(), voiceVariantName);
 		if (voiceVariantIndex == 0) {
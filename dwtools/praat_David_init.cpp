@@ -1801,7 +1801,7 @@ DO
 		if ((xTime >= my xmin && xTime <= my xmax) && (yTime >= my ymin && yTime <= my ymax)) {
 			long irow = Matrix_yToNearestRow (me, yTime);
 			long icol = Matrix_xToNearestColumn (me, xTime);
-			result = my z[irow][icol];
+			result = DeferredMatrix_getValue (me, irow, icol);
 		}
 		NUMBER_ONE_END (U" (= distance at (", xTime, U", ", yTime, U"))")
 }
@@ -1809,6 +1809,7 @@ DO
 DIRECT (REAL_DTW_getMinimumDistance) {
 	NUMBER_ONE (DTW)
 		double result, maximum;
+		DeferredMatrix_materialize (me);
 		Matrix_getWindowExtrema (me, 0, 0, 0, 0, & result, & maximum);
 	NUMBER_ONE_END (U" (minimum)")
 }
@@ -1816,6 +1817,7 @@ DIRECT (REAL_DTW_getMinimumDistance) {
 DIRECT (REAL_DTW_getMaximumDistance) {
 	NUMBER_ONE (DTW)
 		double minimum, result;
+		DeferredMatrix_materialize (me);
 		Matrix_getWindowExtrema (me, 0, 0, 0, 0, & minimum, & result);
 	NUMBER_ONE_END (U" (maximum)")
 }
@@ -1863,6 +1865,7 @@ DO
 		}
 		long irow = Matrix_yToNearestRow (me, yTime);
 		long icol = Matrix_xToNearestColumn (me, xTime);
+		DeferredMatrix_materialize (me);
 		my z[irow][icol] = newDistance;
 	MODIFY_EACH_END
 }
@@ -2469,6 +2472,7 @@ FORM (NEW_FileInMemorySet_createCopyFromFileInMemorySet, U"", nullptr) {
 	OK
 DO
 	CREATE_ONE
+		espeakdata_praat_init ();
 		autoDaata result;
 		const char32 *name;
 		if (whichFile == 1) {
@@ -5584,6 +5588,7 @@ FORM (NEW1_SpeechSynthesizer_create, U"Create SpeechSynthesizer", U"Create Speec
 	 * In the speech synthesis world a language variant is called a "voice", we use the same terminology 
 	 * in our coding. However for the user interface we use "language" instead of "voice".
 	 */
+	espeakdata_praat_init ();
 	static long prefLanguage = Strings_findString (espeakdata_voices_names.get(), U"English");
 	if (prefLanguage == 0) {
 		prefLanguage = 1;
@@ -7263,8 +7268,6 @@ void praat_uvafon_David_init () {
 
 	VowelEditor_prefs ();
 
-	espeakdata_praat_init ();
-
 	praat_addMenuCommand (U"Objects", U"Technical", U"Report floating point properties", U"Report integer properties", 0, INFO_Praat_ReportFloatingPointProperties);
 	praat_addMenuCommand (U"Objects", U"Goodies", U"Get TukeyQ...", 0, praat_HIDDEN, REAL_Praat_getTukeyQ);
 	praat_addMenuCommand (U"Objects", U"Goodies", U"Get invTukeyQ...", 0, praat_HIDDEN, REAL_Praat_getInvTukeyQ);
@@ -80,6 +80,10 @@ static autoStrings Strings_insertAndExpand (Strings me, long position, const cha
 }
 
 void espeakdata_praat_init () {
+	static bool isInitialized = false;
+	if (isInitialized) {
+		return;
+	}
 	try {
 		espeakdata_variants = create_espeakdata_variants ();
 		autoStrings vnames = FileInMemorySet_to_Strings_id (espeakdata_variants.get());
@@ -89,6 +93,7 @@ void espeakdata_praat_init () {
 		espeakdata_voices = create_espeakdata_voices ();
 		espeakdata_voices_names = espeak_voices_sort ();
 		autoTable names_table = espeakdata_voices_to_Table (espeakdata_voices.get());
+		isInitialized = true;
 	} catch (MelderError) {
 		Melder_throw (U"Espeakdata initialization not performed.");
 	}
@@ -170,6 +175,7 @@ autoStrings espeakdata_voices_getNames (Table me, long column) {
 }
 
 char * espeakdata_get_dict_data (const char *name, unsigned int *size) {
+	espeakdata_praat_init ();
 	long lsize;
 	char *data = FileInMemorySet_getCopyOfData (espeakdata_dicts.get(), Melder_peek8to32 (name), &lsize);
 	*size = (unsigned int) lsize;
@@ -178,10 +184,12 @@ char * espeakdata_get_dict_data (const char *name, unsigned int *size) {
 
 
 const char * espeakdata_get_voice (const char *vname, long *numberOfBytes) {
+	espeakdata_praat_init ();
 	return FileInMemorySet_getData (espeakdata_voices.get(), Melder_peek8to32 (vname), numberOfBytes);
 }
 
 const char * espeakdata_get_voiceVariant (const char *vname, long *numberOfBytes) {
+	espeakdata_praat_init ();
 	char *plus = strstr ((char *) vname, "+"); // prototype says: strstr (const char *, const char *)
 	const char *name = ( plus ? ++ plus : vname );
 	return FileInMemorySet_getData (espeakdata_variants.get(), Melder_peek8to32 (name), numberOfBytes);;
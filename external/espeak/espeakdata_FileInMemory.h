@@ -43,6 +43,10 @@ extern autoStrings espeakdata_voices_names;
 extern autoStrings espeakdata_variants_names;
 
 void espeakdata_praat_init ();
+/*
+	Creates the sets above from the data compiled into the program.
+	This is done on first use, not at start-up; later calls do nothing.
+*/
 
 const char * espeakdata_get_voicedata (const char *data, long ndata, char *buf, long nbuf, long *index);
 
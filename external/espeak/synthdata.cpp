@@ -118,6 +118,7 @@ int LoadPhData(int *srate)
 
 #ifdef DATA_FROM_SOURCECODE_FILES
 	long llength;
+	espeakdata_praat_init ();
 	phoneme_tab_data = (unsigned char *) FileInMemorySet_getData (espeakdata_phons.get(), U"phontab", &llength);
 	phoneme_index = (USHORT *) FileInMemorySet_getData (espeakdata_phons.get(), U"phonindex", &llength);
 	phondata_ptr = (char *) FileInMemorySet_getData (espeakdata_phons.get(), U"phondata", &llength);
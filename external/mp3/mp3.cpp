@@ -57,7 +57,7 @@ extern "C" {
 }
 
 #define MP3F_BUFFER_SIZE (8 * 1024)
-#define MP3F_MAX_LOCATIONS 1024
+#define MP3F_MAX_LOCATIONS 131072   /* one location per few frames even for files of many hours, so that seeking hardly needs decoding */
 
 /*
  * MP3 encoders and decoders add a number of silent samples at the beginning.
@@ -255,13 +255,13 @@ void FormantGrid_formula_bandwidths (FormantGrid me, const char32 *expression, I
 		if (! thee) thee = me;
 		for (long irow = 1; irow <= my formants.size; irow ++) {
 			RealTier bandwidth = thy bandwidths.at [irow];
-			for (long icol = 1; icol <= bandwidth -> points.size; icol ++) {
-				struct Formula_Result result;
-				Formula_run (irow, icol, & result);
-				if (result. result.numericResult == NUMundefined)
-					Melder_throw (U"Cannot put an undefined value into the tier.\nFormula not finished.");
-				bandwidth -> points.at [icol] -> value = result. result.numericResult;
-			}
+			Formula_runForCells (thee, irow, irow, 1, bandwidth -> points.size,
+				[=] (long /* irow */, long icol, double value) {
+					if (value == NUMundefined)
+						Melder_throw (U"Cannot put an undefined value into the tier.\nFormula not finished.");
+					bandwidth -> points.at [icol] -> value = value;
+				}
+			);
 		}
 	} catch (MelderError) {
 		Melder_throw (me, U": bandwidth formula not completed.");
@@ -274,13 +274,13 @@ void FormantGrid_formula_frequencies (FormantGrid me, const char32 *expression,
 		if (! thee) thee = me;
 		for (long irow = 1; irow <= my formants.size; irow ++) {
 			RealTier formant = thy formants.at [irow];
-			for (long icol = 1; icol <= formant -> points.size; icol ++) {
-				struct Formula_Result result;
-				Formula_run (irow, icol, & result);
-				if (result. result.numericResult == NUMundefined)
-					Melder_throw (U"Cannot put an undefined value into the tier.\nFormula not finished.");
-				formant -> points.at [icol] -> value = result. result.numericResult;
-			}
+			Formula_runForCells (thee, irow, irow, 1, formant -> points.size,
+				[=] (long /* irow */, long icol, double value) {
+					if (value == NUMundefined)
+						Melder_throw (U"Cannot put an undefined value into the tier.\nFormula not finished.");
+					formant -> points.at [icol] -> value = value;
+				}
+			);
 		}
 	} catch (MelderError) {
 		Melder_throw (me, U": frequency formula not completed.");
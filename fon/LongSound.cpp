@@ -45,6 +45,10 @@
 #include "Preferences.h"
 #include "flac_FLAC_stream_decoder.h"
 #include "mp3.h"
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 Thing_implement (LongSound, Sampled, 0);
 Thing_implement (SoundAndLongSoundList, Ordered, 0);
@@ -52,6 +56,40 @@ Thing_implement (SoundAndLongSoundList, Ordered, 0);
 #define MARGIN  0.01
 #define USE_MEMMOVE  1
 
+/*
+	The window buffer (my buffer, my imin..my imax) is filled from a cache of decoded blocks,
+	so that going back to a part of the file that was seen recently does not require reading or decoding it again.
+	After every change of window, a separate thread reads ahead into the cache,
+	i.e. it decodes the blocks of the next window in the direction in which the user is moving.
+	The cache holds about four buffer lengths; the least recently used blocks are reused first.
+*/
+#define LongSound_BLOCK_SIZE  32768   /* samples per channel */
+
+struct LongSound_CachedBlock {
+	long iblock;   // 0 if the slot is free
+	long numberOfSamples;
+	int16 *samples;   // interleaved channels
+	unsigned long long lastUse;
+	bool loading;   // being decoded, outside the lock
+};
+
+struct structLongSoundCache {
+	std::mutex decoderMutex;   // guards the file pointer and the decoders, which are shared by the main thread and the reader
+	std::mutex mutex;   // guards everything below
+	std::condition_variable changed;   // a block was loaded, the reader got work, or the reader should stop
+	std::vector <LongSound_CachedBlock> blocks;
+	unsigned long long useCount = 0;
+	std::vector <long> readAheadQueue;   // block numbers, in the order in which they should be read
+	size_t readAheadPosition = 0;
+	long previousImin = 0;
+	bool stopping = false;
+	std::thread reader;
+	~structLongSoundCache () {
+		for (size_t i = 0; i < blocks.size(); i ++)
+			NUMvector_free <int16> (blocks [i]. samples, 0);
+	}
+};
+
 static long prefs_bufferLength;
 
 void LongSound_preferences () {
@@ -67,6 +105,15 @@ void structLongSound :: v_destroy () noexcept {
 	 * That pointer is about to dangle, so kill the playback.
 	 */
 	MelderAudio_stopPlaying (MelderAudio_IMPLICIT);
+	if (cache) {
+		{
+			std::lock_guard <std::mutex> lock (cache -> mutex);
+			cache -> stopping = true;
+		}
+		cache -> changed.notify_all ();
+		if (cache -> reader.joinable ())
+			cache -> reader.join ();
+	}
 	if (mp3f)
 		mp3f_delete (mp3f);
 	if (flacDecoder) {
@@ -75,6 +122,7 @@ void structLongSound :: v_destroy () noexcept {
 	}
 	else if (f) fclose (f);
 	NUMvector_free <int16> (buffer, 0);
+	delete cache;
 	LongSound_Parent :: v_destroy ();
 }
 
@@ -224,6 +272,18 @@ static void LongSound_init (LongSound me, MelderFile file) {
 	}
 	my imin = 1;
 	my imax = 0;
+	my cache = new structLongSoundCache;
+	long numberOfCachedBlocks = (long) ceil (4.0 * my bufferLength * my sampleRate / LongSound_BLOCK_SIZE) + 2;
+	if (numberOfCachedBlocks > my nx / LongSound_BLOCK_SIZE + 1) numberOfCachedBlocks = my nx / LongSound_BLOCK_SIZE + 1;
+	my cache -> blocks.resize ((size_t) numberOfCachedBlocks);
+	for (long i = 0; i < numberOfCachedBlocks; i ++) {
+		LongSound_CachedBlock *block = & my cache -> blocks [(size_t) i];
+		block -> iblock = 0;
+		block -> numberOfSamples = 0;
+		block -> lastUse = 0;
+		block -> loading = false;
+		block -> samples = NUMvector <int16> (0, LongSound_BLOCK_SIZE * my numberOfChannels - 1);
+	}
 	my flacDecoder = nullptr;
 	if (my audioFileType == Melder_FLAC) {
 		my flacDecoder = FLAC__stream_decoder_new ();
@@ -245,6 +305,7 @@ void structLongSound :: v_copy (Daata thee_Daata) {
 	LongSound thee = static_cast <LongSound> (thee_Daata);
 	thy f = nullptr;
 	thy buffer = nullptr;
+	thy cache = nullptr;
 	LongSound_init (thee, & file);
 }
 
@@ -296,6 +357,7 @@ static void _LongSound_MP3_readAudioToShort (LongSound me, int16 *buffer, long f
 }
 
 void LongSound_readAudioToFloat (LongSound me, double **buffer, long firstSample, long numberOfSamples) {
+	std::lock_guard <std::mutex> lock (my cache -> decoderMutex);
 	if (my encoding == Melder_FLAC_COMPRESSION_16) {
 		my compressedMode = COMPRESSED_MODE_READ_FLOAT;
 		for (int ichan = 1; ichan <= my numberOfChannels; ichan ++) {
@@ -315,6 +377,7 @@ void LongSound_readAudioToFloat (LongSound me, double **buffer, long firstSample
 }
 
 void LongSound_readAudioToShort (LongSound me, int16 *buffer, long firstSample, long numberOfSamples) {
+	std::lock_guard <std::mutex> lock (my cache -> decoderMutex);
 	if (my encoding == Melder_FLAC_COMPRESSION_16) {
 		_LongSound_FLAC_readAudioToShort (me, buffer, firstSample, numberOfSamples);
 	} else if (my encoding == Melder_MPEG_COMPRESSION_16) {
@@ -342,8 +405,180 @@ autoSound LongSound_extractPart (LongSound me, double tmin, double tmax, int pre
 	}
 }
 
+autoSound LongSound_resample (LongSound me, double samplingFrequency, long precision) {
+	try {
+		if (fabs (samplingFrequency * my dx - 1.0) < 1e-6)
+			return LongSound_extractPart (me, my xmin, my xmax, true);
+		autoMelderProgress progress (U"Resampling...");
+		return Sound_resample_piecewise (me, my numberOfChannels, samplingFrequency, precision,
+			[me] (double **buffer, long firstSample, long numberOfSamples) {
+				Melder_progress ((double) (firstSample - 1) / my nx, U"Resampled ", Melder_fixed ((firstSample - 1) * my dx, 1),
+					U" out of ", Melder_fixed (my xmax - my xmin, 1), U" seconds.");
+				LongSound_readAudioToFloat (me, buffer, firstSample, numberOfSamples);
+			}
+		);
+	} catch (MelderError) {
+		Melder_throw (me, U": not resampled.");
+	}
+}
+
+#define LongSound_ANALYSIS_PART_SIZE  1000000   /* samples per channel, apart from the margins */
+
+void Sampled_analyseSoundInParts (Sampled me, Sampled thee, double margin,
+	std::function <void (Sound part, long sampleOffset, long firstFrame, long lastFrame)> analysePart)
+{
+	if (! Thing_isa (me, classLongSound)) {
+		analysePart (static_cast <Sound> (me), 0, 1, thy nx);
+		return;
+	}
+	long numberOfFramesPerPart = (long) floor (LongSound_ANALYSIS_PART_SIZE * my dx / thy dx);
+	if (numberOfFramesPerPart < 1) numberOfFramesPerPart = 1;
+	for (long firstFrame = 1; firstFrame <= thy nx; firstFrame += numberOfFramesPerPart) {
+		long lastFrame = firstFrame + numberOfFramesPerPart - 1;
+		if (lastFrame > thy nx) lastFrame = thy nx;
+		autoSound part = LongSound_extractPart (static_cast <LongSound> (me),
+			Sampled_indexToX (thee, firstFrame) - margin, Sampled_indexToX (thee, lastFrame) + margin, true);
+		long sampleOffset = lround ((part -> x1 - my x1) / my dx);
+		analysePart (part.get(), sampleOffset, firstFrame, lastFrame);
+	}
+}
+
+static void _LongSound_decodeBlock (LongSound me, long iblock, int16 *samples, long *numberOfSamples) {
+	const long firstSample = (iblock - 1) * LongSound_BLOCK_SIZE + 1;
+	long n = my nx - firstSample + 1;
+	if (n > LongSound_BLOCK_SIZE) n = LongSound_BLOCK_SIZE;
+	std::lock_guard <std::mutex> lock (my cache -> decoderMutex);
+	if (my encoding == Melder_FLAC_COMPRESSION_16 || my encoding == Melder_MPEG_COMPRESSION_16) {
+		/*
+			The decoders count samples from 0.
+		*/
+		my compressedMode = COMPRESSED_MODE_READ_SHORT;
+		my compressedShorts = samples;
+		if (my encoding == Melder_FLAC_COMPRESSION_16)
+			_LongSound_FLAC_process (me, firstSample - 1, n + 1);   // which decodes n samples
+		else
+			_LongSound_MP3_process (me, firstSample - 1, n);
+	} else {
+		_LongSound_FILE_seekSample (me, firstSample);
+		Melder_readAudioToShort (my f, my numberOfChannels, my encoding, samples, n);
+	}
+	*numberOfSamples = n;
+}
+
+static LongSound_CachedBlock * _LongSound_findBlock (LongSound me, long iblock) {
+	for (size_t i = 0; i < my cache -> blocks.size(); i ++)
+		if (my cache -> blocks [i]. iblock == iblock)
+			return & my cache -> blocks [i];
+	return nullptr;
+}
+
+static LongSound_CachedBlock * _LongSound_claimBlock (LongSound me, long iblock) {
+	LongSound_CachedBlock *leastRecentlyUsed = nullptr;
+	for (size_t i = 0; i < my cache -> blocks.size(); i ++) {
+		LongSound_CachedBlock *block = & my cache -> blocks [i];
+		if (block -> loading) continue;
+		if (! leastRecentlyUsed || block -> lastUse < leastRecentlyUsed -> lastUse)
+			leastRecentlyUsed = block;
+	}
+	if (leastRecentlyUsed) {
+		leastRecentlyUsed -> iblock = iblock;
+		leastRecentlyUsed -> loading = true;
+	}
+	return leastRecentlyUsed;
+}
+
+static void _LongSound_readAhead (LongSound me) {
+	structLongSoundCache *cache = my cache;
+	std::unique_lock <std::mutex> lock (cache -> mutex);
+	for (;;) {
+		cache -> changed.wait (lock, [cache] { return cache -> stopping || cache -> readAheadPosition < cache -> readAheadQueue.size(); });
+		if (cache -> stopping) return;
+		const long iblock = cache -> readAheadQueue [cache -> readAheadPosition ++];
+		if (_LongSound_findBlock (me, iblock)) continue;
+		LongSound_CachedBlock *block = _LongSound_claimBlock (me, iblock);
+		if (! block) continue;
+		lock.unlock ();
+		bool decoded = true;
+		try {
+			_LongSound_decodeBlock (me, iblock, block -> samples, & block -> numberOfSamples);
+		} catch (MelderError) {
+			Melder_clearError ();   // the main thread will find out for itself if it needs this block
+			decoded = false;
+		}
+		lock.lock ();
+		block -> loading = false;
+		if (decoded) {
+			block -> lastUse = ++ cache -> useCount;
+		} else {
+			block -> iblock = 0;
+			block -> lastUse = 0;
+			cache -> readAheadPosition = cache -> readAheadQueue.size();   // give up on this request
+		}
+		cache -> changed.notify_all ();
+	}
+}
+
+static void _LongSound_requestReadAhead (LongSound me, long imin, long imax) {
+	structLongSoundCache *cache = my cache;
+	const long n = imax - imin + 1;
+	if (n > (long) cache -> blocks.size() * LongSound_BLOCK_SIZE / 3) return;   // the next window would push the current one out of the cache
+	const bool goingLeft = imin < cache -> previousImin;
+	cache -> previousImin = imin;
+	const long firstSample = goingLeft ? imin - n : imax + 1, lastSample = goingLeft ? imin - 1 : imax + n;
+	long firstBlock = (firstSample < 1 ? 1 : firstSample - 1) / LongSound_BLOCK_SIZE + 1;
+	long lastBlock = ((lastSample > my nx ? my nx : lastSample) - 1) / LongSound_BLOCK_SIZE + 1;
+	{
+		std::lock_guard <std::mutex> lock (cache -> mutex);
+		cache -> readAheadQueue.clear ();
+		cache -> readAheadPosition = 0;
+		if (goingLeft)
+			for (long iblock = lastBlock; iblock >= firstBlock; iblock --)
+				cache -> readAheadQueue.push_back (iblock);
+		else
+			for (long iblock = firstBlock; iblock <= lastBlock; iblock ++)
+				cache -> readAheadQueue.push_back (iblock);
+		if (! cache -> reader.joinable ())
+			cache -> reader = std::thread (_LongSound_readAhead, me);
+	}
+	cache -> changed.notify_all ();
+}
+
 static void _LongSound_readSamples (LongSound me, int16 *buffer, long imin, long imax) {
-	LongSound_readAudioToShort (me, buffer, imin, imax - imin + 1);
+	structLongSoundCache *cache = my cache;
+	const long firstBlock = (imin - 1) / LongSound_BLOCK_SIZE + 1, lastBlock = (imax - 1) / LongSound_BLOCK_SIZE + 1;
+	for (long iblock = firstBlock; iblock <= lastBlock; iblock ++) {
+		std::unique_lock <std::mutex> lock (cache -> mutex);
+		LongSound_CachedBlock *block;
+		for (;;) {
+			block = _LongSound_findBlock (me, iblock);
+			if (! block || ! block -> loading) break;
+			cache -> changed.wait (lock);   // the reader is decoding this very block
+		}
+		if (! block) {
+			block = _LongSound_claimBlock (me, iblock);
+			Melder_assert (block);   // only the reader can be loading, and only one block at a time
+			lock.unlock ();
+			try {
+				_LongSound_decodeBlock (me, iblock, block -> samples, & block -> numberOfSamples);
+			} catch (MelderError) {
+				lock.lock ();
+				block -> loading = false;
+				block -> iblock = 0;
+				block -> lastUse = 0;
+				cache -> changed.notify_all ();
+				throw;
+			}
+			lock.lock ();
+			block -> loading = false;
+			cache -> changed.notify_all ();
+		}
+		block -> lastUse = ++ cache -> useCount;
+		const long blockStart = (iblock - 1) * LongSound_BLOCK_SIZE + 1;
+		const long first = iblock == firstBlock ? imin : blockStart;
+		const long last = iblock == lastBlock ? imax : blockStart + LongSound_BLOCK_SIZE - 1;
+		memcpy (buffer + (first - imin) * my numberOfChannels, block -> samples + (first - blockStart) * my numberOfChannels,
+			(size_t) ((last - first + 1) * my numberOfChannels) * sizeof (int16));
+	}
 }
 
 static void writePartToOpenFile (LongSound me, int audioFileType, long imin, long n, MelderFile file, int numberOfChannels_override, int numberOfBitsPerSamplePoint) {
@@ -483,6 +718,7 @@ bool LongSound_haveWindow (LongSound me, double tmin, double tmax) {
 	long n = Sampled_getWindowSamples (me, tmin, tmax, & imin, & imax);
 	if ((1.0 + 2 * MARGIN) * n + 1 > my nmax) return false;
 	_LongSound_haveSamples (me, imin, imax);
+	_LongSound_requestReadAhead (me, imin, imax);
 	return true;
 }
 
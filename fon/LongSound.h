@@ -27,6 +27,7 @@
 struct FLAC__StreamDecoder;
 struct FLAC__StreamEncoder;
 struct _MP3_FILE;
+struct structLongSoundCache;
 
 Thing_define (LongSound, Sampled) {
 	structMelderFile file;
@@ -43,6 +44,7 @@ Thing_define (LongSound, Sampled) {
 	long compressedSamplesLeft;
 	double *compressedFloats [2];
 	int16 *compressedShorts;
+	struct structLongSoundCache *cache;   // decoded blocks, and the thread that reads ahead
 
 	void v_destroy () noexcept
 		override;
@@ -60,6 +62,25 @@ autoLongSound LongSound_open (MelderFile file);
 
 autoSound LongSound_extractPart (LongSound me, double tmin, double tmax, int preserveTimes);
 
+autoSound LongSound_resample (LongSound me, double samplingFrequency, long precision);
+/*
+	As Sound_resample, but reads the sound file piece by piece.
+*/
+
+void Sampled_analyseSoundInParts (Sampled me, Sampled thee, double margin,
+	std::function <void (Sound part, long sampleOffset, long firstFrame, long lastFrame)> analysePart);
+/*
+	'me' is a Sound or a LongSound, and 'thee' is a short-term analysis of it.
+	A Sound is analysed in one go, as analysePart (me, 0, 1, thy nx).
+	A LongSound is analysed with bounded memory: the frames of 'thee' are divided into consecutive ranges,
+	and for each range, analysePart receives a Sound with the samples of the LongSound
+	within 'margin' seconds of the frame centres of the range (or up to the edges of the LongSound),
+	at their original times; sample i of the part is sample i + sampleOffset of 'me'.
+	To make the results independent of the division into parts, analysePart should compute sample numbers
+	from the times of 'me' rather than from those of the part, e.g. as Sampled_xToLowIndex (me, t) - sampleOffset,
+	because the two can round differently for times that lie halfway between two samples.
+*/
+
 bool LongSound_haveWindow (LongSound me, double tmin, double tmax);
 /*
  * Returns 0 if error or if window exceeds buffer, otherwise 1;
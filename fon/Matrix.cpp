@@ -625,15 +625,13 @@ void Matrix_writeToHeaderlessSpreadsheetFile (Matrix me, MelderFile file) {
 
 void Matrix_formula (Matrix me, const char32 *expression, Interpreter interpreter, Matrix target) {
 	try {
-		struct Formula_Result result;
 		Formula_compile (interpreter, me, expression, kFormula_EXPRESSION_TYPE_NUMERIC, true);
 		if (! target) target = me;
-		for (long irow = 1; irow <= my ny; irow ++) {
-			for (long icol = 1; icol <= my nx; icol ++) {
-				Formula_run (irow, icol, & result);
-				target -> z [irow] [icol] = result. result.numericResult;
+		Formula_runForCells (target, 1, my ny, 1, my nx,
+			[=] (long irow, long icol, double value) {
+				target -> z [irow] [icol] = value;
 			}
-		}
+		);
 	} catch (MelderError) {
 		Melder_throw (me, U": formula not completed.");
 	}
@@ -648,15 +646,13 @@ void Matrix_formula_part (Matrix me, double xmin, double xmax, double ymin, doub
 		long ixmin, ixmax, iymin, iymax;
 		(void) Matrix_getWindowSamplesX (me, xmin, xmax, & ixmin, & ixmax);
 		(void) Matrix_getWindowSamplesY (me, ymin, ymax, & iymin, & iymax);
-		struct Formula_Result result;
 		Formula_compile (interpreter, me, expression, kFormula_EXPRESSION_TYPE_NUMERIC, true);
 		if (! target) target = me;
-		for (long irow = iymin; irow <= iymax; irow ++) {
-			for (long icol = ixmin; icol <= ixmax; icol ++) {
-				Formula_run (irow, icol, & result);
-				target -> z [irow] [icol] = result. result.numericResult;
+		Formula_runForCells (target, iymin, iymax, ixmin, ixmax,
+			[=] (long irow, long icol, double value) {
+				target -> z [irow] [icol] = value;
 			}
-		}
+		);
 	} catch (MelderError) {
 		Melder_throw (me, U": formula not completed.");
 	}
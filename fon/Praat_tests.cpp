@@ -21,11 +21,13 @@
 /* 21 March 2009: modern enums */
 /* 24 May 2011: C++ */
 /* 5 June 2015: char32 */
+/* 6 December 2016: TimeBlas */
 
 #include "Praat_tests.h"
 
 #include "Graphics.h"
 #include "praat.h"
+#include "NUMcblas.h"
 
 #include "enums_getText.h"
 #include "Praat_tests_enums.h"
@@ -47,6 +49,30 @@ static autoDaata newAutoData () {
 	return data;
 }
 
+/*
+	Run a level-3 BLAS routine n times on size x size matrices, starting from c = c0 every time.
+	Debug option 48 selects the reference version of the routine.
+*/
+static double timeBlas (int routine, long size, int64 n, bool reference, double *a, double *b, double *c, double *c0) {
+	int savedDebug = Melder_debug;
+	Melder_debug = reference ? 48 : 0;
+	double one = 1.0, half = 0.5;
+	Melder_stopwatch ();
+	for (int64 i = 1; i <= n; i ++) {
+		NUMvector_copyElements (c0, c, 0, size * size - 1);
+		switch (routine) {
+			case 1: NUMblas_dgemm ("N", "N", & size, & size, & size, & one, a, & size, b, & size, & half, c, & size); break;
+			case 2: NUMblas_dgemm ("T", "N", & size, & size, & size, & one, a, & size, b, & size, & half, c, & size); break;
+			case 3: NUMblas_dsyr2k ("L", "N", & size, & size, & one, a, & size, b, & size, & half, c, & size); break;
+			case 4: NUMblas_dtrsm ("L", "L", "N", "N", & size, & size, & half, a, & size, c, & size); break;
+			case 5: NUMblas_dtrsm ("R", "U", "T", "N", & size, & size, & half, a, & size, c, & size); break;
+		}
+	}
+	double t = Melder_stopwatch ();
+	Melder_debug = savedDebug;
+	return t;
+}
+
 int Praat_tests (int itest, char32 *arg1, char32 *arg2, char32 *arg3, char32 *arg4) {
 	int64 n = Melder_atoi (arg1);
 	double t = 0.0;
@@ -254,6 +280,36 @@ int Praat_tests (int itest, char32 *arg1, char32 *arg2, char32 *arg3, char32 *ar
 			}
 			t = Melder_stopwatch ();
 		} break;
+		case kPraatTests_TIME_BLAS: {
+			/*
+				Compare the blocked level-3 BLAS routines with the reference routines.
+				arg1 is the number of runs, arg2 the size of the matrices (default 300).
+			*/
+			long size = arg2 [0] == U'\0' ? 300 : Melder_atoi (arg2);
+			if (size < 1) Melder_throw (U"The size of the matrices should be positive.");
+			long numberOfElements = size * size;
+			autoNUMvector <double> a ((long) 0, numberOfElements - 1), b ((long) 0, numberOfElements - 1);
+			autoNUMvector <double> c0 ((long) 0, numberOfElements - 1), c ((long) 0, numberOfElements - 1), cReference ((long) 0, numberOfElements - 1);
+			for (long i = 0; i < numberOfElements; i ++) {
+				a [i] = NUMrandomGauss (0.0, 1.0);
+				b [i] = NUMrandomGauss (0.0, 1.0);
+				c0 [i] = NUMrandomGauss (0.0, 1.0);
+			}
+			for (long i = 0; i < size; i ++)
+				a [i + i * size] += size;   // well-conditioned triangles for dtrsm
+			const char32 *names [] = { U"", U"dgemm NN", U"dgemm TN", U"dsyr2k LN", U"dtrsm LLNN", U"dtrsm RUTN" };
+			for (int routine = 1; routine <= 5; routine ++) {
+				double tReference = timeBlas (routine, size, n, true, a.peek(), b.peek(), cReference.peek(), c0.peek());
+				double tBlocked = timeBlas (routine, size, n, false, a.peek(), b.peek(), c.peek(), c0.peek());
+				double maximumDifference = 0.0;
+				for (long i = 0; i < numberOfElements; i ++)
+					maximumDifference = std::max (maximumDifference, fabs (c [i] - cReference [i]));
+				MelderInfo_writeLine (names [routine], U": reference ", Melder_fixed (tReference, 3), U" s, blocked ",
+					Melder_fixed (tBlocked, 3), U" s, speed-up ", Melder_fixed (tReference / tBlocked, 2),
+					U", maximum difference ", maximumDifference);
+				t += tBlocked;
+			}
+		} break;
 		case kPraatTests_THING_AUTO: {
 			int numberOfThingsBefore = theTotalNumberOfThings;
 			{
@@ -41,6 +41,7 @@ enums_begin (kPraatTests, 0)
 	enums_add (kPraatTests, 21, TIME_STR32CPY, U"TimeStr32cpy")
 	enums_add (kPraatTests, 22, TIME_GRAPHICS_TEXT_TOP, U"TimeGraphicsTextTop")
 	enums_add (kPraatTests, 23, THING_AUTO, U"ThingAuto")
-enums_end (kPraatTests, 23, CHECK_RANDOM_1009_2009)
+	enums_add (kPraatTests, 24, TIME_BLAS, U"TimeBlas")
+enums_end (kPraatTests, 24, CHECK_RANDOM_1009_2009)
 
 /* End of file Praat_tests_enums.h */
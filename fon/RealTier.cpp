@@ -466,13 +466,13 @@ void RealTier_formula (RealTier me, const char32 *expression, Interpreter interp
 	try {
 		Formula_compile (interpreter, me, expression, kFormula_EXPRESSION_TYPE_NUMERIC, true);
 		if (! thee) thee = me;
-		for (long icol = 1; icol <= my points.size; icol ++) {
-			struct Formula_Result result;
-			Formula_run (0, icol, & result);
-			if (result. result.numericResult == NUMundefined)
-				Melder_throw (U"Cannot put an undefined value into the tier.");
-			thy points.at [icol] -> value = result. result.numericResult;
-		}
+		Formula_runForCells (thee, 0, 0, 1, my points.size,
+			[=] (long /* irow */, long icol, double value) {
+				if (value == NUMundefined)
+					Melder_throw (U"Cannot put an undefined value into the tier.");
+				thy points.at [icol] -> value = value;
+			}
+		);
 	} catch (MelderError) {
 		Melder_throw (me, U": formula not completed.");
 	}
@@ -17,7 +17,7 @@
  */
 
 #include <math.h>
-#include "Sampled.h"
+#include "SampledAnalysis.h"
 
 #include "oo_DESTROY.h"
 #include "Sampled_def.h"
@@ -81,6 +81,24 @@ void Sampled_shortTermAnalysis (Sampled me, double windowDuration, double timeSt
 	*firstTime = ourMidTime - 0.5 * thyDuration + 0.5 * timeStep;
 }
 
+MelderThread_MUTEX (theSampledAnalysisMutex);
+static bool theSampledAnalysisMutexInited;
+
+void SampledAnalysis_init () {
+	if (! theSampledAnalysisMutexInited) {
+		MelderThread_MUTEX_INIT (theSampledAnalysisMutex);
+		theSampledAnalysisMutexInited = true;
+	}
+}
+
+void SampledAnalysis_lock () {
+	MelderThread_LOCK (theSampledAnalysisMutex);
+}
+
+void SampledAnalysis_unlock () {
+	MelderThread_UNLOCK (theSampledAnalysisMutex);
+}
+
 double Sampled_getValueAtSample (Sampled me, long isamp, long ilevel, int unit) {
 	if (isamp < 1 || isamp > my nx) return NUMundefined;
 	return my v_getValueAtSample (isamp, ilevel, unit);
@@ -0,0 +1,170 @@
+#ifndef _SampledAnalysis_h_
+#define _SampledAnalysis_h_
+/* SampledAnalysis.h
+ *
+ * This code is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at
+ * your option) any later version.
+ *
+ * This code is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this work. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "Sampled.h"
+#include "MelderThread.h"
+
+/*
+	A parallel engine for short-term analyses (Pitch, Formant, Intensity, Spectrogram, LPC...),
+	i.e. for analyses whose result is a Sampled that was set up with Sampled_shortTermAnalysis
+	and whose frames can be computed independently of each other.
+
+	The frames are divided into contiguous chunks, one per thread.
+	Every thread owns a Workspace (scratch buffers, FFT tables and the like)
+	that it sets up once and reuses for all of its frames.
+*/
+
+void SampledAnalysis_init ();   // on the main thread, before any threads are started
+void SampledAnalysis_lock ();
+void SampledAnalysis_unlock ();
+/*
+	For the few parts of a frame analysis that are not reentrant
+	(e.g. the f2c-translated LAPACK routines, which keep their locals in static memory).
+*/
+
+template <class Workspace, class InitWorkspace, class AnalyseFrame>
+struct SampledAnalysis_Chunk {
+	long firstFrame, lastFrame;   // the frames of this chunk
+	long firstFrameOfRange, numberOfFramesInRange, numberOfFrames;   // the range of frames being computed, and the whole analysis
+	InitWorkspace *initWorkspace;
+	AnalyseFrame *analyseFrame;
+	const char32 *progressTitle;
+	bool isMainThread;
+	volatile int *cancelled, *failed;
+	char32 *errorMessage;   // if this chunk failed
+};
+
+template <class Workspace, class InitWorkspace, class AnalyseFrame>
+static MelderThread_RETURN_TYPE SampledAnalysis_runChunk (SampledAnalysis_Chunk <Workspace, InitWorkspace, AnalyseFrame> *me) {
+	try {
+		Workspace workspace;
+		(*my initWorkspace) (workspace);
+		for (long iframe = my firstFrame; iframe <= my lastFrame; iframe ++) {
+			if (my isMainThread) {
+				if (my progressTitle)
+					Melder_progress (0.1 + 0.8 * (my firstFrameOfRange - 1 + (double) (iframe - my firstFrame) /
+							(my lastFrame - my firstFrame + 1) * my numberOfFramesInRange) / my numberOfFrames,
+						my progressTitle, U": analysing ", my numberOfFrames, U" frames");
+				if (*my failed) break;
+			} else if (*my cancelled) {
+				MelderThread_RETURN;
+			}
+			(*my analyseFrame) (workspace, iframe);
+		}
+	} catch (MelderError) {
+		/*
+			A thread other than the main thread cannot throw,
+			so every chunk keeps its message, and the calling thread will rethrow it.
+		*/
+		my errorMessage = Melder_dup_f (Melder_getError ());   // the error buffer is thread-local
+		Melder_clearError ();
+		*my cancelled = 1;   // tell the other threads to stop
+		*my failed = 1;
+	}
+	MelderThread_RETURN;
+}
+
+template <class Workspace, class InitWorkspace, class AnalyseFrame>
+void Sampled_analyseFrames (Sampled thee, long firstFrame, long lastFrame, long minimumNumberOfFramesPerThread,
+	InitWorkspace initWorkspace, AnalyseFrame analyseFrame, const char32 *progressTitle)
+/*
+	Function:
+		compute the frames firstFrame..lastFrame of the analysis 'thee' on as many threads as are useful.
+	Arguments:
+		minimumNumberOfFramesPerThread:
+			below this number, starting a thread costs more time than it saves.
+		initWorkspace (Workspace& workspace):
+			called once for every thread, on a default-constructed Workspace;
+			allocates the scratch buffers and tables needed for analysing one frame.
+		analyseFrame (Workspace& workspace, long iframe):
+			called once for every frame; should write into frame 'iframe' of 'thee' only,
+			and should only read from data that stay constant during the analysis.
+		progressTitle:
+			if not null, the calling thread shows progress (as a fraction of all the frames of 'thee',
+			so that an analysis can be computed range by range), and the analysis can be interrupted.
+	Failures:
+		an exception in any thread (including interruption by the user) stops all threads,
+		and is rethrown in the calling thread.
+*/
+{
+	typedef SampledAnalysis_Chunk <Workspace, InitWorkspace, AnalyseFrame> Chunk;
+	Melder_assert (firstFrame >= 1 && lastFrame <= thy nx);
+	const long numberOfFrames = lastFrame - firstFrame + 1;
+	if (numberOfFrames < 1) return;
+	if (minimumNumberOfFramesPerThread < 1) minimumNumberOfFramesPerThread = 1;
+	long numberOfThreads = (numberOfFrames - 1) / minimumNumberOfFramesPerThread + 1;
+	const int numberOfProcessors = MelderThread_getNumberOfProcessors ();
+	trace (numberOfProcessors, U" processors");
+	if (numberOfThreads > numberOfProcessors) numberOfThreads = numberOfProcessors;
+	if (numberOfThreads < 1) numberOfThreads = 1;
+	const long numberOfFramesPerThread = (numberOfFrames - 1) / numberOfThreads + 1;
+	numberOfThreads = (numberOfFrames - 1) / numberOfFramesPerThread + 1;   // no empty chunks
+
+	SampledAnalysis_init ();
+	volatile int cancelled = 0, failed = 0;
+	std::vector <Chunk> chunks ((size_t) numberOfThreads);
+	const long firstFrameOfRange = firstFrame;
+	for (long ithread = 1; ithread <= numberOfThreads; ithread ++) {
+		Chunk *chunk = & chunks [(size_t) ithread - 1];
+		chunk -> firstFrame = firstFrame;
+		chunk -> lastFrame = ithread == numberOfThreads ? lastFrame : firstFrame + numberOfFramesPerThread - 1;
+		chunk -> firstFrameOfRange = firstFrameOfRange;
+		chunk -> numberOfFramesInRange = numberOfFrames;
+		chunk -> numberOfFrames = thy nx;
+		chunk -> initWorkspace = & initWorkspace;
+		chunk -> analyseFrame = & analyseFrame;
+		chunk -> progressTitle = progressTitle;
+		chunk -> isMainThread = ( ithread == numberOfThreads );   // MelderThread_run runs the last chunk on the calling thread
+		chunk -> cancelled = & cancelled;
+		chunk -> failed = & failed;
+		chunk -> errorMessage = nullptr;
+		firstFrame = chunk -> lastFrame + 1;
+	}
+	MelderThread_run (SampledAnalysis_runChunk <Workspace, InitWorkspace, AnalyseFrame>, chunks.data(), (int) numberOfThreads);
+	/*
+		Report the error in the first chunk that failed.
+	*/
+	char32 *errorMessage = nullptr;
+	for (long ithread = 1; ithread <= numberOfThreads; ithread ++) {
+		char32 *message = chunks [(size_t) ithread - 1]. errorMessage;
+		if (message && ! errorMessage)
+			errorMessage = message;
+		else
+			Melder_free (message);
+	}
+	if (errorMessage) {
+		Melder_appendError_noLine (errorMessage);
+		Melder_free (errorMessage);
+		throw MelderError ();
+	}
+	if (failed)
+		Melder_throw (U"Frame analysis failed in one of the threads.");   // no memory left for the message
+}
+
+template <class Workspace, class InitWorkspace, class AnalyseFrame>
+void Sampled_analyseFrames (Sampled thee, long minimumNumberOfFramesPerThread,
+	InitWorkspace initWorkspace, AnalyseFrame analyseFrame, const char32 *progressTitle)
+/*
+	Compute all the frames 1..thy nx.
+*/
+{
+	Sampled_analyseFrames <Workspace> (thee, 1, thy nx, minimumNumberOfFramesPerThread, initWorkspace, analyseFrame, progressTitle);
+}
+
+/* End of file SampledAnalysis.h */
+#endif
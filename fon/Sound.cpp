@@ -25,6 +25,7 @@
 #include "Sound.h"
 #include "Sound_extensions.h"
 #include "NUM2.h"
+#include "MelderThread.h"
 
 #include "enums_getText.h"
 #include "Sound_enums.h"
@@ -363,62 +364,182 @@ autoSound Sound_upsample (Sound me) {
 	}
 }
 
+/*
+	Resampling.
+
+	Every output sample is a weighted sum of the input samples around it:
+		y (t) = sum over k of x [k] * c * g (c * (index (t) - k)),
+	where index (t) is the (real-valued) input sample number at time t,
+	c = min (1, new sampling frequency / old sampling frequency) is the cutoff frequency as a fraction of the old Nyquist frequency,
+	and g (u) = sinc (pi u) * (0.5 + 0.5 cos (pi u / (depth + 1))) for |u| < depth + 1, and 0 elsewhere.
+	Input samples outside the sound count as zero.
+	For downsampling, this is a windowed-sinc low-pass filter and interpolator in one;
+	for upsampling with depth 1 or less, g is the triangle of linear interpolation.
+
+	As every output sample needs only a window of input samples, the input can be read in blocks of bounded size,
+	and the output samples of a block can be divided among threads.
+	g is tabulated with Sound_RESAMPLE_TABLE_RESOLUTION points per zero crossing, and linearly interpolated.
+*/
+#define Sound_RESAMPLE_TABLE_RESOLUTION  1024
+#define Sound_RESAMPLE_MINIMUM_FILTER_DEPTH  10
+#define Sound_RESAMPLE_INPUT_BLOCK_SIZE  1000000
+#define Sound_RESAMPLE_MINIMUM_SAMPLES_PER_THREAD  10000
+
+struct Sound_ResampleChunk {
+	long numberOfChannels, inputNumberOfSamples;
+	double inputX1, inputDx, outputX1, outputDx;
+	double **from;   // the input samples firstInputSample..lastInputSample, as from [channel] [1..]
+	long firstInputSample, lastInputSample;
+	double **to;
+	long firstOutputSample, lastOutputSample;
+	const double *table;
+	double tableStep, halfWidth, gain;
+	double *weights;
+};
+
+static inline double Sound_resample_inputIndex (Sound_ResampleChunk *me, long ioutput) {
+	return (my outputX1 + (ioutput - 1) * my outputDx - my inputX1) / my inputDx + 1.0;
+}
+
+static inline void Sound_resample_inputWindow (Sound_ResampleChunk *me, double index, long *left, long *right) {
+	*left = (long) ceil (index - my halfWidth);
+	*right = (long) floor (index + my halfWidth);
+	if (*left < 1) *left = 1;
+	if (*right > my inputNumberOfSamples) *right = my inputNumberOfSamples;
+}
+
+static MelderThread_RETURN_TYPE Sound_resample_runChunk (Sound_ResampleChunk *me) {
+	const long lastTableIndex = (long) floor (my halfWidth * my tableStep);
+	for (long ioutput = my firstOutputSample; ioutput <= my lastOutputSample; ioutput ++) {
+		const double index = Sound_resample_inputIndex (me, ioutput);
+		long left, right;
+		Sound_resample_inputWindow (me, index, & left, & right);
+		const long numberOfWeights = right - left + 1;
+		/*
+			The weights are computed once for all channels.
+		*/
+		double u = (index - left) * my tableStep;   // position in the table of the leftmost input sample
+		for (long k = 0; k < numberOfWeights; k ++, u -= my tableStep) {
+			const double position = fabs (u);
+			long itable = (long) position;
+			if (itable >= lastTableIndex) {
+				my weights [k] = 0.0;
+			} else {
+				const double fraction = position - itable;
+				my weights [k] = my gain * (my table [itable] + fraction * (my table [itable + 1] - my table [itable]));
+			}
+		}
+		for (long channel = 1; channel <= my numberOfChannels; channel ++) {
+			const double *x = & my from [channel] [left - my firstInputSample + 1];
+			double sum = 0.0;
+			for (long k = 0; k < numberOfWeights; k ++)
+				sum += x [k] * my weights [k];
+			my to [channel] [ioutput] = sum;
+		}
+	}
+	MelderThread_RETURN;
+}
+
+autoSound Sound_resample_piecewise (Sampled me, long numberOfChannels, double samplingFrequency, long precision,
+	std::function <void (double **buffer, long firstSample, long numberOfSamples)> readSamples)
+{
+	const double upfactor = samplingFrequency * my dx;
+	const long numberOfSamples = lround ((my xmax - my xmin) * samplingFrequency);
+	if (numberOfSamples < 1)
+		Melder_throw (U"The resampled Sound would have no samples.");
+	autoSound thee = Sound_create (numberOfChannels, my xmin, my xmax, numberOfSamples, 1.0 / samplingFrequency,
+		0.5 * (my xmin + my xmax - (numberOfSamples - 1) / samplingFrequency));
+
+	/*
+		Tabulate the kernel g.
+	*/
+	const double cutoff = upfactor < 1.0 ? upfactor : 1.0;
+	const bool linear = ( upfactor >= 1.0 && precision <= 1 );
+	const long depth = linear ? 0 : upfactor < 1.0 && precision < Sound_RESAMPLE_MINIMUM_FILTER_DEPTH ?
+		Sound_RESAMPLE_MINIMUM_FILTER_DEPTH : precision;
+	const long tableSize = (depth + 1) * Sound_RESAMPLE_TABLE_RESOLUTION;
+	autoNUMvector <double> table ((long) 0, tableSize + 1);
+	for (long itable = 0; itable <= tableSize; itable ++) {
+		const double u = (double) itable / Sound_RESAMPLE_TABLE_RESOLUTION;
+		table [itable] = linear ? 1.0 - u :
+			itable == 0 ? 1.0 : sin (NUMpi * u) / (NUMpi * u) * (0.5 + 0.5 * cos (NUMpi * u / (depth + 1)));
+	}
+	table [tableSize] = table [tableSize + 1] = 0.0;
+
+	Sound_ResampleChunk prototype;
+	prototype. numberOfChannels = numberOfChannels;
+	prototype. inputNumberOfSamples = my nx;
+	prototype. inputX1 = my x1;
+	prototype. inputDx = my dx;
+	prototype. outputX1 = thy x1;
+	prototype. outputDx = thy dx;
+	prototype. to = thy z;
+	prototype. table = table.peek();
+	prototype. tableStep = cutoff * Sound_RESAMPLE_TABLE_RESOLUTION;
+	prototype. halfWidth = (depth + 1) / cutoff;
+	prototype. gain = cutoff;
+
+	/*
+		Divide the output into blocks that need at most Sound_RESAMPLE_INPUT_BLOCK_SIZE input samples
+		(plus the margins of the kernel), and each block into chunks for the threads.
+	*/
+	const double inputSamplesPerOutputSample = thy dx / my dx;
+	long numberOfOutputSamplesPerBlock = (long) floor (Sound_RESAMPLE_INPUT_BLOCK_SIZE / inputSamplesPerOutputSample);
+	if (numberOfOutputSamplesPerBlock < 1) numberOfOutputSamplesPerBlock = 1;
+	if (numberOfOutputSamplesPerBlock > numberOfSamples) numberOfOutputSamplesPerBlock = numberOfSamples;
+	const long maximumNumberOfInputSamplesPerBlock =
+		(long) ceil (numberOfOutputSamplesPerBlock * inputSamplesPerOutputSample + 2.0 * prototype. halfWidth) + 3;
+	autoNUMmatrix <double> from (1, numberOfChannels, 1, maximumNumberOfInputSamplesPerBlock);
+	const long numberOfBlocks = (numberOfSamples - 1) / numberOfOutputSamplesPerBlock + 1;
+
+	long numberOfThreads = (numberOfOutputSamplesPerBlock - 1) / Sound_RESAMPLE_MINIMUM_SAMPLES_PER_THREAD + 1;
+	const int numberOfProcessors = MelderThread_getNumberOfProcessors ();
+	if (numberOfThreads > numberOfProcessors) numberOfThreads = numberOfProcessors;
+	std::vector <Sound_ResampleChunk> chunks ((size_t) numberOfThreads, prototype);
+	const long maximumNumberOfWeights = (long) ceil (2.0 * prototype. halfWidth) + 2;
+	autoNUMmatrix <double> weights ((long) 0, numberOfThreads - 1, (long) 0, maximumNumberOfWeights);
+
+	for (long iblock = 1; iblock <= numberOfBlocks; iblock ++) {
+		const long firstOutputSample = 1 + (iblock - 1) * numberOfOutputSamplesPerBlock;
+		const long lastOutputSample = iblock == numberOfBlocks ? numberOfSamples : firstOutputSample + numberOfOutputSamplesPerBlock - 1;
+		long firstInputSample, lastInputSample, dummy;
+		Sound_resample_inputWindow (& prototype, Sound_resample_inputIndex (& prototype, firstOutputSample), & firstInputSample, & dummy);
+		Sound_resample_inputWindow (& prototype, Sound_resample_inputIndex (& prototype, lastOutputSample), & dummy, & lastInputSample);
+		const long numberOfInputSamples = lastInputSample - firstInputSample + 1;
+		Melder_assert (numberOfInputSamples <= maximumNumberOfInputSamplesPerBlock);
+		if (numberOfInputSamples > 0)
+			readSamples (from.peek(), firstInputSample, numberOfInputSamples);
+
+		const long numberOfOutputSamples = lastOutputSample - firstOutputSample + 1;
+		long numberOfThreadsInBlock = (numberOfOutputSamples - 1) / Sound_RESAMPLE_MINIMUM_SAMPLES_PER_THREAD + 1;
+		if (numberOfThreadsInBlock > numberOfThreads) numberOfThreadsInBlock = numberOfThreads;
+		const long numberOfOutputSamplesPerThread = (numberOfOutputSamples - 1) / numberOfThreadsInBlock + 1;
+		numberOfThreadsInBlock = (numberOfOutputSamples - 1) / numberOfOutputSamplesPerThread + 1;   // no empty chunks
+		for (long ithread = 1; ithread <= numberOfThreadsInBlock; ithread ++) {
+			Sound_ResampleChunk *chunk = & chunks [(size_t) ithread - 1];
+			chunk -> from = from.peek();
+			chunk -> firstInputSample = firstInputSample;
+			chunk -> lastInputSample = lastInputSample;
+			chunk -> firstOutputSample = firstOutputSample + (ithread - 1) * numberOfOutputSamplesPerThread;
+			chunk -> lastOutputSample = ithread == numberOfThreadsInBlock ? lastOutputSample :
+				chunk -> firstOutputSample + numberOfOutputSamplesPerThread - 1;
+			chunk -> weights = weights [ithread - 1];
+		}
+		MelderThread_run (Sound_resample_runChunk, chunks.data(), (int) numberOfThreadsInBlock);
+	}
+	return thee;
+}
+
 autoSound Sound_resample (Sound me, double samplingFrequency, long precision) {
 	double upfactor = samplingFrequency * my dx;
-	if (fabs (upfactor - 2) < 1e-6) return Sound_upsample (me);
 	if (fabs (upfactor - 1) < 1e-6) return Data_copy (me);
 	try {
-		long numberOfSamples = lround ((my xmax - my xmin) * samplingFrequency);
-		if (numberOfSamples < 1)
-			Melder_throw (U"The resampled Sound would have no samples.");
-		autoSound filtered;
-		if (upfactor < 1.0) {   // need anti-aliasing filter?
-			long nfft = 1, antiTurnAround = 1000;
-			while (nfft < my nx + antiTurnAround * 2) nfft *= 2;
-			autoNUMvector<double> data (1, nfft);
-			filtered = Sound_create (my ny, my xmin, my xmax, my nx, my dx, my x1);
-			for (long channel = 1; channel <= my ny; channel ++) {
-				for (long i = 1; i <= nfft; i ++) {
-					data [i] = 0.0;
-				}
-				NUMvector_copyElements (my z [channel], & data [antiTurnAround], 1, my nx);
-				NUMrealft (data.peek(), nfft, 1);   // go to the frequency domain
-				for (long i = (long) floor (upfactor * nfft); i <= nfft; i ++) {
-					data [i] = 0.0;   // filter away high frequencies
-				}
-				data [2] = 0.0;
-				NUMrealft (data.peek(), nfft, -1);   // return to the time domain
-				double factor = 1.0 / nfft;
-				double *to = filtered -> z [channel];
-				for (long i = 1; i <= my nx; i ++) {
-					to [i] = data [i + antiTurnAround] * factor;
-				}
+		return Sound_resample_piecewise (me, my ny, samplingFrequency, precision,
+			[me] (double **buffer, long firstSample, long numberOfSamples) {
+				for (long channel = 1; channel <= my ny; channel ++)
+					NUMvector_copyElements (& my z [channel] [firstSample - 1], buffer [channel], 1, numberOfSamples);
 			}
-			me = filtered.get();   // reference copy; remove at end
-		}
-		autoSound thee = Sound_create (my ny, my xmin, my xmax, numberOfSamples, 1.0 / samplingFrequency,
-			0.5 * (my xmin + my xmax - (numberOfSamples - 1) / samplingFrequency));
-		for (long channel = 1; channel <= my ny; channel ++) {
-			double *from = my z [channel];
-			double *to = thy z [channel];
-			if (precision <= 1) {
-				for (long i = 1; i <= numberOfSamples; i ++) {
-					double x = Sampled_indexToX (thee.get(), i);
-					double index = Sampled_xToIndex (me, x);
-					long leftSample = (long) floor (index);
-					double fraction = index - leftSample;
-					to [i] = leftSample < 1 || leftSample >= my nx ? 0.0 :
-						(1 - fraction) * from [leftSample] + fraction * from [leftSample + 1];
-				}
-			} else {
-				for (long i = 1; i <= numberOfSamples; i ++) {
-					double x = Sampled_indexToX (thee.get(), i);
-					double index = Sampled_xToIndex (me, x);
-					to [i] = NUM_interpolate_sinc (my z [channel], my nx, index, precision);
-				}
-			}
-		}
-		return thee;
+		);
 	} catch (MelderError) {
 		Melder_throw (me, U": not resampled.");
 	}
@@ -509,6 +630,130 @@ autoSound Sounds_concatenate (OrderedOf<structSound>& list, double overlapTime)
 	}
 }
 
+/*
+	Convolution by overlap-add.
+	The longer of the two signals is cut into blocks, each of which is convolved with the shorter one (the kernel)
+	by multiplying their spectra; the results of consecutive blocks overlap by the length of the kernel minus one sample.
+	The working memory is therefore proportional to the kernel, whatever the length of the longer signal.
+	The blocks of each channel are divided into ranges, which are handled on separate threads;
+	the overlap that a range contributes to the next range goes into a private tail, which is added afterwards.
+*/
+struct Sound_ConvolveChunk {
+	const double *signal;   // [1..signalLength]
+	long signalLength;
+	bool reverseSignal;
+	const double *kernelSpectrum;   // [1..nfft], in the format of NUMfft_forward
+	long kernelLength, nfft, blockLength;
+	long firstBlock, lastBlock;   // counted from 0
+	double *result;   // [1..signalLength + kernelLength - 1]
+	std::vector <double> tail;   // the kernelLength - 1 samples after the last input sample of this range
+};
+
+static MelderThread_RETURN_TYPE Sound_convolve_runChunk (Sound_ConvolveChunk *me) {
+	autoNUMfft_Table table;
+	NUMfft_Table_init (& table, my nfft);
+	autoNUMvector <double> data (1, my nfft);
+	const long lastOwnSample = std::min ((my lastBlock + 1) * my blockLength, my signalLength);
+	const double scale = 1.0 / my nfft;   // a forward and a backward transform multiply by nfft
+	for (long iblock = my firstBlock; iblock <= my lastBlock; iblock ++) {
+		const long firstSample = iblock * my blockLength + 1;
+		const long numberOfSamples = std::min (my blockLength, my signalLength - firstSample + 1);
+		for (long i = 1; i <= numberOfSamples; i ++) {
+			const long isample = firstSample + i - 1;
+			data [i] = my signal [my reverseSignal ? my signalLength + 1 - isample : isample];
+		}
+		for (long i = numberOfSamples + 1; i <= my nfft; i ++)
+			data [i] = 0.0;
+		NUMfft_forward (& table, data.peek());
+		const double *k = my kernelSpectrum;
+		data [1] *= k [1];
+		data [my nfft] *= k [my nfft];
+		for (long i = 2; i < my nfft; i += 2) {
+			const double re = data [i] * k [i] - data [i + 1] * k [i + 1];
+			data [i + 1] = data [i] * k [i + 1] + data [i + 1] * k [i];
+			data [i] = re;
+		}
+		NUMfft_backward (& table, data.peek());
+		for (long i = 1; i <= numberOfSamples + my kernelLength - 1; i ++) {
+			const long iresult = firstSample + i - 1;
+			if (iresult <= lastOwnSample)
+				my result [iresult] += data [i] * scale;
+			else
+				my tail [(size_t) (iresult - lastOwnSample - 1)] += data [i] * scale;
+		}
+	}
+	MelderThread_RETURN;
+}
+
+/*
+	his z [channel] [1 .. my nx + thy nx - 1] receives the convolution of me and thee, either of which may be reversed in time;
+	a mono Sound is convolved with each channel of the other Sound.
+*/
+static void Sounds_convolve_overlapAdd (Sound me, bool reverseMe, Sound thee, bool reverseThee, Sound him) {
+	const bool meIsSignal = my nx >= thy nx;
+	Sound signal = meIsSignal ? me : thee, kernel = meIsSignal ? thee : me;
+	const bool reverseSignal = meIsSignal ? reverseMe : reverseThee, reverseKernel = meIsSignal ? reverseThee : reverseMe;
+	const long signalLength = signal -> nx, kernelLength = kernel -> nx, resultLength = signalLength + kernelLength - 1;
+	const long numberOfChannels = his ny;
+	Melder_assert (his nx == resultLength);
+	/*
+		A transform of about four kernel lengths wastes little on the overlap,
+		but a single transform suffices if the whole result fits into it.
+	*/
+	long nfft = 8192;
+	while (nfft < 4 * kernelLength) nfft *= 2;
+	long nfftForAll = 2;
+	while (nfftForAll < resultLength) nfftForAll *= 2;
+	if (nfftForAll < nfft) nfft = nfftForAll;
+	const long blockLength = nfft - kernelLength + 1;
+	const long numberOfBlocks = (signalLength - 1) / blockLength + 1;
+
+	autoNUMfft_Table table;
+	NUMfft_Table_init (& table, nfft);
+	autoNUMmatrix <double> kernelSpectra (1, kernel -> ny, 1, nfft);
+	for (long channel = 1; channel <= kernel -> ny; channel ++) {
+		double *k = kernelSpectra [channel];
+		for (long i = 1; i <= kernelLength; i ++)
+			k [i] = kernel -> z [channel] [reverseKernel ? kernelLength + 1 - i : i];
+		for (long i = kernelLength + 1; i <= nfft; i ++)
+			k [i] = 0.0;
+		NUMfft_forward (& table, k);
+	}
+
+	const int numberOfProcessors = MelderThread_getNumberOfProcessors ();
+	long numberOfRangesPerChannel = (numberOfProcessors - 1) / numberOfChannels + 1;
+	if (numberOfRangesPerChannel > numberOfBlocks) numberOfRangesPerChannel = numberOfBlocks;
+	const long numberOfBlocksPerRange = (numberOfBlocks - 1) / numberOfRangesPerChannel + 1;
+	numberOfRangesPerChannel = (numberOfBlocks - 1) / numberOfBlocksPerRange + 1;   // no empty ranges
+	std::vector <Sound_ConvolveChunk> chunks ((size_t) (numberOfChannels * numberOfRangesPerChannel));
+	for (long channel = 1; channel <= numberOfChannels; channel ++) {
+		for (long irange = 0; irange < numberOfRangesPerChannel; irange ++) {
+			Sound_ConvolveChunk *chunk = & chunks [(size_t) ((channel - 1) * numberOfRangesPerChannel + irange)];
+			chunk -> signal = signal -> z [signal -> ny == 1 ? 1 : channel];
+			chunk -> signalLength = signalLength;
+			chunk -> reverseSignal = reverseSignal;
+			chunk -> kernelSpectrum = kernelSpectra [kernel -> ny == 1 ? 1 : channel];
+			chunk -> kernelLength = kernelLength;
+			chunk -> nfft = nfft;
+			chunk -> blockLength = blockLength;
+			chunk -> firstBlock = irange * numberOfBlocksPerRange;
+			chunk -> lastBlock = std::min ((irange + 1) * numberOfBlocksPerRange, numberOfBlocks) - 1;
+			chunk -> result = his z [channel];
+			chunk -> tail. assign ((size_t) (kernelLength - 1), 0.0);
+		}
+	}
+	for (size_t ichunk = 0; ichunk < chunks.size(); ichunk += (size_t) numberOfProcessors) {
+		const int numberOfThreads = (int) std::min (chunks.size() - ichunk, (size_t) numberOfProcessors);
+		MelderThread_run (Sound_convolve_runChunk, & chunks [ichunk], numberOfThreads);
+	}
+	for (size_t ichunk = 0; ichunk < chunks.size(); ichunk ++) {
+		Sound_ConvolveChunk *chunk = & chunks [ichunk];
+		const long lastOwnSample = std::min ((chunk -> lastBlock + 1) * blockLength, signalLength);
+		for (long i = 1; i < kernelLength; i ++)
+			chunk -> result [lastOwnSample + i] += chunk -> tail [(size_t) i - 1];
+	}
+}
+
 autoSound Sounds_convolve (Sound me, Sound thee, enum kSounds_convolve_scaling scaling, enum kSounds_convolve_signalOutsideTimeDomain signalOutsideTimeDomain) {
 	try {
 		if (my ny > 1 && thy ny > 1 && my ny != thy ny)
@@ -516,34 +761,10 @@ autoSound Sounds_convolve (Sound me, Sound thee, enum kSounds_convolve_scaling s
 		if (my dx != thy dx)
 			Melder_throw (U"The sampling frequencies of the two sounds have to be equal.");
 		long n1 = my nx, n2 = thy nx;
-		long n3 = n1 + n2 - 1, nfft = 1;
-		while (nfft < n3) nfft *= 2;
-		autoNUMvector <double> data1 (1, nfft);
-		autoNUMvector <double> data2 (1, nfft);
+		long n3 = n1 + n2 - 1;
 		long numberOfChannels = my ny > thy ny ? my ny : thy ny;
 		autoSound him = Sound_create (numberOfChannels, my xmin + thy xmin, my xmax + thy xmax, n3, my dx, my x1 + thy x1);
-		for (long channel = 1; channel <= numberOfChannels; channel ++) {
-			double *a = my z [my ny == 1 ? 1 : channel];
-			for (long i = n1; i > 0; i --) data1 [i] = a [i];
-			for (long i = n1 + 1; i <= nfft; i ++) data1 [i] = 0.0;
-			a = thy z [thy ny == 1 ? 1 : channel];
-			for (long i = n2; i > 0; i --) data2 [i] = a [i];
-			for (long i = n2 + 1; i <= nfft; i ++) data2 [i] = 0.0;
-			NUMrealft (data1.peek(), nfft, 1);
-			NUMrealft (data2.peek(), nfft, 1);
-			data2 [1] *= data1 [1];
-			data2 [2] *= data1 [2];
-			for (long i = 3; i <= nfft; i += 2) {
-				double temp = data1 [i] * data2 [i] - data1 [i + 1] * data2 [i + 1];
-				data2 [i + 1] = data1 [i] * data2 [i + 1] + data1 [i + 1] * data2 [i];
-				data2 [i] = temp;
-			}
-			NUMrealft (data2.peek(), nfft, -1);
-			a = him -> z [channel];
-			for (long i = 1; i <= n3; i ++) {
-				a [i] = data2 [i];
-			}
-		}
+		Sounds_convolve_overlapAdd (me, false, thee, false, him.get());
 		switch (signalOutsideTimeDomain) {
 			case kSounds_convolve_signalOutsideTimeDomain_ZERO: {
 				// do nothing
@@ -566,15 +787,15 @@ autoSound Sounds_convolve (Sound me, Sound thee, enum kSounds_convolve_scaling s
 		}
 		switch (scaling) {
 			case kSounds_convolve_scaling_INTEGRAL: {
-				Vector_multiplyByScalar (him.get(), my dx / nfft);
+				Vector_multiplyByScalar (him.get(), my dx);
 			} break;
 			case kSounds_convolve_scaling_SUM: {
-				Vector_multiplyByScalar (him.get(), 1.0 / nfft);
+				// do nothing
 			} break;
 			case kSounds_convolve_scaling_NORMALIZE: {
 				double normalizationFactor = Matrix_getNorm (me) * Matrix_getNorm (thee);
 				if (normalizationFactor != 0.0) {
-					Vector_multiplyByScalar (him.get(), 1.0 / nfft / normalizationFactor);
+					Vector_multiplyByScalar (him.get(), 1.0 / normalizationFactor);
 				}
 			} break;
 			case kSounds_convolve_scaling_PEAK_099: {
@@ -596,37 +817,10 @@ autoSound Sounds_crossCorrelate (Sound me, Sound thee, enum kSounds_convolve_sca
 			Melder_throw (U"The sampling frequencies of the two sounds have to be equal.");
 		long numberOfChannels = my ny > thy ny ? my ny : thy ny;
 		long n1 = my nx, n2 = thy nx;
-		long n3 = n1 + n2 - 1, nfft = 1;
-		while (nfft < n3) nfft *= 2;
-		autoNUMvector <double> data1 (1, nfft);
-		autoNUMvector <double> data2 (1, nfft);
+		long n3 = n1 + n2 - 1;
 		double my_xlast = my x1 + (n1 - 1) * my dx;
 		autoSound him = Sound_create (numberOfChannels, thy xmin - my xmax, thy xmax - my xmin, n3, my dx, thy x1 - my_xlast);
-		for (long channel = 1; channel <= numberOfChannels; channel ++) {
-			double *a = my z [my ny == 1 ? 1 : channel];
-			for (long i = n1; i > 0; i --) data1 [i] = a [i];
-			for (long i = n1 + 1; i <= nfft; i ++) data1 [i] = 0.0;
-			a = thy z [thy ny == 1 ? 1 : channel];
-			for (long i = n2; i > 0; i --) data2 [i] = a [i];
-			for (long i = n2 + 1; i <= nfft; i ++) data2 [i] = 0.0;
-			NUMrealft (data1.peek(), nfft, 1);
-			NUMrealft (data2.peek(), nfft, 1);
-			data2 [1] *= data1 [1];
-			data2 [2] *= data1 [2];
-			for (long i = 3; i <= nfft; i += 2) {
-				double temp = data1 [i] * data2 [i] + data1 [i + 1] * data2 [i + 1];   // reverse me by taking the conjugate of data1
-				data2 [i + 1] = data1 [i] * data2 [i + 1] - data1 [i + 1] * data2 [i];   // reverse me by taking the conjugate of data1
-				data2 [i] = temp;
-			}
-			NUMrealft (data2.peek(), nfft, -1);
-			a = him -> z [channel];
-			for (long i = 1; i < n1; i ++) {
-				a [i] = data2 [i + (nfft - (n1 - 1))];   // data for the first part ("negative lags") is at the end of data2
-			}
-			for (long i = 1; i <= n2; i ++) {
-				a [i + (n1 - 1)] = data2 [i];   // data for the second part ("positive lags") is at the beginning of data2
-			}
-		}
+		Sounds_convolve_overlapAdd (me, true, thee, false, him.get());   // cross-correlation is convolution with me reversed
 		switch (signalOutsideTimeDomain) {
 			case kSounds_convolve_signalOutsideTimeDomain_ZERO: {
 				// do nothing
@@ -649,15 +843,15 @@ autoSound Sounds_crossCorrelate (Sound me, Sound thee, enum kSounds_convolve_sca
 		}
 		switch (scaling) {
 			case kSounds_convolve_scaling_INTEGRAL: {
-				Vector_multiplyByScalar (him.get(), my dx / nfft);
+				Vector_multiplyByScalar (him.get(), my dx);
 			} break;
 			case kSounds_convolve_scaling_SUM: {
-				Vector_multiplyByScalar (him.get(), 1.0 / nfft);
+				// do nothing
 			} break;
 			case kSounds_convolve_scaling_NORMALIZE: {
 				double normalizationFactor = Matrix_getNorm (me) * Matrix_getNorm (thee);
 				if (normalizationFactor != 0.0) {
-					Vector_multiplyByScalar (him.get(), 1.0 / nfft / normalizationFactor);
+					Vector_multiplyByScalar (him.get(), 1.0 / normalizationFactor);
 				}
 			} break;
 			case kSounds_convolve_scaling_PEAK_099: {
@@ -673,31 +867,10 @@ autoSound Sounds_crossCorrelate (Sound me, Sound thee, enum kSounds_convolve_sca
 
 autoSound Sound_autoCorrelate (Sound me, enum kSounds_convolve_scaling scaling, enum kSounds_convolve_signalOutsideTimeDomain signalOutsideTimeDomain) {
 	try {
-		long numberOfChannels = my ny, n1 = my nx, n2 = n1 + n1 - 1, nfft = 1;
-		while (nfft < n2) nfft *= 2;
-		autoNUMvector <double> data (1, nfft);
+		long numberOfChannels = my ny, n1 = my nx, n2 = n1 + n1 - 1;
 		double my_xlast = my x1 + (n1 - 1) * my dx;
 		autoSound thee = Sound_create (numberOfChannels, my xmin - my xmax, my xmax - my xmin, n2, my dx, my x1 - my_xlast);
-		for (long channel = 1; channel <= numberOfChannels; channel ++) {
-			double *a = my z [channel];
-			for (long i = n1; i > 0; i --) data [i] = a [i];
-			for (long i = n1 + 1; i <= nfft; i ++) data [i] = 0.0;
-			NUMrealft (data.peek(), nfft, 1);
-			data [1] *= data [1];
-			data [2] *= data [2];
-			for (long i = 3; i <= nfft; i += 2) {
-				data [i] = data [i] * data [i] + data [i + 1] * data [i + 1];
-				data [i + 1] = 0.0;   // reverse me by taking the conjugate of data1
-			}
-			NUMrealft (data.peek(), nfft, -1);
-			a = thy z [channel];
-			for (long i = 1; i < n1; i ++) {
-				a [i] = data [i + (nfft - (n1 - 1))];   // data for the first part ("negative lags") is at the end of data
-			}
-			for (long i = 1; i <= n1; i ++) {
-				a [i + (n1 - 1)] = data [i];   // data for the second part ("positive lags") is at the beginning of data
-			}
-		}
+		Sounds_convolve_overlapAdd (me, true, me, false, thee.get());
 		switch (signalOutsideTimeDomain) {
 			case kSounds_convolve_signalOutsideTimeDomain_ZERO: {
 				// do nothing
@@ -720,15 +893,15 @@ autoSound Sound_autoCorrelate (Sound me, enum kSounds_convolve_scaling scaling,
 		}
 		switch (scaling) {
 			case kSounds_convolve_scaling_INTEGRAL: {
-				Vector_multiplyByScalar (thee.get(), my dx / nfft);
+				Vector_multiplyByScalar (thee.get(), my dx);
 			} break;
 			case kSounds_convolve_scaling_SUM: {
-				Vector_multiplyByScalar (thee.get(), 1.0 / nfft);
+				// do nothing
 			} break;
 			case kSounds_convolve_scaling_NORMALIZE: {
 				double normalizationFactor = Matrix_getNorm (me) * Matrix_getNorm (me);
 				if (normalizationFactor != 0.0) {
-					Vector_multiplyByScalar (thee.get(), 1.0 / nfft / normalizationFactor);
+					Vector_multiplyByScalar (thee.get(), 1.0 / normalizationFactor);
 				}
 			} break;
 			case kSounds_convolve_scaling_PEAK_099: {
@@ -114,6 +114,17 @@ autoSound Sound_resample (Sound me, double samplingFrequency, long precision);
 	Method:
 		precision <= 1: linear interpolation.
 		precision >= 2: sinx/x interpolation with maximum depth equal to 'precision'.
+		If the sampling frequency goes down, the sinx/x function is widened into a low-pass filter
+		at the new Nyquist frequency (with a depth of at least 10).
+	Memory use is bounded: the sound is resampled in blocks, on multiple threads.
+*/
+
+autoSound Sound_resample_piecewise (Sampled me, long numberOfChannels, double samplingFrequency, long precision,
+	std::function <void (double **buffer, long firstSample, long numberOfSamples)> readSamples);
+/*
+	Like Sound_resample, but for sounds that do not have to be in memory as a whole, such as a LongSound.
+	readSamples is called (on the calling thread) for consecutive blocks of limited size;
+	it should put the samples firstSample .. firstSample + numberOfSamples - 1 into buffer [channel] [1 .. numberOfSamples].
 */
 
 autoSound Sounds_append (Sound me, double silenceDuration, Sound thee);
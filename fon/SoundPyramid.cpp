@@ -0,0 +1,213 @@
+/* SoundPyramid.cpp
+ *
+ * This code is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at
+ * your option) any later version.
+ *
+ * This code is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this work. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "SoundPyramid.h"
+
+Thing_implement (SoundPyramid, Thing, 0);
+
+void structSoundPyramid :: v_destroy () noexcept {
+	for (int ilevel = 1; ilevel <= our numberOfLevels; ilevel ++) {
+		NUMmatrix_free <float> (our levels [ilevel]. minima, 1, 1);
+		NUMmatrix_free <float> (our levels [ilevel]. maxima, 1, 1);
+	}
+	SoundPyramid_Parent :: v_destroy ();
+}
+
+autoSoundPyramid SoundPyramid_create (long numberOfChannels, long numberOfSamples, double x1, double dx) {
+	try {
+		autoSoundPyramid me = Thing_new (SoundPyramid);
+		my numberOfChannels = numberOfChannels;
+		my numberOfSamples = numberOfSamples;
+		my x1 = x1;
+		my dx = dx;
+		long blockSize = SoundPyramid_BASE_BLOCK_SIZE;
+		long numberOfBlocks = (numberOfSamples - 1) / blockSize + 1;
+		for (;;) {
+			SoundPyramid_Level *level = & my levels [++ my numberOfLevels];
+			level -> blockSize = blockSize;
+			level -> numberOfBlocks = numberOfBlocks;
+			level -> minima = NUMmatrix <float> (1, numberOfChannels, 1, numberOfBlocks);
+			level -> maxima = NUMmatrix <float> (1, numberOfChannels, 1, numberOfBlocks);
+			if (numberOfBlocks <= SoundPyramid_BRANCHING_FACTOR || my numberOfLevels == SoundPyramid_MAXIMUM_NUMBER_OF_LEVELS)
+				break;
+			blockSize *= SoundPyramid_BRANCHING_FACTOR;
+			numberOfBlocks = (numberOfBlocks - 1) / SoundPyramid_BRANCHING_FACTOR + 1;
+		}
+		return me;
+	} catch (MelderError) {
+		Melder_throw (U"SoundPyramid not created.");
+	}
+}
+
+/*
+	Summarize the samples from my numberOfSamplesDone + 1 through lastSample,
+	where sample i of channel ichan is found in z [ichan] [i - offset].
+	Because every call starts at a block boundary, the blocks of level 1 are computed only once;
+	the blocks of the higher levels that contain new blocks are recomputed from the level below.
+*/
+static void SoundPyramid_summarize (SoundPyramid me, double **z, long offset, long lastSample) {
+	SoundPyramid_Level *base = & my levels [1];
+	Melder_assert (my numberOfSamplesDone % base -> blockSize == 0);
+	long firstBlock = my numberOfSamplesDone / base -> blockSize + 1;
+	long lastBlock = (lastSample - 1) / base -> blockSize + 1;
+	for (long ichan = 1; ichan <= my numberOfChannels; ichan ++) {
+		for (long iblock = firstBlock; iblock <= lastBlock; iblock ++) {
+			long imin = (iblock - 1) * base -> blockSize + 1, imax = iblock * base -> blockSize;
+			if (imax > lastSample) imax = lastSample;
+			double *y = & z [ichan] [- offset];
+			double minimum = y [imin], maximum = minimum;
+			for (long i = imin + 1; i <= imax; i ++) {
+				double value = y [i];
+				if (value < minimum) minimum = value;
+				if (value > maximum) maximum = value;
+			}
+			base -> minima [ichan] [iblock] = (float) minimum;
+			base -> maxima [ichan] [iblock] = (float) maximum;
+		}
+	}
+	for (int ilevel = 2; ilevel <= my numberOfLevels; ilevel ++) {
+		SoundPyramid_Level *below = & my levels [ilevel - 1], *level = & my levels [ilevel];
+		long lastBlockBelow = lastBlock;
+		firstBlock = (firstBlock - 1) / SoundPyramid_BRANCHING_FACTOR + 1;
+		lastBlock = (lastBlock - 1) / SoundPyramid_BRANCHING_FACTOR + 1;
+		for (long ichan = 1; ichan <= my numberOfChannels; ichan ++) {
+			for (long iblock = firstBlock; iblock <= lastBlock; iblock ++) {
+				long jmin = (iblock - 1) * SoundPyramid_BRANCHING_FACTOR + 1, jmax = iblock * SoundPyramid_BRANCHING_FACTOR;
+				if (jmax > lastBlockBelow) jmax = lastBlockBelow;
+				float minimum = below -> minima [ichan] [jmin], maximum = below -> maxima [ichan] [jmin];
+				for (long j = jmin + 1; j <= jmax; j ++) {
+					if (below -> minima [ichan] [j] < minimum) minimum = below -> minima [ichan] [j];
+					if (below -> maxima [ichan] [j] > maximum) maximum = below -> maxima [ichan] [j];
+				}
+				level -> minima [ichan] [iblock] = minimum;
+				level -> maxima [ichan] [iblock] = maximum;
+			}
+		}
+	}
+	my numberOfSamplesDone = lastSample;
+}
+
+#define SoundPyramid_CHUNK_SIZE  (64 * SoundPyramid_BASE_BLOCK_SIZE)
+
+bool SoundPyramid_extendFromSound (SoundPyramid me, Sound sound, double maximumDuration) {
+	Melder_assert (sound -> ny == my numberOfChannels && sound -> nx == my numberOfSamples);
+	double startingTime = Melder_clock ();
+	while (! SoundPyramid_isComplete (me)) {
+		long lastSample = my numberOfSamplesDone + SoundPyramid_CHUNK_SIZE;
+		if (lastSample > my numberOfSamples) lastSample = my numberOfSamples;
+		SoundPyramid_summarize (me, sound -> z, 0, lastSample);
+		if (Melder_clock () - startingTime > maximumDuration) break;
+	}
+	return SoundPyramid_isComplete (me);
+}
+
+bool SoundPyramid_extendFromLongSound (SoundPyramid me, LongSound longSound, double maximumDuration) {
+	Melder_assert (longSound -> numberOfChannels == my numberOfChannels && longSound -> nx == my numberOfSamples);
+	autoNUMmatrix <double> buffer (1, my numberOfChannels, 1, SoundPyramid_CHUNK_SIZE);
+	double startingTime = Melder_clock ();
+	while (! SoundPyramid_isComplete (me)) {
+		long firstSample = my numberOfSamplesDone + 1;
+		long lastSample = my numberOfSamplesDone + SoundPyramid_CHUNK_SIZE;
+		if (lastSample > my numberOfSamples) lastSample = my numberOfSamples;
+		LongSound_readAudioToFloat (longSound, buffer.peek(), firstSample, lastSample - firstSample + 1);
+		SoundPyramid_summarize (me, buffer.peek(), firstSample - 1, lastSample);
+		if (Melder_clock () - startingTime > maximumDuration) break;
+	}
+	return SoundPyramid_isComplete (me);
+}
+
+void SoundPyramid_getExtrema (SoundPyramid me, long channel, long firstSample, long lastSample, double *out_minimum, double *out_maximum) {
+	Melder_assert (SoundPyramid_isComplete (me));
+	if (firstSample < 1) firstSample = 1;
+	if (lastSample > my numberOfSamples) lastSample = my numberOfSamples;
+	if (firstSample > lastSample) {
+		*out_minimum = *out_maximum = 0.0;
+		return;
+	}
+	/*
+		Walk up the pyramid: at every level, take the blocks at the edges of the range
+		that do not make up a complete block of the level above, and hand the rest over to that level.
+	*/
+	long firstBlock = (firstSample - 1) / SoundPyramid_BASE_BLOCK_SIZE + 1;
+	long lastBlock = (lastSample - 1) / SoundPyramid_BASE_BLOCK_SIZE + 1;
+	float minimum = my levels [1]. minima [channel] [firstBlock], maximum = my levels [1]. maxima [channel] [firstBlock];
+	for (int ilevel = 1; firstBlock <= lastBlock; ilevel ++) {
+		SoundPyramid_Level *level = & my levels [ilevel];
+		float *minima = level -> minima [channel], *maxima = level -> maxima [channel];
+		if (ilevel < my numberOfLevels) {
+			while (firstBlock <= lastBlock && (firstBlock - 1) % SoundPyramid_BRANCHING_FACTOR != 0) {
+				if (minima [firstBlock] < minimum) minimum = minima [firstBlock];
+				if (maxima [firstBlock] > maximum) maximum = maxima [firstBlock];
+				firstBlock ++;
+			}
+			while (lastBlock >= firstBlock && lastBlock % SoundPyramid_BRANCHING_FACTOR != 0 && lastBlock != level -> numberOfBlocks) {
+				if (minima [lastBlock] < minimum) minimum = minima [lastBlock];
+				if (maxima [lastBlock] > maximum) maximum = maxima [lastBlock];
+				lastBlock --;
+			}
+			if (firstBlock > lastBlock) break;
+			firstBlock = (firstBlock - 1) / SoundPyramid_BRANCHING_FACTOR + 1;
+			lastBlock = (lastBlock - 1) / SoundPyramid_BRANCHING_FACTOR + 1;
+		} else {
+			for (long iblock = firstBlock; iblock <= lastBlock; iblock ++) {
+				if (minima [iblock] < minimum) minimum = minima [iblock];
+				if (maxima [iblock] > maximum) maximum = maxima [iblock];
+			}
+			break;
+		}
+	}
+	*out_minimum = minimum;
+	*out_maximum = maximum;
+}
+
+void SoundPyramid_getWindowExtrema (SoundPyramid me, double tmin, double tmax, long channel, double *minimum, double *maximum) {
+	long firstSample = (long) ceil ((tmin - my x1) / my dx) + 1;
+	long lastSample = (long) floor ((tmax - my x1) / my dx) + 1;
+	SoundPyramid_getExtrema (me, channel, firstSample, lastSample, minimum, maximum);
+}
+
+void SoundPyramid_draw (SoundPyramid me, Graphics graphics, long channel, double tmin, double tmax) {
+	long x1DC, x2DC, yDC;
+	Graphics_WCtoDC (graphics, tmin, 0.0, & x1DC, & yDC);
+	Graphics_WCtoDC (graphics, tmax, 0.0, & x2DC, & yDC);
+	long numberOfPixels = labs (x2DC - x1DC);
+	if (numberOfPixels < 1) return;
+	autoNUMvector <double> x ((long) 0, 2 * numberOfPixels - 1), y ((long) 0, 2 * numberOfPixels - 1);
+	double pixelDuration = (tmax - tmin) / numberOfPixels;
+	long numberOfPoints = 0;
+	for (long ipixel = 1; ipixel <= numberOfPixels; ipixel ++) {
+		double tleft = tmin + (ipixel - 1) * pixelDuration;
+		long firstSample = (long) ceil ((tleft - my x1) / my dx) + 1;
+		long lastSample = (long) ceil ((tleft + pixelDuration - my x1) / my dx);
+		if (firstSample < 1) firstSample = 1;
+		if (lastSample > my numberOfSamples) lastSample = my numberOfSamples;
+		if (firstSample > lastSample) continue;
+		double minimum, maximum;
+		SoundPyramid_getExtrema (me, channel, firstSample, lastSample, & minimum, & maximum);
+		/*
+			Alternate the direction of the vertical lines,
+			so that the polyline connects the maximum of one pixel to the maximum of the next, and likewise for the minima.
+		*/
+		bool upward = numberOfPoints % 4 == 0;
+		x [numberOfPoints] = x [numberOfPoints + 1] = tleft + 0.5 * pixelDuration;
+		y [numberOfPoints] = upward ? minimum : maximum;
+		y [numberOfPoints + 1] = upward ? maximum : minimum;
+		numberOfPoints += 2;
+	}
+	Graphics_polyline (graphics, numberOfPoints, & x [0], & y [0]);
+}
+
+/* End of file SoundPyramid.cpp */
@@ -0,0 +1,90 @@
+#ifndef _SoundPyramid_h_
+#define _SoundPyramid_h_
+/* SoundPyramid.h
+ *
+ * This code is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at
+ * your option) any later version.
+ *
+ * This code is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this work. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "Sound.h"
+#include "LongSound.h"
+#include "Graphics.h"
+
+/*
+	A multi-resolution summary of the waveform of a Sound or LongSound,
+	with which an editor can draw a zoomed-out window in a time proportional to its width in pixels
+	rather than to the number of samples in the window.
+
+	Level 1 contains the minimum and maximum of every block of 512 samples of every channel;
+	every higher level combines 16 blocks of the level below it.
+	A pyramid is filled incrementally from the start of the sound,
+	so that the reading of a long file can be spread over several redraws.
+*/
+
+#define SoundPyramid_BASE_BLOCK_SIZE  512
+#define SoundPyramid_BRANCHING_FACTOR  16
+#define SoundPyramid_MAXIMUM_NUMBER_OF_LEVELS  8
+
+struct SoundPyramid_Level {
+	long blockSize;   // in samples
+	long numberOfBlocks;
+	float **minima, **maxima;   // [1..numberOfChannels] [1..numberOfBlocks]
+};
+
+Thing_define (SoundPyramid, Thing) {
+	long numberOfChannels, numberOfSamples;
+	double x1, dx;   // as in the Sampled that is summarized
+	int numberOfLevels;
+	struct SoundPyramid_Level levels [1 + SoundPyramid_MAXIMUM_NUMBER_OF_LEVELS];
+	long numberOfSamplesDone;   // the summary is valid for samples 1 through numberOfSamplesDone
+
+	void v_destroy () noexcept
+		override;
+};
+
+autoSoundPyramid SoundPyramid_create (long numberOfChannels, long numberOfSamples, double x1, double dx);
+
+bool SoundPyramid_extendFromSound (SoundPyramid me, Sound sound, double maximumDuration);
+bool SoundPyramid_extendFromLongSound (SoundPyramid me, LongSound longSound, double maximumDuration);
+/*
+	Summarize the next samples of the sound, for about maximumDuration seconds at most
+	(but always at least one block of samples).
+	Return true if the pyramid is complete.
+*/
+
+inline static bool SoundPyramid_isComplete (SoundPyramid me) {
+	return my numberOfSamplesDone >= my numberOfSamples;
+}
+
+inline static double SoundPyramid_getFractionDone (SoundPyramid me) {
+	return my numberOfSamples > 0 ? (double) my numberOfSamplesDone / my numberOfSamples : 1.0;
+}
+
+void SoundPyramid_getExtrema (SoundPyramid me, long channel, long firstSample, long lastSample, double *minimum, double *maximum);
+/*
+	The extrema of samples firstSample through lastSample of the channel,
+	with the range rounded outward to whole blocks of level 1.
+	Precondition: the pyramid is complete.
+*/
+
+void SoundPyramid_getWindowExtrema (SoundPyramid me, double tmin, double tmax, long channel, double *minimum, double *maximum);
+
+void SoundPyramid_draw (SoundPyramid me, Graphics graphics, long channel, double tmin, double tmax);
+/*
+	Draw one vertical line from minimum to maximum for every device pixel between tmin and tmax,
+	in the world coordinates of the graphics, which the caller has set to the sound's values.
+	Precondition: the pyramid is complete.
+*/
+
+/* End of file SoundPyramid.h */
+#endif
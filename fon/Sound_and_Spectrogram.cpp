@@ -34,13 +34,17 @@
 
 #include "Sound_and_Spectrogram.h"
 #include "NUM2.h"
+#include "SampledAnalysis.h"
 
 #include "enums_getText.h"
 #include "Sound_and_Spectrogram_enums.h"
 #include "enums_getValue.h"
 #include "Sound_and_Spectrogram_enums.h"
 
-autoSpectrogram Sound_to_Spectrogram (Sound me, double effectiveAnalysisWidth, double fmax,
+/*
+	'me' is a Sound or a LongSound.
+*/
+static autoSpectrogram Sound_to_Spectrogram_ (Sampled me, double effectiveAnalysisWidth, double fmax,
 	double minimumTimeStep1, double minimumFreqStep1, enum kSound_to_Spectrogram_windowShape windowType,
 	double maximumTimeOversampling, double maximumFreqOversampling)
 {
@@ -96,11 +100,7 @@ autoSpectrogram Sound_to_Spectrogram (Sound me, double effectiveAnalysisWidth, d
 		autoSpectrogram thee = Spectrogram_create (my xmin, my xmax, numberOfTimes, timeStep, t1,
 				0.0, fmax, numberOfFreqs, freqStep, 0.5 * (freqStep - binWidth_hertz));
 
-		autoNUMvector <double> frame (1, nsampFFT);
-		autoNUMvector <double> spec (1, nsampFFT);
 		autoNUMvector <double> window (1, nsamp_window);
-		autoNUMfft_Table fftTable;
-		NUMfft_Table_init (& fftTable, nsampFFT);
 
 		autoMelderProgress progress (U"Sound to Spectrogram...");
 		for (long i = 1; i <= nsamp_window; i ++) {
@@ -133,54 +133,81 @@ autoSpectrogram Sound_to_Spectrogram (Sound me, double effectiveAnalysisWidth, d
 		}
 		double oneByBinWidth = 1.0 / windowssq / binWidth_samples;
 
-		for (long iframe = 1; iframe <= numberOfTimes; iframe ++) {
-			double t = Sampled_indexToX (thee.get(), iframe);
-			long leftSample = Sampled_xToLowIndex (me, t), rightSample = leftSample + 1;
-			long startSample = rightSample - halfnsamp_window;
-			long endSample = leftSample + halfnsamp_window;
-			Melder_assert (startSample >= 1);
-			Melder_assert (endSample <= my nx);
-			for (long i = 1; i <= half_nsampFFT; i ++) {
-				spec [i] = 0.0;
-			}
-			for (long channel = 1; channel <= my ny; channel ++) {
-				for (long j = 1, i = startSample; j <= nsamp_window; j ++) {
-					frame [j] = my z [channel] [i ++] * window [j];
-				}
-				for (long j = nsamp_window + 1; j <= nsampFFT; j ++) frame [j] = 0.0f;
-
-				Melder_progress (iframe / (numberOfTimes + 1.0),
-					U"Sound to Spectrogram: analysis of frame ", iframe, U" out of ", numberOfTimes);
-
-				/* Compute Fast Fourier Transform of the frame. */
-
-				NUMfft_forward (& fftTable, frame.peek());   // complex spectrum
-
-				/* Put power spectrum in frame [1..half_nsampFFT + 1]. */
-
-				spec [1] += frame [1] * frame [1];   // DC component
-				for (long i = 2; i <= half_nsampFFT; i ++)
-					spec [i] += frame [i + i - 2] * frame [i + i - 2] + frame [i + i - 1] * frame [i + i - 1];
-				spec [half_nsampFFT + 1] += frame [nsampFFT] * frame [nsampFFT];   // Nyquist frequency. Correct??
-			}
-			if (my ny > 1 ) for (long i = 1; i <= half_nsampFFT; i ++) {
-				spec [i] /= my ny;
-			}
-
-			/* Bin into frame [1..nBands]. */
-			for (long iband = 1; iband <= numberOfFreqs; iband ++) {
-				long leftsample = (iband - 1) * binWidth_samples + 1, rightsample = leftsample + binWidth_samples;
-				float power = 0.0f;
-				for (long i = leftsample; i < rightsample; i ++) power += spec [i];
-				thy z [iband] [iframe] = power * oneByBinWidth;
-			}
-		}
+		struct Workspace {
+			autoNUMvector <double> frame, spec;
+			autoNUMfft_Table fftTable;
+		};
+		Sampled_analyseSoundInParts (me, thee.get(), 0.5 * physicalAnalysisWidth + 2.0 * my dx, [&] (Sound part, long sampleOffset, long firstFrame, long lastFrame) {
+			Sampled_analyseFrames <Workspace> (thee.get(), firstFrame, lastFrame, 20,
+				[&] (Workspace& workspace) {
+					workspace. frame.reset (1, nsampFFT);
+					workspace. spec.reset (1, nsampFFT);
+					NUMfft_Table_init (& workspace. fftTable, nsampFFT);
+				},
+				[&] (Workspace& workspace, long iframe) {
+					double *frame = workspace. frame.peek(), *spec = workspace. spec.peek();
+					double t = Sampled_indexToX (thee.get(), iframe);
+					long leftSample = Sampled_xToLowIndex (me, t) - sampleOffset, rightSample = leftSample + 1;
+					long startSample = rightSample - halfnsamp_window;
+					long endSample = leftSample + halfnsamp_window;
+					Melder_assert (startSample >= 1);
+					Melder_assert (endSample <= part -> nx);
+					for (long i = 1; i <= half_nsampFFT; i ++) {
+						spec [i] = 0.0;
+					}
+					for (long channel = 1; channel <= part -> ny; channel ++) {
+						for (long j = 1, i = startSample; j <= nsamp_window; j ++) {
+							frame [j] = part -> z [channel] [i ++] * window [j];
+						}
+						for (long j = nsamp_window + 1; j <= nsampFFT; j ++) frame [j] = 0.0f;
+
+						/* Compute Fast Fourier Transform of the frame. */
+
+						NUMfft_forward (& workspace. fftTable, frame);   // complex spectrum
+
+						/* Put power spectrum in frame [1..half_nsampFFT + 1]. */
+
+						spec [1] += frame [1] * frame [1];   // DC component
+						for (long i = 2; i <= half_nsampFFT; i ++)
+							spec [i] += frame [i + i - 2] * frame [i + i - 2] + frame [i + i - 1] * frame [i + i - 1];
+						spec [half_nsampFFT + 1] += frame [nsampFFT] * frame [nsampFFT];   // Nyquist frequency. Correct??
+					}
+					if (part -> ny > 1 ) for (long i = 1; i <= half_nsampFFT; i ++) {
+						spec [i] /= part -> ny;
+					}
+
+					/* Bin into frame [1..nBands]. */
+					for (long iband = 1; iband <= numberOfFreqs; iband ++) {
+						long leftsample = (iband - 1) * binWidth_samples + 1, rightsample = leftsample + binWidth_samples;
+						float power = 0.0f;
+						for (long i = leftsample; i < rightsample; i ++) power += spec [i];
+						thy z [iband] [iframe] = power * oneByBinWidth;
+					}
+				},
+				U"Sound to Spectrogram");
+		});
 		return thee;
 	} catch (MelderError) {
 		Melder_throw (me, U": spectrogram analysis not performed.");
 	}
 }
 
+autoSpectrogram Sound_to_Spectrogram (Sound me, double effectiveAnalysisWidth, double fmax,
+	double minimumTimeStep1, double minimumFreqStep1, enum kSound_to_Spectrogram_windowShape windowShape,
+	double maximumTimeOversampling, double maximumFreqOversampling)
+{
+	return Sound_to_Spectrogram_ (me, effectiveAnalysisWidth, fmax, minimumTimeStep1, minimumFreqStep1, windowShape,
+		maximumTimeOversampling, maximumFreqOversampling);
+}
+
+autoSpectrogram LongSound_to_Spectrogram (LongSound me, double effectiveAnalysisWidth, double fmax,
+	double minimumTimeStep1, double minimumFreqStep1, enum kSound_to_Spectrogram_windowShape windowShape,
+	double maximumTimeOversampling, double maximumFreqOversampling)
+{
+	return Sound_to_Spectrogram_ (me, effectiveAnalysisWidth, fmax, minimumTimeStep1, minimumFreqStep1, windowShape,
+		maximumTimeOversampling, maximumFreqOversampling);
+}
+
 autoSound Spectrogram_to_Sound (Spectrogram me, double fsamp) {
 	try {
 		double dt = 1 / fsamp;
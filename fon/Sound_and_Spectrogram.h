@@ -18,7 +18,7 @@
  * along with this work. If not, see <http://www.gnu.org/licenses/>.
  */
 
-#include "Sound.h"
+#include "LongSound.h"
 #include "Spectrogram.h"
 
 #include "Sound_and_Spectrogram_enums.h"
@@ -27,6 +27,13 @@ autoSpectrogram Sound_to_Spectrogram (Sound me, double effectiveAnalysisWidth, d
 	double minimumTimeStep1, double minimumFreqStep1, enum kSound_to_Spectrogram_windowShape windowShape,
 	double maximumTimeOversampling, double maximumFreqOversampling);
 
+autoSpectrogram LongSound_to_Spectrogram (LongSound me, double effectiveAnalysisWidth, double fmax,
+	double minimumTimeStep1, double minimumFreqStep1, enum kSound_to_Spectrogram_windowShape windowShape,
+	double maximumTimeOversampling, double maximumFreqOversampling);
+/*
+	As Sound_to_Spectrogram, but reads the sound file part by part, so that memory use does not grow with its duration.
+*/
+
 autoSound Spectrogram_to_Sound (Spectrogram me, double fsamp);
 
 /* End of Sound_and_Spectrogram.h */
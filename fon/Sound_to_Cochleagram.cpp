@@ -31,6 +31,7 @@
 #include "Sound_to_Cochleagram.h"
 #include "Sound_and_Spectrum.h"
 #include "Spectrum_to_Excitation.h"
+#include "MelderThread.h"
 
 autoCochleagram Sound_to_Cochleagram (Sound me, double dt, double df, double dt_window, double forwardMaskingTime) {
 	try {
@@ -209,4 +210,262 @@ autoCochleagram Sound_to_Cochleagram_edb
 	}
 }
 
+/*
+	A fourth-order gammatone filter with centre frequency f and bandwidth b
+	(Slaney 1993, as in Sound_filterByGammaToneFilter4) has the transfer function
+		H (z) = Re [1 / (1 - p z^-1)^4],   with   p = exp (- 2 pi b T + 2 pi i f T).
+	For a real input signal, the output is therefore the real part of the output of
+	a cascade of four identical complex one-pole filters. This takes fewer operations than
+	the eighth-order recursion, and stays stable for narrow bands at low frequencies.
+
+	The bands are filtered in groups of Gammatone_NUMBER_OF_LANES;
+	the innermost loop runs over the bands of a group, so that the compiler can keep a group in vector registers.
+	The groups are divided among the threads, and each thread makes a single pass through the sound,
+	block by block, filtering all of its groups in each block.
+*/
+
+#define Gammatone_NUMBER_OF_LANES  8
+#define Gammatone_MAXIMUM_BLOCK_SIZE  1024
+
+struct GammatoneGroup {
+	long firstBand, numberOfBands;
+	double pr [Gammatone_NUMBER_OF_LANES], pi [Gammatone_NUMBER_OF_LANES], gain [Gammatone_NUMBER_OF_LANES];
+	double sr [4] [Gammatone_NUMBER_OF_LANES], si [4] [Gammatone_NUMBER_OF_LANES];   // the states of the four stages
+};
+
+static void inverseFourthPowerOfOneMinus (double ur, double ui, double *out_re, double *out_im) {
+	/*
+		1 / (1 - u)^4
+	*/
+	double ar = 1.0 - ur, ai = - ui;
+	double br = ar * ar - ai * ai, bi = 2.0 * ar * ai;   // (1 - u)^2
+	double cr = br * br - bi * bi, ci = 2.0 * br * bi;   // (1 - u)^4
+	double norm = cr * cr + ci * ci;
+	*out_re = cr / norm;
+	*out_im = - ci / norm;
+}
+
+static void GammatoneGroup_init (GammatoneGroup *me, long firstBand, long numberOfBands,
+	const double *centreFrequency, const double *bandwidth, double dt)
+{
+	my firstBand = firstBand;
+	my numberOfBands = numberOfBands;
+	for (int lane = 0; lane < Gammatone_NUMBER_OF_LANES; lane ++) {
+		my pr [lane] = my pi [lane] = my gain [lane] = 0.0;   // unused lanes filter nothing
+		for (int stage = 0; stage < 4; stage ++)
+			my sr [stage] [lane] = my si [stage] [lane] = 0.0;
+		if (lane >= numberOfBands) continue;
+		double omega = 2.0 * NUMpi * centreFrequency [firstBand + lane] * dt;
+		double radius = exp (- 2.0 * NUMpi * bandwidth [firstBand + lane] * dt);
+		my pr [lane] = radius * cos (omega);
+		my pi [lane] = radius * sin (omega);
+		/*
+			Normalize to unit gain at the centre frequency:
+			H (exp (i omega)) = 1/2 [1 / (1 - p exp (- i omega))^4 + 1 / (1 - conj (p) exp (- i omega))^4],
+			where p exp (- i omega) = radius and conj (p) exp (- i omega) = radius exp (- 2 i omega).
+		*/
+		double h1r, h1i, h2r, h2i;
+		inverseFourthPowerOfOneMinus (radius, 0.0, & h1r, & h1i);
+		inverseFourthPowerOfOneMinus (radius * cos (2.0 * omega), - radius * sin (2.0 * omega), & h2r, & h2i);
+		my gain [lane] = 2.0 / sqrt ((h1r + h2r) * (h1r + h2r) + (h1i + h2i) * (h1i + h2i));
+	}
+}
+
+static void GammatoneGroup_filter (GammatoneGroup *me, const double *x, long n, double * const *out) {
+	/*
+		Work on local copies of the coefficients and states, which cannot be aliased by the output.
+	*/
+	double pr [Gammatone_NUMBER_OF_LANES], pi [Gammatone_NUMBER_OF_LANES], gain [Gammatone_NUMBER_OF_LANES];
+	double sr [4] [Gammatone_NUMBER_OF_LANES], si [4] [Gammatone_NUMBER_OF_LANES];
+	for (int lane = 0; lane < Gammatone_NUMBER_OF_LANES; lane ++) {
+		pr [lane] = my pr [lane];
+		pi [lane] = my pi [lane];
+		gain [lane] = my gain [lane];
+		for (int stage = 0; stage < 4; stage ++) {
+			sr [stage] [lane] = my sr [stage] [lane];
+			si [stage] [lane] = my si [stage] [lane];
+		}
+	}
+	for (long i = 0; i < n; i ++) {
+		double yr [Gammatone_NUMBER_OF_LANES], yi [Gammatone_NUMBER_OF_LANES];
+		for (int lane = 0; lane < Gammatone_NUMBER_OF_LANES; lane ++) {
+			yr [lane] = x [i];
+			yi [lane] = 0.0;
+		}
+		for (int stage = 0; stage < 4; stage ++) {
+			for (int lane = 0; lane < Gammatone_NUMBER_OF_LANES; lane ++) {
+				double re = yr [lane] + pr [lane] * sr [stage] [lane] - pi [lane] * si [stage] [lane];
+				double im = yi [lane] + pr [lane] * si [stage] [lane] + pi [lane] * sr [stage] [lane];
+				sr [stage] [lane] = yr [lane] = re;
+				si [stage] [lane] = yi [lane] = im;
+			}
+		}
+		for (int lane = 0; lane < Gammatone_NUMBER_OF_LANES; lane ++)
+			out [lane] [i] = gain [lane] * yr [lane];
+	}
+	for (int lane = 0; lane < Gammatone_NUMBER_OF_LANES; lane ++) {
+		for (int stage = 0; stage < 4; stage ++) {
+			my sr [stage] [lane] = sr [stage] [lane];
+			my si [stage] [lane] = si [stage] [lane];
+		}
+	}
+}
+
+struct GammatoneChunk {
+	const double *x;   // the mono input signal, [1..nx]
+	const long *blockEnd;   // [0..numberOfBlocks]; block iblock consists of samples blockEnd [iblock - 1] + 1 through blockEnd [iblock]
+	long numberOfBlocks, maximumBlockSize;
+	GammatoneGroup *groups;
+	long firstGroup, lastGroup;
+	double **output;   // if not null: the filter output, [1..numberOfBands] [1..nx]
+	double **energy;   // if not null: the summed squared filter output, [1..numberOfBands] [1..numberOfBlocks]
+	std::vector <double> scratch;   // room for one block of every lane, allocated on the calling thread
+};
+
+static MelderThread_RETURN_TYPE GammatoneChunk_run (GammatoneChunk *me) {
+	for (long iblock = 0; iblock <= my numberOfBlocks; iblock ++) {
+		long firstSample = ( iblock == 0 ? 1 : my blockEnd [iblock - 1] + 1 ), lastSample = my blockEnd [iblock];
+		long n = lastSample - firstSample + 1;
+		if (n < 1) continue;
+		for (long igroup = my firstGroup; igroup <= my lastGroup; igroup ++) {
+			GammatoneGroup *group = & my groups [igroup];
+			double *out [Gammatone_NUMBER_OF_LANES];
+			for (int lane = 0; lane < Gammatone_NUMBER_OF_LANES; lane ++)
+				out [lane] = my output && lane < group -> numberOfBands ?
+					& my output [group -> firstBand + lane] [firstSample] : & my scratch [(size_t) (lane * my maximumBlockSize)];
+			GammatoneGroup_filter (group, & my x [firstSample], n, out);
+			if (my energy && iblock > 0) {
+				for (int lane = 0; lane < group -> numberOfBands; lane ++) {
+					double sum = 0.0;
+					for (long i = 0; i < n; i ++)
+						sum += out [lane] [i] * out [lane] [i];
+					my energy [group -> firstBand + lane] [iblock] = sum;
+				}
+			}
+		}
+	}
+	MelderThread_RETURN;
+}
+
+/*
+	Filter the mono version of the sound through the bands 1..numberOfBands,
+	block by block as given by blockEnd (block 0 is filtered but not measured).
+*/
+static void Sound_gammatoneFilterbank (Sound me, double frequencyResolution, long numberOfBands,
+	const long *blockEnd, long numberOfBlocks, double **output, double **energy)
+{
+	autoNUMvector <double> mono;
+	const double *x = my z [1];
+	if (my ny > 1) {
+		mono.reset (1, my nx);
+		for (long i = 1; i <= my nx; i ++) {
+			double sum = 0.0;
+			for (long ichan = 1; ichan <= my ny; ichan ++)
+				sum += my z [ichan] [i];
+			mono [i] = sum / my ny;
+		}
+		x = mono.peek();
+	}
+	autoNUMvector <double> centreFrequency (1, numberOfBands), bandwidth (1, numberOfBands);
+	for (long iband = 1; iband <= numberOfBands; iband ++) {
+		centreFrequency [iband] = Excitation_barkToHertz ((iband - 0.5) * frequencyResolution);
+		bandwidth [iband] = 1.019 * 24.7 * (4.37e-3 * centreFrequency [iband] + 1.0);
+	}
+	long numberOfGroups = (numberOfBands - 1) / Gammatone_NUMBER_OF_LANES + 1;
+	std::vector <GammatoneGroup> groups ((size_t) numberOfGroups + 1);
+	for (long igroup = 1; igroup <= numberOfGroups; igroup ++) {
+		long firstBand = (igroup - 1) * Gammatone_NUMBER_OF_LANES + 1;
+		GammatoneGroup_init (& groups [(size_t) igroup], firstBand,
+			std::min ((long) Gammatone_NUMBER_OF_LANES, numberOfBands - firstBand + 1),
+			centreFrequency.peek(), bandwidth.peek(), my dx);
+	}
+	long maximumBlockSize = 1;
+	for (long iblock = 0; iblock <= numberOfBlocks; iblock ++) {
+		long n = blockEnd [iblock] - ( iblock == 0 ? 0 : blockEnd [iblock - 1] );
+		if (n > maximumBlockSize) maximumBlockSize = n;
+	}
+	long numberOfThreads = std::min ((long) MelderThread_getNumberOfProcessors (), numberOfGroups);
+	long numberOfGroupsPerThread = (numberOfGroups - 1) / numberOfThreads + 1;
+	numberOfThreads = (numberOfGroups - 1) / numberOfGroupsPerThread + 1;   // no empty chunks
+	std::vector <GammatoneChunk> chunks ((size_t) numberOfThreads);
+	for (long ithread = 1; ithread <= numberOfThreads; ithread ++) {
+		GammatoneChunk *chunk = & chunks [(size_t) ithread - 1];
+		chunk -> x = x;
+		chunk -> blockEnd = blockEnd;
+		chunk -> numberOfBlocks = numberOfBlocks;
+		chunk -> maximumBlockSize = maximumBlockSize;
+		chunk -> groups = groups.data();
+		chunk -> firstGroup = (ithread - 1) * numberOfGroupsPerThread + 1;
+		chunk -> lastGroup = std::min (ithread * numberOfGroupsPerThread, numberOfGroups);
+		chunk -> output = output;
+		chunk -> energy = energy;
+		chunk -> scratch. resize ((size_t) (Gammatone_NUMBER_OF_LANES * maximumBlockSize));
+	}
+	MelderThread_run (GammatoneChunk_run, chunks.data(), (int) numberOfThreads);
+}
+
+static long Sound_getNumberOfGammatoneBands (Sound me, double frequencyResolution, long maximumNumberOfBands) {
+	long numberOfBands = 0;
+	while (numberOfBands < maximumNumberOfBands &&
+	       Excitation_barkToHertz ((numberOfBands + 0.5) * frequencyResolution) < 0.5 / my dx)
+		numberOfBands ++;
+	return numberOfBands;
+}
+
+autoCochleagram Sound_to_Cochleagram_gammatone (Sound me, double timeStep, double frequencyResolution) {
+	try {
+		long numberOfFrequencies = lround (25.6 / frequencyResolution);
+		if (numberOfFrequencies < 1)
+			Melder_throw (U"The frequency resolution should be less than 25.6 Bark.");
+		long numberOfFrames;
+		double firstTime;
+		Sampled_shortTermAnalysis (me, timeStep, timeStep, & numberOfFrames, & firstTime);
+		autoCochleagram thee = Cochleagram_create (my xmin, my xmax, numberOfFrames, timeStep, firstTime, frequencyResolution, numberOfFrequencies);
+		long numberOfBands = Sound_getNumberOfGammatoneBands (me, frequencyResolution, numberOfFrequencies);
+		if (numberOfBands == 0) return thee;
+		/*
+			Frame iframe measures the samples between its centre minus and plus half a time step.
+		*/
+		autoNUMvector <long> blockEnd ((long) 0, numberOfFrames);
+		for (long iframe = 0; iframe <= numberOfFrames; iframe ++) {
+			double t = Sampled_indexToX (thee.get(), iframe) + 0.5 * timeStep;
+			long lastSample = (long) ceil ((t - my x1) / my dx);
+			if (lastSample < 0) lastSample = 0;
+			if (lastSample > my nx) lastSample = my nx;
+			if (iframe > 0 && lastSample < blockEnd [iframe - 1]) lastSample = blockEnd [iframe - 1];
+			blockEnd [iframe] = lastSample;
+		}
+		autoNUMmatrix <double> energy (1, numberOfBands, 1, numberOfFrames);
+		Sound_gammatoneFilterbank (me, frequencyResolution, numberOfBands, blockEnd.peek(), numberOfFrames, nullptr, energy.peek());
+		for (long iframe = 1; iframe <= numberOfFrames; iframe ++) {
+			long n = blockEnd [iframe] - blockEnd [iframe - 1];
+			if (n < 1) continue;
+			for (long iband = 1; iband <= numberOfBands; iband ++) {
+				double meanSquare = energy [iband] [iframe] / n;
+				thy z [iband] [iframe] = meanSquare > 4.0e-10 ? 10.0 * log10 (meanSquare / 4.0e-10) : 0.0;
+			}
+		}
+		return thee;
+	} catch (MelderError) {
+		Melder_throw (me, U": not converted to Cochleagram (gammatone).");
+	}
+}
+
+autoSound Sound_filterByGammatoneFilterbank (Sound me, double frequencyResolution) {
+	try {
+		long numberOfBands = Sound_getNumberOfGammatoneBands (me, frequencyResolution, lround (25.6 / frequencyResolution));
+		if (numberOfBands == 0)
+			Melder_throw (U"The lowest band lies above the Nyquist frequency. Use a smaller frequency resolution.");
+		autoSound thee = Sound_create (numberOfBands, my xmin, my xmax, my nx, my dx, my x1);
+		long numberOfBlocks = (my nx - 1) / Gammatone_MAXIMUM_BLOCK_SIZE + 1;
+		autoNUMvector <long> blockEnd ((long) 0, numberOfBlocks);
+		for (long iblock = 1; iblock <= numberOfBlocks; iblock ++)
+			blockEnd [iblock] = std::min (iblock * Gammatone_MAXIMUM_BLOCK_SIZE, (long) my nx);
+		Sound_gammatoneFilterbank (me, frequencyResolution, numberOfBands, blockEnd.peek(), numberOfBlocks, thy z, nullptr);
+		return thee;
+	} catch (MelderError) {
+		Melder_throw (me, U": not filtered by gammatone filterbank.");
+	}
+}
+
 /* End of file Sound_to_Cochleagram.cpp */
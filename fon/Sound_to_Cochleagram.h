@@ -25,4 +25,26 @@ autoCochleagram Sound_to_Cochleagram_edb
 	(Sound me, double dtime, double dfreq, int hasSynapse, double replenishmentRate,
 	 double lossRate, double returnRate, double reprocessingRate);
 
+autoCochleagram Sound_to_Cochleagram_gammatone (Sound me, double timeStep, double frequencyResolution);
+/*
+	Function:
+		filter the Sound through a bank of fourth-order gammatone filters, one for each band of the Cochleagram,
+		and measure the mean energy of each filter output in consecutive windows of length timeStep.
+	The centre frequency of band iband is at (iband - 0.5) * frequencyResolution Bark,
+	and its bandwidth is 1.019 ERB (Glasberg & Moore 1990); the filters have unit gain at their centre frequencies.
+	Stereo sounds are averaged first.
+	Postconditions:
+		result -> z [iband] [iframe] is in dB re 4e-10 Pa^2, and not lower than 0.0;
+		bands at or above the Nyquist frequency are 0.0.
+*/
+
+autoSound Sound_filterByGammatoneFilterbank (Sound me, double frequencyResolution);
+/*
+	Function:
+		filter the Sound through the filterbank of Sound_to_Cochleagram_gammatone.
+	Postconditions:
+		result -> ny == the number of bands below the Nyquist frequency;
+		channel iband contains the (unsquared) output of the filter of band iband.
+*/
+
 /* End of file Sound_to_Cochleagram.h */
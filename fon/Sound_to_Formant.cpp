@@ -31,6 +31,7 @@
 #include "Sound_to_Formant.h"
 #include "NUM2.h"
 #include "Polynomial.h"
+#include "SampledAnalysis.h"
 
 static void burg (double sample [], long nsamp_window, double cof [], int nPoles,
 	Formant_Frame frame, double nyquistFrequency, double safetyMargin)
@@ -48,8 +49,17 @@ static void burg (double sample [], long nsamp_window, double cof [], int nPoles
 
 	/*
 	 * Find the roots of the polynomial.
+	 * The eigenvalue routine is not reentrant, so frames analysed on other threads have to wait here.
 	 */
-	autoRoots roots = Polynomial_to_Roots (polynomial.get());
+	autoRoots roots;
+	SampledAnalysis_lock ();
+	try {
+		roots = Polynomial_to_Roots (polynomial.get());
+	} catch (MelderError) {
+		SampledAnalysis_unlock ();
+		throw;
+	}
+	SampledAnalysis_unlock ();
 	Roots_fixIntoUnitCircle (roots.get());
 
 	Melder_assert (frame -> nFormants == 0 && ! frame -> formant);
@@ -264,77 +274,108 @@ void Formant_sort (Formant me) {
 	}
 }
 
-static autoFormant Sound_to_Formant_any_inline (Sound me, double dt_in, int numberOfPoles,
-	double halfdt_window, int which, double preemphasisFrequency, double safetyMargin)
+/*
+	Create an empty Formant for the analysis of a sound with the domain xmin..xmax and the samples nx, dx, x1,
+	and compute the window length in samples.
+*/
+static autoFormant Formant_createForAnalysis (double xmin, double xmax, long nx, double dx, double x1,
+	double dt_in, int numberOfPoles, double halfdt_window, long *out_nsamp_window, long *out_halfnsamp_window)
 {
 	double dt = dt_in > 0.0 ? dt_in : halfdt_window / 4.0;
-	double duration = my nx * my dx, t1;
+	double duration = nx * dx, t1;
 	double dt_window = 2.0 * halfdt_window;
 	long nFrames = 1 + (long) floor ((duration - dt_window) / dt);
-	long nsamp_window = (long) floor (dt_window / my dx), halfnsamp_window = nsamp_window / 2;
+	long nsamp_window = (long) floor (dt_window / dx), halfnsamp_window = nsamp_window / 2;
 
 	if (nsamp_window < numberOfPoles + 1)
 		Melder_throw (U"Window too short.");
-	t1 = my x1 + 0.5 * (duration - my dx - (nFrames - 1) * dt);   // centre of first frame
+	t1 = x1 + 0.5 * (duration - dx - (nFrames - 1) * dt);   // centre of first frame
 	if (nFrames < 1) {
 		nFrames = 1;
-		t1 = my x1 + 0.5 * duration;
+		t1 = x1 + 0.5 * duration;
 		dt_window = duration;
-		nsamp_window = my nx;
+		nsamp_window = nx;
 	}
-	autoFormant thee = Formant_create (my xmin, my xmax, nFrames, dt, t1, (numberOfPoles + 1) / 2);   // e.g. 11 poles -> maximally 6 formants
-	autoNUMvector <double> window (1, nsamp_window);
-	autoNUMvector <double> frame (1, nsamp_window);
-	autoNUMvector <double> cof (1, numberOfPoles);   // superfluous if which==2, but nobody uses that anyway
-
-	autoMelderProgress progress (U"Formant analysis...");
-
-	/* Pre-emphasis. */
-	Sound_preEmphasis (me, preemphasisFrequency);
+	*out_nsamp_window = nsamp_window;
+	*out_halfnsamp_window = halfnsamp_window;
+	return Formant_create (xmin, xmax, nFrames, dt, t1, (numberOfPoles + 1) / 2);   // e.g. 11 poles -> maximally 6 formants
+}
 
+/*
+	Analyse the frames firstFrame..lastFrame of 'thee' from the pre-emphasized sound 'me',
+	whose sample i is sample i + sampleOffset of the sound for which 'thee' was created, which has its first sample at time x1.
+*/
+static void Sound_into_Formant (Sound me, double x1, long sampleOffset, Formant thee, long firstFrame, long lastFrame,
+	int numberOfPoles, long nsamp_window, long halfnsamp_window, int which, double safetyMargin)
+{
 	/* Gaussian window. */
+	autoNUMvector <double> window (1, nsamp_window);
 	for (long i = 1; i <= nsamp_window; i ++) {
 		double imid = 0.5 * (nsamp_window + 1), edge = exp (-12.0);
 		window [i] = (exp (-48.0 * (i - imid) * (i - imid) / (nsamp_window + 1) / (nsamp_window + 1)) - edge) / (1.0 - edge);
 	}
 
-	for (long iframe = 1; iframe <= nFrames; iframe ++) {
-		double t = Sampled_indexToX (thee.get(), iframe);
-		long leftSample = Sampled_xToLowIndex (me, t);
-		long rightSample = leftSample + 1;
-		long startSample = rightSample - halfnsamp_window;
-		long endSample = leftSample + halfnsamp_window;
-		double maximumIntensity = 0.0;
-		if (startSample < 1) startSample = 1;
-		if (endSample > my nx) endSample = my nx;
-		for (long i = startSample; i <= endSample; i ++) {
-			double value = Sampled_getValueAtSample (me, i, Sound_LEVEL_MONO, 0);
-			if (value * value > maximumIntensity) {
-				maximumIntensity = value * value;
+	struct Workspace {
+		autoNUMvector <double> frame, cof;
+	};
+	Sampled_analyseFrames <Workspace> (thee, firstFrame, lastFrame, 10,
+		[&] (Workspace& workspace) {
+			workspace. frame.reset (1, nsamp_window);
+			workspace. cof.reset (1, numberOfPoles);   // superfluous if which==2, but nobody uses that anyway
+		},
+		[&] (Workspace& workspace, long iframe) {
+			double *frame = workspace. frame.peek(), *cof = workspace. cof.peek();
+			double t = Sampled_indexToX (thee, iframe);
+			long leftSample = (long) floor ((t - x1) / my dx + 1.0) - sampleOffset;
+			long rightSample = leftSample + 1;
+			long startSample = rightSample - halfnsamp_window;
+			long endSample = leftSample + halfnsamp_window;
+			double maximumIntensity = 0.0;
+			if (startSample < 1) startSample = 1;
+			if (endSample > my nx) endSample = my nx;
+			for (long i = startSample; i <= endSample; i ++) {
+				double value = Sampled_getValueAtSample (me, i, Sound_LEVEL_MONO, 0);
+				if (value * value > maximumIntensity) {
+					maximumIntensity = value * value;
+				}
 			}
-		}
-		if (maximumIntensity == HUGE_VAL)
-			Melder_throw (U"Sound contains infinities.");
-		thy d_frames [iframe]. intensity = maximumIntensity;
-		if (maximumIntensity == 0.0) continue;   // Burg cannot stand all zeroes
-
-		/* Copy a pre-emphasized window to a frame. */
-		for (long j = 1, i = startSample; j <= nsamp_window; j ++)
-			frame [j] = Sampled_getValueAtSample (me, i ++, Sound_LEVEL_MONO, 0) * window [j];
-
-		if (which == 1) {
-			burg (frame.peek(), endSample - startSample + 1, cof.peek(), numberOfPoles, & thy d_frames [iframe], 0.5 / my dx, safetyMargin);
-		} else if (which == 2) {
-			if (! splitLevinson (frame.peek(), endSample - startSample + 1, numberOfPoles, & thy d_frames [iframe], 0.5 / my dx)) {
-				Melder_clearError ();
-				Melder_casual (U"(Sound_to_Formant:)"
-					U" Analysis results of frame ", iframe,
-					U" will be wrong."
-				);
+			if (maximumIntensity == HUGE_VAL)
+				Melder_throw (U"Sound contains infinities.");
+			thy d_frames [iframe]. intensity = maximumIntensity;
+			if (maximumIntensity == 0.0) return;   // Burg cannot stand all zeroes
+
+			/* Copy a pre-emphasized window to a frame. */
+			for (long j = 1, i = startSample; j <= nsamp_window; j ++)
+				frame [j] = Sampled_getValueAtSample (me, i ++, Sound_LEVEL_MONO, 0) * window [j];
+
+			if (which == 1) {
+				burg (frame, endSample - startSample + 1, cof, numberOfPoles, & thy d_frames [iframe], 0.5 / my dx, safetyMargin);
+			} else if (which == 2) {
+				if (! splitLevinson (frame, endSample - startSample + 1, numberOfPoles, & thy d_frames [iframe], 0.5 / my dx)) {
+					Melder_clearError ();
+					Melder_casual (U"(Sound_to_Formant:)"
+						U" Analysis results of frame ", iframe,
+						U" will be wrong."
+					);
+				}
 			}
-		}
-		Melder_progress ((double) iframe / (double) nFrames, U"Formant analysis: frame ", iframe);
-	}
+		},
+		U"Formant analysis");
+}
+
+static autoFormant Sound_to_Formant_any_inline (Sound me, double dt_in, int numberOfPoles,
+	double halfdt_window, int which, double preemphasisFrequency, double safetyMargin)
+{
+	long nsamp_window, halfnsamp_window;
+	autoFormant thee = Formant_createForAnalysis (my xmin, my xmax, my nx, my dx, my x1,
+		dt_in, numberOfPoles, halfdt_window, & nsamp_window, & halfnsamp_window);
+
+	autoMelderProgress progress (U"Formant analysis...");
+
+	/* Pre-emphasis. */
+	Sound_preEmphasis (me, preemphasisFrequency);
+
+	Sound_into_Formant (me, my x1, 0, thee.get(), 1, thy nx, numberOfPoles, nsamp_window, halfnsamp_window, which, safetyMargin);
 	Formant_sort (thee.get());
 	return thee;
 }
@@ -352,6 +393,65 @@ autoFormant Sound_to_Formant_any (Sound me, double dt, int numberOfPoles, double
 	return Sound_to_Formant_any_inline (sound.get(), dt, numberOfPoles, halfdt_window, which, preemphasisFrequency, safetyMargin);
 }
 
+autoFormant LongSound_to_Formant_any (LongSound me, double dt, int numberOfPoles, double maximumFrequency,
+	double halfdt_window, int which, double preemphasisFrequency, double safetyMargin)
+{
+	try {
+		/*
+			The frames are those of the analysis of the whole sound, after resampling it as Sound_to_Formant_any does.
+		*/
+		double nyquist = 0.5 / my dx, samplingFrequency = 1.0 / my dx;
+		bool resample = ! (maximumFrequency <= 0.0 || fabs (maximumFrequency / nyquist - 1) < 1.0e-12) &&
+			fabs (2.0 * maximumFrequency * my dx - 1.0) >= 1e-6;   // as in Sound_resample
+		long nx = my nx;
+		double dx = my dx, x1 = my x1;
+		if (resample) {
+			samplingFrequency = 2.0 * maximumFrequency;
+			nx = lround ((my xmax - my xmin) * samplingFrequency);
+			dx = 1.0 / samplingFrequency;
+			x1 = 0.5 * (my xmin + my xmax - (nx - 1) / samplingFrequency);   // as in Sound_resample
+		}
+		long nsamp_window, halfnsamp_window;
+		autoFormant thee = Formant_createForAnalysis (my xmin, my xmax, nx, dx, x1,
+			dt, numberOfPoles, halfdt_window, & nsamp_window, & halfnsamp_window);
+
+		autoMelderProgress progress (U"Formant analysis...");
+
+		/*
+			Every part has to contain the window samples of its frames, plus one sample for the pre-emphasis,
+			plus the input samples of the resampling kernel (Sound_resample has a depth of 50, i.e. 51 samples at the lower rate).
+		*/
+		double margin = (0.5 * nsamp_window + 4) * dx + ( resample ? 52.0 * (dx > my dx ? dx : my dx) : 0.0 );
+		Sampled_analyseSoundInParts (me, thee.get(), margin, [&] (Sound part, long sampleOffset, long firstFrame, long lastFrame) {
+			autoSound sound;
+			if (resample) {
+				/*
+					Resample only the samples that the frames need, at the times that Sound_resample would give for the whole sound:
+					narrow the domain of the part to a whole number of resampled samples;
+					the samples of the part outside this domain still contribute to the resampled samples near its edges.
+				*/
+				long firstSample = (long) floor ((Sampled_indexToX (thee.get(), firstFrame) - x1) / dx) + 1 - halfnsamp_window - 3;
+				long lastSample = (long) floor ((Sampled_indexToX (thee.get(), lastFrame) - x1) / dx) + 1 + halfnsamp_window + 3;
+				if (firstSample < 1) firstSample = 1;
+				if (lastSample > nx) lastSample = nx;
+				part -> xmin = x1 + (firstSample - 1.5) * dx;
+				part -> xmax = x1 + (lastSample - 0.5) * dx;
+				sound = Sound_resample (part, samplingFrequency, 50);
+				Melder_assert (sound -> nx == lastSample - firstSample + 1);
+				sampleOffset = firstSample - 1;
+			} else {
+				sound = Data_copy (part);
+			}
+			Sound_preEmphasis (sound.get(), preemphasisFrequency);
+			Sound_into_Formant (sound.get(), x1, sampleOffset, thee.get(), firstFrame, lastFrame, numberOfPoles, nsamp_window, halfnsamp_window, which, safetyMargin);
+		});
+		Formant_sort (thee.get());
+		return thee;
+	} catch (MelderError) {
+		Melder_throw (me, U": formant analysis not performed.");
+	}
+}
+
 autoFormant Sound_to_Formant_burg (Sound me, double dt, double nFormants, double maximumFrequency, double halfdt_window, double preemphasisFrequency) {
 	try {
 		return Sound_to_Formant_any (me, dt, (int) (2 * nFormants), maximumFrequency, halfdt_window, 1, preemphasisFrequency, 50.0);
@@ -16,7 +16,7 @@
  * along with this work. If not, see <http://www.gnu.org/licenses/>.
  */
 
-#include "Sound.h"
+#include "LongSound.h"
 #include "Formant.h"
 
 autoFormant Sound_to_Formant_any (Sound me, double timeStep, int numberOfPoles, double maximumFrequency,
@@ -26,6 +26,13 @@ autoFormant Sound_to_Formant_any (Sound me, double timeStep, int numberOfPoles,
 	Which = 2: Split-Levinson
 */
 
+autoFormant LongSound_to_Formant_any (LongSound me, double timeStep, int numberOfPoles, double maximumFrequency,
+	double halfdt_window, int which, double preemphasisFrequency, double safetyMargin);
+/*
+	As Sound_to_Formant_any, but reads the sound file part by part, so that memory use does not grow with its duration.
+	Each part is resampled separately, onto the sample times of the resampled whole sound.
+*/
+
 autoFormant Sound_to_Formant_burg (Sound me, double timeStep, double maximumNumberOfFormants,
 	double maximumFormantFrequency, double windowLength, double preemphasisFrequency);
 /* Throws away all formants below 50 Hz and above Nyquist minus 50 Hz. */
@@ -32,8 +32,12 @@
  */
 
 #include "Sound_to_Intensity.h"
+#include "SampledAnalysis.h"
 
-static autoIntensity Sound_to_Intensity_ (Sound me, double minimumPitch, double timeStep, int subtractMeanPressure) {
+/*
+	'me' is a Sound or a LongSound.
+*/
+static autoIntensity Sound_to_Intensity_ (Sampled me, double minimumPitch, double timeStep, int subtractMeanPressure) {
 	try {
 		/*
 		 * Preconditions.
@@ -52,7 +56,6 @@ static autoIntensity Sound_to_Intensity_ (Sound me, double minimumPitch, double
 		Melder_assert (windowDuration > 0.0);
 		double halfWindowDuration = 0.5 * windowDuration;
 		long halfWindowSamples = (long) floor (halfWindowDuration / my dx);
-		autoNUMvector <double> amplitude (- halfWindowSamples, halfWindowSamples);
 		autoNUMvector <double> window (- halfWindowSamples, halfWindowSamples);
 
 		for (long i = - halfWindowSamples; i <= halfWindowSamples; i ++) {
@@ -69,37 +72,44 @@ static autoIntensity Sound_to_Intensity_ (Sound me, double minimumPitch, double
 				U"i.e. at least ", 6.4 / minimumPitch, U" s, instead of ", my xmax - my xmin, U" s.");
 		}
 		autoIntensity thee = Intensity_create (my xmin, my xmax, numberOfFrames, timeStep, thyFirstTime);
-		for (long iframe = 1; iframe <= numberOfFrames; iframe ++) {
-			double midTime = Sampled_indexToX (thee.get(), iframe);
-			long midSample = Sampled_xToNearestIndex (me, midTime);
-			long leftSample = midSample - halfWindowSamples, rightSample = midSample + halfWindowSamples;
-			double sumxw = 0.0, sumw = 0.0, intensity;
-			if (leftSample < 1) leftSample = 1;
-			if (rightSample > my nx) rightSample = my nx;
+		Sampled_analyseSoundInParts (me, thee.get(), halfWindowDuration + 2.0 * my dx, [&] (Sound part, long sampleOffset, long firstFrame, long lastFrame) {
+			Sampled_analyseFrames <autoNUMvector <double>> (thee.get(), firstFrame, lastFrame, 100,
+				[&] (autoNUMvector <double>& amplitude) {
+					amplitude.reset (- halfWindowSamples, halfWindowSamples);
+				},
+				[&] (autoNUMvector <double>& amplitude, long iframe) {
+					double midTime = Sampled_indexToX (thee.get(), iframe);
+					long midSample = Sampled_xToNearestIndex (me, midTime) - sampleOffset;
+					long leftSample = midSample - halfWindowSamples, rightSample = midSample + halfWindowSamples;
+					double sumxw = 0.0, sumw = 0.0, intensity;
+					if (leftSample < 1) leftSample = 1;
+					if (rightSample > part -> nx) rightSample = part -> nx;
 
-			for (long channel = 1; channel <= my ny; channel ++) {
-				for (long i = leftSample; i <= rightSample; i ++) {
-					amplitude [i - midSample] = my z [channel] [i];
-				}
-				if (subtractMeanPressure) {
-					double sum = 0.0;
-					for (long i = leftSample; i <= rightSample; i ++) {
-						sum += amplitude [i - midSample];
-					}
-					double mean = sum / (rightSample - leftSample + 1);
-					for (long i = leftSample; i <= rightSample; i ++) {
-						amplitude [i - midSample] -= mean;
+					for (long channel = 1; channel <= part -> ny; channel ++) {
+						for (long i = leftSample; i <= rightSample; i ++) {
+							amplitude [i - midSample] = part -> z [channel] [i];
+						}
+						if (subtractMeanPressure) {
+							double sum = 0.0;
+							for (long i = leftSample; i <= rightSample; i ++) {
+								sum += amplitude [i - midSample];
+							}
+							double mean = sum / (rightSample - leftSample + 1);
+							for (long i = leftSample; i <= rightSample; i ++) {
+								amplitude [i - midSample] -= mean;
+							}
+						}
+						for (long i = leftSample; i <= rightSample; i ++) {
+							sumxw += amplitude [i - midSample] * amplitude [i - midSample] * window [i - midSample];
+							sumw += window [i - midSample];
+						}
 					}
-				}
-				for (long i = leftSample; i <= rightSample; i ++) {
-					sumxw += amplitude [i - midSample] * amplitude [i - midSample] * window [i - midSample];
-					sumw += window [i - midSample];
-				}
-			}
-			intensity = sumxw / sumw;
-			intensity /= 4e-10;
-			thy z [1] [iframe] = intensity < 1e-30 ? -300 : 10 * log10 (intensity);
-		}
+					intensity = sumxw / sumw;
+					intensity /= 4e-10;
+					thy z [1] [iframe] = intensity < 1e-30 ? -300 : 10 * log10 (intensity);
+				},
+				nullptr);
+		});
 		return thee;
 	} catch (MelderError) {
 		Melder_throw (me, U": intensity analysis not performed.");
@@ -116,6 +126,10 @@ autoIntensity Sound_to_Intensity (Sound me, double minimumPitch, double timeStep
 	}
 }
 
+autoIntensity LongSound_to_Intensity (LongSound me, double minimumPitch, double timeStep, int subtractMeanPressure) {
+	return Sound_to_Intensity_ (me, minimumPitch, timeStep, subtractMeanPressure);
+}
+
 autoIntensityTier Sound_to_IntensityTier (Sound me, double minimumPitch, double timeStep, int subtractMean) {
 	try {
 		autoIntensity intensity = Sound_to_Intensity (me, minimumPitch, timeStep, subtractMean);
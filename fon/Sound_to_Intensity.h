@@ -16,7 +16,7 @@
  * along with this work. If not, see <http://www.gnu.org/licenses/>.
  */
 
-#include "Sound.h"
+#include "LongSound.h"
 #include "Intensity.h"
 #include "IntensityTier.h"
 
@@ -45,6 +45,11 @@ autoIntensity Sound_to_Intensity (Sound me, double minimumPitch, double timeStep
 		actual window duration = 64 ms;
 */
 
+autoIntensity LongSound_to_Intensity (LongSound me, double minimumPitch, double timeStep, int subtractMean);
+/*
+	As Sound_to_Intensity, but reads the sound file part by part, so that memory use does not grow with its duration.
+*/
+
 autoIntensityTier Sound_to_IntensityTier (Sound me, double minimumPitch, double timeStep, int subtractMean);
 
 /* End of file Sound_to_Intensity.h */
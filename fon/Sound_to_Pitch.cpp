@@ -34,14 +34,17 @@
 
 #include "Sound_to_Pitch.h"
 #include "NUM2.h"
-#include "MelderThread.h"
+#include "SampledAnalysis.h"
 
 #define AC_HANNING  0
 #define AC_GAUSS  1
 #define FCC_NORMAL  2
 #define FCC_ACCURATE  3
 
-static void Sound_into_PitchFrame (Sound me, Pitch_Frame pitchFrame, double t,
+/*
+	Sample i of 'me' is sample i + sampleOffset of the sound that has its first sample at time x1.
+*/
+static void Sound_into_PitchFrame (Sound me, double x1, long sampleOffset, Pitch_Frame pitchFrame, double t,
 	double minimumPitch, int maxnCandidates, int method, double voicingThreshold, double octaveCost,
 	NUMfft_Table fftTable, double dt_window, long nsamp_window, long halfnsamp_window,
 	long maximumLag, long nsampFFT, long nsamp_period, long halfnsamp_period,
@@ -50,7 +53,7 @@ static void Sound_into_PitchFrame (Sound me, Pitch_Frame pitchFrame, double t,
 	double *r, long *imax, double *localMean)
 {
 	double localPeak;
-	long leftSample = Sampled_xToLowIndex (me, t), rightSample = leftSample + 1;
+	long leftSample = (long) floor ((t - x1) / my dx + 1.0) - sampleOffset, rightSample = leftSample + 1;
 	long startSample, endSample;
 
 	for (long channel = 1; channel <= my ny; channel ++) {
@@ -106,7 +109,7 @@ static void Sound_into_PitchFrame (Sound me, Pitch_Frame pitchFrame, double t,
 	if (method >= FCC_NORMAL) {
 		double startTime = t - 0.5 * (1.0 / minimumPitch + dt_window);
 		long localSpan = maximumLag + nsamp_window, localMaximumLag, offset;
-		if ((startSample = Sampled_xToLowIndex (me, startTime)) < 1) startSample = 1;
+		if ((startSample = (long) floor ((startTime - x1) / my dx + 1.0) - sampleOffset) < 1) startSample = 1;
 		if (localSpan > my nx + 1 - startSample) localSpan = my nx + 1 - startSample;
 		localMaximumLag = localSpan - nsamp_window;
 		offset = startSample - 1;
@@ -242,105 +245,67 @@ static void Sound_into_PitchFrame (Sound me, Pitch_Frame pitchFrame, double t,
 	}
 }
 
-Thing_define (Sound_into_Pitch_Args, Thing) { public:
-	Sound sound;
-	Pitch pitch;
-	long firstFrame, lastFrame;
-	double minimumPitch;
-	int maxnCandidates, method;
-	double voicingThreshold, octaveCost, dt_window;
-	long nsamp_window, halfnsamp_window, maximumLag, nsampFFT, nsamp_period, halfnsamp_period, brent_ixmax, brent_depth;
-	double globalPeak, *window, *windowR;
-	bool isMainThread;
-	volatile int *cancelled;
-};
-
-Thing_implement (Sound_into_Pitch_Args, Thing, 0);
-
-static autoSound_into_Pitch_Args Sound_into_Pitch_Args_create (Sound sound, Pitch pitch,
-	long firstFrame, long lastFrame, double minimumPitch, int maxnCandidates, int method,
-	double voicingThreshold, double octaveCost,
-	double dt_window, long nsamp_window, long halfnsamp_window, long maximumLag, long nsampFFT,
-	long nsamp_period, long halfnsamp_period, long brent_ixmax, long brent_depth,
-	double globalPeak, double *window, double *windowR,
-	bool isMainThread, volatile int *cancelled)
-{
-	autoSound_into_Pitch_Args me = Thing_new (Sound_into_Pitch_Args);
-	my sound = sound;
-	my pitch = pitch;
-	my firstFrame = firstFrame;
-	my lastFrame = lastFrame;
-	my minimumPitch = minimumPitch;
-	my maxnCandidates = maxnCandidates;
-	my method = method;
-	my voicingThreshold = voicingThreshold;
-	my octaveCost = octaveCost;
-	my dt_window = dt_window;
-	my nsamp_window = nsamp_window;
-	my halfnsamp_window = halfnsamp_window;
-	my maximumLag = maximumLag;
-	my nsampFFT = nsampFFT;
-	my nsamp_period = nsamp_period;
-	my halfnsamp_period = halfnsamp_period;
-	my brent_ixmax = brent_ixmax;
-	my brent_depth = brent_depth;
-	my globalPeak = globalPeak;
-	my window = window;
-	my windowR = windowR;
-	my isMainThread = isMainThread;
-	my cancelled = cancelled;
-	return me;
-}
-
-MelderThread_MUTEX (mutex);
-bool mutex_inited;
-
-static MelderThread_RETURN_TYPE Sound_into_Pitch (Sound_into_Pitch_Args me)
-{
+struct Sound_into_Pitch_Workspace {
 	autoNUMfft_Table fftTable;
 	autoNUMmatrix <double> frame;
 	autoNUMvector <double> ac, r, localMean;
 	autoNUMvector <long> imax;
-	{// scope
-		MelderThread_LOCK (mutex);
-		if (my method >= FCC_NORMAL) {   // cross-correlation
-			frame.reset (1, my sound -> ny, 1, my nsamp_window);
-		} else {   // autocorrelation
-			NUMfft_Table_init (& fftTable, my nsampFFT);
-			frame.reset (1, my sound -> ny, 1, my nsampFFT);
-			ac.reset (1, my nsampFFT);
+};
+
+/*
+	The largest absolute deviation of any sample from the mean of its channel, for the silence threshold.
+	'me' is a Sound or a LongSound; a LongSound is read block by block.
+*/
+#define Sound_to_Pitch_PEAK_BLOCK_SIZE  65536
+
+static double Sampled_getGlobalPeak (Sampled me) {
+	double globalPeak = 0.0;
+	if (! Thing_isa (me, classLongSound)) {
+		Sound sound = static_cast <Sound> (me);
+		for (long channel = 1; channel <= sound -> ny; channel ++) {
+			double mean = 0.0;
+			for (long i = 1; i <= sound -> nx; i ++) {
+				mean += sound -> z [channel] [i];
+			}
+			mean /= sound -> nx;
+			for (long i = 1; i <= sound -> nx; i ++) {
+				double value = fabs (sound -> z [channel] [i] - mean);
+				if (value > globalPeak) globalPeak = value;
+			}
 		}
-		r.reset (- my nsamp_window, my nsamp_window);
-		imax.reset (1, my maxnCandidates);
-		localMean.reset (1, my sound -> ny);
-		MelderThread_UNLOCK (mutex);
+		return globalPeak;
 	}
-	for (long iframe = my firstFrame; iframe <= my lastFrame; iframe ++) {
-		Pitch_Frame pitchFrame = & my pitch -> frame [iframe];
-		double t = Sampled_indexToX (my pitch, iframe);
-		if (my isMainThread) {
-			try {
-				Melder_progress (0.1 + 0.8 * (iframe - my firstFrame) / (my lastFrame - my firstFrame),
-					U"Sound to Pitch: analysing ", my lastFrame, U" frames");
-			} catch (MelderError) {
-				*my cancelled = 1;
-				throw;
+	LongSound longSound = static_cast <LongSound> (me);
+	const long numberOfChannels = longSound -> numberOfChannels;
+	autoNUMvector <double> sum (1, numberOfChannels), minimum (1, numberOfChannels), maximum (1, numberOfChannels);
+	autoNUMmatrix <double> buffer (1, numberOfChannels, 1, Sound_to_Pitch_PEAK_BLOCK_SIZE);
+	for (long firstSample = 1; firstSample <= my nx; firstSample += Sound_to_Pitch_PEAK_BLOCK_SIZE) {
+		long numberOfSamples = my nx - firstSample + 1;
+		if (numberOfSamples > Sound_to_Pitch_PEAK_BLOCK_SIZE) numberOfSamples = Sound_to_Pitch_PEAK_BLOCK_SIZE;
+		LongSound_readAudioToFloat (longSound, buffer.peek(), firstSample, numberOfSamples);
+		for (long channel = 1; channel <= numberOfChannels; channel ++) {
+			if (firstSample == 1)
+				minimum [channel] = maximum [channel] = buffer [channel] [1];
+			for (long i = 1; i <= numberOfSamples; i ++) {
+				double value = buffer [channel] [i];
+				sum [channel] += value;
+				if (value < minimum [channel]) minimum [channel] = value;
+				if (value > maximum [channel]) maximum [channel] = value;
 			}
-		} else if (*my cancelled) {
-			MelderThread_RETURN;
 		}
-		Sound_into_PitchFrame (my sound, pitchFrame, t,
-			my minimumPitch, my maxnCandidates, my method, my voicingThreshold, my octaveCost,
-			& fftTable, my dt_window, my nsamp_window, my halfnsamp_window,
-			my maximumLag, my nsampFFT, my nsamp_period, my halfnsamp_period,
-			my brent_ixmax, my brent_depth, my globalPeak,
-			frame.peek(), ac.peek(), my window, my windowR,
-			r.peek(), imax.peek(), localMean.peek());
 	}
-	MelderThread_RETURN;
+	for (long channel = 1; channel <= numberOfChannels; channel ++) {
+		double mean = sum [channel] / my nx;
+		if (maximum [channel] - mean > globalPeak) globalPeak = maximum [channel] - mean;
+		if (mean - minimum [channel] > globalPeak) globalPeak = mean - minimum [channel];
+	}
+	return globalPeak;
 }
 
-autoPitch Sound_to_Pitch_any (Sound me,
+/*
+	'me' is a Sound or a LongSound.
+*/
+static autoPitch Sound_to_Pitch_any_ (Sampled me,
 	double dt, double minimumPitch, double periodsPerWindow, int maxnCandidates,
 	int method,
 	double silenceThreshold, double voicingThreshold,
@@ -444,18 +409,7 @@ autoPitch Sound_to_Pitch_any (Sound me,
 		/*
 		 * Compute the global absolute peak for determination of silence threshold.
 		 */
-		globalPeak = 0.0;
-		for (long channel = 1; channel <= my ny; channel ++) {
-			double mean = 0.0;
-			for (long i = 1; i <= my nx; i ++) {
-				mean += my z [channel] [i];
-			}
-			mean /= my nx;
-			for (long i = 1; i <= my nx; i ++) {
-				double value = fabs (my z [channel] [i] - mean);
-				if (value > globalPeak) globalPeak = value;
-			}
-		}
+		globalPeak = Sampled_getGlobalPeak (me);
 		if (globalPeak == 0.0) {
 			return thee;
 		}
@@ -519,32 +473,35 @@ autoPitch Sound_to_Pitch_any (Sound me,
 
 		autoMelderProgress progress (U"Sound to Pitch...");
 
-		long numberOfFramesPerThread = 20;
-		int numberOfThreads = (nFrames - 1) / numberOfFramesPerThread + 1;
-		const int numberOfProcessors = MelderThread_getNumberOfProcessors ();
-		trace (numberOfProcessors, U" processors");
-		if (numberOfThreads > numberOfProcessors) numberOfThreads = numberOfProcessors;
-		if (numberOfThreads > 16) numberOfThreads = 16;
-		if (numberOfThreads < 1) numberOfThreads = 1;
-		numberOfFramesPerThread = (nFrames - 1) / numberOfThreads + 1;
-
-		if (! mutex_inited) { MelderThread_MUTEX_INIT (mutex); mutex_inited = true; }
-		autoSound_into_Pitch_Args args [16];
-		long firstFrame = 1, lastFrame = numberOfFramesPerThread;
-		volatile int cancelled = 0;
-		for (int ithread = 1; ithread <= numberOfThreads; ithread ++) {
-			if (ithread == numberOfThreads) lastFrame = nFrames;
-			args [ithread - 1] = Sound_into_Pitch_Args_create (me, thee.get(),
-				firstFrame, lastFrame, minimumPitch, maxnCandidates, method,
-				voicingThreshold, octaveCost,
-				dt_window, nsamp_window, halfnsamp_window, maximumLag,
-				nsampFFT, nsamp_period, halfnsamp_period, brent_ixmax, brent_depth,
-				globalPeak, window.peek(), windowR.peek(),
-				ithread == numberOfThreads, & cancelled);
-			firstFrame = lastFrame + 1;
-			lastFrame += numberOfFramesPerThread;
-		}
-		MelderThread_run (Sound_into_Pitch, args, numberOfThreads);
+		/*
+			The frames need the samples within half a window, plus one longest period for the local mean
+			(the cross-correlation method reaches at most one longest period further).
+		*/
+		Sampled_analyseSoundInParts (me, thee.get(), dt_window + 2.0 / minimumPitch, [&] (Sound part, long sampleOffset, long firstFrame, long lastFrame) {
+			Sampled_analyseFrames <Sound_into_Pitch_Workspace> (thee.get(), firstFrame, lastFrame, 20,
+				[&] (Sound_into_Pitch_Workspace& workspace) {
+					if (method >= FCC_NORMAL) {   // cross-correlation
+						workspace. frame.reset (1, part -> ny, 1, nsamp_window);
+					} else {   // autocorrelation
+						NUMfft_Table_init (& workspace. fftTable, nsampFFT);
+						workspace. frame.reset (1, part -> ny, 1, nsampFFT);
+						workspace. ac.reset (1, nsampFFT);
+					}
+					workspace. r.reset (- nsamp_window, nsamp_window);
+					workspace. imax.reset (1, maxnCandidates);
+					workspace. localMean.reset (1, part -> ny);
+				},
+				[&] (Sound_into_Pitch_Workspace& workspace, long iframe) {
+					Sound_into_PitchFrame (part, my x1, sampleOffset, & thy frame [iframe], Sampled_indexToX (thee.get(), iframe),
+						minimumPitch, maxnCandidates, method, voicingThreshold, octaveCost,
+						& workspace. fftTable, dt_window, nsamp_window, halfnsamp_window,
+						maximumLag, nsampFFT, nsamp_period, halfnsamp_period,
+						brent_ixmax, brent_depth, globalPeak,
+						workspace. frame.peek(), workspace. ac.peek(), window.peek(), windowR.peek(),
+						workspace. r.peek(), workspace. imax.peek(), workspace. localMean.peek());
+				},
+				U"Sound to Pitch");
+		});
 
 		Melder_progress (0.95, U"Sound to Pitch: path finder");
 		Pitch_pathFinder (thee.get(), silenceThreshold, voicingThreshold,
@@ -556,6 +513,26 @@ autoPitch Sound_to_Pitch_any (Sound me,
 	}
 }
 
+autoPitch Sound_to_Pitch_any (Sound me,
+	double dt, double minimumPitch, double periodsPerWindow, int maxnCandidates,
+	int method,
+	double silenceThreshold, double voicingThreshold,
+	double octaveCost, double octaveJumpCost, double voicedUnvoicedCost, double ceiling)
+{
+	return Sound_to_Pitch_any_ (me, dt, minimumPitch, periodsPerWindow, maxnCandidates, method,
+		silenceThreshold, voicingThreshold, octaveCost, octaveJumpCost, voicedUnvoicedCost, ceiling);
+}
+
+autoPitch LongSound_to_Pitch_any (LongSound me,
+	double dt, double minimumPitch, double periodsPerWindow, int maxnCandidates,
+	int method,
+	double silenceThreshold, double voicingThreshold,
+	double octaveCost, double octaveJumpCost, double voicedUnvoicedCost, double ceiling)
+{
+	return Sound_to_Pitch_any_ (me, dt, minimumPitch, periodsPerWindow, maxnCandidates, method,
+		silenceThreshold, voicingThreshold, octaveCost, octaveJumpCost, voicedUnvoicedCost, ceiling);
+}
+
 autoPitch Sound_to_Pitch (Sound me, double timeStep, double minimumPitch, double maximumPitch) {
 	return Sound_to_Pitch_ac (me, timeStep, minimumPitch,
 		3.0, 15, false, 0.03, 0.45, 0.01, 0.35, 0.14, maximumPitch);
@@ -16,7 +16,7 @@
  * along with this work. If not, see <http://www.gnu.org/licenses/>.
  */
 
-#include "Sound.h"
+#include "LongSound.h"
 #include "Pitch.h"
 
 autoPitch Sound_to_Pitch (Sound me, double timeStep,
@@ -84,4 +84,13 @@ autoPitch Sound_to_Pitch_any (Sound me,
 		pitches above a certain value "voiceless".
 */
 
+autoPitch LongSound_to_Pitch_any (LongSound me, double dt, double minimumPitch, double periodsPerWindow, int maxnCandidates,
+	int method, double silenceThreshold, double voicingThreshold, double octaveCost, double octaveJumpCost,
+	double voicedUnvoicedCost, double maximumPitch);
+/*
+	As Sound_to_Pitch_any, but reads the sound file part by part, so that memory use does not grow with its duration
+	(apart from the memory of the resulting Pitch itself, which the path finder needs as a whole).
+	The result is the same as that of Sound_to_Pitch_any on the whole sound.
+*/
+
 /* End of file Sound_to_Pitch.h */
@@ -678,6 +678,7 @@ static void menu_cb_AlignInterval (TextGridEditor me, EDITOR_ARGS_DIRECT) {
 }
 
 static void menu_cb_AlignmentSettings (TextGridEditor me, EDITOR_ARGS_FORM) {
+	espeakdata_praat_init ();
 	EDITOR_FORM (U"Alignment settings", nullptr)
 		OPTIONMENU (U"Language", Strings_findString (espeakdata_voices_names.get(), U"English"))
 		for (long i = 1; i <= espeakdata_voices_names -> numberOfStrings; i ++) {
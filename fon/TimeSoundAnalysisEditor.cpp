@@ -131,6 +131,10 @@ void structTimeSoundAnalysisEditor :: v_reset_analysis () {
 	d_intensity. reset();
 	d_formant. reset();
 	d_pulses. reset();
+	d_spectrogramTiles. reset ();
+	d_intensityTiles. reset ();
+	d_formantTiles. reset ();
+	d_overview. reset();
 }
 
 enum {
@@ -1556,23 +1560,229 @@ void structTimeSoundAnalysisEditor :: v_createMenuItems_pulses_picture (EditorMe
 	EditorMenu_addCommand (menu, U"Draw visible pulses...", 0, menu_cb_drawVisiblePulses);
 }
 
+/********** ANALYSIS TILES **********/
+
+/*
+	What the tile cache has to know about an analysis:
+	how to compute it, how to create an empty one like it, and how to copy one frame.
+*/
+struct TimeSoundAnalysisEditor_TileType {
+	autoSampled (*analyse) (TimeSoundAnalysisEditor me, Sound sound, double timeStep);
+	autoSampled (*create) (Sampled prototype, double tmin, double tmax, long numberOfFrames, double timeStep, double firstTime);
+	void (*copyFrame) (Sampled from, long ifrom, Sampled to, long ito);
+};
+
+static autoSampled Matrix_createLike (Sampled prototype, double tmin, double tmax, long numberOfFrames, double timeStep, double firstTime) {
+	Matrix proto = static_cast <Matrix> (prototype);
+	autoMatrix thee = Thing_newFromClass (proto -> classInfo).static_cast_move <structMatrix> ();
+	Matrix_init (thee.get(), tmin, tmax, numberOfFrames, timeStep, firstTime, proto -> ymin, proto -> ymax, proto -> ny, proto -> dy, proto -> y1);
+	return thee.move();
+}
+
+static void Matrix_copyFrame (Sampled from, long ifrom, Sampled to, long ito) {
+	Matrix me = static_cast <Matrix> (from), thee = static_cast <Matrix> (to);
+	for (long iy = 1; iy <= my ny; iy ++)
+		thy z [iy] [ito] = my z [iy] [ifrom];
+}
+
+static autoSampled Formant_createLike (Sampled prototype, double tmin, double tmax, long numberOfFrames, double timeStep, double firstTime) {
+	return Formant_create (tmin, tmax, numberOfFrames, timeStep, firstTime, static_cast <Formant> (prototype) -> maxnFormants).move();
+}
+
+static void Formant_copyFrame (Sampled from, long ifrom, Sampled to, long ito) {
+	static_cast <Formant> (from) -> d_frames [ifrom]. copy (& static_cast <Formant> (to) -> d_frames [ito]);
+}
+
+static TimeSoundAnalysisEditor_Tile * TileCache_findTile (TimeSoundAnalysisEditor_TileCache *cache, double timeStep, long tileNumber) {
+	for (TimeSoundAnalysisEditor_Tile& tile : cache -> tiles)
+		if (tile. tileNumber == tileNumber && fabs (tile. timeStep - timeStep) <= 1e-9 * timeStep)
+			return & tile;
+	return nullptr;
+}
+
+/*
+	Analyse the tiles firstTile through lastTile (which are not yet in the cache) in one go,
+	and store the frames in the cache per tile.
+	The margin is half the duration of the analysis window.
+*/
+static void TileCache_computeTiles (TimeSoundAnalysisEditor me, TimeSoundAnalysisEditor_TileCache *cache,
+	const TimeSoundAnalysisEditor_TileType *type, double timeStep, double margin, long firstTile, long lastTile)
+{
+	const long framesPerTile = TimeSoundAnalysisEditor_NUMBER_OF_FRAMES_PER_TILE;
+	/*
+		An analysis centres its frames in the stretch of sound:
+		with n frames in a stretch of duration (n - 1 + 0.5) * timeStep + 2 * margin,
+		the first frame lies a quarter of a time step after tmin + margin.
+		Extending the stretch by 1.25 time steps on either side thus puts the frames on the grid,
+		and keeps the number of frames well away from a rounding boundary;
+		at the edges of the sound, the stretch can shrink only by whole time steps.
+	*/
+	Sampled sampled = my d_sound.data ? (Sampled) my d_sound.data : (Sampled) my d_longSound.data;
+	double tmin = (firstTile * framesPerTile - 1.25) * timeStep - margin;
+	double tmax = ((lastTile + 1) * framesPerTile - 1 + 1.25) * timeStep + margin;
+	if (tmin < sampled -> xmin)
+		tmin += ceil ((sampled -> xmin - tmin) / timeStep) * timeStep;
+	if (tmax > sampled -> xmax)
+		tmax -= ceil ((tmax - sampled -> xmax) / timeStep) * timeStep;
+	autoSampled analysis;
+	try {
+		autoSound sound = extractSound (me, tmin, tmax);
+		analysis = type -> analyse (me, sound.get(), timeStep);
+		if (analysis) {
+			/*
+				If the frames lie halfway between the grid points nevertheless
+				(the analysis window may be slightly longer than the margin suggests),
+				the same centre with one frame fewer puts them on the grid.
+			*/
+			double frameOffset = analysis -> x1 / timeStep - round (analysis -> x1 / timeStep);
+			if (fabs (frameOffset) > 0.25) {
+				sound = extractSound (me, tmin + 0.5 * timeStep, tmax - 0.5 * timeStep);
+				analysis = type -> analyse (me, sound.get(), timeStep);
+			}
+		}
+		if (analysis && fabs (analysis -> dx - timeStep) > 1e-9 * timeStep)
+			analysis.reset();   // the analysis chose a different time step; cannot happen if the caller predicts it correctly
+	} catch (MelderError) {
+		Melder_clearError ();
+		analysis.reset();
+	}
+	long firstFrameNumber = analysis ? lround (analysis -> x1 / timeStep) : 0;   // the grid number of frame 1
+	for (long itile = firstTile; itile <= lastTile; itile ++) {
+		TimeSoundAnalysisEditor_Tile tile;
+		tile. timeStep = timeStep;
+		tile. tileNumber = itile;
+		tile. lastUse = 0;
+		if (analysis) {
+			long ifirst = itile * framesPerTile - firstFrameNumber + 1, ilast = ifirst + framesPerTile - 1;
+			if (ifirst < 1) ifirst = 1;
+			if (ilast > analysis -> nx) ilast = analysis -> nx;
+			if (ifirst <= ilast) {
+				double firstTime = (firstFrameNumber + ifirst - 1) * timeStep;
+				tile. analysis = type -> create (analysis.get(), firstTime - 0.5 * timeStep, firstTime + (ilast - ifirst + 0.5) * timeStep,
+					ilast - ifirst + 1, timeStep, firstTime);
+				for (long iframe = ifirst; iframe <= ilast; iframe ++)
+					type -> copyFrame (analysis.get(), iframe, tile. analysis.get(), iframe - ifirst + 1);
+			}
+		}
+		cache -> tiles. push_back (std::move (tile));
+	}
+}
+
+/*
+	Assemble the analysis of the visible window from the cached tiles,
+	after analysing the tiles that are not in the cache yet.
+	The result contains one frame on either side of the window, as far as available,
+	so that drawings reach the edges of the window.
+*/
+static autoSampled TileCache_getWindow (TimeSoundAnalysisEditor me, TimeSoundAnalysisEditor_TileCache *cache,
+	const TimeSoundAnalysisEditor_TileType *type, const std::vector <double>& settings, double timeStep, double margin)
+{
+	const long framesPerTile = TimeSoundAnalysisEditor_NUMBER_OF_FRAMES_PER_TILE;
+	if (cache -> settings != settings) {
+		cache -> reset ();
+		cache -> settings = settings;
+	}
+	long firstFrameNumber = (long) floor (my startWindow / timeStep), lastFrameNumber = (long) ceil (my endWindow / timeStep);
+	long firstTile = (long) floor ((double) firstFrameNumber / framesPerTile), lastTile = (long) floor ((double) lastFrameNumber / framesPerTile);
+	for (long itile = firstTile; itile <= lastTile; itile ++) {
+		if (TileCache_findTile (cache, timeStep, itile))
+			continue;
+		long jtile = itile;
+		while (jtile < lastTile && ! TileCache_findTile (cache, timeStep, jtile + 1))
+			jtile ++;
+		TileCache_computeTiles (me, cache, type, timeStep, margin, itile, jtile);
+		itile = jtile;
+	}
+	/*
+		Collect the frames of the window; they should form a contiguous range.
+	*/
+	long firstAvailable = 0, lastAvailable = -1;
+	Sampled prototype = nullptr;
+	bool contiguous = true;
+	for (long itile = firstTile; itile <= lastTile; itile ++) {
+		TimeSoundAnalysisEditor_Tile *tile = TileCache_findTile (cache, timeStep, itile);
+		tile -> lastUse = ++ cache -> numberOfUses;
+		if (! tile -> analysis)
+			continue;
+		long tileFirst = lround (tile -> analysis -> x1 / timeStep), tileLast = tileFirst + tile -> analysis -> nx - 1;
+		if (tileFirst < firstFrameNumber) tileFirst = firstFrameNumber;
+		if (tileLast > lastFrameNumber) tileLast = lastFrameNumber;
+		if (tileFirst > tileLast)
+			continue;
+		if (! prototype) {
+			prototype = tile -> analysis.get();
+			firstAvailable = tileFirst;
+		} else if (tileFirst != lastAvailable + 1) {
+			contiguous = false;
+		}
+		lastAvailable = tileLast;
+	}
+	autoSampled result;
+	if (prototype && contiguous) {
+		result = type -> create (prototype, my startWindow, my endWindow, lastAvailable - firstAvailable + 1, timeStep, firstAvailable * timeStep);
+		for (long itile = firstTile; itile <= lastTile; itile ++) {
+			TimeSoundAnalysisEditor_Tile *tile = TileCache_findTile (cache, timeStep, itile);
+			if (! tile -> analysis)
+				continue;
+			long tileFirst = lround (tile -> analysis -> x1 / timeStep);
+			for (long iframe = 1; iframe <= tile -> analysis -> nx; iframe ++) {
+				long frameNumber = tileFirst + iframe - 1;
+				if (frameNumber >= firstAvailable && frameNumber <= lastAvailable)
+					type -> copyFrame (tile -> analysis.get(), iframe, result.get(), frameNumber - firstAvailable + 1);
+			}
+		}
+	}
+	/*
+		Forget the least recently used tiles.
+	*/
+	while (cache -> tiles. size () > TimeSoundAnalysisEditor_MAXIMUM_NUMBER_OF_TILES) {
+		auto oldest = cache -> tiles. begin ();
+		for (auto tile = cache -> tiles. begin (); tile != cache -> tiles. end (); ++ tile)
+			if (tile -> lastUse < oldest -> lastUse)
+				oldest = tile;
+		cache -> tiles. erase (oldest);
+	}
+	return result;
+}
+
+static autoSampled analyseSpectrogram (TimeSoundAnalysisEditor me, Sound sound, double timeStep) {
+	return Sound_to_Spectrogram (sound, my p_spectrogram_windowLength,
+		my p_spectrogram_viewTo, timeStep,
+		my p_spectrogram_viewTo / my p_spectrogram_frequencySteps, my p_spectrogram_windowShape, 8.0, 8.0).move();
+}
+
+static autoSampled analyseIntensity (TimeSoundAnalysisEditor me, Sound sound, double timeStep) {
+	return Sound_to_Intensity (sound, my p_pitch_floor, timeStep, my p_intensity_subtractMeanPressure).move();
+}
+
+static autoSampled analyseFormants (TimeSoundAnalysisEditor me, Sound sound, double timeStep) {
+	return Sound_to_Formant_any (sound, timeStep,
+		lround (my p_formant_numberOfFormants * 2), my p_formant_maximumFormant,
+		my p_formant_windowLength, my p_formant_method, my p_formant_preemphasisFrom, 50.0).move();
+}
+
+static const TimeSoundAnalysisEditor_TileType
+	theSpectrogramTileType { analyseSpectrogram, Matrix_createLike, Matrix_copyFrame },
+	theIntensityTileType { analyseIntensity, Matrix_createLike, Matrix_copyFrame },
+	theFormantTileType { analyseFormants, Formant_createLike, Formant_copyFrame };
+
 void TimeSoundAnalysisEditor_computeSpectrogram (TimeSoundAnalysisEditor me) {
 	autoMelderProgressOff progress;
 	if (my p_spectrogram_show && my endWindow - my startWindow <= my p_longestAnalysis &&
 		(! my d_spectrogram || my d_spectrogram -> xmin != my startWindow || my d_spectrogram -> xmax != my endWindow))
 	{
 		double margin = my p_spectrogram_windowShape == kSound_to_Spectrogram_windowShape_GAUSSIAN ? my p_spectrogram_windowLength : 0.5 * my p_spectrogram_windowLength;
+		/*
+			The time step depends on the view, but Sound_to_Spectrogram will not oversample by more than 8.
+		*/
+		double timeStep = (my endWindow - my startWindow) / my p_spectrogram_timeSteps;
+		double minimumTimeStep = my p_spectrogram_windowLength / sqrt (NUMpi) / 8.0;
+		if (timeStep < minimumTimeStep) timeStep = minimumTimeStep;
 		my d_spectrogram.reset();
-		try {
-			autoSound sound = extractSound (me, my startWindow - margin, my endWindow + margin);
-			my d_spectrogram = Sound_to_Spectrogram (sound.get(), my p_spectrogram_windowLength,
-				my p_spectrogram_viewTo, (my endWindow - my startWindow) / my p_spectrogram_timeSteps,
-				my p_spectrogram_viewTo / my p_spectrogram_frequencySteps, my p_spectrogram_windowShape, 8.0, 8.0);
-			my d_spectrogram -> xmin = my startWindow;
-			my d_spectrogram -> xmax = my endWindow;
-		} catch (MelderError) {
-			Melder_clearError ();
-		}
+		autoSampled spectrogram = TileCache_getWindow (me, & my d_spectrogramTiles, & theSpectrogramTileType,
+			{ my p_spectrogram_windowLength, my p_spectrogram_viewTo, (double) my p_spectrogram_frequencySteps, (double) my p_spectrogram_windowShape },
+			timeStep, margin);
+		my d_spectrogram = spectrogram.static_cast_move <structSpectrogram> ();
 	}
 }
 
@@ -1614,17 +1824,12 @@ void TimeSoundAnalysisEditor_computeIntensity (TimeSoundAnalysisEditor me) {
 		(! my d_intensity || my d_intensity -> xmin != my startWindow || my d_intensity -> xmax != my endWindow))
 	{
 		double margin = 3.2 / my p_pitch_floor;
+		double timeStep = 0.8 / my p_pitch_floor;   // the default of Sound_to_Intensity
 		my d_intensity. reset();
-		try {
-			autoSound sound = extractSound (me, my startWindow - margin, my endWindow + margin);
-			my d_intensity = Sound_to_Intensity (sound.get(), my p_pitch_floor,
-				my endWindow - my startWindow > my p_longestAnalysis ? (my endWindow - my startWindow) / 100 : 0.0,
-				my p_intensity_subtractMeanPressure);
-			my d_intensity -> xmin = my startWindow;
-			my d_intensity -> xmax = my endWindow;
-		} catch (MelderError) {
-			Melder_clearError ();
-		}
+		autoSampled intensity = TileCache_getWindow (me, & my d_intensityTiles, & theIntensityTileType,
+			{ my p_pitch_floor, (double) my p_intensity_subtractMeanPressure },
+			timeStep, margin);
+		my d_intensity = intensity.static_cast_move <structIntensity> ();
 	}
 }
 
@@ -1633,27 +1838,21 @@ void TimeSoundAnalysisEditor_computeFormants (TimeSoundAnalysisEditor me) {
 	if (my p_formant_show && my endWindow - my startWindow <= my p_longestAnalysis &&
 		(! my d_formant || my d_formant -> xmin != my startWindow || my d_formant -> xmax != my endWindow))
 	{
-		double margin = my p_formant_windowLength;
+		/*
+			Besides the analysis window, the margin contains the 50 samples
+			that Sound_resample needs at either edge of the stretch.
+		*/
+		double margin = my p_formant_windowLength + 50.0 / (2.0 * my p_formant_maximumFormant);
+		double formantTimeStep =
+			my p_timeStepStrategy == kTimeSoundAnalysisEditor_timeStepStrategy_FIXED ? my p_fixedTimeStep :
+			my p_timeStepStrategy == kTimeSoundAnalysisEditor_timeStepStrategy_VIEW_DEPENDENT ? (my endWindow - my startWindow) / my p_numberOfTimeStepsPerView :
+			my p_formant_windowLength / 4.0;   // the default of Sound_to_Formant_any
 		my d_formant. reset();
-		try {
-			autoSound sound =
-				my endWindow - my startWindow > my p_longestAnalysis ?
-					extractSound (me,
-						0.5 * (my startWindow + my endWindow - my p_longestAnalysis) - margin,
-						0.5 * (my startWindow + my endWindow + my p_longestAnalysis) + margin) :
-					extractSound (me, my startWindow - margin, my endWindow + margin);
-			double formantTimeStep =
-				my p_timeStepStrategy == kTimeSoundAnalysisEditor_timeStepStrategy_FIXED ? my p_fixedTimeStep :
-				my p_timeStepStrategy == kTimeSoundAnalysisEditor_timeStepStrategy_VIEW_DEPENDENT ? (my endWindow - my startWindow) / my p_numberOfTimeStepsPerView :
-				0.0;   // the default: determined by analysis window length
-			my d_formant = Sound_to_Formant_any (sound.get(), formantTimeStep,
-				lround (my p_formant_numberOfFormants * 2), my p_formant_maximumFormant,
-				my p_formant_windowLength, my p_formant_method, my p_formant_preemphasisFrom, 50.0);
-			my d_formant -> xmin = my startWindow;
-			my d_formant -> xmax = my endWindow;
-		} catch (MelderError) {
-			Melder_clearError ();
-		}
+		autoSampled formant = TileCache_getWindow (me, & my d_formantTiles, & theFormantTileType,
+			{ my p_formant_numberOfFormants, my p_formant_maximumFormant, my p_formant_windowLength,
+			  (double) my p_formant_method, my p_formant_preemphasisFrom },
+			formantTimeStep, margin);
+		my d_formant = formant.static_cast_move <structFormant> ();
 	}
 }
 
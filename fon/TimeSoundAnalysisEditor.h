@@ -24,9 +24,37 @@
 #include "Intensity.h"
 #include "Formant.h"
 #include "PointProcess.h"
+#include <vector>
 
 #include "TimeSoundAnalysisEditor_enums.h"
 
+/*
+	The spectrogram, intensity and formant analyses are kept in tiles of frames on a fixed time grid
+	(frame k at time k * timeStep), so that scrolling, or zooming with an unchanged time step,
+	analyses only those parts of the sound that have not been visible before.
+	The pitch analysis is not tiled, because its path finder and its silence threshold
+	depend on the whole analysed stretch of sound.
+*/
+#define TimeSoundAnalysisEditor_NUMBER_OF_FRAMES_PER_TILE  64
+#define TimeSoundAnalysisEditor_MAXIMUM_NUMBER_OF_TILES  128
+
+struct TimeSoundAnalysisEditor_Tile {
+	double timeStep;
+	long tileNumber;   // the tile holds the frames k with k / NUMBER_OF_FRAMES_PER_TILE == tileNumber
+	autoSampled analysis;   // those frames of the tile that could be analysed, or null
+	long lastUse;
+};
+
+struct TimeSoundAnalysisEditor_TileCache {
+	std::vector <double> settings;   // all analysis settings except the time step; a change discards all tiles
+	std::vector <TimeSoundAnalysisEditor_Tile> tiles;
+	long numberOfUses;
+	void reset () {
+		settings. clear ();
+		tiles. clear ();
+	}
+};
+
 Thing_define (TimeSoundAnalysisEditor, TimeSoundEditor) {
 	autoSpectrogram d_spectrogram;
 	double d_spectrogram_cursor;
@@ -34,6 +62,7 @@ Thing_define (TimeSoundAnalysisEditor, TimeSoundEditor) {
 	autoIntensity d_intensity;
 	autoFormant d_formant;
 	autoPointProcess d_pulses;
+	TimeSoundAnalysisEditor_TileCache d_spectrogramTiles, d_intensityTiles, d_formantTiles;
 	GuiMenuItem spectrogramToggle, pitchToggle, intensityToggle, formantToggle, pulsesToggle;
 
 	void v_destroy () noexcept
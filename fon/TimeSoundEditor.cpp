@@ -50,6 +50,11 @@ void structTimeSoundEditor :: v_info () {
 	MelderInfo_writeLine (U"Sound scaling strategy: ", kTimeSoundEditor_scalingStrategy_getText (p_sound_scalingStrategy));
 }
 
+void structTimeSoundEditor :: v_dataChanged () {
+	our d_overview.reset();
+	TimeSoundEditor_Parent :: v_dataChanged ();
+}
+
 /***** FILE MENU *****/
 
 static void menu_cb_DrawVisibleSound (TimeSoundEditor me, EDITOR_ARGS_FORM) {
@@ -454,6 +459,38 @@ void structTimeSoundEditor :: v_updateMenuItems_file () {
 	GuiThing_setSensitive (writeFlacButton, selectedSamples != 0);
 }
 
+/*
+	Above this number of samples per pixel, the sound is drawn from its overview (a SoundPyramid),
+	whose resolution is a block of SoundPyramid_BASE_BLOCK_SIZE samples.
+*/
+#define TimeSoundEditor_OVERVIEW_SAMPLES_PER_PIXEL  (4 * SoundPyramid_BASE_BLOCK_SIZE)
+
+/*
+	Make sure that the overview is complete, if possible within the time budget;
+	the in-memory Sound is summarized at once, the LongSound a bit at every redraw.
+*/
+static bool TimeSoundEditor_haveOverview (TimeSoundEditor me) {
+	Sound sound = my d_sound.data;
+	LongSound longSound = my d_longSound.data;
+	Sampled sampled = sound ? (Sampled) sound : (Sampled) longSound;
+	if (! my d_overview || my d_overview -> numberOfSamples != sampled -> nx || my d_overview -> x1 != sampled -> x1)
+		my d_overview = SoundPyramid_create (sound ? sound -> ny : longSound -> numberOfChannels, sampled -> nx, sampled -> x1, sampled -> dx);
+	if (sound)
+		return SoundPyramid_extendFromSound (my d_overview.get(), sound, 1e308);
+	return SoundPyramid_extendFromLongSound (my d_overview.get(), longSound, 0.1);
+}
+
+static void TimeSoundEditor_getWindowExtrema (TimeSoundEditor me, bool useOverview, long first, long last, int channel,
+	double *minimum, double *maximum)
+{
+	if (useOverview)
+		SoundPyramid_getExtrema (my d_overview.get(), channel, first, last, minimum, maximum);
+	else if (my d_longSound.data)
+		LongSound_getWindowExtrema (my d_longSound.data, my startWindow, my endWindow, channel, minimum, maximum);
+	else
+		Matrix_getWindowExtrema (my d_sound.data, first, last, channel, channel, minimum, maximum);
+}
+
 void TimeSoundEditor_drawSound (TimeSoundEditor me, double globalMinimum, double globalMaximum) {
 	Sound sound = my d_sound.data;
 	LongSound longSound = my d_longSound.data;
@@ -461,28 +498,44 @@ void TimeSoundEditor_drawSound (TimeSoundEditor me, double globalMinimum, double
 	int nchan = sound ? sound -> ny : longSound -> numberOfChannels;
 	bool cursorVisible = my startSelection == my endSelection && my startSelection >= my startWindow && my startSelection <= my endWindow;
 	Graphics_setColour (my graphics.get(), Graphics_BLACK);
+	long first, last;
+	if (Sampled_getWindowSamples (sound ? (Sampled) sound : (Sampled) longSound, my startWindow, my endWindow, & first, & last) <= 1) {
+		Graphics_setWindow (my graphics.get(), 0.0, 1.0, 0.0, 1.0);
+		Graphics_setTextAlignment (my graphics.get(), Graphics_CENTRE, Graphics_HALF);
+		Graphics_text (my graphics.get(), 0.5, 0.5, U"(zoom out to see the data)");
+		return;
+	}
+	/*
+		A zoomed-out window is drawn from the overview, in a time proportional to its width in pixels.
+		For a LongSound, this is also the only way to draw a window that does not fit in the buffer;
+		until the overview is complete, such a window shows the progress, and asks to be redrawn.
+	*/
+	Graphics_setWindow (my graphics.get(), my startWindow, my endWindow, 0.0, 1.0);
+	long x1DC, x2DC, yDC;
+	Graphics_WCtoDC (my graphics.get(), my startWindow, 0.0, & x1DC, & yDC);
+	Graphics_WCtoDC (my graphics.get(), my endWindow, 0.0, & x2DC, & yDC);
+	bool useOverview = last - first + 1 > TimeSoundEditor_OVERVIEW_SAMPLES_PER_PIXEL * (labs (x2DC - x1DC) + 1);
 	bool fits;
 	try {
 		fits = sound ? true : LongSound_haveWindow (longSound, my startWindow, my endWindow);
+		if (useOverview || ! fits)
+			useOverview = TimeSoundEditor_haveOverview (me);
 	} catch (MelderError) {
 		bool outOfMemory = !! str32str (Melder_getError (), U"memory");
 		if (Melder_debug == 9) Melder_flushError (); else Melder_clearError ();
+		my d_overview.reset();
 		Graphics_setWindow (my graphics.get(), 0.0, 1.0, 0.0, 1.0);
 		Graphics_setTextAlignment (my graphics.get(), Graphics_CENTRE, Graphics_HALF);
 		Graphics_text (my graphics.get(), 0.5, 0.5, outOfMemory ? U"(out of memory)" : U"(cannot read sound file)");
 		return;
 	}
-	if (! fits) {
+	if (my d_overview && ! SoundPyramid_isComplete (my d_overview.get()))
+		Graphics_updateWs (my graphics.get());   // continue the overview at the next redraw
+	if (! fits && ! useOverview) {
 		Graphics_setWindow (my graphics.get(), 0.0, 1.0, 0.0, 1.0);
 		Graphics_setTextAlignment (my graphics.get(), Graphics_CENTRE, Graphics_HALF);
-		Graphics_text (my graphics.get(), 0.5, 0.5, U"(window too large; zoom in to see the data)");
-		return;
-	}
-	long first, last;
-	if (Sampled_getWindowSamples (sound ? (Sampled) sound : (Sampled) longSound, my startWindow, my endWindow, & first, & last) <= 1) {
-		Graphics_setWindow (my graphics.get(), 0.0, 1.0, 0.0, 1.0);
-		Graphics_setTextAlignment (my graphics.get(), Graphics_CENTRE, Graphics_HALF);
-		Graphics_text (my graphics.get(), 0.5, 0.5, U"(zoom out to see the data)");
+		Graphics_text (my graphics.get(), 0.5, 0.5, U"(computing overview: ",
+			(long) floor (100.0 * SoundPyramid_getFractionDone (my d_overview.get())), U"%)");
 		return;
 	}
 	const int numberOfVisibleChannels = nchan > 8 ? 8 : nchan;
@@ -491,16 +544,10 @@ void TimeSoundEditor_drawSound (TimeSoundEditor me, double globalMinimum, double
 	if (lastVisibleChannel > nchan) lastVisibleChannel = nchan;
 	double maximumExtent = 0.0, visibleMinimum = 0.0, visibleMaximum = 0.0;
 	if (my p_sound_scalingStrategy == kTimeSoundEditor_scalingStrategy_BY_WINDOW) {
-		if (longSound)
-			LongSound_getWindowExtrema (longSound, my startWindow, my endWindow, firstVisibleChannel, & visibleMinimum, & visibleMaximum);
-		else
-			Matrix_getWindowExtrema (sound, first, last, firstVisibleChannel, firstVisibleChannel, & visibleMinimum, & visibleMaximum);
+		TimeSoundEditor_getWindowExtrema (me, useOverview, first, last, firstVisibleChannel, & visibleMinimum, & visibleMaximum);
 		for (int ichan = firstVisibleChannel + 1; ichan <= lastVisibleChannel; ichan ++) {
 			double visibleChannelMinimum, visibleChannelMaximum;
-			if (longSound)
-				LongSound_getWindowExtrema (longSound, my startWindow, my endWindow, ichan, & visibleChannelMinimum, & visibleChannelMaximum);
-			else
-				Matrix_getWindowExtrema (sound, first, last, ichan, ichan, & visibleChannelMinimum, & visibleChannelMaximum);
+			TimeSoundEditor_getWindowExtrema (me, useOverview, first, last, ichan, & visibleChannelMinimum, & visibleChannelMaximum);
 			if (visibleChannelMinimum < visibleMinimum)
 				visibleMinimum = visibleChannelMinimum;
 			if (visibleChannelMaximum > visibleMaximum)
@@ -521,11 +568,7 @@ void TimeSoundEditor_drawSound (TimeSoundEditor me, double globalMinimum, double
 		double minimum = sound ? globalMinimum : -1.0, maximum = sound ? globalMaximum : 1.0;
 		if (my p_sound_scalingStrategy == kTimeSoundEditor_scalingStrategy_BY_WINDOW) {
 			if (nchan > 2) {
-				if (longSound) {
-					LongSound_getWindowExtrema (longSound, my startWindow, my endWindow, ichan, & minimum, & maximum);
-				} else {
-					Matrix_getWindowExtrema (sound, first, last, ichan, ichan, & minimum, & maximum);
-				}
+				TimeSoundEditor_getWindowExtrema (me, useOverview, first, last, ichan, & minimum, & maximum);
 				if (maximumExtent > 0.0) {
 					double middle = 0.5 * (minimum + maximum);
 					minimum = middle - 0.5 * maximumExtent;
@@ -536,17 +579,9 @@ void TimeSoundEditor_drawSound (TimeSoundEditor me, double globalMinimum, double
 				maximum = visibleMaximum;
 			}
 		} else if (my p_sound_scalingStrategy == kTimeSoundEditor_scalingStrategy_BY_WINDOW_AND_CHANNEL) {
-			if (longSound) {
-				LongSound_getWindowExtrema (longSound, my startWindow, my endWindow, ichan, & minimum, & maximum);
-			} else {
-				Matrix_getWindowExtrema (sound, first, last, ichan, ichan, & minimum, & maximum);
-			}
+			TimeSoundEditor_getWindowExtrema (me, useOverview, first, last, ichan, & minimum, & maximum);
 		} else if (my p_sound_scalingStrategy == kTimeSoundEditor_scalingStrategy_FIXED_HEIGHT) {
-			if (longSound) {
-				LongSound_getWindowExtrema (longSound, my startWindow, my endWindow, ichan, & minimum, & maximum);
-			} else {
-				Matrix_getWindowExtrema (sound, first, last, ichan, ichan, & minimum, & maximum);
-			}
+			TimeSoundEditor_getWindowExtrema (me, useOverview, first, last, ichan, & minimum, & maximum);
 			double channelExtent = my p_sound_scaling_height;
 			double middle = 0.5 * (minimum + maximum);
 			minimum = middle - 0.5 * channelExtent;
@@ -628,8 +663,14 @@ void TimeSoundEditor_drawSound (TimeSoundEditor me, double globalMinimum, double
 			if (cursorVisible && NUMdefined (cursorFunctionValue))
 				FunctionEditor_drawCursorFunctionValue (me, cursorFunctionValue, Melder_float (Melder_half (cursorFunctionValue)), U"");
 			Graphics_setColour (my graphics.get(), Graphics_BLACK);
-			Graphics_function (my graphics.get(), sound -> z [ichan], first, last,
-				Sampled_indexToX (sound, first), Sampled_indexToX (sound, last));
+			if (useOverview)
+				SoundPyramid_draw (my d_overview.get(), my graphics.get(), ichan, my startWindow, my endWindow);
+			else
+				Graphics_function (my graphics.get(), sound -> z [ichan], first, last,
+					Sampled_indexToX (sound, first), Sampled_indexToX (sound, last));
+		} else if (useOverview) {
+			Graphics_setWindow (my graphics.get(), my startWindow, my endWindow, minimum, maximum);
+			SoundPyramid_draw (my d_overview.get(), my graphics.get(), ichan, my startWindow, my endWindow);
 		} else {
 			Graphics_setWindow (my graphics.get(), my startWindow, my endWindow, minimum * 32768, maximum * 32768);
 			Graphics_function16 (my graphics.get(),
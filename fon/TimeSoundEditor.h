@@ -21,6 +21,7 @@
 #include "FunctionEditor.h"
 #include "Sound.h"
 #include "LongSound.h"
+#include "SoundPyramid.h"
 
 #include "TimeSoundEditor_enums.h"
 
@@ -35,6 +36,7 @@ Thing_define (TimeSoundEditor, FunctionEditor) {
 	bool d_ownSound;
 	struct TimeSoundEditor_sound d_sound;
 	struct { LongSound data; } d_longSound;
+	autoSoundPyramid d_overview;   // for drawing zoomed-out windows; filled on demand, discarded when the data change
 	GuiMenuItem drawButton, publishButton, publishPreserveButton, publishWindowButton, publishOverlapButton;
 	GuiMenuItem writeAiffButton, d_saveAs24BitWavButton, d_saveAs32BitWavButton, writeAifcButton, writeWavButton, writeNextSunButton, writeNistButton, writeFlacButton;
 
@@ -42,6 +44,8 @@ Thing_define (TimeSoundEditor, FunctionEditor) {
 		override;
 	void v_info ()
 		override;
+	void v_dataChanged ()
+		override;
 	void v_createMenuItems_file (EditorMenu menu)
 		override;
 	void v_createMenuItems_query_info (EditorMenu menu)
@@ -3348,6 +3348,14 @@ TAG (U"##--no-pref-files#")
 DEFINITION (U"Ignore the preferences file and the buttons file at start-up, and don't write them when quitting (see above).")
 TAG (U"##--no-plugins#")
 DEFINITION (U"Don't activate the plugins at start-up.")
+TAG (U"##--parallel-objects#")
+DEFINITION (U"When a command such as ##To Pitch...# is applied to many selected objects, "
+	"analyse several of these objects at the same time, one per processor. "
+	"The new objects appear in the list in the same order as without this option.")
+TAG (U"##--startup-times#")
+DEFINITION (U"Before running the script, write to stderr how many milliseconds each stage of starting up Praat took, "
+	"such as the initialization of each library, reading the preferences, and running the start-up files. "
+	"The manual pages and the speech synthesis data are not created at start-up, but only when they are first needed.")
 TAG (U"##--pref-dir=#/var/www/praat_plugins")
 DEFINITION (U"Set the preferences directory to /var/www/praat_plugins (for instance). "
 	"This can come in handy if you require access to preference files and/or plugins that are not in your home directory.")
@@ -956,8 +956,8 @@ NORMAL (U"where \\De%t is the sampling period of the sound. Every sample %x__%i_
 FORMULA (U"%x__%i_ = %x__%i_ - %\\al %x__%i-1_")
 MAN_END
 
-MAN_BEGIN (U"Sound: Resample...", U"ppgb", 20040330)
-INTRO (U"A command that creates new @Sound objects from the selected Sounds.")
+MAN_BEGIN (U"Sound: Resample...", U"ppgb", 20161017)
+INTRO (U"A command that creates new @Sound objects from the selected Sounds (or @LongSound objects).")
 ENTRY (U"Purpose")
 NORMAL (U"High-precision resampling from any sampling frequency to any other sampling frequency.")
 ENTRY (U"Settings")
@@ -973,7 +973,12 @@ NORMAL (U"If #Precision is greater than 1, the method is sin(%x)/%x (\"%sinc\")
 	"with a depth equal to #Precision. "
 	"For higher #Precision, the algorithm is slower but more accurate.")
 NORMAL (U"If ##Sampling frequency# is less than the sampling frequency of the selected sound, "
-	"an anti-aliasing low-pass filtering is performed prior to resampling.")
+	"the sinc function is widened into an anti-aliasing low-pass filter at the new Nyquist frequency, "
+	"with a depth of #Precision zero crossings (at least 10) on either side.")
+NORMAL (U"Every new sample depends only on the old samples around it, so the sound is resampled in blocks, "
+	"using a limited amount of memory and all the processors of your computer. "
+	"For a LongSound, the file is read piece by piece, so that recordings of several hours can be resampled "
+	"without reading them into memory first.")
 ENTRY (U"Behaviour")
 NORMAL (U"A new Sound will appear in the list of objects, "
 	"bearing the same name as the original Sound, followed by the sampling frequency. "
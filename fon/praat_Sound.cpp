@@ -60,6 +60,16 @@ DO
 	CONVERT_EACH_END (my name)
 }
 
+FORM (NEW_LongSound_resample, U"LongSound: Resample", U"Sound: Resample...") {
+	POSITIVE4 (newSamplingFrequency, U"New sampling frequency (Hz)", U"10000.0")
+	NATURAL4 (precision, U"Precision (samples)", U"50")
+	OK
+DO
+	CONVERT_EACH (LongSound)
+		autoSound result = LongSound_resample (me, newSamplingFrequency, precision);
+	CONVERT_EACH_END (my name, U"_", lround (newSamplingFrequency));
+}
+
 FORM (REAL_LongSound_getIndexFromTime, U"LongSound: Get sample index from time", U"Sound: Get index from time...") {
 	REAL4 (time, U"Time (s)", U"0.5")
 	OK
@@ -156,6 +166,59 @@ DO
 	CONVERT_EACH_END (my name)
 }
 
+FORM (NEW_LongSound_to_Formant_burg, U"LongSound: To Formant (Burg method)", U"Sound: To Formant (burg)...") {
+	REAL4 (timeStep, U"Time step (s)", U"0.0 (= auto)")
+	POSITIVE4 (maximumNumberOfFormants, U"Max. number of formants", U"5.0")
+	REAL4 (maximumFormant, U"Maximum formant (Hz)", U"5500.0 (= adult female)")
+	POSITIVE4 (windowLength, U"Window length (s)", U"0.025")
+	POSITIVE4 (preEmphasisFrom, U"Pre-emphasis from (Hz)", U"50.0")
+	OK
+DO
+	CONVERT_EACH (LongSound)
+		autoFormant result = LongSound_to_Formant_any (me, timeStep,
+			(int) (2 * maximumNumberOfFormants), maximumFormant, windowLength, 1, preEmphasisFrom, 50.0);
+	CONVERT_EACH_END (my name)
+}
+
+FORM (NEW_LongSound_to_Intensity, U"LongSound: To Intensity", U"Sound: To Intensity...") {
+	POSITIVE4 (minimumPitch, U"Minimum pitch (Hz)", U"100.0")
+	REAL4 (timeStep, U"Time step (s)", U"0.0 (= auto)")
+	BOOLEAN4 (subtractMean, U"Subtract mean", true)
+	OK
+DO
+	CONVERT_EACH (LongSound)
+		autoIntensity result = LongSound_to_Intensity (me,
+			minimumPitch, timeStep, subtractMean);
+	CONVERT_EACH_END (my name)
+}
+
+FORM (NEW_LongSound_to_Pitch, U"LongSound: To Pitch", U"Sound: To Pitch...") {
+	REAL4 (timeStep, U"Time step (s)", U"0.0 (= auto)")
+	POSITIVE4 (pitchFloor, U"Pitch floor (Hz)", U"75.0")
+	POSITIVE4 (pitchCeiling, U"Pitch ceiling (Hz)", U"600.0")
+	OK
+DO
+	CONVERT_EACH (LongSound)
+		autoPitch result = LongSound_to_Pitch_any (me, timeStep, pitchFloor,
+			3.0, 15, 0, 0.03, 0.45, 0.01, 0.35, 0.14, pitchCeiling);   // the defaults of Sound_to_Pitch
+	CONVERT_EACH_END (my name)
+}
+
+FORM (NEW_LongSound_to_Spectrogram, U"LongSound: To Spectrogram", U"Sound: To Spectrogram...") {
+	POSITIVE4 (windowLength, U"Window length (s)", U"0.005")
+	POSITIVE4 (maximumFrequency, U"Maximum frequency (Hz)", U"5000.0")
+	POSITIVE4 (timeStep, U"Time step (s)", U"0.002")
+	POSITIVE4 (frequencyStep, U"Frequency step (Hz)", U"20.0")
+	RADIO_ENUM4 (windowShape, U"Window shape", kSound_to_Spectrogram_windowShape, DEFAULT)
+	OK
+DO
+	CONVERT_EACH (LongSound)
+		autoSpectrogram result = LongSound_to_Spectrogram (me, windowLength,
+			maximumFrequency, timeStep,
+			frequencyStep, (kSound_to_Spectrogram_windowShape) windowShape, 8.0, 8.0);
+	CONVERT_EACH_END (my name)
+}
+
 DIRECT (WINDOW_LongSound_view) {
 	if (theCurrentPraatApplication -> batch) Melder_throw (U"Cannot view or edit a LongSound from batch.");
 	LOOP {
@@ -757,6 +820,15 @@ DO
 	CONVERT_EACH_END (my name, U"_filt")
 }
 
+FORM (NEW_Sound_filter_gammatoneFilterbank, U"Sound: Filter (gammatone filterbank)", nullptr) {
+	POSITIVE4 (frequencyResolution, U"Frequency resolution (Bark)", U"1.0")
+	OK
+DO
+	CONVERT_EACH (Sound)
+		autoSound result = Sound_filterByGammatoneFilterbank (me, frequencyResolution);
+	CONVERT_EACH_END (my name, U"_gammatone")
+}
+
 FORM (NEW_Sound_filter_oneFormant, U"Sound: Filter (one formant)", U"Sound: Filter (one formant)...") {
 	REAL4 (frequency, U"Frequency (Hz)", U"1000.0")
 	POSITIVE4 (bandwidth, U"Bandwidth (Hz)", U"100.0")
@@ -1330,9 +1402,9 @@ FORM (NEW_Sound_resample, U"Sound: Resample", U"Sound: Resample...") {
 	NATURAL4 (precision, U"Precision (samples)", U"50")
 	OK
 DO
-	CONVERT_EACH (Sound)
+	CONVERT_EACH_PARALLEL (Sound)
 		autoSound result = Sound_resample (me, newSamplingFrequency, precision);
-	CONVERT_EACH_END (my name, U"_", lround (newSamplingFrequency));
+	CONVERT_EACH_PARALLEL_END (my name, U"_", lround (newSamplingFrequency));
 }
 
 DIRECT (MODIFY_Sound_reverse) {
@@ -1465,6 +1537,16 @@ DO
 	CONVERT_EACH_END (my name)
 }
 
+FORM (NEW_Sound_to_Cochleagram_gammatone, U"Sound: To Cochleagram (gammatone)", nullptr) {
+	POSITIVE4 (timeStep, U"Time step (s)", U"0.01")
+	POSITIVE4 (frequencyResolution, U"Frequency resolution (Bark)", U"0.1")
+	OK
+DO
+	CONVERT_EACH (Sound)
+		autoCochleagram result = Sound_to_Cochleagram_gammatone (me, timeStep, frequencyResolution);
+	CONVERT_EACH_END (my name)
+}
+
 FORM (NEW_Sound_to_Formant_burg, U"Sound: To Formant (Burg method)", U"Sound: To Formant (burg)...") {
 	REAL4 (timeStep, U"Time step (s)", U"0.0 (= auto)")
 	POSITIVE4 (maximumNumberOfFormants, U"Max. number of formants", U"5.0")
@@ -1473,10 +1555,10 @@ FORM (NEW_Sound_to_Formant_burg, U"Sound: To Formant (Burg method)", U"Sound: To
 	POSITIVE4 (preEmphasisFrom, U"Pre-emphasis from (Hz)", U"50.0")
 	OK
 DO
-	CONVERT_EACH (Sound)
+	CONVERT_EACH_PARALLEL (Sound)
 		autoFormant result = Sound_to_Formant_burg (me, timeStep,
 			maximumNumberOfFormants, maximumFormant, windowLength, preEmphasisFrom);
-	CONVERT_EACH_END (my name)
+	CONVERT_EACH_PARALLEL_END (my name)
 }
 
 FORM (NEW_Sound_to_Formant_keepAll, U"Sound: To Formant (keep all)", U"Sound: To Formant (keep all)...") {
@@ -1487,10 +1569,10 @@ FORM (NEW_Sound_to_Formant_keepAll, U"Sound: To Formant (keep all)", U"Sound: To
 	POSITIVE4 (preEmphasisFrom, U"Pre-emphasis from (Hz)", U"50.0")
 	OK
 DO
-	CONVERT_EACH (Sound)
+	CONVERT_EACH_PARALLEL (Sound)
 		autoFormant result = Sound_to_Formant_keepAll (me, timeStep,
 			maximumNumberOfFormants, maximumFormant, windowLength, preEmphasisFrom);
-	CONVERT_EACH_END (my name)
+	CONVERT_EACH_PARALLEL_END (my name)
 }
 
 FORM (NEW_Sound_to_Formant_willems, U"Sound: To Formant (split Levinson (Willems))", U"Sound: To Formant (sl)...") {
@@ -1515,10 +1597,10 @@ FORM (NEW_Sound_to_Harmonicity_ac, U"Sound: To Harmonicity (ac)", U"Sound: To Ha
 	OK
 DO
 	if (periodsPerWindow < 3.0) Melder_throw (U"Number of periods per window must be at least 3.0.");
-	CONVERT_EACH (Sound)
+	CONVERT_EACH_PARALLEL (Sound)
 		autoHarmonicity result = Sound_to_Harmonicity_ac (me, timeStep,
 			minimumPitch, silenceThreshold, periodsPerWindow);
-	CONVERT_EACH_END (my name)
+	CONVERT_EACH_PARALLEL_END (my name)
 }
 
 FORM (NEW_Sound_to_Harmonicity_cc, U"Sound: To Harmonicity (cc)", U"Sound: To Harmonicity (cc)...") {
@@ -1528,10 +1610,10 @@ FORM (NEW_Sound_to_Harmonicity_cc, U"Sound: To Harmonicity (cc)", U"Sound: To Ha
 	POSITIVE4 (periodsPerWindow, U"Periods per window", U"4.5")
 	OK
 DO
-	CONVERT_EACH (Sound)
+	CONVERT_EACH_PARALLEL (Sound)
 		autoHarmonicity result = Sound_to_Harmonicity_cc (me, timeStep,
 			minimumPitch, silenceThreshold, periodsPerWindow);
-	CONVERT_EACH_END (my name)
+	CONVERT_EACH_PARALLEL_END (my name)
 }
 
 FORM (NEW_Sound_to_Harmonicity_gne, U"Sound: To Harmonicity (gne)", nullptr) {
@@ -1564,10 +1646,10 @@ FORM (NEW_Sound_to_Intensity, U"Sound: To Intensity", U"Sound: To Intensity...")
 	BOOLEAN4 (subtractMean, U"Subtract mean", true)
 	OK
 DO_ALTERNATIVE (NEW_old_Sound_to_Intensity)
-	CONVERT_EACH (Sound)
+	CONVERT_EACH_PARALLEL (Sound)
 		autoIntensity result = Sound_to_Intensity (me,
 			minimumPitch, timeStep, subtractMean);
-	CONVERT_EACH_END (my name)
+	CONVERT_EACH_PARALLEL_END (my name)
 }
 
 FORM (NEW_Sound_to_IntensityTier, U"Sound: To IntensityTier", nullptr) {
@@ -1576,10 +1658,10 @@ FORM (NEW_Sound_to_IntensityTier, U"Sound: To IntensityTier", nullptr) {
 	BOOLEAN4 (subtractMean, U"Subtract mean", true)
 	OK
 DO
-	CONVERT_EACH (Sound)
+	CONVERT_EACH_PARALLEL (Sound)
 		autoIntensityTier result = Sound_to_IntensityTier (me,
 			minimumPitch, timeStep, subtractMean);
-	CONVERT_EACH_END (my name)
+	CONVERT_EACH_PARALLEL_END (my name)
 }
 
 DIRECT (NEW_Sound_to_IntervalTier) {
@@ -1592,9 +1674,9 @@ FORM (NEW_Sound_to_Ltas, U"Sound: To long-term average spectrum", nullptr) {
 	POSITIVE4 (bandwidth, U"Bandwidth (Hz)", U"100")
 	OK
 DO
-	CONVERT_EACH (Sound)
+	CONVERT_EACH_PARALLEL (Sound)
 		autoLtas result = Sound_to_Ltas (me, bandwidth);
-	CONVERT_EACH_END (my name)
+	CONVERT_EACH_PARALLEL_END (my name)
 }
 
 FORM (NEW_Sound_to_Ltas_pitchCorrected, U"Sound: To Ltas (pitch-corrected)", U"Sound: To Ltas (pitch-corrected)...") {
@@ -1636,9 +1718,9 @@ FORM (NEW_Sound_to_Pitch, U"Sound: To Pitch", U"Sound: To Pitch...") {
 	POSITIVE4 (pitchCeiling, U"Pitch ceiling (Hz)", U"600.0")
 	OK
 DO
-	CONVERT_EACH (Sound)
+	CONVERT_EACH_PARALLEL (Sound)
 		autoPitch result = Sound_to_Pitch (me, timeStep, pitchFloor, pitchCeiling);
-	CONVERT_EACH_END (my name)
+	CONVERT_EACH_PARALLEL_END (my name)
 }
 
 FORM (NEW_Sound_to_Pitch_ac, U"Sound: To Pitch (ac)", U"Sound: To Pitch (ac)...") {
@@ -1658,11 +1740,11 @@ FORM (NEW_Sound_to_Pitch_ac, U"Sound: To Pitch (ac)", U"Sound: To Pitch (ac)..."
 DO
 	if (maximumNumberOfCandidates <= 1)
 		Melder_throw (U"Your maximum number of candidates should be greater than 1.");
-	CONVERT_EACH (Sound)
+	CONVERT_EACH_PARALLEL (Sound)
 		autoPitch result = Sound_to_Pitch_ac (me, timeStep,
 			pitchFloor, 3.0, maximumNumberOfCandidates, veryAccurate,
 			silenceThreshold, voicingThreshold, octaveCost, octaveJumpCost, voicedUnvoicedCost, pitchCeiling);
-	CONVERT_EACH_END (my name)
+	CONVERT_EACH_PARALLEL_END (my name)
 }
 
 FORM (NEW_Sound_to_Pitch_cc, U"Sound: To Pitch (cc)", U"Sound: To Pitch (cc)...") {
@@ -1682,11 +1764,11 @@ FORM (NEW_Sound_to_Pitch_cc, U"Sound: To Pitch (cc)", U"Sound: To Pitch (cc)..."
 DO
 	long maxnCandidates = GET_INTEGER (U"Max. number of candidates");
 	if (maxnCandidates <= 1) Melder_throw (U"Maximum number of candidates must be greater than 1.");
-	CONVERT_EACH (Sound)
+	CONVERT_EACH_PARALLEL (Sound)
 		autoPitch result = Sound_to_Pitch_cc (me, timeStep,
 			pitchFloor, 1.0, maximumNumberOfCandidates, veryAccurate,
 			silenceThreshold, voicingThreshold, octaveCost, octaveJumpCost, voicedUnvoicedCost, pitchCeiling);
-	CONVERT_EACH_END (my name)
+	CONVERT_EACH_PARALLEL_END (my name)
 }
 
 FORM (NEW_Sound_to_PointProcess_extrema, U"Sound: To PointProcess (extrema)", nullptr) {
@@ -1714,9 +1796,9 @@ FORM (NEW_Sound_to_PointProcess_periodic_cc, U"Sound: To PointProcess (periodic,
 DO
 	if (maximumPitch <= minimumPitch)
 		Melder_throw (U"Your maximum pitch should be greater than your minimum pitch.");
-	CONVERT_EACH (Sound)
+	CONVERT_EACH_PARALLEL (Sound)
 		autoPointProcess result = Sound_to_PointProcess_periodic_cc (me, minimumPitch, maximumPitch);
-	CONVERT_EACH_END (my name)
+	CONVERT_EACH_PARALLEL_END (my name)
 }
 
 FORM (NEW_Sound_to_PointProcess_periodic_peaks, U"Sound: To PointProcess (periodic, peaks)", U"Sound: To PointProcess (periodic, peaks)...") {
@@ -1754,32 +1836,32 @@ FORM (NEW_Sound_to_Spectrogram, U"Sound: To Spectrogram", U"Sound: To Spectrogra
 	RADIO_ENUM4 (windowShape, U"Window shape", kSound_to_Spectrogram_windowShape, DEFAULT)
 	OK
 DO
-	CONVERT_EACH (Sound)
+	CONVERT_EACH_PARALLEL (Sound)
 		autoSpectrogram result = Sound_to_Spectrogram (me, windowLength,
 			maximumFrequency, timeStep,
 			frequencyStep, (kSound_to_Spectrogram_windowShape) windowShape, 8.0, 8.0);
-	CONVERT_EACH_END (my name)
+	CONVERT_EACH_PARALLEL_END (my name)
 }
 
 FORM (NEW_Sound_to_Spectrum, U"Sound: To Spectrum", U"Sound: To Spectrum...") {
 	BOOLEAN4 (fast, U"Fast", true)
 	OK
 DO
-	CONVERT_EACH (Sound)
+	CONVERT_EACH_PARALLEL (Sound)
 		autoSpectrum result = Sound_to_Spectrum (me, fast);
-	CONVERT_EACH_END (my name)
+	CONVERT_EACH_PARALLEL_END (my name)
 }
 
 DIRECT (NEW_Sound_to_Spectrum_dft) {
-	CONVERT_EACH (Sound)
+	CONVERT_EACH_PARALLEL (Sound)
 		autoSpectrum result = Sound_to_Spectrum (me, false);
-	CONVERT_EACH_END (my name)
+	CONVERT_EACH_PARALLEL_END (my name)
 }
 
 DIRECT (NEW_Sound_to_Spectrum_fft) {
-	CONVERT_EACH (Sound)
+	CONVERT_EACH_PARALLEL (Sound)
 		autoSpectrum result = Sound_to_Spectrum (me, true);
-	CONVERT_EACH_END (my name)
+	CONVERT_EACH_PARALLEL_END (my name)
 }
 
 FORM (NEW_Sound_to_TextGrid, U"Sound: To TextGrid", U"Sound: To TextGrid...") {
@@ -2164,8 +2246,14 @@ void praat_Sound_init () {
 		praat_addAction1 (classLongSound, 0, U"Annotation tutorial", nullptr, 1, HELP_AnnotationTutorial);
 		praat_addAction1 (classLongSound, 0, U"-- to text grid --", nullptr, 1, nullptr);
 		praat_addAction1 (classLongSound, 0, U"To TextGrid...", nullptr, 1, NEW_LongSound_to_TextGrid);
+	praat_addAction1 (classLongSound, 0, U"Analyse -", nullptr, 0, nullptr);
+		praat_addAction1 (classLongSound, 0, U"To Pitch...", nullptr, 1, NEW_LongSound_to_Pitch);
+		praat_addAction1 (classLongSound, 0, U"To Intensity...", nullptr, 1, NEW_LongSound_to_Intensity);
+		praat_addAction1 (classLongSound, 0, U"To Formant (burg)...", nullptr, 1, NEW_LongSound_to_Formant_burg);
+		praat_addAction1 (classLongSound, 0, U"To Spectrogram...", nullptr, 1, NEW_LongSound_to_Spectrogram);
 	praat_addAction1 (classLongSound, 0, U"Convert to Sound", nullptr, 0, nullptr);
 	praat_addAction1 (classLongSound, 0, U"Extract part...", nullptr, 0, NEW_LongSound_extractPart);
+	praat_addAction1 (classLongSound, 0, U"Resample...", nullptr, 0, NEW_LongSound_resample);
 	praat_addAction1 (classLongSound, 0, U"Concatenate?", nullptr, 0, INFO_LongSound_concatenate);
 	praat_addAction1 (classLongSound, 0, U"Save as WAV file...", nullptr, 0, SAVE_LongSound_saveAsWavFile);
 	praat_addAction1 (classLongSound, 0,   U"Write to WAV file...", U"*Save as WAV file...", praat_DEPRECATED_2011, SAVE_LongSound_saveAsWavFile);
@@ -2345,6 +2433,7 @@ void praat_Sound_init () {
 		praat_addAction1 (classSound, 0, U"To Spectrogram...", nullptr, 1, NEW_Sound_to_Spectrogram);
 		praat_addAction1 (classSound, 0, U"To Cochleagram...", nullptr, 1, NEW_Sound_to_Cochleagram);
 		praat_addAction1 (classSound, 0, U"To Cochleagram (edb)...", nullptr, praat_DEPTH_1 | praat_HIDDEN, NEW_Sound_to_Cochleagram_edb);
+		praat_addAction1 (classSound, 0, U"To Cochleagram (gammatone)...", nullptr, 1, NEW_Sound_to_Cochleagram_gammatone);
 		praat_addAction1 (classSound, 0, U"-- formants --", nullptr, 1, nullptr);
 		praat_addAction1 (classSound, 0, U"To Formant (burg)...", nullptr, 1, NEW_Sound_to_Formant_burg);
 		praat_addAction1 (classSound, 0, U"To Formant (hack)", nullptr, 1, nullptr);
@@ -2380,6 +2469,7 @@ void praat_Sound_init () {
 		praat_addAction1 (classSound, 0, U"Filter (one formant)...", nullptr, 1, NEW_Sound_filter_oneFormant);
 		praat_addAction1 (classSound, 0, U"Filter (pre-emphasis)...", nullptr, 1, NEW_Sound_filter_preemphasis);
 		praat_addAction1 (classSound, 0, U"Filter (de-emphasis)...", nullptr, 1, NEW_Sound_filter_deemphasis);
+		praat_addAction1 (classSound, 0, U"Filter (gammatone filterbank)...", nullptr, 1, NEW_Sound_filter_gammatoneFilterbank);
 	praat_addAction1 (classSound, 0, U"Combine -", nullptr, 0, nullptr);
 		praat_addAction1 (classSound, 0, U"Combine to stereo", nullptr, 1, NEW1_Sounds_combineToStereo);
 		praat_addAction1 (classSound, 0, U"Concatenate", nullptr, 1, NEW1_Sounds_concatenate);
@@ -19,7 +19,7 @@
 #include "NUM.h"
 #include "melder.h"
 
-static long theTotalNumberOfArrays;
+static std::atomic <long> theTotalNumberOfArrays (0);   // atomic because arrays can be created on several threads at once
 
 long NUM_getTotalNumberOfArrays () { return theTotalNumberOfArrays; }
 
@@ -198,6 +198,30 @@ bool NUMmatrix_equal (long elementSize, void *m1, void *m2, long row1, long row2
 
 /*** Typed I/O routines for vectors and matrices. ***/
 
+/*
+	Binary reading and writing of consecutive elements.
+	For real numbers, abcio moves the bytes in blocks; for the other types we go element by element.
+*/
+#define ELEMENTWISE(type,storage)  \
+	static void binget##storage##_vector (type *x, long n, FILE *f) { \
+		for (long i = 0; i < n; i ++) \
+			x [i] = binget##storage (f); \
+	} \
+	static void binput##storage##_vector (const type *x, long n, FILE *f) { \
+		for (long i = 0; i < n; i ++) \
+			binput##storage (x [i], f); \
+	}
+
+ELEMENTWISE (signed char, i1)
+ELEMENTWISE (int, i2)
+ELEMENTWISE (long, i4)
+ELEMENTWISE (unsigned char, u1)
+ELEMENTWISE (unsigned int, u2)
+ELEMENTWISE (unsigned long, u4)
+ELEMENTWISE (fcomplex, c8)
+ELEMENTWISE (dcomplex, c16)
+#undef ELEMENTWISE
+
 #define FUNCTION(type,storage)  \
 	void NUMvector_writeText_##storage (const type *v, long lo, long hi, MelderFile file, const char32 *name) { \
 		texputintro (file, name, U" []: ", hi >= lo ? nullptr : U"(empty)", 0,0,0); \
@@ -207,8 +231,8 @@ bool NUMmatrix_equal (long elementSize, void *m1, void *m2, long row1, long row2
 		if (feof (file -> filePointer) || ferror (file -> filePointer)) Melder_throw (U"Write error."); \
 	} \
 	void NUMvector_writeBinary_##storage (const type *v, long lo, long hi, FILE *f) { \
-		for (long i = lo; i <= hi; i ++) \
-			binput##storage (v [i], f); \
+		if (hi >= lo) \
+			binput##storage##_vector (& v [lo], hi - lo + 1, f); \
 		if (feof (f) || ferror (f)) Melder_throw (U"Write error."); \
 	} \
 	type * NUMvector_readText_##storage (long lo, long hi, MelderReadText text, const char *name) { \
@@ -232,9 +256,8 @@ bool NUMmatrix_equal (long elementSize, void *m1, void *m2, long row1, long row2
 		type *result = nullptr; \
 		try { \
 			result = NUMvector <type> (lo, hi); \
-			for (long i = lo; i <= hi; i ++) { \
-				result [i] = binget##storage (f); \
-			} \
+			if (hi >= lo) \
+				binget##storage##_vector (& result [lo], hi - lo + 1, f); \
 			return result; \
 		} catch (MelderError) { \
 			NUMvector_free (result, lo); \
@@ -257,10 +280,9 @@ bool NUMmatrix_equal (long elementSize, void *m1, void *m2, long row1, long row2
 	} \
 	void NUMmatrix_writeBinary_##storage (type **m, long row1, long row2, long col1, long col2, FILE *f) { \
 		if (row2 >= row1) { \
-			for (long irow = row1; irow <= row2; irow ++) { \
-				for (long icol = col1; icol <= col2; icol ++) \
-					binput##storage (m [irow] [icol], f); \
-			} \
+			for (long irow = row1; irow <= row2; irow ++) \
+				if (col2 >= col1) \
+					binput##storage##_vector (& m [irow] [col1], col2 - col1 + 1, f); \
 		} \
 		if (feof (f) || ferror (f)) Melder_throw (U"Write error."); \
 	} \
@@ -285,8 +307,9 @@ bool NUMmatrix_equal (long elementSize, void *m1, void *m2, long row1, long row2
 		type **result = nullptr; \
 		try { \
 			result = NUMmatrix <type> (row1, row2, col1, col2); \
-			for (long irow = row1; irow <= row2; irow ++) for (long icol = col1; icol <= col2; icol ++) \
-				result [irow] [icol] = binget##storage (f); \
+			for (long irow = row1; irow <= row2; irow ++) \
+				if (col2 >= col1) \
+					binget##storage##_vector (& result [irow] [col1], col2 - col1 + 1, f); \
 			return result; \
 		} catch (MelderError) { \
 			NUMmatrix_free (result, row1, col1); \
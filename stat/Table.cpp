@@ -17,6 +17,9 @@
  */
 
 #include <ctype.h>
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
 #include "Table.h"
 #include "NUM2.h"
 #include "Formula.h"
@@ -74,6 +77,21 @@ double structTable :: v_getColIndex (const char32 *columnLabel) {
 	return Table_findColumnIndexFromColumnLabel (this, columnLabel);
 }
 
+/*
+	The numeric cache of a column is a contiguous copy of the numbers of its cells, in the order of the rows.
+	It has to be forgotten whenever a cell of the column changes, or rows are inserted, removed or reordered.
+*/
+static void Table_forgetNumericColumn (Table me, long columnNumber) {
+	NUMvector_free <double> (my columnHeaders [columnNumber]. cachedNumbers, 1);
+	my columnHeaders [columnNumber]. cachedNumbers = nullptr;
+	my columnHeaders [columnNumber]. numberOfCachedNumbers = 0;
+}
+
+static void Table_forgetNumericColumns (Table me) {
+	for (long icol = 1; icol <= my numberOfColumns; icol ++)
+		Table_forgetNumericColumn (me, icol);
+}
+
 static autoTableRow TableRow_create (long numberOfColumns) {
 	autoTableRow me = Thing_new (TableRow);
 	my numberOfColumns = numberOfColumns;
@@ -124,6 +142,7 @@ void Table_appendRow (Table me) {
 	try {
 		autoTableRow row = TableRow_create (my numberOfColumns);
 		my rows. addItem_move (row.move());
+		Table_forgetNumericColumns (me);
 	} catch (MelderError) {
 		Melder_throw (me, U": row not appended.");
 	}
@@ -152,6 +171,7 @@ void Table_removeRow (Table me, long rowNumber) {
 		my rows. removeItem (rowNumber);
 		for (long icol = 1; icol <= my numberOfColumns; icol ++)
 			my columnHeaders [icol]. numericized = false;
+		Table_forgetNumericColumns (me);
 	} catch (MelderError) {
 		Melder_throw (me, U": row ", rowNumber, U" not removed.");
 	}
@@ -173,6 +193,7 @@ void Table_removeColumn (Table me, long columnNumber) {
 		 * Changes without error.
 		 */
 		Melder_free (my columnHeaders [columnNumber]. label);
+		Table_forgetNumericColumn (me, columnNumber);
 		for (long icol = columnNumber; icol < my numberOfColumns; icol ++)
 			my columnHeaders [icol] = my columnHeaders [icol + 1];
 		for (long irow = 1; irow <= my rows.size; irow ++) {
@@ -207,6 +228,7 @@ void Table_insertRow (Table me, long rowNumber) {
 		 */
 		for (long icol = 1; icol <= my numberOfColumns; icol ++)
 			my columnHeaders [icol]. numericized = false;
+		Table_forgetNumericColumns (me);
 	} catch (MelderError) {
 		Melder_throw (me, U": row ", rowNumber, U" not inserted.");
 	}
@@ -346,6 +368,7 @@ void Table_setStringValue (Table me, long rowNumber, long columnNumber, const ch
 		Melder_free (row -> cells [columnNumber]. string);
 		row -> cells [columnNumber]. string = newValue.transfer();
 		my columnHeaders [columnNumber]. numericized = false;
+		Table_forgetNumericColumn (me, columnNumber);
 	} catch (MelderError) {
 		Melder_throw (me, U": string value not set.");
 	}
@@ -366,6 +389,7 @@ void Table_setNumericValue (Table me, long rowNumber, long columnNumber, double
 		Melder_free (row -> cells [columnNumber]. string);
 		row -> cells [columnNumber]. string = newValue.transfer();
 		my columnHeaders [columnNumber]. numericized = false;
+		Table_forgetNumericColumn (me, columnNumber);
 	} catch (MelderError) {
 		Melder_throw (me, U": numeric value not set.");
 	}
@@ -401,21 +425,6 @@ bool Table_isColumnNumeric_ErrorFalse (Table me, long columnNumber) {
 	return true;
 }
 
-static long stringCompare_column;
-
-static int stringCompare_NoError (const void *first, const void *second) {
-	TableRow me = * (TableRow *) first, thee = * (TableRow *) second;
-	char32 *firstString = my cells [stringCompare_column]. string;
-	char32 *secondString = thy cells [stringCompare_column]. string;
-	return str32cmp (firstString ? firstString : U"", secondString ? secondString : U"");
-}
-
-static void sortRowsByStrings_Assert (Table me, long columnNumber) {
-	Melder_assert (columnNumber >= 1 && columnNumber <= my numberOfColumns);
-	stringCompare_column = columnNumber;
-	qsort (& my rows.at [1], (unsigned long) my rows.size, sizeof (TableRow), stringCompare_NoError);
-}
-
 static int indexCompare_NoError (const void *first, const void *second) {
 	TableRow me = * (TableRow *) first, thee = * (TableRow *) second;
 	if (my sortingIndex < thy sortingIndex) return -1;
@@ -425,11 +434,32 @@ static int indexCompare_NoError (const void *first, const void *second) {
 
 static void sortRowsByIndex_NoError (Table me) {
 	qsort (& my rows.at [1], (unsigned long) my rows.size, sizeof (TableRow), indexCompare_NoError);
+	Table_forgetNumericColumns (me);
 }
 
+/*
+	A string column is numericized through a dictionary of its distinct strings:
+	every row is looked up once in a hash table, and only the distinct strings are sorted,
+	so that the numbers are the ranks of the strings, as they would be after sorting the rows by string.
+*/
+struct Table_stringHash {
+	size_t operator() (const char32 *string) const {
+		size_t hash = 5381;
+		for (const char32 *p = string; *p != U'\0'; p ++)
+			hash = hash * 33 + (size_t) *p;
+		return hash;
+	}
+};
+struct Table_stringEqual {
+	bool operator() (const char32 *first, const char32 *second) const {
+		return str32equ (first, second);
+	}
+};
+
 void Table_numericize_Assert (Table me, long columnNumber) {
 	Melder_assert (columnNumber >= 1 && columnNumber <= my numberOfColumns);
 	if (my columnHeaders [columnNumber]. numericized) return;
+	Table_forgetNumericColumn (me, columnNumber);
 	if (Table_isColumnNumeric_ErrorFalse (me, columnNumber)) {
 		for (long irow = 1; irow <= my rows.size; irow ++) {
 			TableRow row = my rows.at [irow];
@@ -439,33 +469,48 @@ void Table_numericize_Assert (Table me, long columnNumber) {
 				Melder_atof (string);
 		}
 	} else {
-		long iunique = 0;
-		const char32 *previousString = nullptr;
-		for (long irow = 1; irow <= my rows.size; irow ++) {
-			TableRow row = my rows.at [irow];
-			row -> sortingIndex = irow;
-		}
-		sortRowsByStrings_Assert (me, columnNumber);
+		std::unordered_map <const char32 *, long, Table_stringHash, Table_stringEqual> dictionary;
+		std::vector <const char32 *> distinctStrings;
 		for (long irow = 1; irow <= my rows.size; irow ++) {
 			TableRow row = my rows.at [irow];
 			const char32 *string = row -> cells [columnNumber]. string;
 			if (! string) string = U"";
-			if (! previousString || ! str32equ (string, previousString)) {
-				iunique ++;
-			}
-			row -> cells [columnNumber]. number = iunique;
-			previousString = string;
+			auto entry = dictionary. insert (std::make_pair (string, (long) distinctStrings. size ()));
+			if (entry. second) distinctStrings. push_back (string);
+			row -> cells [columnNumber]. number = entry. first -> second;   // provisionally the index of the distinct string
+		}
+		std::vector <long> order (distinctStrings. size ());
+		for (size_t i = 0; i < order. size (); i ++) order [i] = (long) i;
+		std::sort (order. begin (), order. end (),
+			[& distinctStrings] (long first, long second) { return str32cmp (distinctStrings [first], distinctStrings [second]) < 0; });
+		std::vector <double> rank (distinctStrings. size ());
+		for (size_t i = 0; i < order. size (); i ++) rank [order [i]] = i + 1;
+		for (long irow = 1; irow <= my rows.size; irow ++) {
+			TableRow row = my rows.at [irow];
+			row -> cells [columnNumber]. number = rank [(long) row -> cells [columnNumber]. number];
 		}
-		sortRowsByIndex_NoError (me);
 	}
 	my columnHeaders [columnNumber]. numericized = true;
 }
 
-static void Table_numericize_checkDefined (Table me, long columnNumber) {
+const double * Table_getNumericColumn_Assert (Table me, long columnNumber) {
 	Table_numericize_Assert (me, columnNumber);
+	structTableColumnHeader *header = & my columnHeaders [columnNumber];
+	if (! header -> cachedNumbers || header -> numberOfCachedNumbers != my rows.size) {
+		Table_forgetNumericColumn (me, columnNumber);
+		if (my rows.size < 1) return nullptr;
+		header -> cachedNumbers = NUMvector <double> (1, my rows.size);
+		header -> numberOfCachedNumbers = my rows.size;
+		for (long irow = 1; irow <= my rows.size; irow ++)
+			header -> cachedNumbers [irow] = my rows.at [irow] -> cells [columnNumber]. number;
+	}
+	return header -> cachedNumbers;
+}
+
+static void Table_numericize_checkDefined (Table me, long columnNumber) {
+	const double *numbers = Table_getNumericColumn_Assert (me, columnNumber);
 	for (long irow = 1; irow <= my rows.size; irow ++) {
-		TableRow row = my rows.at [irow];
-		if (row -> cells [columnNumber]. number == NUMundefined)
+		if (numbers [irow] == NUMundefined)
 			Melder_throw (me, U": the cell in row ", irow,
 				U" of column \"", my columnHeaders [columnNumber]. label ? my columnHeaders [columnNumber]. label : Melder_integer (columnNumber),
 				U" is undefined.");
@@ -493,11 +538,10 @@ double Table_getMean (Table me, long columnNumber) {
 		Table_numericize_checkDefined (me, columnNumber);
 		if (my rows.size < 1)
 			return NUMundefined;
+		const double *numbers = Table_getNumericColumn_Assert (me, columnNumber);
 		double sum = 0.0;
-		for (long irow = 1; irow <= my rows.size; irow ++) {
-			TableRow row = my rows.at [irow];
-			sum += row -> cells [columnNumber]. number;
-		}
+		for (long irow = 1; irow <= my rows.size; irow ++)
+			sum += numbers [irow];
 		return sum / my rows.size;
 	} catch (MelderError) {
 		Melder_throw (me, U": cannot compute mean of column ", columnNumber, U".");
@@ -510,12 +554,11 @@ double Table_getMaximum (Table me, long columnNumber) {
 		Table_numericize_checkDefined (me, columnNumber);
 		if (my rows.size < 1)
 			return NUMundefined;
-		TableRow firstRow = my rows.at [1];
-		double maximum = firstRow -> cells [columnNumber]. number;
+		const double *numbers = Table_getNumericColumn_Assert (me, columnNumber);
+		double maximum = numbers [1];
 		for (long irow = 2; irow <= my rows.size; irow ++) {
-			TableRow row = my rows.at [irow];
-			if (row -> cells [columnNumber]. number > maximum)
-				maximum = row -> cells [columnNumber]. number;
+			if (numbers [irow] > maximum)
+				maximum = numbers [irow];
 		}
 		return maximum;
 	} catch (MelderError) {
@@ -529,12 +572,11 @@ double Table_getMinimum (Table me, long columnNumber) {
 		Table_numericize_checkDefined (me, columnNumber);
 		if (my rows.size < 1)
 			return NUMundefined;
-		TableRow firstRow = my rows.at [1];
-		double minimum = firstRow -> cells [columnNumber]. number;
+		const double *numbers = Table_getNumericColumn_Assert (me, columnNumber);
+		double minimum = numbers [1];
 		for (long irow = 2; irow <= my rows.size; irow ++) {
-			TableRow row = my rows.at [irow];
-			if (row -> cells [columnNumber]. number < minimum)
-				minimum = row -> cells [columnNumber]. number;
+			if (numbers [irow] < minimum)
+				minimum = numbers [irow];
 		}
 		return minimum;
 	} catch (MelderError) {
@@ -546,13 +588,14 @@ double Table_getGroupMean (Table me, long columnNumber, long groupColumnNumber,
 	try {
 		Table_checkSpecifiedColumnNumberWithinRange (me, columnNumber);
 		Table_numericize_checkDefined (me, columnNumber);
+		const double *numbers = Table_getNumericColumn_Assert (me, columnNumber);
 		long n = 0;
 		double sum = 0.0;
 		for (long irow = 1; irow <= my rows.size; irow ++) {
 			TableRow row = my rows.at [irow];
 			if (Melder_equ (row -> cells [groupColumnNumber]. string, group)) {
 				n += 1;
-				sum += row -> cells [columnNumber]. number;
+				sum += numbers [irow];
 			}
 		}
 		if (n < 1) return NUMundefined;
@@ -570,10 +613,9 @@ double Table_getQuantile (Table me, long columnNumber, double quantile) {
 		if (my rows.size < 1)
 			return NUMundefined;
 		autoNUMvector <double> sortingColumn (1, my rows.size);
-		for (long irow = 1; irow <= my rows.size; irow ++) {
-			TableRow row = my rows.at [irow];
-			sortingColumn [irow] = row -> cells [columnNumber]. number;
-		}
+		const double *numbers = Table_getNumericColumn_Assert (me, columnNumber);
+		for (long irow = 1; irow <= my rows.size; irow ++)
+			sortingColumn [irow] = numbers [irow];
 		NUMsort_d (my rows.size, sortingColumn.peek());
 		return NUMquantile (my rows.size, sortingColumn.peek(), quantile);
 	} catch (MelderError) {
@@ -586,10 +628,10 @@ double Table_getStdev (Table me, long columnNumber) {
 		double mean = Table_getMean (me, columnNumber);   // already checks for columnNumber and undefined cells
 		if (my rows.size < 2)
 			return NUMundefined;
+		const double *numbers = Table_getNumericColumn_Assert (me, columnNumber);
 		double sum = 0.0;
 		for (long irow = 1; irow <= my rows.size; irow ++) {
-			TableRow row = my rows.at [irow];
-			double d = row -> cells [columnNumber]. number - mean;
+			double d = numbers [irow] - mean;
 			sum += d * d;
 		}
 		return sqrt (sum / (my rows.size - 1));
@@ -690,218 +732,225 @@ static void Table_columns_checkCrossSectionEmpty (char32 **factors, long nfactor
 	}
 }
 
+/*
+	The order of the rows after a stable sort on the given columns, as a permutation of 1..numberOfRows.
+	The keys are read from the numeric caches, so that the comparisons do not have to chase the row and cell pointers.
+*/
+static std::vector <long> Table_getSortedRowOrder (Table me, long *columns, long numberOfColumns) {
+	std::vector <const double *> keys ((size_t) numberOfColumns);
+	for (long icol = 1; icol <= numberOfColumns; icol ++)
+		keys [(size_t) icol - 1] = Table_getNumericColumn_Assert (me, columns [icol]);
+	std::vector <long> order ((size_t) my rows.size);
+	for (long irow = 1; irow <= my rows.size; irow ++) order [(size_t) irow - 1] = irow;
+	std::stable_sort (order. begin (), order. end (), [& keys, numberOfColumns] (long first, long second) {
+		for (long icol = 0; icol < numberOfColumns; icol ++) {
+			if (keys [(size_t) icol] [first] < keys [(size_t) icol] [second]) return true;
+			if (keys [(size_t) icol] [first] > keys [(size_t) icol] [second]) return false;
+		}
+		return false;
+	});
+	return order;
+}
+
 autoTable Table_collapseRows (Table me, const char32 *factors_string, const char32 *columnsToSum_string,
 	const char32 *columnsToAverage_string, const char32 *columnsToMedianize_string,
 	const char32 *columnsToAverageLogarithmically_string, const char32 *columnsToMedianizeLogarithmically_string)
 {
-	bool originalChanged = false;
-	try {
-		Melder_assert (factors_string);
+	Melder_assert (factors_string);
 
-		/*
-		 * Parse the six strings of tokens.
-		 */
-		autoMelderTokens factors (factors_string);
-		long numberOfFactors = factors.count();
-		if (numberOfFactors < 1)
-			Melder_throw (U"In order to pool table data, you must supply at least one independent variable.");
-		Table_columns_checkExist (me, factors.peek(), numberOfFactors);
-
-		autoMelderTokens columnsToSum;
-		long numberToSum = 0;
-		if (columnsToSum_string) {
-			columnsToSum.reset (columnsToSum_string);
-			numberToSum = columnsToSum.count();
-			Table_columns_checkExist (me, columnsToSum.peek(), numberToSum);
-			Table_columns_checkCrossSectionEmpty (factors.peek(), numberOfFactors, columnsToSum.peek(), numberToSum);
-		}
-		autoMelderTokens columnsToAverage;
-		long numberToAverage = 0;
-		if (columnsToAverage_string) {
-			columnsToAverage.reset (columnsToAverage_string);
-			numberToAverage = columnsToAverage.count();
-			Table_columns_checkExist (me, columnsToAverage.peek(), numberToAverage);
-			Table_columns_checkCrossSectionEmpty (factors.peek(), numberOfFactors, columnsToAverage.peek(), numberToAverage);
-		}
-		autoMelderTokens columnsToMedianize;
-		long numberToMedianize = 0;
-		if (columnsToMedianize_string) {
-			columnsToMedianize.reset (columnsToMedianize_string);
-			numberToMedianize = columnsToMedianize.count();
-			Table_columns_checkExist (me, columnsToMedianize.peek(), numberToMedianize);
-			Table_columns_checkCrossSectionEmpty (factors.peek(), numberOfFactors, columnsToMedianize.peek(), numberToMedianize);
-		}
-		autoMelderTokens columnsToAverageLogarithmically;
-		long numberToAverageLogarithmically = 0;
-		if (columnsToAverageLogarithmically_string) {
-			columnsToAverageLogarithmically.reset (columnsToAverageLogarithmically_string);
-			numberToAverageLogarithmically = columnsToAverageLogarithmically.count();
-			Table_columns_checkExist (me, columnsToAverageLogarithmically.peek(), numberToAverageLogarithmically);
-			Table_columns_checkCrossSectionEmpty (factors.peek(), numberOfFactors, columnsToAverageLogarithmically.peek(), numberToAverageLogarithmically);
-		}
-		autoMelderTokens columnsToMedianizeLogarithmically;
-		long numberToMedianizeLogarithmically = 0;
-		if (columnsToMedianizeLogarithmically_string) {
-			columnsToMedianizeLogarithmically.reset (columnsToMedianizeLogarithmically_string);
-			numberToMedianizeLogarithmically = columnsToMedianizeLogarithmically.count();
-			Table_columns_checkExist (me, columnsToMedianizeLogarithmically.peek(), numberToMedianizeLogarithmically);
-			Table_columns_checkCrossSectionEmpty (factors.peek(), numberOfFactors, columnsToMedianizeLogarithmically.peek(), numberToMedianizeLogarithmically);
-		}
-
-		autoTable thee = Table_createWithoutColumnNames (0,
-			numberOfFactors + numberToSum + numberToAverage + numberToMedianize + numberToAverageLogarithmically + numberToMedianizeLogarithmically);
-		Melder_assert (thy numberOfColumns > 0);
-
-		autoNUMvector <double> sortingColumn;
-		if (numberToMedianize > 0 || numberToMedianizeLogarithmically > 0) {
-			sortingColumn.reset (1, my rows.size);
+	/*
+	 * Parse the six strings of tokens.
+	 */
+	autoMelderTokens factors (factors_string);
+	long numberOfFactors = factors.count();
+	if (numberOfFactors < 1)
+		Melder_throw (U"In order to pool table data, you must supply at least one independent variable.");
+	Table_columns_checkExist (me, factors.peek(), numberOfFactors);
+
+	autoMelderTokens columnsToSum;
+	long numberToSum = 0;
+	if (columnsToSum_string) {
+		columnsToSum.reset (columnsToSum_string);
+		numberToSum = columnsToSum.count();
+		Table_columns_checkExist (me, columnsToSum.peek(), numberToSum);
+		Table_columns_checkCrossSectionEmpty (factors.peek(), numberOfFactors, columnsToSum.peek(), numberToSum);
+	}
+	autoMelderTokens columnsToAverage;
+	long numberToAverage = 0;
+	if (columnsToAverage_string) {
+		columnsToAverage.reset (columnsToAverage_string);
+		numberToAverage = columnsToAverage.count();
+		Table_columns_checkExist (me, columnsToAverage.peek(), numberToAverage);
+		Table_columns_checkCrossSectionEmpty (factors.peek(), numberOfFactors, columnsToAverage.peek(), numberToAverage);
+	}
+	autoMelderTokens columnsToMedianize;
+	long numberToMedianize = 0;
+	if (columnsToMedianize_string) {
+		columnsToMedianize.reset (columnsToMedianize_string);
+		numberToMedianize = columnsToMedianize.count();
+		Table_columns_checkExist (me, columnsToMedianize.peek(), numberToMedianize);
+		Table_columns_checkCrossSectionEmpty (factors.peek(), numberOfFactors, columnsToMedianize.peek(), numberToMedianize);
+	}
+	autoMelderTokens columnsToAverageLogarithmically;
+	long numberToAverageLogarithmically = 0;
+	if (columnsToAverageLogarithmically_string) {
+		columnsToAverageLogarithmically.reset (columnsToAverageLogarithmically_string);
+		numberToAverageLogarithmically = columnsToAverageLogarithmically.count();
+		Table_columns_checkExist (me, columnsToAverageLogarithmically.peek(), numberToAverageLogarithmically);
+		Table_columns_checkCrossSectionEmpty (factors.peek(), numberOfFactors, columnsToAverageLogarithmically.peek(), numberToAverageLogarithmically);
+	}
+	autoMelderTokens columnsToMedianizeLogarithmically;
+	long numberToMedianizeLogarithmically = 0;
+	if (columnsToMedianizeLogarithmically_string) {
+		columnsToMedianizeLogarithmically.reset (columnsToMedianizeLogarithmically_string);
+		numberToMedianizeLogarithmically = columnsToMedianizeLogarithmically.count();
+		Table_columns_checkExist (me, columnsToMedianizeLogarithmically.peek(), numberToMedianizeLogarithmically);
+		Table_columns_checkCrossSectionEmpty (factors.peek(), numberOfFactors, columnsToMedianizeLogarithmically.peek(), numberToMedianizeLogarithmically);
+	}
+
+	autoTable thee = Table_createWithoutColumnNames (0,
+		numberOfFactors + numberToSum + numberToAverage + numberToMedianize + numberToAverageLogarithmically + numberToMedianizeLogarithmically);
+	Melder_assert (thy numberOfColumns > 0);
+
+	autoNUMvector <double> sortingColumn;
+	if (numberToMedianize > 0 || numberToMedianizeLogarithmically > 0) {
+		sortingColumn.reset (1, my rows.size);
+	}
+	/*
+	 * Set the column names. Within the dependent variables, the same name may occur more than once.
+	 */
+	autoNUMvector <long> columns (1, thy numberOfColumns);
+	{
+		long icol = 0;
+		for (long i = 1; i <= numberOfFactors; i ++) {
+			Table_setColumnLabel (thee.get(), ++ icol, factors [i]);
+			columns [icol] = Table_findColumnIndexFromColumnLabel (me, factors [i]);
+		}
+		for (long i = 1; i <= numberToSum; i ++) {
+			Table_setColumnLabel (thee.get(), ++ icol, columnsToSum [i]);
+			columns [icol] = Table_findColumnIndexFromColumnLabel (me, columnsToSum [i]);
+		}
+		for (long i = 1; i <= numberToAverage; i ++) {
+			Table_setColumnLabel (thee.get(), ++ icol, columnsToAverage [i]);
+			columns [icol] = Table_findColumnIndexFromColumnLabel (me, columnsToAverage [i]);
+		}
+		for (long i = 1; i <= numberToMedianize; i ++) {
+			Table_setColumnLabel (thee.get(), ++ icol, columnsToMedianize [i]);
+			columns [icol] = Table_findColumnIndexFromColumnLabel (me, columnsToMedianize [i]);
+		}
+		for (long i = 1; i <= numberToAverageLogarithmically; i ++) {
+			Table_setColumnLabel (thee.get(), ++ icol, columnsToAverageLogarithmically [i]);
+			columns [icol] = Table_findColumnIndexFromColumnLabel (me, columnsToAverageLogarithmically [i]);
+		}
+		for (long i = 1; i <= numberToMedianizeLogarithmically; i ++) {
+			Table_setColumnLabel (thee.get(), ++ icol, columnsToMedianizeLogarithmically [i]);
+			columns [icol] = Table_findColumnIndexFromColumnLabel (me, columnsToMedianizeLogarithmically [i]);
+		}
+		Melder_assert (icol == thy numberOfColumns);
+	}
+	/*
+	 * Make sure that all the columns in the original table that we will use in the pooled table are defined.
+	 */
+	for (long icol = 1; icol <= thy numberOfColumns; icol ++) {
+		Table_numericize_checkDefined (me, columns [icol]);
+	}
+	/*
+	 * Find the order of the rows after sorting by the factors (independent variables) only,
+	 * and read all the columns from their numeric caches in that order;
+	 * the original table itself does not have to be sorted.
+	 */
+	std::vector <long> order = Table_getSortedRowOrder (me, columns.peek(), numberOfFactors);   // this works only because the factors come first
+	autoNUMvector <const double *> numbers (1, thy numberOfColumns);
+	for (long icol = 1; icol <= thy numberOfColumns; icol ++) {
+		numbers [icol] = Table_getNumericColumn_Assert (me, columns [icol]);
+	}
+	/*
+	 * Find stretches of identical factors.
+	 */
+	for (long irow = 1; irow <= my rows.size; irow ++) {
+		long rowmin = irow, rowmax = irow;
+		for (;;) {
+			bool identical = true;
+			if (++ rowmax > my rows.size) break;
+			for (long icol = 1; icol <= numberOfFactors; icol ++) {
+				if (numbers [icol] [order [(size_t) rowmax - 1]] != numbers [icol] [order [(size_t) rowmin - 1]]) {
+					identical = false;
+					break;
+				}
+			}
+			if (! identical) break;
 		}
+		rowmax --;
 		/*
-		 * Set the column names. Within the dependent variables, the same name may occur more than once.
+		 * We have the stretch.
 		 */
-		autoNUMvector <long> columns (1, thy numberOfColumns);
+		Table_insertRow (thee.get(), thy rows.size + 1);
 		{
 			long icol = 0;
 			for (long i = 1; i <= numberOfFactors; i ++) {
-				Table_setColumnLabel (thee.get(), ++ icol, factors [i]);
-				columns [icol] = Table_findColumnIndexFromColumnLabel (me, factors [i]);
+				++ icol;
+				Table_setStringValue (thee.get(), thy rows.size, icol,
+					my rows.at [order [(size_t) rowmin - 1]] -> cells [columns [icol]]. string);
 			}
 			for (long i = 1; i <= numberToSum; i ++) {
-				Table_setColumnLabel (thee.get(), ++ icol, columnsToSum [i]);
-				columns [icol] = Table_findColumnIndexFromColumnLabel (me, columnsToSum [i]);
+				++ icol;
+				double sum = 0.0;
+				for (long jrow = rowmin; jrow <= rowmax; jrow ++) {
+					sum += numbers [icol] [order [(size_t) jrow - 1]];
+				}
+				Table_setNumericValue (thee.get(), thy rows.size, icol, sum);
 			}
 			for (long i = 1; i <= numberToAverage; i ++) {
-				Table_setColumnLabel (thee.get(), ++ icol, columnsToAverage [i]);
-				columns [icol] = Table_findColumnIndexFromColumnLabel (me, columnsToAverage [i]);
+				++ icol;
+				double sum = 0.0;
+				for (long jrow = rowmin; jrow <= rowmax; jrow ++) {
+					sum += numbers [icol] [order [(size_t) jrow - 1]];
+				}
+				Table_setNumericValue (thee.get(), thy rows.size, icol, sum / (rowmax - rowmin + 1));
 			}
 			for (long i = 1; i <= numberToMedianize; i ++) {
-				Table_setColumnLabel (thee.get(), ++ icol, columnsToMedianize [i]);
-				columns [icol] = Table_findColumnIndexFromColumnLabel (me, columnsToMedianize [i]);
+				++ icol;
+				for (long jrow = rowmin; jrow <= rowmax; jrow ++) {
+					sortingColumn [jrow] = numbers [icol] [order [(size_t) jrow - 1]];
+				}
+				NUMsort_d (rowmax - rowmin + 1, & sortingColumn [rowmin - 1]);
+				double median = NUMquantile (rowmax - rowmin + 1, & sortingColumn [rowmin - 1], 0.5);
+				Table_setNumericValue (thee.get(), thy rows.size, icol, median);
 			}
 			for (long i = 1; i <= numberToAverageLogarithmically; i ++) {
-				Table_setColumnLabel (thee.get(), ++ icol, columnsToAverageLogarithmically [i]);
-				columns [icol] = Table_findColumnIndexFromColumnLabel (me, columnsToAverageLogarithmically [i]);
-			}
-			for (long i = 1; i <= numberToMedianizeLogarithmically; i ++) {
-				Table_setColumnLabel (thee.get(), ++ icol, columnsToMedianizeLogarithmically [i]);
-				columns [icol] = Table_findColumnIndexFromColumnLabel (me, columnsToMedianizeLogarithmically [i]);
-			}
-			Melder_assert (icol == thy numberOfColumns);
-		}
-		/*
-		 * Make sure that all the columns in the original table that we will use in the pooled table are defined.
-		 */
-		for (long icol = 1; icol <= thy numberOfColumns; icol ++) {
-			Table_numericize_checkDefined (me, columns [icol]);
-		}
-		/*
-		 * Remember the present sorting of the original table.
-		 * (This is safe: the sorting index may change only vacuously when numericizing.)
-		 * But this cannot be done before the previous block!
-		 */
-		for (long irow = 1; irow <= my rows.size; irow ++) {
-			TableRow row = my rows.at [irow];
-			row -> sortingIndex = irow;
-		}
-		/*
-		 * We will now sort the original table temporarily, by the factors (independent variables) only.
-		 */
-		Table_sortRows_Assert (me, columns.peek(), numberOfFactors);   /* This works only because the factors come first. */
-		originalChanged = true;
-		/*
-		 * Find stretches of identical factors.
-		 */
-		for (long irow = 1; irow <= my rows.size; irow ++) {
-			long rowmin = irow, rowmax = irow;
-			for (;;) {
-				bool identical = true;
-				if (++ rowmax > my rows.size) break;
-				for (long icol = 1; icol <= numberOfFactors; icol ++) {
-					if (my rows.at [rowmax] -> cells [columns [icol]]. number !=
-						my rows.at [rowmin] -> cells [columns [icol]]. number)
-					{
-						identical = false;
-						break;
-					}
+				++ icol;
+				double sum = 0.0;
+				for (long jrow = rowmin; jrow <= rowmax; jrow ++) {
+					double value = numbers [icol] [order [(size_t) jrow - 1]];
+					if (value <= 0.0)
+						Melder_throw (
+							U"The cell in column \"", columnsToAverageLogarithmically [i],
+							U"\" of row ", order [(size_t) jrow - 1], U" of ", me,
+							U" is not positive.\nCannot average logarithmically.");
+					sum += log (value);
 				}
-				if (! identical) break;
+				Table_setNumericValue (thee.get(), thy rows.size, icol, exp (sum / (rowmax - rowmin + 1)));
 			}
-			rowmax --;
-			/*
-			 * We have the stretch.
-			 */
-			Table_insertRow (thee.get(), thy rows.size + 1);
-			{
-				long icol = 0;
-				for (long i = 1; i <= numberOfFactors; i ++) {
-					++ icol;
-					Table_setStringValue (thee.get(), thy rows.size, icol,
-						my rows.at [rowmin] -> cells [columns [icol]]. string);
-				}
-				for (long i = 1; i <= numberToSum; i ++) {
-					++ icol;
-					double sum = 0.0;
-					for (long jrow = rowmin; jrow <= rowmax; jrow ++) {
-						sum += my rows.at [jrow] -> cells [columns [icol]]. number;
-					}
-					Table_setNumericValue (thee.get(), thy rows.size, icol, sum);
-				}
-				for (long i = 1; i <= numberToAverage; i ++) {
-					++ icol;
-					double sum = 0.0;
-					for (long jrow = rowmin; jrow <= rowmax; jrow ++) {
-						sum += my rows.at [jrow] -> cells [columns [icol]]. number;
-					}
-					Table_setNumericValue (thee.get(), thy rows.size, icol, sum / (rowmax - rowmin + 1));
-				}
-				for (long i = 1; i <= numberToMedianize; i ++) {
-					++ icol;
-					for (long jrow = rowmin; jrow <= rowmax; jrow ++) {
-						sortingColumn [jrow] = my rows.at [jrow] -> cells [columns [icol]]. number;
-					}
-					NUMsort_d (rowmax - rowmin + 1, & sortingColumn [rowmin - 1]);
-					double median = NUMquantile (rowmax - rowmin + 1, & sortingColumn [rowmin - 1], 0.5);
-					Table_setNumericValue (thee.get(), thy rows.size, icol, median);
-				}
-				for (long i = 1; i <= numberToAverageLogarithmically; i ++) {
-					++ icol;
-					double sum = 0.0;
-					for (long jrow = rowmin; jrow <= rowmax; jrow ++) {
-						double value = my rows.at [jrow] -> cells [columns [icol]]. number;
-						if (value <= 0.0)
-							Melder_throw (
-								U"The cell in column \"", columnsToAverageLogarithmically [i],
-								U"\" of row ", jrow, U" of ", me,
-								U" is not positive.\nCannot average logarithmically.");
-						sum += log (value);
-					}
-					Table_setNumericValue (thee.get(), thy rows.size, icol, exp (sum / (rowmax - rowmin + 1)));
-				}
-				for (long i = 1; i <= numberToMedianizeLogarithmically; i ++) {
-					++ icol;
-					for (long jrow = rowmin; jrow <= rowmax; jrow ++) {
-						double value = my rows.at [jrow] -> cells [columns [icol]]. number;
-						if (value <= 0.0)
-							Melder_throw (
-								U"The cell in column \"", columnsToMedianizeLogarithmically [i],
-								U"\" of row ", jrow, U" of ", me,
-								U" is not positive.\nCannot medianize logarithmically.");
-						sortingColumn [jrow] = log (value);
-					}
-					NUMsort_d (rowmax - rowmin + 1, & sortingColumn [rowmin - 1]);
-					double median = NUMquantile (rowmax - rowmin + 1, & sortingColumn [rowmin - 1], 0.5);
-					Table_setNumericValue (thee.get(), thy rows.size, icol, exp (median));
+			for (long i = 1; i <= numberToMedianizeLogarithmically; i ++) {
+				++ icol;
+				for (long jrow = rowmin; jrow <= rowmax; jrow ++) {
+					double value = numbers [icol] [order [(size_t) jrow - 1]];
+					if (value <= 0.0)
+						Melder_throw (
+							U"The cell in column \"", columnsToMedianizeLogarithmically [i],
+							U"\" of row ", order [(size_t) jrow - 1], U" of ", me,
+							U" is not positive.\nCannot medianize logarithmically.");
+					sortingColumn [jrow] = log (value);
 				}
-				Melder_assert (icol == thy numberOfColumns);
+				NUMsort_d (rowmax - rowmin + 1, & sortingColumn [rowmin - 1]);
+				double median = NUMquantile (rowmax - rowmin + 1, & sortingColumn [rowmin - 1], 0.5);
+				Table_setNumericValue (thee.get(), thy rows.size, icol, exp (median));
 			}
-			irow = rowmax;
+			Melder_assert (icol == thy numberOfColumns);
 		}
-		if (originalChanged) sortRowsByIndex_NoError (me);   // unsort the original table
-		return thee;
-	} catch (MelderError) {
-		if (originalChanged) sortRowsByIndex_NoError (me);   // unsort the original table   // UGLY
-		throw;
+		irow = rowmax;
 	}
+	return thee;
 }
 
 static char32 ** _Table_getLevels (Table me, long column, long *numberOfLevels) {
@@ -1084,24 +1133,17 @@ autoTable Table_transpose (Table me) {
 	}
 }
 
-static long *cellCompare_columns, cellCompare_numberOfColumns;
-
-static int cellCompare_NoError (const void *first, const void *second) {
-	TableRow me = * (TableRow *) first, thee = * (TableRow *) second;
-	for (long icol = 1; icol <= cellCompare_numberOfColumns; icol ++) {
-		if (my cells [cellCompare_columns [icol]]. number < thy cells [cellCompare_columns [icol]]. number) return -1;
-		if (my cells [cellCompare_columns [icol]]. number > thy cells [cellCompare_columns [icol]]. number) return +1;
-	}
-	return 0;
-}
-
 void Table_sortRows_Assert (Table me, long *columns, long numberOfColumns) {
 	for (long icol = 1; icol <= numberOfColumns; icol ++) {
 		Table_numericize_Assert (me, columns [icol]);
 	}
-	cellCompare_columns = columns;
-	cellCompare_numberOfColumns = numberOfColumns;
-	qsort (& my rows.at [1], (unsigned long) my rows.size, sizeof (TableRow), cellCompare_NoError);
+	long numberOfRows = my rows.size;
+	if (numberOfRows < 2 || numberOfColumns < 1) return;
+	std::vector <long> order = Table_getSortedRowOrder (me, columns, numberOfColumns);
+	std::vector <TableRow> sortedRows ((size_t) numberOfRows);
+	for (long irow = 1; irow <= numberOfRows; irow ++) sortedRows [(size_t) irow - 1] = my rows.at [order [(size_t) irow - 1]];
+	for (long irow = 1; irow <= numberOfRows; irow ++) my rows.at [irow] = sortedRows [(size_t) irow - 1];
+	Table_forgetNumericColumns (me);
 }
 
 void Table_sortRows_string (Table me, const char32 *columns_string) {
@@ -1129,6 +1171,7 @@ void Table_randomizeRows (Table me) noexcept {
 		my rows.at [irow] = my rows.at [jrow];
 		my rows.at [jrow] = tmp;
 	}
+	Table_forgetNumericColumns (me);
 }
 
 void Table_reflectRows (Table me) noexcept {
@@ -1138,6 +1181,7 @@ void Table_reflectRows (Table me) noexcept {
 		my rows.at [irow] = my rows.at [jrow];
 		my rows.at [jrow] = tmp;
 	}
+	Table_forgetNumericColumns (me);
 }
 
 autoTable Tables_append (OrderedOf<structTable>* me) {
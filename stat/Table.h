@@ -63,6 +63,11 @@ void Table_setNumericValue (Table me, long row, long column, double value);
 
 /* For optimizations only (e.g. conversion to Matrix or TableOfReal). */
 void Table_numericize_Assert (Table me, long columnNumber);
+const double * Table_getNumericColumn_Assert (Table me, long columnNumber);
+/*
+ * The numeric values of a column as a contiguous vector [1..numberOfRows], built on demand.
+ * The vector stays valid until the column is changed or rows are inserted, removed or reordered.
+ */
 
 double Table_getQuantile (Table me, long column, double quantile);
 double Table_getMean (Table me, long column);
@@ -311,13 +311,11 @@ void TableOfReal_formula (TableOfReal me, const char32 *expression, Interpreter
 	try {
 		Formula_compile (interpreter, me, expression, kFormula_EXPRESSION_TYPE_NUMERIC, true);
 		if (! thee) thee = me;
-		for (long irow = 1; irow <= my numberOfRows; irow ++) {
-			for (long icol = 1; icol <= my numberOfColumns; icol ++) {
-				struct Formula_Result result;
-				Formula_run (irow, icol, & result);
-				thy data [irow] [icol] = result. result.numericResult;
+		Formula_runForCells (thee, 1, my numberOfRows, 1, my numberOfColumns,
+			[=] (long irow, long icol, double value) {
+				thy data [irow] [icol] = value;
 			}
-		}
+		);
 	} catch (MelderError) {
 		Melder_throw (me, U": formula not completed.");
 	}
@@ -52,6 +52,10 @@ oo_DEFINE_STRUCT (TableColumnHeader)
 	#if oo_DECLARING || oo_COPYING
 		oo_INT (numericized)
 	#endif
+	#if oo_DECLARING || oo_DESTROYING
+		oo_LONG (numberOfCachedNumbers)
+		oo_DOUBLE_VECTOR (cachedNumbers, numberOfCachedNumbers)   // the numbers of the column, contiguously; see Table_getNumericColumn_Assert
+	#endif
 
 oo_END_STRUCT (TableColumnHeader)
 #undef ooSTRUCT
@@ -33,15 +33,21 @@
 #include "longchar.h"
 #include "UiPause.h"
 #include "DemoEditor.h"
+#include "MelderThread.h"
 
-static Interpreter theInterpreter;
-static autoInterpreter theLocalInterpreter;
-static Daata theSource;
-static const char32 *theExpression;
-static int theLevel = 1;
+/*
+	The state of the compiler and of the virtual machine is thread-local,
+	so that formulas can be compiled and run on several threads at the same time
+	(see Formula_runForCells).
+*/
+static thread_local Interpreter theInterpreter;
+static thread_local autoInterpreter theLocalInterpreter;
+static thread_local Daata theSource;
+static thread_local const char32 *theExpression;
+static thread_local int theLevel = 1;
 #define MAXIMUM_NUMBER_OF_LEVELS  20
-static int theExpressionType [1 + MAXIMUM_NUMBER_OF_LEVELS];
-static bool theOptimize;
+static thread_local int theExpressionType [1 + MAXIMUM_NUMBER_OF_LEVELS];
+static thread_local bool theOptimize;
 
 static struct Formula_NumericVector theZeroNumericVector = { 0, nullptr };
 static struct Formula_NumericMatrix theZeroNumericMatrix = { 0, 0, nullptr };
@@ -59,8 +65,21 @@ typedef struct structFormulaInstruction {
 	} content;
 } *FormulaInstruction;
 
-static FormulaInstruction lexan, parse;
-static int ilabel, ilexan, iparse, numberOfInstructions, numberOfStringConstants;
+static thread_local FormulaInstruction lexan, parse;
+static thread_local int ilabel, ilexan, iparse, numberOfInstructions, numberOfStringConstants;
+
+static void Formula_freeThreadBuffers ();
+static thread_local struct FormulaThreadBuffers {
+	bool allocated;   // setting this makes sure that the buffers will be freed when the thread ends
+	~FormulaThreadBuffers () { if (allocated) Formula_freeThreadBuffers (); }
+} theThreadBuffers;
+
+struct structFormulaCompiledExpression {
+	int numberOfInstructions;
+	FormulaInstruction instructions;   // [1..numberOfInstructions + 1], the last one being END_
+};
+
+#define Formula_MAXIMUM_NUMBER_OF_COMPILED_EXPRESSIONS  10000
 
 enum { GEENSYMBOOL_,
 
@@ -296,12 +315,12 @@ static const char32 *Formula_instructionNames [1 + hoogsteSymbool] = { U"",
 #define oudlees  (-- ilexan)
 
 static void formulefout (const char32 *message, int position) {
-	static MelderString truncatedExpression { 0 };
+	static thread_local MelderString truncatedExpression { 0 };
 	MelderString_ncopy (& truncatedExpression, theExpression, position + 1);
 	Melder_throw (message, U":\n" U_LEFT_GUILLEMET U" ", truncatedExpression.string);
 }
 
-static const char32 *languageNameCompare_searchString;
+static thread_local const char32 *languageNameCompare_searchString;
 
 static int languageNameCompare (const void *first, const void *second) {
 	int i = * (int *) first, j = * (int *) second;
@@ -309,25 +328,22 @@ static int languageNameCompare (const void *first, const void *second) {
 		j == 0 ? languageNameCompare_searchString : Formula_instructionNames [j]);
 }
 
-static int Formula_hasLanguageName (const char32 *f) {
-	static int *index;
-	if (! index) {
-		index = NUMvector <int> (1, hoogsteInvoersymbool);
-		for (int tok = 1; tok <= hoogsteInvoersymbool; tok ++) {
-			index [tok] = tok;
-		}
-		qsort (& index [1], hoogsteInvoersymbool, sizeof (int), languageNameCompare);
-	}
-	if (! index) {   // linear search
-		for (int tok = 1; tok <= hoogsteInvoersymbool; tok ++) {
-			if (str32equ (f, Formula_instructionNames [tok])) return tok;
-		}
-	} else {   // binary search
-		int dummy = 0, *found;
-		languageNameCompare_searchString = f;
-		found = (int *) bsearch (& dummy, & index [1], hoogsteInvoersymbool, sizeof (int), languageNameCompare);
-		if (found) return *found;
+static int * Formula_createLanguageNameIndex () {
+	int *index = NUMvector <int> (1, hoogsteInvoersymbool);
+	for (int tok = 1; tok <= hoogsteInvoersymbool; tok ++) {
+		index [tok] = tok;
 	}
+	languageNameCompare_searchString = nullptr;
+	qsort (& index [1], hoogsteInvoersymbool, sizeof (int), languageNameCompare);
+	return index;
+}
+
+static int Formula_hasLanguageName (const char32 *f) {
+	static int *index = Formula_createLanguageNameIndex ();   // initialized only once, even if several threads get here at the same time
+	int dummy = 0, *found;
+	languageNameCompare_searchString = f;
+	found = (int *) bsearch (& dummy, & index [1], hoogsteInvoersymbool, sizeof (int), languageNameCompare);
+	if (found) return *found;
 	return 0;
 }
 
@@ -358,7 +374,7 @@ static void Formula_lexan () {
 #define tokgetal(g)  lexan [itok]. content.number = (g)
 #define tokmatriks(m)  lexan [itok]. content.object = (m)
 
-	static MelderString token { 0 };   /* String to collect a symbol name in. */
+	static thread_local MelderString token { 0 };   /* String to collect a symbol name in. */
 #define stokaan MelderString_empty (& token);
 #define stokkar { MelderString_appendCharacter (& token, kar); nieuwkar; }
 #define stokuit (void) 0
@@ -813,7 +829,7 @@ static void pas (int symbol) {
 		const char32 *symbolName2 = Formula_instructionNames [lexan [ilexan]. symbol];
 		bool needQuotes1 = ( str32chr (symbolName1, U' ') == nullptr );
 		bool needQuotes2 = ( str32chr (symbolName2, U' ') == nullptr );
-		static MelderString melding { 0 };
+		static thread_local MelderString melding { 0 };
 		MelderString_copy (& melding,
 			U"Expected ", needQuotes1 ? U"\"" : nullptr, symbolName1, needQuotes1 ? U"\"" : nullptr,
 			U", but found ", needQuotes2 ? U"\"" : nullptr, symbolName2, needQuotes2 ? U"\"" : nullptr);
@@ -827,7 +843,7 @@ static bool pasArguments () {
     if (symbol == COLON_) return false;   // success: a function call like: myFunction: ...
     const char32 *symbolName2 = Formula_instructionNames [lexan [ilexan]. symbol];
     bool needQuotes2 = ( str32chr (symbolName2, U' ') == nullptr );
-    static MelderString melding { 0 };
+    static thread_local MelderString melding { 0 };
     MelderString_copy (& melding,
 		U"Expected \"(\" or \":\", but found ", needQuotes2 ? U"\"" : nullptr, symbolName2, needQuotes2 ? U"\"" : nullptr);
     formulefout (melding.string, lexan [ilexan]. position);
@@ -1909,7 +1925,74 @@ static void Formula_print (FormulaInstruction f) {
 	} while (symbol != END_);
 }
 
+static bool instructionOwnsString (int symbol) {
+	return symbol == STRING_ || symbol == VARIABLE_NAME_ || symbol == INDEXED_NUMERIC_VARIABLE_ || symbol == INDEXED_STRING_VARIABLE_ || symbol == CALL_;
+}
+
+void FormulaCompiledExpression_free (FormulaCompiledExpression me) {
+	if (! me) return;
+	for (int i = 1; i <= my numberOfInstructions; i ++)
+		if (instructionOwnsString (my instructions [i]. symbol))
+			Melder_free (my instructions [i]. content.string);
+	Melder_free (my instructions);
+	Melder_free (me);
+}
+
+static bool lexanRefersToObjects () {
+	for (int i = 1; lexan [i]. symbol != END_; i ++)
+		if (lexan [i]. symbol == MATRIKS_ || lexan [i]. symbol == MATRIKSSTR_)
+			return true;
+	return false;
+}
+
+static void Formula_rememberCompiledExpression (Interpreter interpreter, const std::u32string& key) {
+	if (interpreter -> compiledExpressions. size () >= Formula_MAXIMUM_NUMBER_OF_COMPILED_EXPRESSIONS)
+		Interpreter_forgetCompiledExpressions (interpreter);   // probably lots of expressions with substituted variables, i.e. never the same
+	FormulaCompiledExpression me = Melder_calloc (struct structFormulaCompiledExpression, 1);
+	try {
+		my instructions = Melder_calloc (struct structFormulaInstruction, numberOfInstructions + 2);
+	} catch (MelderError) {
+		Melder_free (me);
+		throw;
+	}
+	my numberOfInstructions = numberOfInstructions;
+	for (int i = 1; i <= numberOfInstructions + 1; i ++) {
+		my instructions [i] = parse [i];
+		if (instructionOwnsString (parse [i]. symbol))
+			my instructions [i]. content.string = Melder_dup_f (parse [i]. content.string);   // parse only has reference copies of the strings in lexan
+	}
+	interpreter -> compiledExpressions [key] = me;
+}
+
+static void Formula_freeStringConstants () {
+	if (numberOfStringConstants) {
+		ilexan = 1;
+		for (;;) {
+			int symbol = lexan [ilexan]. symbol;
+			if (instructionOwnsString (symbol)) Melder_free (lexan [ilexan]. content.string);
+			else if (symbol == END_) break;   /* Either the end of a formula, or the end of lexan. */
+			ilexan ++;
+		}
+		numberOfStringConstants = 0;
+	}
+}
+
 void Formula_compile (Interpreter interpreter, Daata data, const char32 *expression, int expressionType, bool optimize) {
+	/*
+		Expressions compiled by an interpreter without a current object can be remembered.
+		The result of a compilation depends on the expression type and on the optimization,
+		and on the procedure we are in (because local variables like ".x" are resolved during lexical analysis).
+	*/
+	const bool rememberable = interpreter && ! data;
+	std::u32string key;
+	if (rememberable) {
+		key. reserve (str32len (expression) + 30);
+		key += (char32) (U'0' + expressionType);
+		key += optimize ? U'1' : U'0';
+		key += interpreter -> procedureNames [interpreter -> callDepth];
+		key += U'\n';
+		key += expression;
+	}
 	theInterpreter = interpreter;
 	if (! theInterpreter) {
 		if (! theLocalInterpreter) {
@@ -1931,21 +2014,23 @@ void Formula_compile (Interpreter interpreter, Daata data, const char32 *express
 		lexan [3000 - 1]. symbol = END_;   /* Make sure that string cleaning always terminates. */
 	}
 	if (! parse) parse = Melder_calloc_f (struct structFormulaInstruction, 3000);
+	theThreadBuffers. allocated = true;
+
+	if (rememberable) {
+		auto it = interpreter -> compiledExpressions. find (key);
+		if (it != interpreter -> compiledExpressions. end ()) {
+			FormulaCompiledExpression compiled = it -> second;
+			numberOfInstructions = compiled -> numberOfInstructions;
+			memcpy (& parse [1], & compiled -> instructions [1], (size_t) (numberOfInstructions + 1) * sizeof (struct structFormulaInstruction));   // reference copies of the strings
+			return;
+		}
+	}
 
 	/*
 		Clean up strings from the previous call.
 		These strings are in a union, that's why this cannot be done later, when a new string is created.
 	*/
-	if (numberOfStringConstants) {
-		ilexan = 1;
-		for (;;) {
-			int symbol = lexan [ilexan]. symbol;
-			if (symbol == STRING_ || symbol == VARIABLE_NAME_ || symbol == INDEXED_NUMERIC_VARIABLE_ || symbol == INDEXED_STRING_VARIABLE_ || symbol == CALL_) Melder_free (lexan [ilexan]. content.string);
-			else if (symbol == END_) break;   /* Either the end of a formula, or the end of lexan. */
-			ilexan ++;
-		}
-		numberOfStringConstants = 0;
-	}
+	Formula_freeStringConstants ();
 
 	Formula_lexan ();
 	if (Melder_debug == 17) Formula_print (lexan);
@@ -1959,13 +2044,15 @@ void Formula_compile (Interpreter interpreter, Daata data, const char32 *express
 	}
 	Formula_removeLabels ();
 	if (Melder_debug == 17) Formula_print (parse);
+	if (rememberable && ! lexanRefersToObjects ())
+		Formula_rememberCompiledExpression (interpreter, key);
 }
 
 /*
  * Running.
  */
 
-static int programPointer;
+static thread_local int programPointer;
 
 static void Stackel_cleanUp (Stackel me) {
 	if (my which == Stackel_STRING) {
@@ -1978,8 +2065,8 @@ static void Stackel_cleanUp (Stackel me) {
 		my numericMatrix = theZeroNumericMatrix;
 	}
 }
-static Stackel theStack;
-static int w, wmax;   /* w = stack pointer; */
+static thread_local Stackel theStack;
+static thread_local int w, wmax;   /* w = stack pointer; */
 #define pop  & theStack [w --]
 static inline void pushNumber (double x) {
 	/* inline runs 10 to 20 percent faster on i386; here's the test script:
@@ -3674,7 +3761,7 @@ static void do_indexedNumericVariable () {
 	if (nindex < 1)
 		Melder_throw (U"Indexed variables require at least one index.");
 	char32 *indexedVariableName = parse [programPointer]. content.string;
-	static MelderString totalVariableName { 0 };
+	static thread_local MelderString totalVariableName { 0 };
 	MelderString_copy (& totalVariableName, indexedVariableName, U"[");
 	w -= nindex;
 	for (int iindex = 1; iindex <= nindex; iindex ++) {
@@ -3699,7 +3786,7 @@ static void do_indexedStringVariable () {
 	if (nindex < 1)
 		Melder_throw (U"Indexed variables require at least one index.");
 	char32 *indexedVariableName = parse [programPointer]. content.string;
-	static MelderString totalVariableName { 0 };
+	static thread_local MelderString totalVariableName { 0 };
 	MelderString_copy (& totalVariableName, indexedVariableName, U"[");
 	w -= nindex;
 	for (int iindex = 1; iindex <= nindex; iindex ++) {
@@ -4101,9 +4188,8 @@ static void do_numberOfSelected () {
 	pushNumber (result);
 }
 static int praat_findObjectById (int id) {
-	int IOBJECT;
-	WHERE_DOWN (ID == id)
-		return IOBJECT;
+	int IOBJECT = praat_positionOfObjectWithId (id);
+	if (IOBJECT) return IOBJECT;
 	Melder_throw (U"No object with number ", id, U".");
 }
 static int praat_findObjectFromString (const char32 *name) {
@@ -4112,24 +4198,18 @@ static int praat_findObjectFromString (const char32 *name) {
 		/*
 		 * Find the object by its name.
 		 */
-		static MelderString buffer { 0 };
+		static thread_local MelderString buffer { 0 };
 		MelderString_copy (& buffer, name);
 		char32 *space = str32chr (buffer.string, U' ');
 		if (space == nullptr)
 			Melder_throw (U"Missing space in object name \"", name, U"\".");
 		*space = U'\0';
 		char32 *className = & buffer.string [0], *givenName = space + 1;
-		WHERE_DOWN (1) {
-			Daata object = OBJECT;
-			if (str32equ (className, Thing_className (OBJECT)) && str32equ (givenName, object -> name))
-				return IOBJECT;
-		}
+		IOBJECT = praat_positionOfObjectWithFullName (className, givenName);
+		if (IOBJECT) return IOBJECT;
 		ClassInfo klas = Thing_classFromClassName (className, nullptr);
-		WHERE_DOWN (1) {
-			Daata object = OBJECT;
-			if (str32equ (klas -> className, Thing_className (OBJECT)) && str32equ (givenName, object -> name))
-				return IOBJECT;
-		}
+		IOBJECT = praat_positionOfObjectWithFullName (klas -> className, givenName);
+		if (IOBJECT) return IOBJECT;
 	}
 	Melder_throw (U"No object with name \"", name, U"\".");
 }
@@ -5468,7 +5548,10 @@ static double NUMerf (double x) {
 void Formula_run (long row, long col, struct Formula_Result *result) {
 	FormulaInstruction f = parse;
 	programPointer = 1;   // first symbol of the program
-	if (! theStack) theStack = Melder_calloc_f (struct structStackel, 10000);
+	if (! theStack) {
+		theStack = Melder_calloc_f (struct structStackel, 10000);
+		theThreadBuffers. allocated = true;
+	}
 	if (! theStack)
 		Melder_throw (U"Out of memory during formula computation.");
 	w = 0, wmax = 0;   // start new stack
@@ -5879,4 +5962,311 @@ case NUMBER_: { pushNumber (f [programPointer]. content.number);
 	}
 }
 
+static void Formula_freeThreadBuffers () {
+	if (lexan) Formula_freeStringConstants ();
+	Melder_free (lexan);
+	Melder_free (parse);
+	Melder_free (theStack);
+}
+
+static bool Formula_canRunInParallel (Daata target) {
+	/*
+		The compiled formula can be run on several threads at the same time
+		if it changes nothing except the cell it computes, and reads only from data that stay constant.
+		The following instructions are safe in that respect
+		(in particular, random numbers, interpreter procedures and the object list are not).
+	*/
+	for (int i = 1; i <= numberOfInstructions; i ++) {
+		FormulaInstruction instruction = & parse [i];
+		int symbol = instruction -> symbol;
+		switch (symbol) {
+			case CALL_: case STOPWATCH_: case SLEEP_:
+			case RANDOM_BERNOULLI_: case RANDOM_BERNOULLI_NUMVEC_: case RANDOM_POISSON_:
+			case RANDOM_UNIFORM_: case RANDOM_INTEGER_: case RANDOM_GAUSS_: case RANDOM_BINOMIAL_:
+			case OBJECTS_ARE_IDENTICAL_:
+				return false;
+			case MIN_: case MAX_: case IMIN_: case IMAX_: case LEFTSTR_: case RIGHTSTR_: case MIDSTR_:
+			case ZERO_NUMVEC_: case ZERO_NUMMAT_: case LINEAR_NUMVEC_: case LINEAR_NUMMAT_:
+			case NUMBER_OF_ROWS_: case NUMBER_OF_COLUMNS_:
+			case LENGTH_: case STRING_TO_NUMBER_: case INDEX_: case RINDEX_: case STARTS_WITH_: case ENDS_WITH_: case REPLACESTR_:
+			case EXTRACT_NUMBER_: case EXTRACT_WORDSTR_: case EXTRACT_LINESTR_: case FIXEDSTR_: case PERCENTSTR_:
+			case TRUE_: case FALSE_: case GOTO_: case IFTRUE_: case IFFALSE_:
+			case NUMERIC_VECTOR_ELEMENT_: case NUMERIC_MATRIX_ELEMENT_: case SQR_: case STRING_:
+			case SELF0_: case SELFSTR0_:
+			case NUMERIC_VARIABLE_: case NUMERIC_VECTOR_VARIABLE_: case NUMERIC_MATRIX_VARIABLE_: case STRING_VARIABLE_:
+				continue;
+			case SELFMATRIKS1_: case SELFMATRIKSSTR1_: case SELFMATRIKS2_: case SELFMATRIKSSTR2_:
+			case SELFFUNKTIE1_: case SELFFUNKTIESTR1_: case SELFFUNKTIE2_: case SELFFUNKTIESTR2_:
+				if (theSource == target) return false;   // would read cells that another thread may be writing
+				continue;
+			case MATRIKS0_: case MATRIKSSTR0_: case MATRIKS1_: case MATRIKSSTR1_: case MATRIKS2_: case MATRIKSSTR2_:
+			case FUNKTIE0_: case FUNKTIESTR0_: case FUNKTIE1_: case FUNKTIESTR1_: case FUNKTIE2_: case FUNKTIESTR2_:
+				if (instruction -> content.object == target) return false;
+				continue;
+		}
+		if (symbol >= IF_ && symbol <= HIGH_VALUE) continue;   // operators, numbers, attributes
+		if (symbol >= LOW_FUNCTION_1 && symbol <= HIGH_FUNCTION_3) continue;   // numeric functions with fixed numbers of arguments
+		return false;
+	}
+	return true;
+}
+
+/*
+	Formulas that consist of arithmetic on numbers, variables, self, row, col, x and y only
+	(e.g. "self * 0.5" or "sin (2 * pi * 377 * x)")
+	can be evaluated for a block of consecutive cells in a row at once:
+	every instruction then works on a whole block of values, in a tight loop.
+	The results are identical to those of Formula_run, cell by cell.
+*/
+#define Formula_BLOCK_SIZE  256
+#define Formula_MAXIMUM_BLOCK_STACK_DEPTH  16
+
+static bool Formula_canRunInBlocks (long firstRow, long lastRow, long firstColumn) {
+	Daata me = theSource;
+	if (! me) return false;
+	int depth = 0;
+	for (int i = 1; i <= numberOfInstructions; i ++) {
+		switch (parse [i]. symbol) {
+			case NUMBER_: case NUMERIC_VARIABLE_: case ROW_: case COL_:
+				depth ++;
+				break;
+			case X_:
+				if (! my v_hasGetX ()) return false;   // let Formula_run generate the error message
+				depth ++;
+				break;
+			case Y_:
+				if (! my v_hasGetY ()) return false;
+				depth ++;
+				break;
+			case SELF0_:
+				if (! my v_hasGetCell () && ! (my v_hasGetVector () && firstColumn >= 1) &&
+					! (my v_hasGetMatrix () && firstColumn >= 1 && firstRow >= 1 && lastRow >= 1))
+					return false;   // let do_self0 generate the error message
+				depth ++;
+				break;
+			case ADD_: case SUB_: case MUL_: case RDIV_: case POWER_:
+				depth --;
+				break;
+			case MINUS_: case SQR_: case ABS_: case SQRT_: case SIN_: case COS_: case EXP_: case LN_: case LOG10_:
+				break;
+			default:
+				return false;
+		}
+		if (depth > Formula_MAXIMUM_BLOCK_STACK_DEPTH) return false;
+	}
+	return depth == 1;
+}
+
+static void Formula_runBlock (long row, long firstColumn, long numberOfColumns, double *result) {
+	Daata me = theSource;
+	double stack [1 + Formula_MAXIMUM_BLOCK_STACK_DEPTH] [Formula_BLOCK_SIZE];
+	int depth = 0;
+	for (int i = 1; i <= numberOfInstructions; i ++) {
+		double *x = stack [depth], *y = stack [depth + 1];   // x is the top of the stack before the instruction, y is the new top
+		switch (parse [i]. symbol) {
+			case NUMBER_: {
+				const double value = parse [i]. content.number;
+				for (long k = 0; k < numberOfColumns; k ++) y [k] = value;
+				depth ++;
+			} break; case NUMERIC_VARIABLE_: {
+				const double value = parse [i]. content.variable -> numericValue;
+				for (long k = 0; k < numberOfColumns; k ++) y [k] = value;
+				depth ++;
+			} break; case ROW_: {
+				for (long k = 0; k < numberOfColumns; k ++) y [k] = row;
+				depth ++;
+			} break; case COL_: {
+				for (long k = 0; k < numberOfColumns; k ++) y [k] = firstColumn + k;
+				depth ++;
+			} break; case X_: {
+				for (long k = 0; k < numberOfColumns; k ++) y [k] = my v_getX (firstColumn + k);
+				depth ++;
+			} break; case Y_: {
+				const double value = my v_getY (row);
+				for (long k = 0; k < numberOfColumns; k ++) y [k] = value;
+				depth ++;
+			} break; case SELF0_: {
+				if (my v_hasGetCell ()) {
+					const double value = my v_getCell ();
+					for (long k = 0; k < numberOfColumns; k ++) y [k] = value;
+				} else if (my v_hasGetVector ()) {
+					for (long k = 0; k < numberOfColumns; k ++) y [k] = my v_getVector (row, firstColumn + k);
+				} else {
+					for (long k = 0; k < numberOfColumns; k ++) y [k] = my v_getMatrix (row, firstColumn + k);
+				}
+				depth ++;
+			} break; case ADD_: {
+				double *a = stack [depth - 1];
+				for (long k = 0; k < numberOfColumns; k ++)
+					a [k] = a [k] == NUMundefined || x [k] == NUMundefined ? NUMundefined : a [k] + x [k];
+				depth --;
+			} break; case SUB_: {
+				double *a = stack [depth - 1];
+				for (long k = 0; k < numberOfColumns; k ++)
+					a [k] = a [k] == NUMundefined || x [k] == NUMundefined ? NUMundefined : a [k] - x [k];
+				depth --;
+			} break; case MUL_: {
+				double *a = stack [depth - 1];
+				for (long k = 0; k < numberOfColumns; k ++)
+					a [k] = a [k] == NUMundefined || x [k] == NUMundefined ? NUMundefined : a [k] * x [k];
+				depth --;
+			} break; case RDIV_: {
+				double *a = stack [depth - 1];
+				for (long k = 0; k < numberOfColumns; k ++)
+					a [k] = a [k] == NUMundefined || x [k] == NUMundefined ? NUMundefined :
+						x [k] == 0.0 ? NUMundefined : a [k] / x [k];
+				depth --;
+			} break; case POWER_: {
+				double *a = stack [depth - 1];
+				for (long k = 0; k < numberOfColumns; k ++)
+					a [k] = a [k] == NUMundefined || x [k] == NUMundefined ? NUMundefined : pow (a [k], x [k]);
+				depth --;
+			} break; case MINUS_: {
+				for (long k = 0; k < numberOfColumns; k ++) x [k] = x [k] == NUMundefined ? NUMundefined : - x [k];
+			} break; case SQR_: {
+				for (long k = 0; k < numberOfColumns; k ++) x [k] = x [k] == NUMundefined ? NUMundefined : x [k] * x [k];
+			} break; case ABS_: {
+				for (long k = 0; k < numberOfColumns; k ++) x [k] = x [k] == NUMundefined ? NUMundefined : fabs (x [k]);
+			} break; case SQRT_: {
+				for (long k = 0; k < numberOfColumns; k ++)
+					x [k] = x [k] == NUMundefined ? NUMundefined : x [k] < 0.0 ? NUMundefined : sqrt (x [k]);
+			} break; case SIN_: {
+				for (long k = 0; k < numberOfColumns; k ++) x [k] = x [k] == NUMundefined ? NUMundefined : sin (x [k]);
+			} break; case COS_: {
+				for (long k = 0; k < numberOfColumns; k ++) x [k] = x [k] == NUMundefined ? NUMundefined : cos (x [k]);
+			} break; case EXP_: {
+				for (long k = 0; k < numberOfColumns; k ++) x [k] = x [k] == NUMundefined ? NUMundefined : exp (x [k]);
+			} break; case LN_: {
+				for (long k = 0; k < numberOfColumns; k ++)
+					x [k] = x [k] == NUMundefined ? NUMundefined : x [k] <= 0.0 ? NUMundefined : log (x [k]);
+			} break; case LOG10_: {
+				for (long k = 0; k < numberOfColumns; k ++)
+					x [k] = x [k] == NUMundefined ? NUMundefined : x [k] <= 0.0 ? NUMundefined : log10 (x [k]);
+			} break; default: Melder_fatal (U"Formula_runBlock: symbol \"", Formula_instructionNames [parse [i]. symbol], U"\" cannot be run in blocks.");
+		}
+	}
+	Melder_assert (depth == 1);
+	for (long k = 0; k < numberOfColumns; k ++) result [k] = stack [1] [k];
+}
+
+static void Formula_runCells (long firstRow, long firstColumn, long numberOfColumns, long firstCell, long lastCell, bool inBlocks,
+	std::function <void (long row, long column, double value)>& store)
+{
+	if (inBlocks) {
+		double result [Formula_BLOCK_SIZE];
+		long icell = firstCell;
+		while (icell <= lastCell) {
+			const long row = firstRow + icell / numberOfColumns, column = firstColumn + icell % numberOfColumns;
+			long numberOfColumnsInBlock = numberOfColumns - icell % numberOfColumns;   // until the end of the row...
+			if (numberOfColumnsInBlock > lastCell - icell + 1) numberOfColumnsInBlock = lastCell - icell + 1;   // ...or of the chunk...
+			if (numberOfColumnsInBlock > Formula_BLOCK_SIZE) numberOfColumnsInBlock = Formula_BLOCK_SIZE;   // ...or of the block
+			Formula_runBlock (row, column, numberOfColumnsInBlock, result);
+			for (long k = 0; k < numberOfColumnsInBlock; k ++)
+				store (row, column + k, result [k]);
+			icell += numberOfColumnsInBlock;
+		}
+	} else {
+		for (long icell = firstCell; icell <= lastCell; icell ++) {
+			const long row = firstRow + icell / numberOfColumns, column = firstColumn + icell % numberOfColumns;
+			struct Formula_Result result;
+			Formula_run (row, column, & result);
+			store (row, column, result. result.numericResult);
+		}
+	}
+}
+
+typedef struct {
+	FormulaInstruction program;
+	int numberOfInstructions, expressionType;
+	bool optimize, inBlocks;
+	Interpreter interpreter;
+	Daata source;
+	long firstRow, firstColumn, numberOfColumns;
+	long firstCell, lastCell;   // counted from 0, row by row
+	bool isCallingThread;
+	std::function <void (long row, long column, double value)> *store;
+	char32 *errorMessage;
+} Formula_Chunk;
+
+static MelderThread_RETURN_TYPE Formula_runChunk (Formula_Chunk *me) {
+	try {
+		if (! my isCallingThread) {
+			/*
+				Every thread has its own virtual machine, which needs its own copy of the program.
+			*/
+			theInterpreter = my interpreter;
+			theSource = my source;
+			theExpressionType [theLevel] = my expressionType;
+			theOptimize = my optimize;   // determines the meaning of the jump labels
+			if (! parse) {
+				parse = Melder_calloc (struct structFormulaInstruction, 3000);
+				theThreadBuffers. allocated = true;
+			}
+			memcpy (& parse [1], & my program [1], (size_t) (my numberOfInstructions + 1) * sizeof (struct structFormulaInstruction));   // reference copies of the strings
+			numberOfInstructions = my numberOfInstructions;
+		}
+		Formula_runCells (my firstRow, my firstColumn, my numberOfColumns, my firstCell, my lastCell, my inBlocks, *my store);
+	} catch (MelderError) {
+		my errorMessage = Melder_dup_f (Melder_getError ());   // the error buffer is thread-local
+		Melder_clearError ();
+	}
+	MelderThread_RETURN;
+}
+
+void Formula_runForCells (Daata target, long firstRow, long lastRow, long firstColumn, long lastColumn,
+	std::function <void (long row, long column, double value)> store)
+{
+	Melder_assert (theExpressionType [theLevel] == kFormula_EXPRESSION_TYPE_NUMERIC);
+	if (lastRow < firstRow || lastColumn < firstColumn) return;
+	const long numberOfColumns = lastColumn - firstColumn + 1;
+	const long numberOfCells = (lastRow - firstRow + 1) * numberOfColumns;
+	const long minimumNumberOfCellsPerThread = 10000;
+	long numberOfThreads = (numberOfCells - 1) / minimumNumberOfCellsPerThread + 1;
+	const int numberOfProcessors = MelderThread_getNumberOfProcessors ();
+	if (numberOfThreads > numberOfProcessors) numberOfThreads = numberOfProcessors;
+	const bool inBlocks = Formula_canRunInBlocks (firstRow, lastRow, firstColumn);
+	if (numberOfThreads <= 1 || ! Formula_canRunInParallel (target)) {
+		Formula_runCells (firstRow, firstColumn, numberOfColumns, 0, numberOfCells - 1, inBlocks, store);
+		return;
+	}
+	const long numberOfCellsPerThread = (numberOfCells - 1) / numberOfThreads + 1;
+	numberOfThreads = (numberOfCells - 1) / numberOfCellsPerThread + 1;   // no empty chunks
+	std::vector <Formula_Chunk> chunks ((size_t) numberOfThreads);
+	for (long ithread = 1; ithread <= numberOfThreads; ithread ++) {
+		Formula_Chunk *chunk = & chunks [(size_t) ithread - 1];
+		chunk -> program = parse;
+		chunk -> numberOfInstructions = numberOfInstructions;
+		chunk -> expressionType = theExpressionType [theLevel];
+		chunk -> optimize = theOptimize;
+		chunk -> inBlocks = inBlocks;
+		chunk -> interpreter = theInterpreter;
+		chunk -> source = theSource;
+		chunk -> firstRow = firstRow;
+		chunk -> firstColumn = firstColumn;
+		chunk -> numberOfColumns = numberOfColumns;
+		chunk -> firstCell = (ithread - 1) * numberOfCellsPerThread;
+		chunk -> lastCell = ithread == numberOfThreads ? numberOfCells - 1 : ithread * numberOfCellsPerThread - 1;
+		chunk -> isCallingThread = ( ithread == numberOfThreads );   // MelderThread_run runs the last chunk on the calling thread
+		chunk -> store = & store;
+		chunk -> errorMessage = nullptr;
+	}
+	MelderThread_run (Formula_runChunk, chunks.data(), (int) numberOfThreads);
+	/*
+		Report the error in the first cell that failed, as a single thread would have done.
+	*/
+	char32 *errorMessage = nullptr;
+	for (long ithread = 1; ithread <= numberOfThreads; ithread ++) {
+		char32 *message = chunks [(size_t) ithread - 1]. errorMessage;
+		if (message && ! errorMessage)
+			errorMessage = message;
+		else
+			Melder_free (message);
+	}
+	if (errorMessage) {
+		Melder_appendError_noLine (errorMessage);
+		Melder_free (errorMessage);
+		throw MelderError ();
+	}
+}
+
 /* End of file Formula.cpp */
@@ -74,8 +74,28 @@ struct Formula_Result {
 Thing_declare (Interpreter);
 
 void Formula_compile (Interpreter interpreter, Daata data, const char32 *expression, int expressionType, bool optimize);
+/*
+	If 'interpreter' is not null and 'data' is null, the compiled formula is remembered by the interpreter,
+	so that the next compilation of the same expression (e.g. in the next iteration of a loop)
+	can skip lexical analysis, parsing and optimization.
+	Formulas that refer to objects by name are not remembered, because objects can come and go.
+*/
+
+typedef struct structFormulaCompiledExpression *FormulaCompiledExpression;
+void FormulaCompiledExpression_free (FormulaCompiledExpression me);
 
 void Formula_run (long row, long col, struct Formula_Result *result);
 
+void Formula_runForCells (Daata target, long firstRow, long lastRow, long firstColumn, long lastColumn,
+	std::function <void (long row, long column, double value)> store);
+/*
+	Runs the compiled numeric formula for all cells (row, column) and hands every result to 'store'.
+	If the formula only reads data that stay constant (e.g. it does not look at other cells of 'target',
+	and does not draw random numbers), the cells are computed on several threads at the same time,
+	in which case 'store' is called from several threads at the same time as well, and should only write into the cell.
+	Otherwise, the cells are computed one after another, row by row.
+	Simple arithmetic formulas are computed for blocks of cells at a time.
+*/
+
 /* End of file Formula.h */
 #endif
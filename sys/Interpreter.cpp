@@ -79,6 +79,7 @@ void structInterpreter :: v_destroy () noexcept {
 		}
 	//	delete (our variablesMap);
 	//}
+	Interpreter_forgetCompiledExpressions (this);
 	Interpreter_Parent :: v_destroy ();
 }
 
@@ -617,6 +618,14 @@ static void Interpreter_addStringVariable (Interpreter me, const char32 *key, co
 	variable.releaseToAmbiguousOwner();
 }
 
+void Interpreter_forgetCompiledExpressions (Interpreter me) {
+	for (auto it = my compiledExpressions. begin(); it != my compiledExpressions. end(); it ++) {
+		FormulaCompiledExpression compiled = it -> second;
+		FormulaCompiledExpression_free (compiled);
+	}
+	my compiledExpressions. clear ();
+}
+
 InterpreterVariable Interpreter_hasVariable (Interpreter me, const char32 *key) {
 	Melder_assert (key);
 	auto it = my variablesMap. find (key [0] == U'.' ? Melder_cat (my procedureNames [my callDepth], key) : key);
@@ -775,6 +784,7 @@ void Interpreter_run (Interpreter me, char32 *text) {
 			forget (var);
 		}
 		my variablesMap. clear ();
+		Interpreter_forgetCompiledExpressions (me);
 		for (ipar = 1; ipar <= my numberOfParameters; ipar ++) {
 			char32 parameter [200];
 			/*
@@ -832,6 +842,12 @@ void Interpreter_run (Interpreter me, char32 *text) {
 		 */
 		#define wordEnd(c)  (c == U'\0' || c == U' ' || c == U'\t')
 		trace (U"going to handle ", numberOfLines, U" lines");
+		/*
+			The targets of the jumps in loops and conditionals depend on the text of the lines only,
+			so we have to search for them only once.
+			Only lines whose keyword is literally in the text (i.e. not the result of variable substitution) qualify.
+		*/
+		autoNUMvector <long> jumpTargets (1, numberOfLines);   // 0 = not yet known
 		//for (lineNumber = 1; lineNumber <= numberOfLines; lineNumber ++) {
 			//trace (U"line ", lineNumber, U": ", lines [lineNumber]);
 		//}
@@ -1156,47 +1172,63 @@ void Interpreter_run (Interpreter me, char32 *text) {
 							if (str32nequ (command2.string, U"endif", 5) && wordEnd (command2.string [5])) {
 								/* Ignore. */
 							} else if (str32nequ (command2.string, U"endfor", 6) && wordEnd (command2.string [6])) {
-								int depth = 0;
-								long iline;
-								for (iline = lineNumber - 1; iline > 0; iline --) {
-									char32 *line = lines [iline];
-									if (line [0] == U'f' && line [1] == U'o' && line [2] == U'r' && line [3] == U' ') {
-										if (depth == 0) { lineNumber = iline - 1; fromendfor = true; break; }   // go before 'for'
-										else depth --;
-									} else if (str32nequ (lines [iline], U"endfor", 6) && wordEnd (lines [iline] [6])) {
-										depth ++;
+								const bool literal = str32nequ (lines [lineNumber], U"endfor", 6);
+								long iline = literal ? jumpTargets [lineNumber] : 0;
+								if (iline == 0) {
+									int depth = 0;
+									for (iline = lineNumber - 1; iline > 0; iline --) {
+										char32 *line = lines [iline];
+										if (line [0] == U'f' && line [1] == U'o' && line [2] == U'r' && line [3] == U' ') {
+											if (depth == 0) break;
+											else depth --;
+										} else if (str32nequ (lines [iline], U"endfor", 6) && wordEnd (lines [iline] [6])) {
+											depth ++;
+										}
 									}
+									if (iline <= 0) Melder_throw (U"Unmatched 'endfor'.");
+									if (literal) jumpTargets [lineNumber] = iline;
 								}
-								if (iline <= 0) Melder_throw (U"Unmatched 'endfor'.");
+								lineNumber = iline - 1;   // go before 'for'
+								fromendfor = true;
 							} else if (str32nequ (command2.string, U"endwhile", 8) && wordEnd (command2.string [8])) {
-								int depth = 0;
-								long iline;
-								for (iline = lineNumber - 1; iline > 0; iline --) {
-									if (str32nequ (lines [iline], U"while ", 6)) {
-										if (depth == 0) { lineNumber = iline - 1; break; }   // go before 'while'
-										else depth --;
-									} else if (str32nequ (lines [iline], U"endwhile", 8) && wordEnd (lines [iline] [8])) {
-										depth ++;
+								const bool literal = str32nequ (lines [lineNumber], U"endwhile", 8);
+								long iline = literal ? jumpTargets [lineNumber] : 0;
+								if (iline == 0) {
+									int depth = 0;
+									for (iline = lineNumber - 1; iline > 0; iline --) {
+										if (str32nequ (lines [iline], U"while ", 6)) {
+											if (depth == 0) break;
+											else depth --;
+										} else if (str32nequ (lines [iline], U"endwhile", 8) && wordEnd (lines [iline] [8])) {
+											depth ++;
+										}
 									}
+									if (iline <= 0) Melder_throw (U"Unmatched 'endwhile'.");
+									if (literal) jumpTargets [lineNumber] = iline;
 								}
-								if (iline <= 0) Melder_throw (U"Unmatched 'endwhile'.");
+								lineNumber = iline - 1;   // go before 'while'
 							} else if (str32nequ (command2.string, U"endproc", 7) && wordEnd (command2.string [7])) {
 								if (callDepth == 0) Melder_throw (U"Unmatched 'endproc'.");
 								lineNumber = callStack [callDepth --];
 								-- my callDepth;
 							} else fail = true;
 						} else if (str32nequ (command2.string, U"else", 4) && wordEnd (command2.string [4])) {
-							int depth = 0;
-							long iline;
-							for (iline = lineNumber + 1; iline <= numberOfLines; iline ++) {
-								if (str32nequ (lines [iline], U"endif", 5) && wordEnd (lines [iline] [5])) {
-									if (depth == 0) { lineNumber = iline; break; }   // go after 'endif'
-									else depth --;
-								} else if (str32nequ (lines [iline], U"if ", 3)) {
-									depth ++;
+							const bool literal = str32nequ (lines [lineNumber], U"else", 4);
+							long iline = literal ? jumpTargets [lineNumber] : 0;
+							if (iline == 0) {
+								int depth = 0;
+								for (iline = lineNumber + 1; iline <= numberOfLines; iline ++) {
+									if (str32nequ (lines [iline], U"endif", 5) && wordEnd (lines [iline] [5])) {
+										if (depth == 0) break;
+										else depth --;
+									} else if (str32nequ (lines [iline], U"if ", 3)) {
+										depth ++;
+									}
 								}
+								if (iline > numberOfLines) Melder_throw (U"Unmatched 'else'.");
+								if (literal) jumpTargets [lineNumber] = iline;
 							}
-							if (iline > numberOfLines) Melder_throw (U"Unmatched 'else'.");
+							lineNumber = iline;   // go after 'endif'
 						} else if (str32nequ (command2.string, U"elsif ", 6) || str32nequ (command2.string, U"elif ", 5)) {
 							if (fromif) {
 								double value;
@@ -1317,21 +1349,31 @@ void Interpreter_run (Interpreter me, char32 *text) {
 							double value;
 							Interpreter_numericExpression (me, command2.string + 3, & value);
 							if (value == 0.0) {
-								int depth = 0;
-								long iline;
-								for (iline = lineNumber + 1; iline <= numberOfLines; iline ++) {
-									if (str32nequ (lines [iline], U"endif", 5)) {
-										if (depth == 0) { lineNumber = iline; break; }   // go after 'endif'
-										else depth --;
-									} else if (str32nequ (lines [iline], U"else", 4)) {
-										if (depth == 0) { lineNumber = iline; break; }   // go after 'else'
-									} else if (str32nequ (lines [iline], U"elsif ", 6) || str32nequ (lines [iline], U"elif ", 5)) {
-										if (depth == 0) { lineNumber = iline - 1; fromif = true; break; }   // go at 'elsif'
-									} else if (str32nequ (lines [iline], U"if ", 3)) {
-										depth ++;
+								const bool literal = str32nequ (lines [lineNumber], U"if ", 3);
+								long iline = literal ? jumpTargets [lineNumber] : 0;
+								if (iline == 0) {
+									int depth = 0;
+									for (iline = lineNumber + 1; iline <= numberOfLines; iline ++) {
+										if (str32nequ (lines [iline], U"endif", 5)) {
+											if (depth == 0) break;
+											else depth --;
+										} else if (str32nequ (lines [iline], U"else", 4)) {
+											if (depth == 0) break;
+										} else if (str32nequ (lines [iline], U"elsif ", 6) || str32nequ (lines [iline], U"elif ", 5)) {
+											if (depth == 0) break;
+										} else if (str32nequ (lines [iline], U"if ", 3)) {
+											depth ++;
+										}
 									}
+									if (iline > numberOfLines) Melder_throw (U"Unmatched 'if'.");
+									if (literal) jumpTargets [lineNumber] = iline;
+								}
+								if (str32nequ (lines [iline], U"elsif ", 6) || str32nequ (lines [iline], U"elif ", 5)) {
+									lineNumber = iline - 1;   // go at 'elsif'
+									fromif = true;
+								} else {
+									lineNumber = iline;   // go after 'endif' or 'else'
 								}
-								if (iline > numberOfLines) Melder_throw (U"Unmatched 'if'.");
 							} else if (value == NUMundefined) {
 								Melder_throw (U"The value of the 'if' condition is undefined.");
 							}
@@ -1400,17 +1442,22 @@ void Interpreter_run (Interpreter me, char32 *text) {
 							double value;
 							Interpreter_numericExpression (me, command2.string + 6, & value);
 							if (value == 0.0) {
-								int depth = 0;
-								long iline;
-								for (iline = lineNumber - 1; iline > 0; iline --) {
-									if (str32nequ (lines [iline], U"repeat", 6) && wordEnd (lines [iline] [6])) {
-										if (depth == 0) { lineNumber = iline; break; }   // go after 'repeat'
-										else depth --;
-									} else if (str32nequ (lines [iline], U"until ", 6)) {
-										depth ++;
+								const bool literal = str32nequ (lines [lineNumber], U"until ", 6);
+								long iline = literal ? jumpTargets [lineNumber] : 0;
+								if (iline == 0) {
+									int depth = 0;
+									for (iline = lineNumber - 1; iline > 0; iline --) {
+										if (str32nequ (lines [iline], U"repeat", 6) && wordEnd (lines [iline] [6])) {
+											if (depth == 0) break;
+											else depth --;
+										} else if (str32nequ (lines [iline], U"until ", 6)) {
+											depth ++;
+										}
 									}
+									if (iline <= 0) Melder_throw (U"Unmatched 'until'.");
+									if (literal) jumpTargets [lineNumber] = iline;
 								}
-								if (iline <= 0) Melder_throw (U"Unmatched 'until'.");
+								lineNumber = iline;   // go after 'repeat'
 							}
 						} else fail = true;
 						break;
@@ -1857,8 +1904,8 @@ void Interpreter_run (Interpreter me, char32 *text) {
 							if (status == 0) {
 								value = NUMundefined;
 							} else if (valueString.string [0] == 1) {   // ...not overwritten by any MelderInfo function? then the return value will be the selected object
-								int IOBJECT, result = 0, found = 0;
-								WHERE (SELECTED) { result = IOBJECT; found += 1; }
+								int IOBJECT, result = 0, found = theCurrentPraatObjects -> totalSelection;
+								WHERE_DOWN (SELECTED) { result = IOBJECT; break; }   // a new object is at the bottom of the list
 								if (found > 1) {
 									Melder_throw (U"Multiple objects selected. Cannot assign ID to variable.");
 								} else if (found == 0) {
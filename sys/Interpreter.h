@@ -56,6 +56,7 @@ Thing_define (Interpreter, Thing) {
 	long labelLines [1+Interpreter_MAXNUM_LABELS];
 	char32 dialogTitle [1+100], procedureNames [1+Interpreter_MAX_CALL_DEPTH] [100];
 	std::unordered_map <std::u32string, InterpreterVariable> variablesMap;
+	std::unordered_map <std::u32string, FormulaCompiledExpression> compiledExpressions;   // refer to the variables in variablesMap
 	bool running, stopped;
 
 	void v_destroy () noexcept
@@ -87,5 +88,7 @@ void Interpreter_anyExpression (Interpreter me, const char32 *expression, struct
 InterpreterVariable Interpreter_hasVariable (Interpreter me, const char32 *key);
 InterpreterVariable Interpreter_lookUpVariable (Interpreter me, const char32 *key);
 
+void Interpreter_forgetCompiledExpressions (Interpreter me);   // should be called whenever variables are removed
+
 /* End of file Interpreter.h */
 #endif
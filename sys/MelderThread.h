@@ -46,6 +46,7 @@
 	#define MelderThread_RETURN  return 0;
 #elif USE_PTHREADS
 	#include <pthread.h>
+	#include <unistd.h>
 	#define MelderThread_MUTEX(_mutex)  static pthread_mutex_t _mutex = (pthread_mutex_t) PTHREAD_MUTEX_INITIALIZER
 	#define MelderThread_MUTEX_INIT(_mutex)  (void) 0
 	#define MelderThread_LOCK(_mutex)  pthread_mutex_lock (& _mutex)
@@ -79,30 +80,43 @@
 	#define MelderThread_UNLOCK(_mutex)  _mutex = 0
 #endif
 
-static int MelderThread_getNumberOfProcessors () {
+static inline int MelderThread_getNumberOfProcessors () {
+	if (Melder_debug == 49) return 1;   // to check a multithreaded result against the single-threaded one
+	if (Melder_debug == 50) return 16;   // to exercise the threads on a machine with few processors
 	#if USE_WINTHREADS
-		return 8;
+		SYSTEM_INFO systemInfo;
+		GetSystemInfo (& systemInfo);
+		return systemInfo. dwNumberOfProcessors > 0 ? (int) systemInfo. dwNumberOfProcessors : 1;
 	#elif USE_PTHREADS
-		return 8;
+		long numberOfProcessors = sysconf (_SC_NPROCESSORS_ONLN);
+		return numberOfProcessors > 0 ? (int) numberOfProcessors : 1;
 	#elif USE_CPPTHREADS
-		return std::thread::hardware_concurrency ();
+		int numberOfProcessors = (int) std::thread::hardware_concurrency ();
+		return numberOfProcessors > 0 ? numberOfProcessors : 1;
 	#else
 		return 1;
 	#endif
 }
 
+/*
+	The per-thread arguments of MelderThread_run can be either Things (autoThing array)
+	or plain structs (array of structs).
+*/
+template <class T> inline T * MelderThread_getArgs (_Thing_auto <T> & args) { return args.get(); }
+template <class T> inline T * MelderThread_getArgs (T & args) { return & args; }
+
 #if USE_WINTHREADS
-	template <class T> void MelderThread_run (DWORD (WINAPI *func) (T *), _Thing_auto <T> *args, int numberOfThreads) {
+	template <class T, class Args> void MelderThread_run (DWORD (WINAPI *func) (T *), Args *args, int numberOfThreads) {
 		if (numberOfThreads == 1) {
-			func (args [0].get());
+			func (MelderThread_getArgs (args [0]));
 		} else {
 			std::vector <HANDLE> threads (numberOfThreads);
 			try {
 				for (int ithread = 1; ithread < numberOfThreads; ithread ++) {
 					threads [ithread - 1] = CreateThread (nullptr, 0,
-						(DWORD (WINAPI *)(void *)) func, (void *) args [ithread - 1].get(), 0, nullptr);
+						(DWORD (WINAPI *)(void *)) func, (void *) MelderThread_getArgs (args [ithread - 1]), 0, nullptr);
 				}
-				func (args [numberOfThreads - 1].get());
+				func (MelderThread_getArgs (args [numberOfThreads - 1]));
 			} catch (MelderError) {
 				for (int ithread = 1; ithread < numberOfThreads; ithread ++) {
 					WaitForSingleObject (threads [ithread - 1], INFINITE);
@@ -117,17 +131,17 @@ static int MelderThread_getNumberOfProcessors () {
 		}
 	}
 #elif USE_PTHREADS
-	template <class T> void MelderThread_run (void * (*func) (T *), _Thing_auto <T> *args, int numberOfThreads) {
+	template <class T, class Args> void MelderThread_run (void * (*func) (T *), Args *args, int numberOfThreads) {
 		if (numberOfThreads == 1) {
-			func (args [0].get());
+			func (MelderThread_getArgs (args [0]));
 		} else {
 			std::vector <pthread_t> threads (numberOfThreads);
 			try {
 				for (int ithread = 1; ithread < numberOfThreads; ithread ++) {
 					(void) pthread_create (& threads [ithread - 1],
-						nullptr, (void*(*)(void *)) func, (void *) args [ithread - 1].get());
+						nullptr, (void*(*)(void *)) func, (void *) MelderThread_getArgs (args [ithread - 1]));
 				}
-				func (args [numberOfThreads - 1].get());
+				func (MelderThread_getArgs (args [numberOfThreads - 1]));
 			} catch (MelderError) {
 				for (int ithread = 1; ithread < numberOfThreads; ithread ++) {
 					pthread_join (threads [ithread - 1], nullptr);
@@ -140,16 +154,16 @@ static int MelderThread_getNumberOfProcessors () {
 		}
 	}
 #elif USE_CPPTHREADS
-	template <class T> void MelderThread_run (void * (*func) (T *), _Thing_auto <T> *args, int numberOfThreads) {
+	template <class T, class Args> void MelderThread_run (void * (*func) (T *), Args *args, int numberOfThreads) {
 		if (numberOfThreads == 1) {
-			func (args [0].get());
+			func (MelderThread_getArgs (args [0]));
 		} else {
 			std::vector <std::thread> thread (numberOfThreads);
 			try {
 				for (int ithread = 1; ithread < numberOfThreads; ithread ++) {
-					thread [ithread - 1] = std::thread (func, args [ithread - 1].get());
+					thread [ithread - 1] = std::thread (func, MelderThread_getArgs (args [ithread - 1]));
 				}
-				func (args [numberOfThreads - 1].get());
+				func (MelderThread_getArgs (args [numberOfThreads - 1]));
 			} catch (MelderError) {
 				for (int ithread = 1; ithread < numberOfThreads; ithread ++) {
 					if (thread [ithread - 1]. joinable ())
@@ -163,8 +177,8 @@ static int MelderThread_getNumberOfProcessors () {
 		}
 	}
 #else
-	template <class T> void MelderThread_run (void (*func) (T *), _Thing_auto <T> *args, int numberOfThreads) {
-		func (args [0].get());
+	template <class T, class Args> void MelderThread_run (void (*func) (T *), Args *args, int numberOfThreads) {
+		func (MelderThread_getArgs (args [0]));
 	}
 #endif
 
@@ -20,7 +20,7 @@
 #include <time.h>
 #include "Thing.h"
 
-long theTotalNumberOfThings;
+std::atomic <long> theTotalNumberOfThings (0);
 
 void structThing :: v_info ()
 {
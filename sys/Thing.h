@@ -241,7 +241,7 @@ void * _Thing_check (Thing me, ClassInfo table, const char *fileName, int line);
 
 /* For debugging. */
 
-extern long theTotalNumberOfThings;
+extern std::atomic <long> theTotalNumberOfThings;   // atomic because Things can be created on several threads at once
 /* This number is 0 initially, increments at every successful `new', and decrements at every `forget'. */
 
 template <class T>
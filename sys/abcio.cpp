@@ -35,6 +35,8 @@
 #include "melder.h"
 #include "NUM.h"
 #include <ctype.h>
+#include <algorithm>
+#include <limits>
 #ifdef macintosh
 	#include <TargetConditionals.h>
 #endif
@@ -1250,6 +1252,35 @@ void binputu4LE (uint32 u, FILE *f) {
 	}
 }
 
+static void binario_encodeR4 (double x, uint8 *bytes) {
+	int sign, exponent;
+	double fMantissa, fsMantissa;
+	uint32 mantissa;
+	if (x < 0.0) { sign = 0x0100; x *= -1.0; }
+	else sign = 0;
+	if (x == 0.0) { exponent = 0; mantissa = 0; }
+	else {
+		fMantissa = frexp (x, & exponent);
+		if ((exponent > 128) || ! (fMantissa < 1))   // Infinity or Not-a-Number
+			{ exponent = sign | 0x00FF; mantissa = 0; }   // Infinity
+		else {   // finite
+			exponent += 126;   // add bias
+			if (exponent <= 0) {   // denormalized
+				fMantissa = ldexp (fMantissa, exponent - 1);
+				exponent = 0;
+			}
+			exponent |= sign;
+			fMantissa = ldexp (fMantissa, 24);          
+			fsMantissa = floor (fMantissa); 
+			mantissa = (uint32) fsMantissa & 0x007FFFFF;
+		}
+	}
+	bytes [0] = (uint8) (exponent >> 1);   // truncate: bits 2 through 9 (bit 9 is the sign bit)
+	bytes [1] = (uint8) ((exponent << 7) | (mantissa >> 16));   // truncate
+	bytes [2] = (uint8) (mantissa >> 8);   // truncate
+	bytes [3] = (uint8) mantissa;   // truncate
+}
+
 void binputr4 (double x, FILE *f) {
 	try {
 		if (binario_floatIEEE4msb && Melder_debug != 18) {
@@ -1257,32 +1288,7 @@ void binputr4 (double x, FILE *f) {
 			if (fwrite (& x4, sizeof (float), 1, f) != 1) writeError (U"a 32-bit floating-point number.");
 		} else {
 			uint8 bytes [4];
-			int sign, exponent;
-			double fMantissa, fsMantissa;
-			uint32 mantissa;
-			if (x < 0.0) { sign = 0x0100; x *= -1.0; }
-			else sign = 0;
-			if (x == 0.0) { exponent = 0; mantissa = 0; }
-			else {
-				fMantissa = frexp (x, & exponent);
-				if ((exponent > 128) || ! (fMantissa < 1))   // Infinity or Not-a-Number
-					{ exponent = sign | 0x00FF; mantissa = 0; }   // Infinity
-				else {   // finite
-					exponent += 126;   // add bias
-					if (exponent <= 0) {   // denormalized
-						fMantissa = ldexp (fMantissa, exponent - 1);
-						exponent = 0;
-					}
-					exponent |= sign;
-					fMantissa = ldexp (fMantissa, 24);          
-					fsMantissa = floor (fMantissa); 
-					mantissa = (uint32) fsMantissa & 0x007FFFFF;
-				}
-			}
-			bytes [0] = (uint8) (exponent >> 1);   // truncate: bits 2 through 9 (bit 9 is the sign bit)
-			bytes [1] = (uint8) ((exponent << 7) | (mantissa >> 16));   // truncate
-			bytes [2] = (uint8) (mantissa >> 8);   // truncate
-			bytes [3] = (uint8) mantissa;   // truncate
+			binario_encodeR4 (x, bytes);
 			if (fwrite (bytes, sizeof (uint8), 4, f) != 4) writeError (U"four bytes.");
 		}
 	} catch (MelderError) {
@@ -1376,6 +1382,129 @@ void binputr8 (double x, FILE *f) {
 	}
 }
 
+/*
+	Reading and writing vectors of real numbers.
+	The bytes are moved in blocks, and converted in memory.
+	On a machine with IEEE floating-point numbers,
+	the most-significant-byte-first bit patterns can be reassembled into a 32-bit or 64-bit integer
+	and reinterpreted as a float or a double; this gives the same values as bingetr4 and bingetr8,
+	as long as infinities and NaN's are mapped to HUGE_VAL just as those functions do.
+*/
+#define binario_NUMBERS_PER_BLOCK  8192
+
+static inline double binario_decodeR4 (const uint8 *bytes) {
+	uint32 bits =
+		(uint32) bytes [0] << 24 | (uint32) bytes [1] << 16 | (uint32) bytes [2] << 8 | (uint32) bytes [3];
+	if ((bits & 0x7F800000) == 0x7F800000)   // Infinity or Not-a-Number
+		return bytes [0] & 0x80 ? - HUGE_VAL : HUGE_VAL;
+	float x;
+	memcpy (& x, & bits, 4);
+	return x;
+}
+
+static inline double binario_decodeR8 (const uint8 *bytes) {
+	uint64_t bits =
+		(uint64_t) bytes [0] << 56 | (uint64_t) bytes [1] << 48 | (uint64_t) bytes [2] << 40 | (uint64_t) bytes [3] << 32 |
+		(uint64_t) bytes [4] << 24 | (uint64_t) bytes [5] << 16 | (uint64_t) bytes [6] << 8 | (uint64_t) bytes [7];
+	if ((bits & 0x7FF0000000000000) == 0x7FF0000000000000)   // Infinity or Not-a-Number
+		return bytes [0] & 0x80 ? - HUGE_VAL : HUGE_VAL;
+	double x;
+	memcpy (& x, & bits, 8);
+	return x;
+}
+
+static inline void binario_encodeR8 (double x, uint8 *bytes) {
+	uint64_t bits;
+	if (x == 0.0)
+		bits = 0;   // binputr8 writes minus zero as plus zero
+	else if (isnan (x))
+		bits = 0x7FF0000000000000;   // plus infinity, as in binputr8
+	else
+		memcpy (& bits, & x, 8);
+	for (int ibyte = 7; ibyte >= 0; ibyte --) {
+		bytes [ibyte] = (uint8) bits;
+		bits >>= 8;
+	}
+}
+
+static bool binario_canConvertInMemory () {
+	return std::numeric_limits <float>::is_iec559 && std::numeric_limits <double>::is_iec559 &&
+		! binario_floatIEEE4msb && ! binario_doubleIEEE8msb &&   // there, bingetr4 and bingetr8 read the bits as they are, without mapping NaN's to HUGE_VAL
+		Melder_debug != 18;
+}
+
+void bingetr4_vector (double *x, long n, FILE *f) {
+	if (! binario_canConvertInMemory ()) {
+		for (long i = 0; i < n; i ++) x [i] = bingetr4 (f);
+		return;
+	}
+	try {
+		uint8 bytes [4 * binario_NUMBERS_PER_BLOCK];
+		for (long offset = 0; offset < n; offset += binario_NUMBERS_PER_BLOCK) {
+			size_t numberOfNumbers = (size_t) std::min ((long) binario_NUMBERS_PER_BLOCK, n - offset);
+			if (fread (bytes, 4, numberOfNumbers, f) != numberOfNumbers) readError (f, U"a block of 32-bit floating-point numbers.");
+			for (size_t i = 0; i < numberOfNumbers; i ++)
+				x [offset + (long) i] = binario_decodeR4 (& bytes [4 * i]);
+		}
+	} catch (MelderError) {
+		Melder_throw (U"Floating-point numbers not read from binary file.");
+	}
+}
+
+void binputr4_vector (const double *x, long n, FILE *f) {
+	if (! binario_canConvertInMemory ()) {
+		for (long i = 0; i < n; i ++) binputr4 (x [i], f);
+		return;
+	}
+	try {
+		uint8 bytes [4 * binario_NUMBERS_PER_BLOCK];
+		for (long offset = 0; offset < n; offset += binario_NUMBERS_PER_BLOCK) {
+			size_t numberOfNumbers = (size_t) std::min ((long) binario_NUMBERS_PER_BLOCK, n - offset);
+			for (size_t i = 0; i < numberOfNumbers; i ++)
+				binario_encodeR4 (x [offset + (long) i], & bytes [4 * i]);   // with the truncation of binputr4
+			if (fwrite (bytes, 4, numberOfNumbers, f) != numberOfNumbers) writeError (U"a block of 32-bit floating-point numbers.");
+		}
+	} catch (MelderError) {
+		Melder_throw (U"Floating-point numbers not written to binary file.");
+	}
+}
+
+void bingetr8_vector (double *x, long n, FILE *f) {
+	if (! binario_canConvertInMemory ()) {
+		for (long i = 0; i < n; i ++) x [i] = bingetr8 (f);
+		return;
+	}
+	try {
+		uint8 bytes [8 * binario_NUMBERS_PER_BLOCK];
+		for (long offset = 0; offset < n; offset += binario_NUMBERS_PER_BLOCK) {
+			size_t numberOfNumbers = (size_t) std::min ((long) binario_NUMBERS_PER_BLOCK, n - offset);
+			if (fread (bytes, 8, numberOfNumbers, f) != numberOfNumbers) readError (f, U"a block of 64-bit floating-point numbers.");
+			for (size_t i = 0; i < numberOfNumbers; i ++)
+				x [offset + (long) i] = binario_decodeR8 (& bytes [8 * i]);
+		}
+	} catch (MelderError) {
+		Melder_throw (U"Floating-point numbers not read from binary file.");
+	}
+}
+
+void binputr8_vector (const double *x, long n, FILE *f) {
+	if (! binario_canConvertInMemory ()) {
+		for (long i = 0; i < n; i ++) binputr8 (x [i], f);
+		return;
+	}
+	try {
+		uint8 bytes [8 * binario_NUMBERS_PER_BLOCK];
+		for (long offset = 0; offset < n; offset += binario_NUMBERS_PER_BLOCK) {
+			size_t numberOfNumbers = (size_t) std::min ((long) binario_NUMBERS_PER_BLOCK, n - offset);
+			for (size_t i = 0; i < numberOfNumbers; i ++)
+				binario_encodeR8 (x [offset + (long) i], & bytes [8 * i]);
+			if (fwrite (bytes, 8, numberOfNumbers, f) != numberOfNumbers) writeError (U"a block of 64-bit floating-point numbers.");
+		}
+	} catch (MelderError) {
+		Melder_throw (U"Floating-point numbers not written to binary file.");
+	}
+}
+
 void binputr10 (double x, FILE *f) {
 	try {
 		unsigned char bytes [10];
@@ -166,6 +166,13 @@ double bingetr8 (FILE *f);   void binputr8 (double x, FILE *f);
 	This is the native format of a `double` on Silicon Graphics Iris and PowerMac.
 */
 
+void bingetr4_vector (double *x, long n, FILE *f);   void binputr4_vector (const double *x, long n, FILE *f);
+void bingetr8_vector (double *x, long n, FILE *f);   void binputr8_vector (const double *x, long n, FILE *f);
+/*
+	Read or write the n numbers x [0..n-1] in the same format as bingetr4/binputr4 or bingetr8/binputr8,
+	but with a few large reads or writes instead of one per number.
+*/
+
 double bingetr10 (FILE *f);   void binputr10 (double x, FILE *f);
 /*
 	Read or write a real number from or to 10 bytes in the stream `f`,
@@ -18,6 +18,7 @@
 
 //#include <ctype.h>
 //#include <assert.h>
+#include <atomic>
 #include "melder.h"
 #include "regularExp.h"
 #ifdef _WIN32
@@ -115,7 +116,7 @@ static struct {
 
 /********** PROGRESS **********/
 
-static int theProgressDepth = 0;
+static std::atomic <int> theProgressDepth (0);   // may be switched off and on by analyses on several threads
 void Melder_progressOff () { theProgressDepth --; }
 void Melder_progressOn () { theProgressDepth ++; }
 
@@ -125,7 +126,7 @@ static void _Melder_progress (double progress, const char32 *message) {
 	}
 }
 
-static MelderString theProgressBuffer = { 0 };
+static thread_local MelderString theProgressBuffer { 0 };   // every thread has its own, like the error buffer
 
 void Melder_progress (double progress) {
 	_Melder_progress (progress, U"");
@@ -312,11 +313,11 @@ void Melder_search () {
 
 /********** WARNING **********/
 
-static int theWarningDepth = 0;
+static std::atomic <int> theWarningDepth (0);
 void Melder_warningOff () { theWarningDepth --; }
 void Melder_warningOn () { theWarningDepth ++; }
 
-static MelderString theWarningBuffer = { 0 };
+static thread_local MelderString theWarningBuffer { 0 };
 
 void Melder_warning (Melder_1_ARG) {
 	if (theWarningDepth < 0) return;
@@ -34,6 +34,7 @@
 #endif
 #include <stdbool.h>
 #include <functional>
+#include <atomic>
 /*
  * The following two lines are for obsolete (i.e. C99) versions of stdint.h
  */
@@ -20,8 +20,12 @@
 #include <wctype.h>
 #include <assert.h>
 
-static int64 totalNumberOfAllocations = 0, totalNumberOfDeallocations = 0, totalAllocationSize = 0,
-	totalNumberOfMovingReallocs = 0, totalNumberOfReallocsInSitu = 0;
+/*
+ * The statistics are atomic, because memory can be allocated on several threads at once
+ * (e.g. in Sampled_analyseFrames).
+ */
+static std::atomic <int64> totalNumberOfAllocations (0), totalNumberOfDeallocations (0), totalAllocationSize (0),
+	totalNumberOfMovingReallocs (0), totalNumberOfReallocsInSitu (0);
 
 /*
  * The rainy-day fund.
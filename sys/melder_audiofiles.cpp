@@ -18,11 +18,17 @@
 
 #include "melder.h"
 #include "abcio.h"
+#include "NUM.h"
 #include "math.h"
 #include "flac_FLAC_metadata.h"
 #include "flac_FLAC_stream_decoder.h"
 #include "flac_FLAC_stream_encoder.h"
 #include "mp3.h"
+#if ! defined (_WIN32)
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
 
 /***** WRITING *****/
 
@@ -852,6 +858,145 @@ static void Melder_readMp3File (FILE *f, int numberOfChannels, double **buffer,
 		Melder_throw (U"Error decoding MP3 file.");
 }
 
+/*
+	Uncompressed linear and floating-point samples are decoded one channel at a time,
+	from a memory mapping of the file if possible, or else from a buffer of limited size.
+	The decoding loops are simple enough for the compiler to vectorize.
+*/
+static int Melder_numberOfBytesPerSamplePerChannel (int encoding) {
+	return
+		encoding == Melder_LINEAR_16_BIG_ENDIAN || encoding == Melder_LINEAR_16_LITTLE_ENDIAN ? 2 :
+		encoding == Melder_LINEAR_24_BIG_ENDIAN || encoding == Melder_LINEAR_24_LITTLE_ENDIAN ? 3 : 4;
+}
+
+static inline double Melder_float32FromBits (uint32 bits) {
+	float value;
+	memcpy (& value, & bits, 4);
+	/*
+		Infinity or Not-a-Number (exponent 255) become +/- HUGE_VAL, as in bingetr4 and bingetr4LE.
+	*/
+	return (bits & 0x7F800000) == 0x7F800000 ? ( bits & 0x80000000 ? - HUGE_VAL : HUGE_VAL ) : value;
+}
+
+template <typename Decode>
+static void Melder_decodeChannels (const uint8 *bytes, int numberOfChannels, int numberOfBytesPerSamplePerChannel,
+	double **buffer, long firstSample, long numberOfSamples, Decode decode)
+{
+	const long stride = numberOfChannels * numberOfBytesPerSamplePerChannel;
+	for (int ichan = 1; ichan <= numberOfChannels; ichan ++) {
+		const uint8 *from = bytes + (ichan - 1) * numberOfBytesPerSamplePerChannel;
+		double *to = & buffer [ichan] [firstSample];
+		for (long isamp = 0; isamp < numberOfSamples; isamp ++)
+			to [isamp] = decode (from + isamp * stride);
+	}
+}
+
+static void Melder_decodeAudioToFloat (const uint8 *bytes, int numberOfChannels, int encoding,
+	double **buffer, long firstSample, long numberOfSamples)
+{
+	const int n = Melder_numberOfBytesPerSamplePerChannel (encoding);
+	switch (encoding) {
+		case Melder_LINEAR_16_BIG_ENDIAN:
+			Melder_decodeChannels (bytes, numberOfChannels, n, buffer, firstSample, numberOfSamples, [] (const uint8 *p) {
+				return (int16) (uint16) ((uint16) ((uint16) p [0] << 8) | (uint16) p [1]) * (1.0 / 32768);
+			});
+			break;
+		case Melder_LINEAR_16_LITTLE_ENDIAN:
+			Melder_decodeChannels (bytes, numberOfChannels, n, buffer, firstSample, numberOfSamples, [] (const uint8 *p) {
+				return (int16) (uint16) ((uint16) ((uint16) p [1] << 8) | (uint16) p [0]) * (1.0 / 32768);
+			});
+			break;
+		case Melder_LINEAR_24_BIG_ENDIAN:
+			Melder_decodeChannels (bytes, numberOfChannels, n, buffer, firstSample, numberOfSamples, [] (const uint8 *p) {
+				return (int32) ((uint32) p [0] << 24 | (uint32) p [1] << 16 | (uint32) p [2] << 8) * (1.0 / 32768 / 65536);
+			});
+			break;
+		case Melder_LINEAR_24_LITTLE_ENDIAN:
+			Melder_decodeChannels (bytes, numberOfChannels, n, buffer, firstSample, numberOfSamples, [] (const uint8 *p) {
+				return (int32) ((uint32) p [2] << 24 | (uint32) p [1] << 16 | (uint32) p [0] << 8) * (1.0 / 32768 / 65536);
+			});
+			break;
+		case Melder_LINEAR_32_BIG_ENDIAN:
+			Melder_decodeChannels (bytes, numberOfChannels, n, buffer, firstSample, numberOfSamples, [] (const uint8 *p) {
+				return (int32) ((uint32) p [0] << 24 | (uint32) p [1] << 16 | (uint32) p [2] << 8 | (uint32) p [3]) * (1.0 / 32768 / 65536);
+			});
+			break;
+		case Melder_LINEAR_32_LITTLE_ENDIAN:
+			Melder_decodeChannels (bytes, numberOfChannels, n, buffer, firstSample, numberOfSamples, [] (const uint8 *p) {
+				return (int32) ((uint32) p [3] << 24 | (uint32) p [2] << 16 | (uint32) p [1] << 8 | (uint32) p [0]) * (1.0 / 32768 / 65536);
+			});
+			break;
+		case Melder_IEEE_FLOAT_32_BIG_ENDIAN:
+			Melder_decodeChannels (bytes, numberOfChannels, n, buffer, firstSample, numberOfSamples, [] (const uint8 *p) {
+				return Melder_float32FromBits ((uint32) p [0] << 24 | (uint32) p [1] << 16 | (uint32) p [2] << 8 | (uint32) p [3]);
+			});
+			break;
+		case Melder_IEEE_FLOAT_32_LITTLE_ENDIAN:
+			Melder_decodeChannels (bytes, numberOfChannels, n, buffer, firstSample, numberOfSamples, [] (const uint8 *p) {
+				return Melder_float32FromBits ((uint32) p [3] << 24 | (uint32) p [2] << 16 | (uint32) p [1] << 8 | (uint32) p [0]);
+			});
+			break;
+		default:
+			Melder_fatal (U"Melder_decodeAudioToFloat: unexpected encoding ", encoding, U".");
+	}
+}
+
+static bool Melder_readAudioToFloat_mapped (FILE *f, int numberOfChannels, int encoding, double **buffer, long numberOfSamples) {
+	#if defined (_WIN32)
+		(void) f; (void) numberOfChannels; (void) encoding; (void) buffer; (void) numberOfSamples;
+		return false;
+	#else
+		const double numberOfBytes_f = (double) numberOfChannels * (double) numberOfSamples *
+			(double) Melder_numberOfBytesPerSamplePerChannel (encoding);
+		if (numberOfBytes_f > (double) SIZE_MAX / 2) return false;
+		const size_t numberOfBytes = (size_t) numberOfBytes_f;
+		if (numberOfBytes == 0) return false;
+		const int fileDescriptor = fileno (f);
+		struct stat fileStatus;
+		if (fileDescriptor < 0 || fstat (fileDescriptor, & fileStatus) != 0 || ! S_ISREG (fileStatus. st_mode)) return false;
+		const off_t offset = ftello (f);
+		if (offset < 0 || (double) offset + numberOfBytes_f > (double) fileStatus. st_size)
+			return false;   // the file is too small: let the buffered version read what is there and warn
+		const long pageSize = sysconf (_SC_PAGESIZE);
+		if (pageSize <= 0) return false;
+		const off_t mappingStart = offset - offset % pageSize;
+		const size_t mappingLength = numberOfBytes + (size_t) (offset - mappingStart);
+		void *mapping = mmap (nullptr, mappingLength, PROT_READ, MAP_PRIVATE, fileDescriptor, mappingStart);
+		if (mapping == MAP_FAILED) return false;
+		(void) madvise (mapping, mappingLength, MADV_SEQUENTIAL);
+		Melder_decodeAudioToFloat ((const uint8 *) mapping + (offset - mappingStart), numberOfChannels, encoding, buffer, 1, numberOfSamples);
+		munmap (mapping, mappingLength);
+		fseeko (f, offset + (off_t) numberOfBytes, SEEK_SET);   // leave the file pointer after the samples, as fread would
+		return true;
+	#endif
+}
+
+static void Melder_readAudioToFloat_blocks (FILE *f, int numberOfChannels, int encoding, double **buffer, long numberOfSamples) {
+	const int numberOfBytesPerSamplePerChannel = Melder_numberOfBytesPerSamplePerChannel (encoding);
+	const long numberOfBytesPerSample = numberOfChannels * numberOfBytesPerSamplePerChannel;
+	const long numberOfSamplesPerBlock = 65536;
+	autoNUMvector <uint8> bytes ((long) 0, numberOfSamplesPerBlock * numberOfBytesPerSample - 1);
+	for (long firstSample = 1; firstSample <= numberOfSamples; firstSample += numberOfSamplesPerBlock) {
+		long numberOfSamplesToRead = numberOfSamples - firstSample + 1;
+		if (numberOfSamplesToRead > numberOfSamplesPerBlock) numberOfSamplesToRead = numberOfSamplesPerBlock;
+		const size_t numberOfBytesToRead = (size_t) (numberOfSamplesToRead * numberOfBytesPerSample);
+		const size_t numberOfBytesRead = fread (bytes.peek(), 1, numberOfBytesToRead, f);
+		if (numberOfBytesRead < numberOfBytesToRead)
+			memset (bytes.peek() + numberOfBytesRead, 0, numberOfBytesToRead - numberOfBytesRead);   // so that a last incomplete sample is completed with zeroes
+		const long numberOfSamplesRead = ((long) numberOfBytesRead + numberOfBytesPerSample - 1) / numberOfBytesPerSample;
+		Melder_decodeAudioToFloat (bytes.peek(), numberOfChannels, encoding, buffer, firstSample, numberOfSamplesRead);
+		if (numberOfBytesRead < numberOfBytesToRead) {
+			for (int ichan = 1; ichan <= numberOfChannels; ichan ++)
+				for (long isamp = firstSample + numberOfSamplesRead; isamp <= numberOfSamples; isamp ++)
+					buffer [ichan] [isamp] = 0.0;
+			Melder_warning (U"File too small (", numberOfChannels, U"-channel ", numberOfBytesPerSamplePerChannel * 8,
+				encoding == Melder_IEEE_FLOAT_32_BIG_ENDIAN || encoding == Melder_IEEE_FLOAT_32_LITTLE_ENDIAN ? U"-bit floating point" : U"-bit",
+				U").\nMissing samples were set to zero.");
+			return;
+		}
+	}
+}
+
 void Melder_readAudioToFloat (FILE *f, int numberOfChannels, int encoding, double **buffer, long numberOfSamples) {
 	try {
 		switch (encoding) {
@@ -887,295 +1032,12 @@ void Melder_readAudioToFloat (FILE *f, int numberOfChannels, int encoding, doubl
 			case Melder_LINEAR_24_LITTLE_ENDIAN:
 			case Melder_LINEAR_32_BIG_ENDIAN:
 			case Melder_LINEAR_32_LITTLE_ENDIAN:
-			{
-				int numberOfBytesPerSamplePerChannel =
-					encoding == Melder_LINEAR_16_BIG_ENDIAN || encoding == Melder_LINEAR_16_LITTLE_ENDIAN ? 2 :
-					encoding == Melder_LINEAR_24_BIG_ENDIAN || encoding == Melder_LINEAR_24_LITTLE_ENDIAN ? 3 : 4;
-				double numberOfBytes_f = (double) numberOfChannels * (double) numberOfSamples * (double) numberOfBytesPerSamplePerChannel;
-				if (isinf (numberOfBytes_f) || numberOfBytes_f > (double) (1LL << 53)) {
-					Melder_throw (U"Cannot read ", numberOfBytes_f, U" bytes, "
-						U"because that crosses the 9-petabyte limit.");
-				}
-				if (numberOfBytes_f > (double) SIZE_MAX) {
-					Melder_throw (U"Cannot read ", numberOfBytes_f, U" bytes. "
-						U"Perhaps try a 64-bit edition of Praat?");
-				}
-				Melder_assert (numberOfBytes_f >= 0.0);
-				size_t numberOfBytes = (size_t) numberOfBytes_f;   // cast is safe because overflow and signedness have been checked
-				uint8 *bytes = (uint8 *) & buffer [numberOfChannels] [numberOfSamples] + sizeof (double) - numberOfBytes;
-				/*
-				 * Read 16-bit data into the last quarter of the buffer,
-				 * or 24-bit data into the last three-eighths of the buffer,
-				 * or 32-bit data into the last half of the buffer.
-				 */
-				size_t numberOfBytesRead = fread (bytes, 1, numberOfBytes, f);
-				if (numberOfChannels == 1) {
-					switch (encoding) {
-						case Melder_LINEAR_16_BIG_ENDIAN: {
-							for (long isamp = 1; isamp <= numberOfSamples; isamp ++) {
-								unsigned char byte1 = * bytes ++, byte2 = * bytes ++;
-								int value = (int) (int16_t) (((uint16_t) byte1 << 8) | (uint16_t) byte2);   // extend sign
-								buffer [1] [isamp] = value * (1.0 / 32768);
-							}
-						} break;
-						case Melder_LINEAR_16_LITTLE_ENDIAN: {
-							for (long isamp = 1; isamp <= numberOfSamples; isamp ++) {
-								unsigned char byte1 = * bytes ++, byte2 = * bytes ++;
-								int value = (int) (int16_t) (((uint16_t) byte2 << 8) | (uint16_t) byte1);   // extend sign
-								buffer [1] [isamp] = value * (1.0 / 32768);
-							}
-						} break;
-						case Melder_LINEAR_24_BIG_ENDIAN: {
-							for (long isamp = 1; isamp <= numberOfSamples; isamp ++) {
-								unsigned char byte1 = * bytes ++, byte2 = * bytes ++, byte3 = * bytes ++;
-								int32 value = (int32)
-									((uint32) ((uint32) byte1 << 24) |
-									 (uint32) ((uint32) byte2 << 16) |
-											  ((uint32) byte3 << 8));
-								buffer [1] [isamp] = value * (1.0 / 32768 / 65536);
-							}
-						} break;
-						case Melder_LINEAR_24_LITTLE_ENDIAN: {
-							for (long isamp = 1; isamp <= numberOfSamples; isamp ++) {
-								unsigned char byte1 = * bytes ++, byte2 = * bytes ++, byte3 = * bytes ++;
-								int32 value = (int32)
-									((uint32) ((uint32) byte3 << 24) |
-									 (uint32) ((uint32) byte2 << 16) |
-											  ((uint32) byte1 << 8));
-								buffer [1] [isamp] = value * (1.0 / 32768 / 65536);
-							}
-						} break;
-						case Melder_LINEAR_32_BIG_ENDIAN: {
-							for (long isamp = 1; isamp <= numberOfSamples; isamp ++) {
-								unsigned char byte1 = * bytes ++, byte2 = * bytes ++, byte3 = * bytes ++, byte4 = * bytes ++;
-								int32 value = (int32)
-									((uint32) ((uint32) byte1 << 24) |
-									 (uint32) ((uint32) byte2 << 16) |
-									 (uint32) ((uint32) byte3 << 8) |
-											   (uint32) byte4);
-								buffer [1] [isamp] = value * (1.0 / 32768 / 65536);
-							}
-						} break;
-						case Melder_LINEAR_32_LITTLE_ENDIAN: {
-							for (long isamp = 1; isamp <= numberOfSamples; isamp ++) {
-								unsigned char byte1 = * bytes ++, byte2 = * bytes ++, byte3 = * bytes ++, byte4 = * bytes ++;
-								int32 value = (int32)
-									((uint32) ((uint32) byte4 << 24) |
-									 (uint32) ((uint32) byte3 << 16) |
-									 (uint32) ((uint32) byte2 << 8) |
-											   (uint32) byte1);
-								buffer [1] [isamp] = value * (1.0 / 32768 / 65536);
-							}
-						} break;
-					}
-				} else if (numberOfChannels <= (int) sizeof (double) / numberOfBytesPerSamplePerChannel) {
-					switch (encoding) {
-						case Melder_LINEAR_16_BIG_ENDIAN: {
-							for (long isamp = 1; isamp <= numberOfSamples; isamp ++) {
-								for (long ichan = 1; ichan <= numberOfChannels; ichan ++) {
-									uint8 byte1 = * bytes ++, byte2 = * bytes ++;
-									int value = (int) (int16) (uint16) ((uint16) ((uint16) byte1 << 8) | (uint16) byte2);
-									buffer [ichan] [isamp] = value * (1.0 / 32768);
-								}
-							}
-						} break;
-						case Melder_LINEAR_16_LITTLE_ENDIAN: {
-							for (long isamp = 1; isamp <= numberOfSamples; isamp ++) {
-								for (long ichan = 1; ichan <= numberOfChannels; ichan ++) {
-									uint8 byte1 = * bytes ++, byte2 = * bytes ++;
-									int value = (int) (int16) (uint16) ((uint16) ((uint16) byte2 << 8) | (uint16) byte1);
-									buffer [ichan] [isamp] = value * (1.0 / 32768);
-								}
-							}
-						} break;
-						case Melder_LINEAR_24_BIG_ENDIAN: {
-							for (long isamp = 1; isamp <= numberOfSamples; isamp ++) {
-								for (long ichan = 1; ichan <= numberOfChannels; ichan ++) {
-									uint8 byte1 = * bytes ++, byte2 = * bytes ++, byte3 = * bytes ++;
-									uint32 unsignedValue =
-										(uint32) ((uint32) byte1 << 16) |
-										(uint32) ((uint32) byte2 << 8) |
-												  (uint32) byte3;
-									if ((byte1 & 128) != 0) unsignedValue |= 0xFF000000;   // extend sign
-									buffer [ichan] [isamp] = (int32_t) unsignedValue * (1.0 / 8388608);
-								}
-							}
-						} break;
-						case Melder_LINEAR_24_LITTLE_ENDIAN: {
-							for (long isamp = 1; isamp <= numberOfSamples; isamp ++) {
-								for (long ichan = 1; ichan <= numberOfChannels; ichan ++) {
-									uint8 byte1 = * bytes ++, byte2 = * bytes ++, byte3 = * bytes ++;
-									uint32 unsignedValue = ((uint32) byte3 << 16) | ((uint32) byte2 << 8) | (uint32) byte1;
-									if ((byte3 & 128) != 0) unsignedValue |= 0xFF000000;
-									buffer [ichan] [isamp] = (int32) unsignedValue * (1.0 / 8388608);
-								}
-							}
-						} break;
-						case Melder_LINEAR_32_BIG_ENDIAN: {
-							for (long isamp = 1; isamp <= numberOfSamples; isamp ++) {
-								for (long ichan = 1; ichan <= numberOfChannels; ichan ++) {
-									uint8 byte1 = * bytes ++, byte2 = * bytes ++, byte3 = * bytes ++, byte4 = * bytes ++;
-									int32 value = (int32)
-										((uint32) ((uint32) byte1 << 24) |
-										 (uint32) ((uint32) byte2 << 16) |
-										 (uint32) ((uint32) byte3 << 8) |
-												   (uint32) byte4);
-									buffer [ichan] [isamp] = value * (1.0 / 32768 / 65536);
-								}
-							}
-						} break;
-						case Melder_LINEAR_32_LITTLE_ENDIAN: {
-							for (long isamp = 1; isamp <= numberOfSamples; isamp ++) {
-								for (long ichan = 1; ichan <= numberOfChannels; ichan ++) {
-									uint8 byte1 = * bytes ++, byte2 = * bytes ++, byte3 = * bytes ++, byte4 = * bytes ++;
-									int32 value = (int32)
-										((uint32) ((uint32) byte4 << 24) |
-										 (uint32) ((uint32) byte3 << 16) |
-										 (uint32) ((uint32) byte2 << 8) |
-												   (uint32) byte1);
-									buffer [ichan] [isamp] = value * (1.0 / 32768 / 65536);
-								}
-							}
-						} break;
-					}
-				} else {
-					Melder_assert (sizeof (double) == 8);
-					int32_t *ints = (int32_t *) & buffer [1] [1];
-					switch (encoding) {
-						case Melder_LINEAR_16_BIG_ENDIAN: {
-							for (long isamp = 1; isamp <= numberOfSamples; isamp ++) {
-								for (long ichan = 1; ichan <= numberOfChannels; ichan ++) {
-									uint8 byte1 = * bytes ++, byte2 = * bytes ++;
-									int32 value = (int32)
-										((uint32) ((uint32) byte1 << 24) |
-										 (uint32) ((uint32) byte2 << 16));
-									* ints ++ = value;
-									* ints ++ = 0;   // the marker
-								}
-							}
-						} break;
-						case Melder_LINEAR_16_LITTLE_ENDIAN: {
-							for (long isamp = 1; isamp <= numberOfSamples; isamp ++) {
-								for (long ichan = 1; ichan <= numberOfChannels; ichan ++) {
-									uint8 byte1 = * bytes ++, byte2 = * bytes ++;
-									int32 value = (int32)
-										(((uint32) byte2 << 24) |
-										 ((uint32) byte1 << 16));
-									* ints ++ = value;
-									* ints ++ = 0;   // the marker
-								}
-							}
-						} break;
-						case Melder_LINEAR_24_BIG_ENDIAN: {
-							for (long isamp = 1; isamp <= numberOfSamples; isamp ++) {
-								for (long ichan = 1; ichan <= numberOfChannels; ichan ++) {
-									uint8 byte1 = * bytes ++, byte2 = * bytes ++, byte3 = * bytes ++;
-									int32 value = (int32)
-										(((uint32) byte1 << 24) |
-										 ((uint32) byte2 << 16) |
-										 ((uint32) byte3 << 8));
-									* ints ++ = value;
-									* ints ++ = 0;   // the marker
-								}
-							}
-						} break;
-						case Melder_LINEAR_24_LITTLE_ENDIAN: {
-							for (long isamp = 1; isamp <= numberOfSamples; isamp ++) {
-								for (long ichan = 1; ichan <= numberOfChannels; ichan ++) {
-									uint8 byte1 = * bytes ++, byte2 = * bytes ++, byte3 = * bytes ++;
-									int32 value = (int32)
-										(((uint32) byte3 << 24) |
-										 ((uint32) byte2 << 16) |
-										 ((uint32) byte1 << 8));
-									* ints ++ = value;
-									* ints ++ = 0;   // the marker
-								}
-							}
-						} break;
-						case Melder_LINEAR_32_BIG_ENDIAN: {
-							for (long isamp = 1; isamp <= numberOfSamples; isamp ++) {
-								for (long ichan = 1; ichan <= numberOfChannels; ichan ++) {
-									uint8 byte1 = * bytes ++, byte2 = * bytes ++, byte3 = * bytes ++, byte4 = * bytes ++;
-									int32 value = (int32)
-										(((uint32) byte1 << 24) |
-										 ((uint32) byte2 << 16) |
-										 ((uint32) byte3 << 8) |
-										  (uint32) byte4);
-									* ints ++ = value;
-									* ints ++ = 0;   // the marker
-								}
-							}
-						} break;
-						case Melder_LINEAR_32_LITTLE_ENDIAN: {
-							for (long isamp = 1; isamp <= numberOfSamples; isamp ++) {
-								for (long ichan = 1; ichan <= numberOfChannels; ichan ++) {
-									uint8 byte1 = * bytes ++, byte2 = * bytes ++, byte3 = * bytes ++, byte4 = * bytes ++;
-									int32 value = (int32)
-										(((uint32) byte4 << 24) |
-										 ((uint32) byte3 << 16) |
-										 ((uint32) byte2 << 8) |
-										  (uint32) byte1);
-									* ints ++ = value;
-									* ints ++ = 0;   // the marker
-								}
-							}
-						}
-					}
-					double *doubles = & buffer [1] [1];
-					long n = numberOfSamples * numberOfChannels;
-					for (long i = 0; i < n; i ++) {
-						int32_t *valuePosition = (int32_t *) & doubles [i];
-						int32_t *markerPosition = valuePosition + 1;
-						if (! *markerPosition) {
-							int32_t value = *valuePosition;
-							long ichan = i / numberOfSamples, isamp = i % numberOfSamples;
-							for (long other = isamp * numberOfChannels + ichan; other != i; ) {
-								int32_t *otherValuePosition = (int32_t *) & doubles [other];
-								*valuePosition = *otherValuePosition;
-								*markerPosition = 1;
-								valuePosition = otherValuePosition;
-								markerPosition = valuePosition + 1;
-								ichan = other / numberOfSamples, isamp = other % numberOfSamples;
-								other = isamp * numberOfChannels + ichan;
-							}
-							*valuePosition = value;
-							*markerPosition = 1;
-						}
-					}
-					for (long isamp = 1; isamp <= numberOfSamples; isamp ++) {
-						for (long ichan = 1; ichan <= numberOfChannels; ichan ++) {
-							buffer [ichan] [isamp] = * (int32_t *) & buffer [ichan] [isamp] * (1.0 / 32768 / 65536);
-						}
-					}
-				}
-				if (numberOfBytesRead < numberOfBytes)
-					Melder_warning (U"File too small (", numberOfChannels, U"-channel ", numberOfBytesPerSamplePerChannel * 8, U"-bit).\n"
-						U"Missing samples were set to zero.");
-			} break;
 			case Melder_IEEE_FLOAT_32_BIG_ENDIAN:
-				try {
-					for (long isamp = 1; isamp <= numberOfSamples; isamp ++) {
-						for (long ichan = 1; ichan <= numberOfChannels; ichan ++) {
-							buffer [ichan] [isamp] = bingetr4 (f);
-						}
-					}
-				} catch (MelderError) {
-					Melder_clearError ();
-					Melder_warning (U"File too small (", numberOfChannels, U"-channel 32-bit floating point).\nMissing samples set to zero.");
-				}
-				break;
 			case Melder_IEEE_FLOAT_32_LITTLE_ENDIAN:
-				try {
-					for (long isamp = 1; isamp <= numberOfSamples; isamp ++) {
-						for (long ichan = 1; ichan <= numberOfChannels; ichan ++) {
-							buffer [ichan] [isamp] = bingetr4LE (f);
-						}
-					}
-				} catch (MelderError) {
-					Melder_clearError ();
-					Melder_warning (U"File too small (", numberOfChannels, U"-channel 32-bit floating point).\nMissing samples set to zero.");
-				}
-				break;
+			{
+				if (! Melder_readAudioToFloat_mapped (f, numberOfChannels, encoding, buffer, numberOfSamples))
+					Melder_readAudioToFloat_blocks (f, numberOfChannels, encoding, buffer, numberOfSamples);
+			} break;
 			case Melder_MULAW:
 				try {
 					for (long isamp = 1; isamp <= numberOfSamples; isamp ++) {
@@ -77,6 +77,9 @@ the behaviour of that program changes in the following way:
 45: tracing structMatrix :: read ()
 46: trace GTK parent sizes in _GuiObject_position ()
 47: force resampling in OTGrammar RIP
+48: use the reference rather than the blocked level-3 BLAS routines in NUMcblas.cpp
+49: MelderThread_getNumberOfProcessors () reports a single processor
+50: MelderThread_getNumberOfProcessors () reports 16 processors
 900: use DG Meta Serif Science instead of Palatino
 1264: Mac: Sound_record_fixedTime uses microphone "FW Solo (1264)"
 
@@ -30,7 +30,7 @@ void Melder_setErrorProc (void (*error) (const char32 *)) {
 	theError = error ? error : defaultError;
 }
 
-static char32 errors [2000+1];   // safe in low-memory situations
+static thread_local char32 errors [2000+1];   // safe in low-memory situations; every thread has its own errors
 
 static void appendError (const char32 *message) {
 	if (! message) return;
@@ -43,6 +43,10 @@
 #include "Printer.h"
 #include "ScriptEditor.h"
 #include "Strings_.h"
+#include "MelderThread.h"
+#include <algorithm>
+#include <atomic>
+#include <unordered_map>
 
 #if gtk
 	#include <gdk/gdkx.h>
@@ -173,7 +177,14 @@ void praat_deselect (int IOBJECT) {
 	}
 }
 
-void praat_deselectAll () { int IOBJECT; WHERE (1) praat_deselect (IOBJECT); }
+void praat_deselectAll () {
+	/*
+		The selected objects tend to be at the bottom of the list, so search from there,
+		and stop as soon as nothing is selected any longer.
+	*/
+	for (int IOBJECT = theCurrentPraatObjects -> n; IOBJECT > 0 && theCurrentPraatObjects -> totalSelection > 0; IOBJECT --)
+		praat_deselect (IOBJECT);
+}
 
 void praat_select (int IOBJECT) {
 	if (SELECTED) return;
@@ -291,6 +302,97 @@ void praat_cleanUpName (char32 *name) {
 	}
 }
 
+/***** the object registry *****/
+
+/*
+	For each full name ("Sound hallo"), the IDs of the objects that have it, in increasing order.
+*/
+struct structPraat_NameIndex {
+	std::unordered_map <std::u32string, std::vector <long>> ids;
+};
+
+static void praat_nameIndex_add (const char32 *fullName, long id) {
+	if (! theCurrentPraatObjects -> nameIndex)
+		theCurrentPraatObjects -> nameIndex = new structPraat_NameIndex;
+	std::vector <long> & ids = theCurrentPraatObjects -> nameIndex -> ids [fullName];
+	ids. insert (std::upper_bound (ids. begin (), ids. end (), id), id);
+}
+
+static void praat_nameIndex_remove (const char32 *fullName, long id) {
+	if (! theCurrentPraatObjects -> nameIndex || ! fullName) return;
+	auto entry = theCurrentPraatObjects -> nameIndex -> ids. find (fullName);
+	if (entry == theCurrentPraatObjects -> nameIndex -> ids. end ()) return;
+	std::vector <long> & ids = entry -> second;
+	auto position = std::lower_bound (ids. begin (), ids. end (), id);
+	if (position != ids. end () && *position == id) ids. erase (position);
+	if (ids. empty ()) theCurrentPraatObjects -> nameIndex -> ids. erase (entry);
+}
+
+void praat_setFullName (int position, const char32 *fullName) {
+	praat_Object object = & theCurrentPraatObjects -> list [position];
+	praat_nameIndex_remove (object -> name, object -> id);
+	Melder_free (object -> name);
+	object -> name = Melder_dup_f (fullName);   // all right to crash if out of memory
+	praat_nameIndex_add (object -> name, object -> id);
+}
+
+int praat_positionOfObjectWithId (long id) {
+	/*
+		New objects are appended with ever higher IDs, and removing an object keeps the order of the others,
+		so the list is sorted by ID.
+	*/
+	int low = 1, high = theCurrentPraatObjects -> n;
+	while (low <= high) {
+		int mid = low + (high - low) / 2;
+		long midId = theCurrentPraatObjects -> list [mid]. id;
+		if (midId < id)
+			low = mid + 1;
+		else if (midId > id)
+			high = mid - 1;
+		else
+			return mid;
+	}
+	return 0;
+}
+
+int praat_positionOfObjectWithFullName (const char32 *className, const char32 *givenName) {
+	int IOBJECT;
+	if (theCurrentPraatObjects -> nameIndex) {
+		std::u32string fullName (className);
+		fullName += U' ';
+		fullName += givenName;
+		auto entry = theCurrentPraatObjects -> nameIndex -> ids. find (fullName);
+		if (entry != theCurrentPraatObjects -> nameIndex -> ids. end ()) {
+			const std::vector <long> & ids = entry -> second;
+			for (auto id = ids. rbegin (); id != ids. rend (); id ++) {
+				IOBJECT = praat_positionOfObjectWithId (*id);
+				if (IOBJECT && str32equ (className, Thing_className (OBJECT)) && str32equ (givenName, OBJECT -> name))
+					return IOBJECT;
+			}
+		}
+	}
+	/*
+		The name of the object itself may have been changed behind the back of the list.
+	*/
+	WHERE_DOWN (1) {
+		if (str32equ (className, Thing_className (OBJECT)) && OBJECT -> name && str32equ (givenName, OBJECT -> name))
+			return IOBJECT;
+	}
+	return 0;
+}
+
+void praat_destroyObjects (PraatObjects me) noexcept {
+	for (int iobject = my n; iobject >= 1; iobject --) {
+		Melder_free (my list [iobject]. name);
+		forget (my list [iobject]. object);
+	}
+	my n = 0;
+	Melder_free (my list);
+	my _capacity = 0;
+	delete my nameIndex;
+	my nameIndex = nullptr;
+}
+
 /***** objects + commands *****/
 
 static void praat_new_unpackCollection (autoCollection me, const char32* myName) {
@@ -326,11 +428,15 @@ void praat_newWithFile (autoDaata me, MelderFile file, const char32 *myName) {
 	praat_cleanUpName (givenName.string);
 	MelderString_append (& name, Thing_className (me.get()), U" ", givenName.string);
 
-	if (theCurrentPraatObjects -> n == praat_MAXNUM_OBJECTS) {
-		//forget (me);
-		Melder_throw (U"The Object Window cannot contain more than ", praat_MAXNUM_OBJECTS, U" objects. You could remove some objects.");
+	if (theCurrentPraatObjects -> n == theCurrentPraatObjects -> _capacity) {
+		int newCapacity = 2 * theCurrentPraatObjects -> _capacity + 1000;
+		praat_Object newList = (praat_Object) Melder_realloc (theCurrentPraatObjects -> list, (1 + (int64) newCapacity) * (int64) sizeof (structPraat_Object));
+		memset (& newList [1 + theCurrentPraatObjects -> _capacity], 0, (size_t) (newCapacity - theCurrentPraatObjects -> _capacity) * sizeof (structPraat_Object));
+		if (theCurrentPraatObjects -> _capacity == 0) memset (& newList [0], 0, sizeof (structPraat_Object));
+		theCurrentPraatObjects -> list = newList;
+		theCurrentPraatObjects -> _capacity = newCapacity;
 	}
-		
+
 	int IOBJECT = ++ theCurrentPraatObjects -> n;
 	Melder_assert (FULL_NAME == nullptr);
 	FULL_NAME = Melder_dup_f (name.string);   // all right to crash if out of memory
@@ -352,6 +458,7 @@ void praat_newWithFile (autoDaata me, MelderFile file, const char32 *myName) {
 		MelderFile_setToNull (& theCurrentPraatObjects -> list [IOBJECT]. file);
 	}
 	ID = theCurrentPraatObjects -> uniqueId;
+	praat_nameIndex_add (FULL_NAME, ID);
 	theCurrentPraatObjects -> list [IOBJECT]. isBeingCreated = true;
 	Thing_setName (OBJECT, givenName.string);
 	theCurrentPraatObjects -> totalBeingCreated ++;
@@ -397,13 +504,81 @@ void praat_new (autoDaata me, Melder_9_ARGS) {
 	praat_new (me.move(), thePraatNewName.string);
 }
 
+typedef struct {
+	std::function <autoDaata (Daata object)> *convert;
+	std::vector <Daata> *objects;
+	std::vector <autoDaata> *results;
+	std::vector <char32 *> *errorMessages;
+	std::atomic <long> *nextObject, *firstFailure;
+} praat_ConvertChunk;
+
+static MelderThread_RETURN_TYPE praat_convertChunk (praat_ConvertChunk *me) {
+	const long numberOfObjects = (long) my objects -> size ();
+	for (;;) {
+		const long iobject = (*my nextObject) ++;
+		if (iobject >= numberOfObjects || iobject > *my firstFailure) break;   // a single thread would not have got this far
+		try {
+			(*my results) [(size_t) iobject] = (*my convert) ((*my objects) [(size_t) iobject]);
+		} catch (MelderError) {
+			(*my errorMessages) [(size_t) iobject] = Melder_dup_f (Melder_getError ());   // the error buffer is thread-local
+			Melder_clearError ();
+			long failure = *my firstFailure;
+			while (iobject < failure && ! my firstFailure -> compare_exchange_weak (failure, iobject)) { }
+		}
+	}
+	MelderThread_RETURN;
+}
+
+void praat_convertEach (std::function <autoDaata (Daata object)> convert, std::function <void (Daata object, autoDaata result)> insert) {
+	std::vector <Daata> objects;
+	for (int IOBJECT = 1; IOBJECT <= theCurrentPraatObjects -> n; IOBJECT ++)
+		if (SELECTED) objects. push_back (OBJECT);
+	const long numberOfObjects = (long) objects. size ();
+	long numberOfThreads = MelderThread_getNumberOfProcessors ();
+	if (numberOfThreads > numberOfObjects) numberOfThreads = numberOfObjects;
+	if (! theCurrentPraatApplication -> batch || ! praatP.parallelObjects || numberOfThreads <= 1) {
+		for (long iobject = 0; iobject < numberOfObjects; iobject ++) {
+			autoDaata result = convert (objects [(size_t) iobject]);
+			insert (objects [(size_t) iobject], result.move());
+		}
+		return;
+	}
+	std::vector <autoDaata> results ((size_t) numberOfObjects);
+	std::vector <char32 *> errorMessages ((size_t) numberOfObjects, nullptr);
+	std::atomic <long> nextObject (0), firstFailure (numberOfObjects);
+	std::vector <praat_ConvertChunk> chunks ((size_t) numberOfThreads);
+	for (long ithread = 0; ithread < numberOfThreads; ithread ++)
+		chunks [(size_t) ithread] = { & convert, & objects, & results, & errorMessages, & nextObject, & firstFailure };
+	MelderThread_run (praat_convertChunk, chunks.data(), (int) numberOfThreads);
+	/*
+		Insert the results in the order of the list, up to the first object that failed,
+		as a single thread would have done.
+	*/
+	const long failure = firstFailure;
+	for (long iobject = 0; iobject < failure; iobject ++)
+		insert (objects [(size_t) iobject], results [(size_t) iobject].move());
+	for (long iobject = failure + 1; iobject < numberOfObjects; iobject ++)
+		Melder_free (errorMessages [(size_t) iobject]);
+	if (failure < numberOfObjects) {
+		Melder_appendError_noLine (errorMessages [(size_t) failure]);
+		Melder_free (errorMessages [(size_t) failure]);
+		throw MelderError ();
+	}
+}
+
 void praat_updateSelection () {
 	if (theCurrentPraatObjects -> totalBeingCreated) {
 		int IOBJECT;
 		praat_deselectAll ();
-		WHERE (theCurrentPraatObjects -> list [IOBJECT]. isBeingCreated) {
-			praat_select (IOBJECT);
-			theCurrentPraatObjects -> list [IOBJECT]. isBeingCreated = false;
+		/*
+			New objects are at the bottom of the list.
+		*/
+		for (IOBJECT = theCurrentPraatObjects -> n; IOBJECT > 0 && theCurrentPraatObjects -> totalBeingCreated > 0; IOBJECT --) {
+			if (theCurrentPraatObjects -> list [IOBJECT]. isBeingCreated) {
+				praat_select (IOBJECT);
+				theCurrentPraatObjects -> list [IOBJECT]. isBeingCreated = false;
+				theCurrentPraatObjects -> totalBeingCreated --;
+			}
 		}
 		theCurrentPraatObjects -> totalBeingCreated = 0;
 		praat_show ();
@@ -465,6 +640,7 @@ void praat_name2 (char32 *name, ClassInfo klas1, ClassInfo klas2) {
 }
 
 void praat_removeObject (int i) {
+	praat_nameIndex_remove (theCurrentPraatObjects -> list [i]. name, theCurrentPraatObjects -> list [i]. id);
 	praat_remove (i, true);   // dangle
 	for (int j = i; j < theCurrentPraatObjects -> n; j ++)
 		theCurrentPraatObjects -> list [j] = theCurrentPraatObjects -> list [j + 1];   // undangle but create second references
@@ -743,13 +919,80 @@ void praat_dataChanged (Daata object) {
 	}
 }
 
+/********** START-UP TIMES AND MANUAL PAGES **********/
+
+/*
+	With the --startup-times option, Praat reports on stderr how long each stage of starting up took,
+	so that regressions in the start-up time of short scripts can be tracked.
+*/
+#define praat_MAXNUM_STARTUP_STAGES  100
+static struct {
+	const char32 *name;
+	int depth;   // libraries can include other libraries
+	double duration;
+} theStartUpStages [1 + praat_MAXNUM_STARTUP_STAGES];
+static int theNumberOfStartUpStages = 0, theStartUpDepth = 0;
+static double theStartUpClock = 0.0;   // the time at which praat_init was entered
+
+static int startUpStage_begin (const char32 *name) {
+	if (theNumberOfStartUpStages >= praat_MAXNUM_STARTUP_STAGES) return 0;   // no room: don't report
+	int istage = ++ theNumberOfStartUpStages;
+	theStartUpStages [istage]. name = name;
+	theStartUpStages [istage]. depth = theStartUpDepth;
+	theStartUpStages [istage]. duration = Melder_clock ();   // the start time, until startUpStage_end
+	return istage;
+}
+
+static void startUpStage_end (int istage) {
+	if (istage == 0) return;
+	theStartUpStages [istage]. duration = Melder_clock () - theStartUpStages [istage]. duration;
+}
+
+static void reportStartUpTimes () {
+	Melder_casual (U"Start-up times (milliseconds):");
+	for (int istage = 1; istage <= theNumberOfStartUpStages; istage ++) {
+		static const char32 *indent [] = { U"", U"  ", U"    ", U"      " };
+		int depth = theStartUpStages [istage]. depth;
+		Melder_casual (Melder_pad (10, Melder_fixed (1000.0 * theStartUpStages [istage]. duration, 3)),
+			U"  ", indent [depth < 3 ? depth : 3], theStartUpStages [istage]. name);
+	}
+	Melder_casual (Melder_pad (10, Melder_fixed (1000.0 * (Melder_clock () - theStartUpClock), 3)), U"  total");
+}
+
+void praat_includeLibrary (void (*praat_xxx_init) (), const char32 *name) {
+	int istage = startUpStage_begin (name);
+	theStartUpDepth ++;
+	praat_xxx_init ();
+	theStartUpDepth --;
+	startUpStage_end (istage);
+}
+
+#define praat_MAXNUM_MANPAGE_SETS  100
+static void (*theManPagesInits [1 + praat_MAXNUM_MANPAGE_SETS]) (ManPages me);
+static int theNumberOfManPagesInits = 0, theNumberOfManPagesInitsDone = 0;
+
+void praat_addManPages (void (*manual_xxx_init) (ManPages me)) {
+	Melder_assert (theNumberOfManPagesInits < praat_MAXNUM_MANPAGE_SETS);
+	theManPagesInits [++ theNumberOfManPagesInits] = manual_xxx_init;
+}
+
+ManPages praat_getManPages () {
+	if (theNumberOfManPagesInitsDone < theNumberOfManPagesInits) {
+		int istage = startUpStage_begin (U"manual pages");
+		while (theNumberOfManPagesInitsDone < theNumberOfManPagesInits)
+			theManPagesInits [++ theNumberOfManPagesInitsDone] (theCurrentPraatApplication -> manPages);
+		startUpStage_end (istage);
+	}
+	return theCurrentPraatApplication -> manPages;
+}
+
 static void helpProc (const char32 *query) {
 	if (theCurrentPraatApplication -> batch) {
 		Melder_flushError (U"Cannot view manual from batch.");
 		return;
 	}
 	try {
-		autoManual manual = Manual_create (query, theCurrentPraatApplication -> manPages, false);
+		autoManual manual = Manual_create (query, praat_getManPages (), false);
 		manual.releaseToUser();
 	} catch (MelderError) {
 		Melder_flushError (U"help: no help on \"", query, U"\".");
@@ -1034,6 +1277,8 @@ extern "C" void praatlib_init () {
 
 void praat_init (const char32 *title, int argc, char **argv)
 {
+	theStartUpClock = Melder_clock ();
+	int startUpStage = startUpStage_begin (U"praat_init");
 	bool weWereStartedFromTheCommandLine = tryToAttachToTheCommandLine ();
 
 	for (int iarg = 0; iarg < argc; iarg ++) {
@@ -1074,6 +1319,12 @@ void praat_init (const char32 *title, int argc, char **argv)
 		} else if (strequ (argv [praatP.argumentNumber], "--no-plugins")) {
 			praatP.ignorePlugins = true;
 			praatP.argumentNumber += 1;
+		} else if (strequ (argv [praatP.argumentNumber], "--parallel-objects")) {
+			praatP.parallelObjects = true;
+			praatP.argumentNumber += 1;
+		} else if (strequ (argv [praatP.argumentNumber], "--startup-times")) {
+			praatP.reportStartUpTimes = true;
+			praatP.argumentNumber += 1;
 		} else if (strnequ (argv [praatP.argumentNumber], "--pref-dir=", 11)) {
 			Melder_pathToDir (Melder_peek8to32 (argv [praatP.argumentNumber] + 11), & praatDir);
 			praatP.argumentNumber += 1;
@@ -1091,6 +1342,9 @@ void praat_init (const char32 *title, int argc, char **argv)
 			MelderInfo_writeLine (U"                   (--run is superfluous when you use a Console or Terminal)");
 			MelderInfo_writeLine (U"  --no-pref-files  don't read or write the preferences file and the buttons file");
 			MelderInfo_writeLine (U"  --no-plugins     don't activate the plugins");
+			MelderInfo_writeLine (U"  --parallel-objects");
+			MelderInfo_writeLine (U"                   in batch, convert several selected objects at the same time");
+			MelderInfo_writeLine (U"  --startup-times  report on stderr how long each stage of starting up took");
 			MelderInfo_writeLine (U"  --pref-dir=DIR   set the preferences directory to DIR");
 			MelderInfo_writeLine (U"  --version        print the Praat version");
 			MelderInfo_writeLine (U"  --help           print this list of command line options");
@@ -1380,6 +1634,7 @@ void praat_init (const char32 *title, int argc, char **argv)
 	trace (U"before picture window shows: locale is ", Melder_peek8to32 (setlocale (LC_ALL, nullptr)));
 	if (! praatP.dontUsePictureWindow) praat_picture_init ();
 	trace (U"after picture window shows: locale is ", Melder_peek8to32 (setlocale (LC_ALL, nullptr)));
+	startUpStage_end (startUpStage);
 
 	if (unknownCommandLineOption) {
 		Melder_fatal (U"Unrecognized command line option ", unknownCommandLineOption);
@@ -1446,6 +1701,7 @@ static void executeStartUpFile (MelderDir startUpDirectory, const char32 *fileNa
 #endif
 
 void praat_run () {
+	int startUpStage = startUpStage_begin (U"menus");
 	trace (U"adding menus, second round");
 	praat_addMenus2 ();
 	trace (U"locale is ", Melder_peek8to32 (setlocale (LC_ALL, nullptr)));
@@ -1453,21 +1709,25 @@ void praat_run () {
 	trace (U"adding the Quit command");
 	praat_addMenuCommand (U"Objects", U"Praat", U"-- quit --", nullptr, 0, nullptr);
 	praat_addMenuCommand (U"Objects", U"Praat", U"Quit", nullptr, praat_UNHIDABLE | 'Q' | praat_NO_API, DO_Quit);
+	startUpStage_end (startUpStage);
 
 	trace (U"read the preferences file, and notify those who want to be notified of this");
 	/* ...namely, those who already have a window (namely, the Picture window),
 	 * and those that regard the start of a new session as a meaningful event
 	 * (namely, the session counter and the cross-session memory counter).
 	 */
+	startUpStage = startUpStage_begin (U"preferences");
 	if (! praatP.ignorePreferenceFiles) {
 		Preferences_read (& prefsFile);
 		if (! praatP.dontUsePictureWindow) praat_picture_prefsChanged ();
 		praat_statistics_prefsChanged ();
 	}
+	startUpStage_end (startUpStage);
 
 	praatP.phase = praat_STARTING_UP;
 
 	trace (U"execute start-up file(s)");
+	startUpStage = startUpStage_begin (U"start-up files");
 	/*
 	 * On Unix and the Mac, we try no less than three start-up file names.
 	 */
@@ -1482,7 +1742,9 @@ void praat_run () {
 	#if defined (UNIX) || defined (macintosh) || defined (_WIN32)
 		executeStartUpFile (& homeDir, U"", U"-user-startUp");
 	#endif
+	startUpStage_end (startUpStage);
 
+	startUpStage = startUpStage_begin (U"plug-ins");
 	if (! MelderDir_isNull (& praatDir) && ! praatP.ignorePlugins) {
 		trace (U"install plug-ins");
 		trace (U"locale is ", Melder_peek8to32 (setlocale (LC_ALL, nullptr)));
@@ -1514,6 +1776,7 @@ void praat_run () {
 			Melder_clearError ();   // in case Strings_createAsDirectoryList () threw an error
 		}
 	}
+	startUpStage_end (startUpStage);
 
 	Melder_assert (str32equ (Melder_double (1.5), U"1.5"));   // check locale settings; because of the required file portability Praat cannot stand "1,5"
 	{ int dummy = 200;
@@ -1559,6 +1822,9 @@ void praat_run () {
 	if (sizeof (off_t) < 8)
 		Melder_fatal (U"sizeof(off_t) is less than 8. Compile Praat with -D_FILE_OFFSET_BITS=64.");
 
+	if (praatP.reportStartUpTimes)
+		reportStartUpTimes ();
+
 	if (Melder_batch) {
 		if (thePraatStandAloneScriptText) {
 			try {
@@ -21,6 +21,7 @@
 #include "Editor.h"
 #include "Manual.h"
 #include "Preferences.h"
+#include <functional>
 
 /* The explanations in this header file assume
 	that you put your extra commands in praat_Sybil.cpp
@@ -160,7 +161,6 @@ typedef struct {
 	bool isBeingCreated;
 } structPraat_Object, *praat_Object;
 
-#define praat_MAXNUM_OBJECTS 10000   /* Maximum number of objects in the list. */
 typedef struct {   /* Readonly */
 	MelderString batchName;   /* The name of the command file when called from batch. */
 	int batch;   /* Was the program called from the command line? */
@@ -169,7 +169,9 @@ typedef struct {   /* Readonly */
 } structPraatApplication, *PraatApplication;
 typedef struct {   /* Readonly */
 	int n;	 /* The current number of objects in the list. */
-	structPraat_Object list [1 + praat_MAXNUM_OBJECTS];   /* The list of objects: list [1..n]. */
+	structPraat_Object *list;   /* The list of objects: list [1..n]; grows as objects are added. */
+	int _capacity;
+	struct structPraat_NameIndex *nameIndex;   /* For finding objects by full name ("Sound hallo"). */
 	int totalSelection;   /* The total number of selected objects, <= n. */
 	int numberOfSelected [1 + 1000];   /* For each (readable) class. */
 	int totalBeingCreated;
@@ -202,6 +204,13 @@ void praat_new (autoDaata me, Melder_7_ARGS);
 void praat_new (autoDaata me, Melder_8_ARGS);
 void praat_new (autoDaata me, Melder_9_ARGS);
 void praat_newWithFile (autoDaata me, MelderFile file, const char32 *name);
+void praat_convertEach (std::function <autoDaata (Daata object)> convert, std::function <void (Daata object, autoDaata result)> insert);
+/*
+	Applies 'convert' to each selected object and 'insert' to each result, in the order of the list.
+	In batch mode with --parallel-objects, the conversions run on several threads,
+	so 'convert' should only read its object and the form arguments;
+	'insert' always runs on the calling thread.
+*/
 void praat_name2 (char32 *name, ClassInfo klas1, ClassInfo klas2);
 
 /* Macros for description of forms (dialog boxes).
@@ -647,6 +656,10 @@ void praat_name2 (char32 *name, ClassInfo klas1, ClassInfo klas2);
 #define CONVERT_EACH(klas)  LOOP { iam_LOOP (klas);
 #define CONVERT_EACH_END(...)  praat_new (result.move(), __VA_ARGS__); } END
 
+#define CONVERT_EACH_PARALLEL(klas)  praat_convertEach ([&] (Daata object_) -> autoDaata { klas me = static_cast<klas> (object_);
+#define CONVERT_EACH_PARALLEL_END(...)  return result.move(); }, \
+	[&] (Daata object_, autoDaata result_) { Daata me = object_; praat_new (result_.move(), __VA_ARGS__); }); END
+
 #define CONVERT_TWO(klas1,klas2)  FIND_TWO (klas1, klas2)
 #define CONVERT_TWO_END(...)  praat_new (result.move(), __VA_ARGS__); END
 
@@ -722,9 +735,21 @@ void praat_picture_close ();
 /* For main.cpp */
 
 #define INCLUDE_LIBRARY(praat_xxx_init)  \
-   { extern void praat_xxx_init (); praat_xxx_init (); }
+   { extern void praat_xxx_init (); praat_includeLibrary (praat_xxx_init, U"" #praat_xxx_init); }
 #define INCLUDE_MANPAGES(manual_xxx_init)  \
-   { extern void manual_xxx_init (ManPages me); manual_xxx_init (theCurrentPraatApplication -> manPages); }
+   { extern void manual_xxx_init (ManPages me); praat_addManPages (manual_xxx_init); }
+
+void praat_includeLibrary (void (*praat_xxx_init) (), const char32 *name);
+/*
+	Calls praat_xxx_init, and remembers how long that took (see the --startup-times option).
+*/
+void praat_addManPages (void (*manual_xxx_init) (ManPages me));
+ManPages praat_getManPages ();
+/*
+	The manual pages are not created at start-up, which would slow down every session
+	(especially short scripts run from the command line), but on the first call to praat_getManPages (),
+	in the order in which they were added with praat_addManPages ().
+*/
 
 /* For text-only applications that do not want to see that irritating Picture window. */
 /* Works only if called before praat_init. */
@@ -743,6 +768,11 @@ void praat_setLogo (double width_mm, double height_mm, void (*draw) (Graphics g)
 	praat_show ();   // Needed because the selection has changed.
 */
 void praat_removeObject (int i);   // i = 1..praat.n
+int praat_positionOfObjectWithId (long id);
+int praat_positionOfObjectWithFullName (const char32 *className, const char32 *givenName);
+	/* Return the position of the object in the list (1..praat.n), or 0 if there is no such object. */
+	/* If several objects have the same name, the one lowest in the list is found. */
+void praat_destroyObjects (PraatObjects me) noexcept;   // forget all objects, the list and the name index of a private object list (e.g. of a manual page)
 void praat_show ();   // forces an update of the dynamic menu
 void praat_updateSelection ();
 	/* If you require the correct selection immediately after calling praat_new. */
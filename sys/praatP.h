@@ -176,6 +176,7 @@ void praat_actions_writeAsCHeader (bool includeSaveAPI,
 
 void praat_cleanUpName (char32 *name);
 void praat_list_renameAndSelect (int position, const char32 *name);
+void praat_setFullName (int position, const char32 *fullName);   // "Sound hallo"; keeps the name index up to date
 
 extern struct PraatP {
 	int argc;
@@ -185,6 +186,8 @@ extern struct PraatP {
 	bool dontUsePictureWindow;   // see praat_dontUsePictureWindow ()
 	bool ignorePreferenceFiles, ignorePlugins;
 	bool hasCommandLineInput;
+	bool parallelObjects;   // in batch, convert selected objects on several threads (see praat_convertEach)
+	bool reportStartUpTimes;   // see the --startup-times option
 	char32 *title;
 	GuiWindow menuBar;
 	int phase;
@@ -56,7 +56,7 @@ DO
 	static MelderString fullName { 0 };
 	MelderString_copy (& fullName, Thing_className (OBJECT), U" ", string.string);
 	if (! str32equ (fullName.string, FULL_NAME)) {
-		Melder_free (FULL_NAME), FULL_NAME = Melder_dup_f (fullName.string);
+		praat_setFullName (IOBJECT, fullName.string);
 		autoMelderString listName;
 		MelderString_append (& listName, ID, U". ", fullName.string);
 		praat_list_renameAndSelect (IOBJECT, listName.string);
@@ -513,20 +513,20 @@ FORM (HELP_SearchManual, U"Search manual", U"Manual") {
 DO
 	if (theCurrentPraatApplication -> batch)
 		Melder_throw (U"Cannot view a manual from batch.");
-	autoManual manual = Manual_create (U"Intro", theCurrentPraatApplication -> manPages, false);
+	autoManual manual = Manual_create (U"Intro", praat_getManPages (), false);
 	Manual_search (manual.get(), query);
 	manual.releaseToUser();
 END }
 
 FORM (HELP_GoToManualPage, U"Go to manual page", nullptr) {
 	static long numberOfPages;
-	static const char32 **pages = ManPages_getTitles (theCurrentPraatApplication -> manPages, & numberOfPages);
+	static const char32 **pages = ManPages_getTitles (praat_getManPages (), & numberOfPages);
 	LIST (U"Page", numberOfPages, pages, 1)
 	OK
 DO
 	if (theCurrentPraatApplication -> batch)
 		Melder_throw (U"Cannot view a manual from batch.");
-	autoManual manual = Manual_create (U"Intro", theCurrentPraatApplication -> manPages, false);
+	autoManual manual = Manual_create (U"Intro", praat_getManPages (), false);
 	HyperPage_goToPage_i (manual.get(), GET_INTEGER (U"Page"));
 	manual.releaseToUser();
 END }
@@ -539,7 +539,7 @@ OK
 	Melder_getDefaultDir (& currentDirectory);
 	SET_STRING (U"directory", Melder_dirToPath (& currentDirectory))
 DO
-	ManPages_writeAllToHtmlDir (theCurrentPraatApplication -> manPages, directory);
+	ManPages_writeAllToHtmlDir (praat_getManPages (), directory);
 END }
 
 /********** Menu descriptions. **********/
@@ -139,7 +139,7 @@ void praat_reportMemoryUse () {
 	MelderInfo_writeLine (U"Currently in use:\n"
 		U"   Strings: ", MelderString_allocationCount () - MelderString_deallocationCount ());
 	MelderInfo_writeLine (U"   Arrays: ", NUM_getTotalNumberOfArrays ());
-	MelderInfo_writeLine (U"   Things: ", theTotalNumberOfThings,
+	MelderInfo_writeLine (U"   Things: ", theTotalNumberOfThings.load(),
 		U" (objects in list: ", theCurrentPraatObjects -> n, U")");
 	long numberOfMotifWidgets =
 	#if motif